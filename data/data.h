@@ -28,7 +28,7 @@ struct data_device_info
 	uint8_t device_type;		///< тип устройства
 	uint8_t device_id;			///< id устройства
 	uint8_t active;				///< активно или нет
-	uint8_t reserved;			///< просто байт для выравнивания структуры до 4 байт
+	uint8_t group;				///< группа для групповых mesh команд, 0 (и 0xFF стертой flash) - без группы
 };
 
 /**
@@ -18,6 +18,10 @@ int http_system_info_handler(struct query *query);
 int http_get_device_info_handler(struct query *query);
 int http_scan_wifi_info_list_handler(struct query *query);
 
+/**
+ * @brief Обработчики настройки, пишут flash синхронно в потоке LwIP
+ * @see cgi_handler
+ */
 int http_set_device_name_handler(struct query *query);
 int http_set_main_wifi_handler(struct query *query);
 int http_get_wifi_error_handler(struct query *query);
@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @brief Таблица точных uri для user/user_main.c, сгенерирована http_route_gen, не редактировать
+ * Перегенерировать после изменения списка обработчиков:
+ * http_route_gen --source=user/user_main.c --output=include/user_http_routes.h --name=user_http_routes --include=../light_http/light_http.h
+ */
+#ifndef __USER_HTTP_ROUTES_H__
+#define __USER_HTTP_ROUTES_H__
+
+#include "../light_http/light_http.h"
+
+static const uint32_t user_http_routes_slots[16] ICACHE_RODATA_ATTR =
+{
+	6,	// /on
+	9,	// /testModeOn
+	2,	// /getBroadcastNetworks
+	HTTP_ROUTE_NONE,
+	3,	// /setDeviceName
+	4,	// /setWifi
+	HTTP_ROUTE_NONE,
+	1,	// /getDeviceInfo
+	5,	// /getWifiError
+	7,	// /off
+	HTTP_ROUTE_NONE,
+	HTTP_ROUTE_NONE,
+	10,	// /testModeOff
+	0,	// /getSystemInfo
+	HTTP_ROUTE_NONE,
+	8,	// /status
+};
+
+static const struct http_route_table user_http_routes ICACHE_RODATA_ATTR =
+{
+	0x1E712332u,
+	15,
+	11,
+	user_http_routes_slots
+};
+
+#endif
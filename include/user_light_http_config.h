@@ -18,7 +18,6 @@
 #define SEND_BUF_SIZE 1024 * 2
 #define CONNECTION_POOL_SIZE 2
 #define HTTPD_TCP_PRIO DEFAULT_TASK_PRIO + 1
-#define WEB_HANLDERS_PRIO DEFAULT_TASK_PRIO + 2
 
 /**
  * @}
@@ -18,6 +18,22 @@ void mesh_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* send
 void mesh_devices_info_request_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* message);
 void mesh_device_info_response_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* message);
 void mesh_device_info_response_confirm_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* message);
+void mesh_group_switch_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* message);
+void mesh_time_sync_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* message);
+void mesh_election_announce_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* message);
+
+/**
+ * @brief Функция запуска выборов лидера сегмента, узел сам рассылает keep_alive
+ * @param[in] ctx Контекст mesh
+ */
+void mesh_election_setup(struct mesh_ctx* ctx);
+
+/**
+ * @brief Подписчик user_power, рассылает mesh_power_event на каждое переключение нагрузки
+ * @param[in] state Новое состояние нагрузки
+ * @param[in] arg Контекст mesh
+ */
+void mesh_power_listener(uint8_t state, void* arg);
 
 /**
  * @}
@@ -14,11 +14,26 @@
  * @{
  */
 
+/**
+ * @brief Подписчик на переключения нагрузки
+ * @param[in] state Новое состояние, 1 - питание есть
+ * @param[in] arg Аргумент из power_set_listener
+ */
+typedef void (* power_listener)(uint8_t state, void* arg);
+
 /**
  * @brief Функция для инициализации управления питанием
  */
 void power_init();
 
+/**
+ * @brief Функция установки подписчика на переключения нагрузки
+ * Подписчик вызывается на каждое изменение состояния, включая тестовый режим
+ * @param[in] listener Подписчик либо NULL
+ * @param[in] arg Аргумент подписчика
+ */
+void power_set_listener(power_listener listener, void* arg);
+
 /**
  * @brief Функция для отключения питания
  */
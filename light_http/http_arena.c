@@ -0,0 +1,56 @@
+#include "http_arena.h"
+
+#include <string.h>
+
+/**
+ * @defgroup light_http
+ * @brief HTTP сервер
+ *
+ * @addtogroup light_http
+ * @{
+ */
+
+void http_arena_init(struct http_arena* arena, void* buffer, uint32_t size)
+{
+	arena->base = (uint8_t*) buffer;
+	arena->size = size;
+	arena->used = 0;
+	arena->peak = 0;
+}
+
+void* http_arena_alloc(struct http_arena* arena, uint32_t size)
+{
+	// выравнивается адрес, а не смещение: буфер арены может быть выровнен только на 4
+	uintptr_t address = (uintptr_t)(arena->base + arena->used);
+	uint32_t offset = arena->used + (uint32_t)((HTTP_ARENA_ALIGN - (address & (HTTP_ARENA_ALIGN - 1))) & (HTTP_ARENA_ALIGN - 1));
+	if(size > arena->size || offset > arena->size - size)
+	{
+		return NULL;
+	}
+
+	arena->used = offset + size;
+	if(arena->used > arena->peak)
+	{
+		arena->peak = arena->used;
+	}
+	return arena->base + offset;
+}
+
+void* http_arena_zalloc(struct http_arena* arena, uint32_t size)
+{
+	void* ptr = http_arena_alloc(arena, size);
+	if(ptr != NULL)
+	{
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+void http_arena_reset(struct http_arena* arena)
+{
+	arena->used = 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,75 @@
+#ifndef __HTTP_ARENA_H__
+#define __HTTP_ARENA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http
+ * @brief HTTP сервер
+ *
+ * @addtogroup light_http
+ * @{
+ */
+
+/**
+ * @brief Выравнивание блоков арены, достаточно для double в узлах cJSON
+ */
+#define HTTP_ARENA_ALIGN 8
+
+/**
+ * @brief Арена запроса
+ *
+ * Память выдается сдвигом указателя из буфера соединения, отдельные блоки
+ * не освобождаются, вся арена сбрасывается одним вызовом при закрытии соединения.
+ */
+struct http_arena
+{
+	uint8_t* base;			///< буфер арены
+	uint32_t size;			///< размер буфера
+	uint32_t used;			///< занято байт
+	uint32_t peak;			///< максимум used между сбросами, для подбора HTTP_ARENA_SIZE
+};
+
+/**
+ * @brief Функция инициализации арены поверх буфера
+ */
+void http_arena_init(struct http_arena* arena, void* buffer, uint32_t size);
+
+/**
+ * @brief Функция выделения блока
+ * @return NULL если места в арене не осталось
+ */
+void* http_arena_alloc(struct http_arena* arena, uint32_t size);
+
+/**
+ * @brief Функция выделения обнуленного блока
+ */
+void* http_arena_zalloc(struct http_arena* arena, uint32_t size);
+
+/**
+ * @brief Функция сброса арены, все выданные блоки становятся недействительными
+ */
+void http_arena_reset(struct http_arena* arena);
+
+/**
+ * @brief Функция проверки принадлежности блока арене
+ */
+static inline bool http_arena_owns(const struct http_arena* arena, const void* ptr)
+{
+	return (const uint8_t*) ptr >= arena->base && (const uint8_t*) ptr < arena->base + arena->size;
+}
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,421 @@
+#include "http_parser.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @defgroup light_http
+ * @brief HTTP сервер
+ *
+ * @addtogroup light_http
+ * @{
+ */
+
+#define STATIC_STRLEN(x) (sizeof(x) - 1)
+
+/**
+ * @brief Максимальное значение Content-Length, больше не поместится ни в один буфер
+ */
+#define HTTP_PARSER_MAX_CONTENT_LENGTH 0xFFFFFF
+
+/**
+ * @brief Машинное слово для поиска разделителей: 32 бита на Xtensa lx106, 64 на PC
+ * HTTP_PARSER_WORD позволяет проверить 32 битный вариант на PC
+ */
+#ifdef HTTP_PARSER_WORD
+	typedef HTTP_PARSER_WORD http_word_t;
+#else
+	typedef uintptr_t http_word_t;
+#endif
+
+#define HTTP_WORD_ONES ((http_word_t) -1 / 0xFF)
+#define HTTP_WORD_HIGHS (HTTP_WORD_ONES * 0x80)
+#define HTTP_WORD_REPEAT(c) (HTTP_WORD_ONES * (uint8_t)(c))
+
+/**
+ * @brief Не 0 если в слове есть байт c (c - слово из повторенного байта)
+ */
+static inline http_word_t http_word_has(http_word_t v, http_word_t c)
+{
+	v ^= c;
+	return (v - HTTP_WORD_ONES) & ~v & HTTP_WORD_HIGHS;
+}
+
+static inline http_word_t http_word_load(const char* data)
+{	// адрес выровнен, на Xtensa это одна инструкция l32i
+	http_word_t v;
+	memcpy(&v, __builtin_assume_aligned(data, sizeof(http_word_t)), sizeof(http_word_t));
+	return v;
+}
+
+/**
+ * @brief Функция поиска первого из символов a, b, c в [from, to)
+ *
+ * До выравнивания байты проверяются по одному, далее выровненными словами,
+ * на Xtensa невыровненное чтение слова недопустимо. Слово с совпадением
+ * дочитывается побайтно для точной позиции. Для поиска одного или двух
+ * символов повторяется тот же символ, проверка слова при этом сокращается.
+ *
+ * @return Позиция символа либо to если не найден
+ */
+static inline uint32_t http_find(const char* data, uint32_t from, uint32_t to, char a, char b, char c)
+{
+	uint32_t i = from;
+	while(i < to && ((uintptr_t)(data + i) & (sizeof(http_word_t) - 1)) != 0)
+	{
+		if(data[i] == a || data[i] == b || data[i] == c)
+		{
+			return i;
+		}
+		++i;
+	}
+
+	const http_word_t wa = HTTP_WORD_REPEAT(a);
+	const http_word_t wb = HTTP_WORD_REPEAT(b);
+	const http_word_t wc = HTTP_WORD_REPEAT(c);
+	for(; i + sizeof(http_word_t) <= to; i += sizeof(http_word_t))
+	{
+		http_word_t v = http_word_load(data + i);
+		http_word_t found = http_word_has(v, wa);
+		if(b != a)
+		{
+			found |= http_word_has(v, wb);
+		}
+		if(c != b)
+		{
+			found |= http_word_has(v, wc);
+		}
+
+		if(found != 0)
+		{
+			break;
+		}
+	}
+
+	for(; i < to; ++i)
+	{
+		if(data[i] == a || data[i] == b || data[i] == c)
+		{
+			return i;
+		}
+	}
+	return to;
+}
+
+static inline char to_lower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static bool equals_nocase(const char* data, uint32_t size, const char* lower, uint32_t lower_size)
+{
+	if(size != lower_size)
+	{
+		return false;
+	}
+
+	for(uint32_t i = 0; i < size; ++i)
+	{
+		if(to_lower(data[i]) != lower[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+/**
+ * @brief Функция разбора значения Content-Length
+ * @return false если значение некорректно
+ */
+static bool http_parser_content_length(struct http_parser* parser, const char* value, uint32_t size)
+{
+	if(size == 0)
+	{
+		return false;
+	}
+
+	uint32_t result = 0;
+	for(uint32_t i = 0; i < size; ++i)
+	{
+		if(value[i] < '0' || value[i] > '9')
+		{
+			return false;
+		}
+
+		result = result * 10 + (value[i] - '0');
+		if(result > HTTP_PARSER_MAX_CONTENT_LENGTH)
+		{
+			return false;
+		}
+	}
+
+	parser->content_length = result;
+	return true;
+}
+
+/**
+ * @brief Функция разбора значения Connection, список токенов через запятую
+ */
+static void http_parser_connection(struct http_parser* parser, const char* value, uint32_t size)
+{
+	uint32_t i = 0;
+	while(i < size)
+	{
+		while(i < size && (is_space(value[i]) || value[i] == ','))
+		{
+			++i;
+		}
+
+		uint32_t token = i;
+		while(i < size && value[i] != ',' && !is_space(value[i]))
+		{
+			++i;
+		}
+
+		if(equals_nocase(value + token, i - token, "close", STATIC_STRLEN("close")))
+		{	// close приоритетнее keep-alive
+			parser->connection = HTTP_PARSER_CONNECTION_CLOSE;
+			return;
+		}
+		else if(equals_nocase(value + token, i - token, "keep-alive", STATIC_STRLEN("keep-alive")))
+		{
+			parser->connection = HTTP_PARSER_CONNECTION_KEEP_ALIVE;
+		}
+	}
+}
+
+/**
+ * @brief Функция сохранения законченной строки заголовка [line_start, end), end указывает на '\r'
+ *
+ * Тело определяется только по Content-Length. Transfer-Encoding не поддерживается и
+ * повторный Content-Length не принимается: иначе граница следующего запроса
+ * на соединении может разойтись с клиентом и прокси.
+ *
+ * @return false если запрос отклонен, код ответа в error_status
+ */
+static bool http_parser_header(struct http_parser* parser, const char* data, uint32_t end)
+{
+	uint32_t name = parser->line_start;
+	uint32_t colon = parser->line_colon;
+	if(colon == 0 || colon == name)
+	{
+		return false;
+	}
+
+	if(parser->headers_count >= HTTP_PARSER_MAX_HEADERS)
+	{
+		parser->error_status = 431;
+		return false;
+	}
+
+	uint32_t name_end = colon;
+	while(name_end > name && is_space(data[name_end - 1]))
+	{
+		--name_end;
+	}
+
+	uint32_t value = colon + 1;
+	while(value < end && is_space(data[value]))
+	{
+		++value;
+	}
+
+	uint32_t value_end = end;
+	while(value_end > value && is_space(data[value_end - 1]))
+	{
+		--value_end;
+	}
+
+	if(equals_nocase(data + name, name_end - name, "content-length", STATIC_STRLEN("content-length")))
+	{
+		if(parser->content_length_set || !http_parser_content_length(parser, data + value, value_end - value))
+		{
+			return false;
+		}
+		parser->content_length_set = true;
+	}
+
+	if(equals_nocase(data + name, name_end - name, "transfer-encoding", STATIC_STRLEN("transfer-encoding")))
+	{
+		parser->error_status = 501;
+		return false;
+	}
+
+	if(equals_nocase(data + name, name_end - name, "connection", STATIC_STRLEN("connection")))
+	{
+		http_parser_connection(parser, data + value, value_end - value);
+	}
+
+	struct http_header_token* token = &parser->headers[parser->headers_count++];
+	token->name = name;
+	token->name_length = name_end - name;
+	token->value = value;
+	token->value_length = value_end - value;
+	return true;
+}
+
+void http_parser_init(struct http_parser* parser)
+{
+	parser->state = HTTP_PARSER_METHOD;
+	parser->offset = 0;
+	parser->line_start = 0;
+	parser->line_colon = 0;
+	parser->method_end = 0;
+	parser->uri_start = 0;
+	parser->uri_query = 0;
+	parser->uri_end = 0;
+	parser->headers_start = 0;
+	parser->headers_end = 0;
+	parser->headers_count = 0;
+	parser->content_length = 0;
+	parser->content_length_set = false;
+	parser->version_minor = 0;
+	parser->connection = HTTP_PARSER_CONNECTION_DEFAULT;
+	parser->error_status = 400;
+}
+
+HTTP_PARSE_RESULT http_parser_execute(struct http_parser* parser, const char* data, uint32_t size)
+{
+	uint32_t i = parser->offset;
+	while(i < size && parser->state < HTTP_PARSER_BODY)
+	{
+		uint32_t found;
+		switch(parser->state)
+		{
+			case HTTP_PARSER_METHOD:
+				found = http_find(data, i, size, ' ', '\r', '\n');
+				if(found == size)
+				{
+					i = size;
+				}
+				else if(data[found] != ' ' || found == 0)
+				{
+					parser->state = HTTP_PARSER_ERROR;
+				}
+				else
+				{
+					parser->method_end = found;
+					parser->uri_start = found + 1;
+					parser->state = HTTP_PARSER_URI;
+					i = found + 1;
+				}
+				break;
+
+			case HTTP_PARSER_URI:
+				found = http_find(data, i, size, ' ', '?', '\n');
+				if(found == size)
+				{
+					i = size;
+				}
+				else if(data[found] == '?')
+				{
+					if(parser->uri_query == 0)
+					{
+						parser->uri_query = found;
+					}
+					i = found + 1;
+				}
+				else if(data[found] != ' ' || found == parser->uri_start)
+				{	// пустой uri либо HTTP/0.9
+					parser->state = HTTP_PARSER_ERROR;
+				}
+				else
+				{
+					parser->uri_end = found;
+					parser->line_start = found + 1;
+					parser->state = HTTP_PARSER_VERSION;
+					i = found + 1;
+				}
+				break;
+
+			case HTTP_PARSER_VERSION:
+				found = http_find(data, i, size, '\n', '\n', '\n');
+				if(found == size)
+				{
+					i = size;
+				}
+				else if(data[found - 1] != '\r' || found - 1 - parser->line_start != STATIC_STRLEN("HTTP/1.1")
+					|| memcmp(data + parser->line_start, "HTTP/1.", STATIC_STRLEN("HTTP/1.")) != 0
+				|| data[found - 2] < '0' || data[found - 2] > '9')
+				{
+					parser->state = HTTP_PARSER_ERROR;
+				}
+				else
+				{
+					parser->version_minor = data[found - 2] - '0';
+					parser->headers_start = found + 1;
+					parser->line_start = found + 1;
+					parser->state = HTTP_PARSER_HEADER;
+					i = found + 1;
+				}
+				break;
+
+			case HTTP_PARSER_HEADER:
+				// до ':' ищется и ':' и конец строки, после только конец строки
+				found = parser->line_colon == 0
+					? http_find(data, i, size, ':', '\n', '\n')
+					: http_find(data, i, size, '\n', '\n', '\n');
+				if(found == size)
+				{
+					i = size;
+				}
+				else if(data[found] == ':')
+				{
+					parser->line_colon = found;
+					i = found + 1;
+				}
+				else if(data[found - 1] != '\r')
+				{
+					parser->state = HTTP_PARSER_ERROR;
+				}
+				else if(found - 1 == parser->line_start)
+				{	// пустая строка, конец заголовков
+					parser->headers_end = found + 1;
+					parser->state = HTTP_PARSER_BODY;
+				}
+				else if(!http_parser_header(parser, data, found - 1))
+				{
+					parser->state = HTTP_PARSER_ERROR;
+				}
+				else
+				{
+					parser->line_start = found + 1;
+					parser->line_colon = 0;
+					i = found + 1;
+				}
+				break;
+		}
+	}
+
+	if(parser->state == HTTP_PARSER_ERROR)
+	{
+		parser->offset = i;
+		return HTTP_PARSE_FAILED;
+	}
+
+	// тело не разбирается, достаточно дождаться нужного размера
+	if(parser->state == HTTP_PARSER_BODY && size - parser->headers_end >= parser->content_length)
+	{
+		parser->state = HTTP_PARSER_DONE;
+	}
+
+	if(parser->state == HTTP_PARSER_DONE)
+	{
+		parser->offset = http_parser_message_size(parser);
+		return HTTP_PARSE_COMPLETE;
+	}
+
+	parser->offset = size;
+	return HTTP_PARSE_NEED_MORE;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,142 @@
+#ifndef __HTTP_PARSER_H__
+#define __HTTP_PARSER_H__
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http
+ * @brief HTTP сервер
+ *
+ * @addtogroup light_http
+ * @{
+ */
+
+/**
+ * @brief Максимальное кол-во заголовков, запрос с большим кол-вом отклоняется с 431
+ */
+#ifndef HTTP_PARSER_MAX_HEADERS
+	#define HTTP_PARSER_MAX_HEADERS 16
+#endif
+
+/**
+ * @brief Состояние разбора запроса
+ */
+enum http_parser_state
+{
+	HTTP_PARSER_METHOD = 0,		///< метод
+	HTTP_PARSER_URI,			///< uri
+	HTTP_PARSER_VERSION,		///< версия протокола до конца строки запроса
+	HTTP_PARSER_HEADER,			///< строки заголовков до пустой строки
+	HTTP_PARSER_BODY,			///< тело размером Content-Length
+	HTTP_PARSER_DONE,			///< запрос принят целиком
+	HTTP_PARSER_ERROR			///< запрос не соответствует HTTP/1.x
+};
+
+/**
+ * @brief Значение заголовка Connection
+ */
+enum http_parser_connection
+{
+	HTTP_PARSER_CONNECTION_DEFAULT = 0,	///< заголовка нет, решает версия протокола
+	HTTP_PARSER_CONNECTION_CLOSE,		///< Connection: close
+	HTTP_PARSER_CONNECTION_KEEP_ALIVE	///< Connection: keep-alive
+};
+
+/**
+ * @brief Результат разбора очередной порции данных
+ */
+typedef enum
+{
+	HTTP_PARSE_NEED_MORE = 0,	///< запрос еще не принят целиком
+	HTTP_PARSE_COMPLETE = 1,	///< запрос принят целиком
+	HTTP_PARSE_FAILED = -1		///< ошибка формата
+} HTTP_PARSE_RESULT;
+
+/**
+ * @brief Заголовок запроса, смещения относительно начала буфера
+ */
+struct http_header_token
+{
+	uint16_t name;				///< начало имени
+	uint16_t name_length;		///< длина имени без ':'
+	uint16_t value;				///< начало значения без пробелов
+	uint16_t value_length;		///< длина значения без пробелов и "\r\n"
+};
+
+/**
+ * @brief Возобновляемый разбор запроса
+ *
+ * Данные накапливаются вызывающим в одном буфере, парсер хранит только смещения
+ * и продолжает с места остановки, уже разобранные байты повторно не читаются.
+ * За один проход выделяются метод, uri, версия и заголовки, разделители
+ * ищутся машинными словами, sizeof(uintptr_t) байт (SWAR).
+ * Смещения указываются относительно начала буфера.
+ */
+struct http_parser
+{
+	uint8_t state;				///< http_parser_state
+	uint32_t offset;			///< сколько байт буфера разобрано
+	uint32_t line_start;		///< начало текущей строки заголовка
+	uint32_t line_colon;		///< ':' текущей строки заголовка, 0 пока не найден
+
+	uint32_t method_end;		///< конец метода (пробел)
+	uint32_t uri_start;			///< начало uri
+	uint32_t uri_query;			///< '?' в uri, 0 если параметров нет
+	uint32_t uri_end;			///< конец uri (пробел перед версией)
+	uint32_t headers_start;		///< начало первого заголовка
+	uint32_t headers_end;		///< начало тела, сразу после "\r\n\r\n"
+	uint32_t headers_count;		///< кол-во сохраненных заголовков
+
+	uint32_t content_length;	///< значение Content-Length
+	uint8_t content_length_set;	///< Content-Length уже встречался
+	uint8_t version_minor;		///< x из HTTP/1.x
+	uint8_t connection;			///< http_parser_connection
+	uint16_t error_status;		///< код ответа при HTTP_PARSE_FAILED
+
+	struct http_header_token headers[HTTP_PARSER_MAX_HEADERS];	///< заголовки
+};
+
+/**
+ * @brief Функция подготовки парсера к новому запросу
+ */
+void http_parser_init(struct http_parser* parser);
+
+/**
+ * @brief Функция разбора новых данных
+ * @param[in] parser Парсер
+ * @param[in] data Буфер со всеми принятыми данными запроса
+ * @param[in] size Размер данных в буфере, байты до parser->offset уже разобраны
+ */
+HTTP_PARSE_RESULT http_parser_execute(struct http_parser* parser, const char* data, uint32_t size);
+
+/**
+ * @brief Полный размер запроса, известен после HTTP_PARSE_COMPLETE
+ */
+static inline uint32_t http_parser_message_size(const struct http_parser* parser)
+{
+	return parser->headers_end + parser->content_length;
+}
+
+/**
+ * @brief Хочет ли клиент сохранить соединение после ответа
+ * HTTP/1.1 по умолчанию сохраняет соединение, HTTP/1.0 только с Connection: keep-alive
+ */
+static inline int http_parser_keep_alive(const struct http_parser* parser)
+{
+	return parser->connection == HTTP_PARSER_CONNECTION_KEEP_ALIVE
+		|| (parser->version_minor >= 1 && parser->connection != HTTP_PARSER_CONNECTION_CLOSE);
+}
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
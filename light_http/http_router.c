@@ -0,0 +1,453 @@
+#include "http_router.h"
+
+#include <string.h>
+
+/**
+ * @defgroup light_http
+ * @brief HTTP сервер
+ *
+ * @addtogroup light_http
+ * @{
+ */
+
+static inline bool http_route_is_param(const char* uri, uint32_t i)
+{
+	return uri[i] == ':' && (i == 0 || uri[i - 1] == '/');
+}
+
+static inline bool http_route_is_wildcard(const char* uri, uint32_t i)
+{
+	return uri[i] == '*' && uri[i + 1] == '\0' && i != 0 && uri[i - 1] == '/';
+}
+
+/**
+ * @brief Функция проверки шаблона uri
+ * @param[out] params Кол-во параметров включая '*'
+ * @return false если шаблон некорректен
+ */
+static bool http_route_valid(const char* uri, uint32_t* params)
+{
+	if(uri[0] != '/')
+	{
+		return false;
+	}
+
+	*params = 0;
+	for(uint32_t i = 0; uri[i] != '\0'; ++i)
+	{
+		if(http_route_is_param(uri, i))
+		{	// пустое имя параметра
+			if(uri[i + 1] == '\0' || uri[i + 1] == '/')
+			{
+				return false;
+			}
+			++*params;
+		}
+		else if(http_route_is_wildcard(uri, i))
+		{
+			++*params;
+		}
+		else if(uri[i] == '*')
+		{	// '*' допустим только последним сегментом
+			return false;
+		}
+	}
+	return *params <= HTTP_ROUTER_MAX_PARAMS;
+}
+
+static uint16_t http_route_node_new(struct http_router* router, const char* label, uint16_t length)
+{
+	if(router->nodes_count == router->nodes_size)
+	{
+		return HTTP_ROUTE_NONE;
+	}
+
+	uint16_t index = router->nodes_count++;
+	struct http_route_node* node = &router->nodes[index];
+	node->label = label;
+	node->label_length = length;
+	node->child = HTTP_ROUTE_NONE;
+	node->sibling = HTTP_ROUTE_NONE;
+	node->param = HTTP_ROUTE_NONE;
+	node->route = HTTP_ROUTE_NONE;
+	node->wildcard = HTTP_ROUTE_NONE;
+	return index;
+}
+
+/**
+ * @brief Функция добавления статического фрагмента под узел
+ * Метка потомка с общим началом делится, узел сохраняет индекс и становится общей частью
+ * @return Узел в конце фрагмента
+ */
+static uint16_t http_route_insert_static(struct http_router* router, uint16_t parent, const char* label, uint32_t length)
+{
+	while(length != 0)
+	{
+		uint16_t index = router->nodes[parent].child;
+		while(index != HTTP_ROUTE_NONE && router->nodes[index].label[0] != label[0])
+		{
+			index = router->nodes[index].sibling;
+		}
+
+		if(index == HTTP_ROUTE_NONE)
+		{
+			uint16_t leaf = http_route_node_new(router, label, length);
+			router->nodes[leaf].sibling = router->nodes[parent].child;
+			router->nodes[parent].child = leaf;
+			return leaf;
+		}
+
+		struct http_route_node* node = &router->nodes[index];
+		uint16_t common = 0;
+		while(common < node->label_length && common < length && node->label[common] == label[common])
+		{
+			++common;
+		}
+
+		if(common < node->label_length)
+		{
+			uint16_t tail = http_route_node_new(router, node->label + common, node->label_length - common);
+			router->nodes[tail].child = node->child;
+			router->nodes[tail].param = node->param;
+			router->nodes[tail].route = node->route;
+			router->nodes[tail].wildcard = node->wildcard;
+
+			node->label_length = common;
+			node->child = tail;
+			node->param = HTTP_ROUTE_NONE;
+			node->route = HTTP_ROUTE_NONE;
+			node->wildcard = HTTP_ROUTE_NONE;
+		}
+
+		label += common;
+		length -= common;
+		parent = index;
+	}
+	return parent;
+}
+
+/**
+ * @brief Функция добавления правила в конец цепочки, раньше объявленное правило приоритетнее
+ */
+static void http_route_append(struct http_router* router, uint16_t* head, uint16_t rule)
+{
+	while(*head != HTTP_ROUTE_NONE)
+	{
+		head = &router->next[*head];
+	}
+	*head = rule;
+}
+
+static void http_route_insert(struct http_router* router, uint16_t rule)
+{
+	const char* uri = router->rules[rule].uri;
+	uint16_t node = 0;
+	uint32_t i = 0;
+	while(uri[i] != '\0')
+	{
+		if(http_route_is_param(uri, i))
+		{
+			uint32_t end = i;
+			while(uri[end] != '\0' && uri[end] != '/')
+			{
+				++end;
+			}
+
+			if(router->nodes[node].param == HTTP_ROUTE_NONE)
+			{
+				router->nodes[node].param = http_route_node_new(router, uri + i, end - i);
+			}
+			node = router->nodes[node].param;
+			i = end;
+		}
+		else if(http_route_is_wildcard(uri, i))
+		{
+			http_route_append(router, &router->nodes[node].wildcard, rule);
+			return;
+		}
+		else
+		{
+			uint32_t end = i;
+			while(uri[end] != '\0' && !http_route_is_param(uri, end) && !http_route_is_wildcard(uri, end))
+			{
+				++end;
+			}
+			node = http_route_insert_static(router, node, uri + i, end - i);
+			i = end;
+		}
+	}
+	http_route_append(router, &router->nodes[node].route, rule);
+}
+
+bool http_router_init(struct http_router* router, const struct http_handler_rule* rules)
+{
+	// на каждый статический фрагмент не больше 2 узлов (новый и разделенный), на параметр 1
+	uint32_t rules_count = 0;
+	uint32_t nodes_size = 1;
+	for(const struct http_handler_rule* rule = rules; rule->uri != NULL && rule->handler != NULL; ++rule)
+	{
+		uint32_t params = 0;
+		if(http_route_valid(rule->uri, &params))
+		{
+			nodes_size += 3 * params + 2;
+		}
+		++rules_count;
+	}
+
+	if(rules_count >= HTTP_ROUTE_NONE || nodes_size >= HTTP_ROUTE_NONE)
+	{
+		os_printf("http_router: too many routes %d\n", rules_count);
+		return false;
+	}
+
+	router->rules = rules;
+	router->nodes_count = 0;
+	router->nodes_size = nodes_size;
+	router->nodes = (struct http_route_node*) zalloc(sizeof(struct http_route_node) * nodes_size + sizeof(uint16_t) * (rules_count + 1));
+	if(router->nodes == NULL)
+	{
+		return false;
+	}
+	router->next = (uint16_t*)(router->nodes + nodes_size);
+
+	http_route_node_new(router, "", 0);
+	for(uint16_t i = 0; i < rules_count; ++i)
+	{
+		uint32_t params = 0;
+		router->next[i] = HTTP_ROUTE_NONE;
+		if(!http_route_valid(rules[i].uri, &params))
+		{
+			os_printf("http_router: invalid route `%s`, skipped\n", rules[i].uri);
+			continue;
+		}
+		http_route_insert(router, i);
+	}
+
+	os_printf("http_router: %d routes, %d nodes\n", rules_count, router->nodes_count);
+	return true;
+}
+
+void http_router_free(struct http_router* router)
+{
+	if(router->nodes != NULL)
+	{
+		free(router->nodes);
+		router->nodes = NULL;
+		router->next = NULL;
+	}
+	router->nodes_count = 0;
+	router->nodes_size = 0;
+}
+
+/**
+ * @brief Функция выбора первого правила цепочки, допускающего метод
+ */
+static HTTP_ROUTE_RESULT http_route_select(const struct http_router* router, uint16_t rule, uint8_t method, struct http_route_match* match)
+{
+	if(rule == HTTP_ROUTE_NONE)
+	{
+		return HTTP_ROUTE_NOT_FOUND;
+	}
+
+	for(; rule != HTTP_ROUTE_NONE; rule = router->next[rule])
+	{
+		uint8_t methods = router->rules[rule].methods;
+		if(methods == HTTP_METHOD_ANY || (methods & method) != 0)
+		{
+			match->rule = &router->rules[rule];
+			return HTTP_ROUTE_FOUND;
+		}
+	}
+	return HTTP_ROUTE_METHOD_NOT_ALLOWED;
+}
+
+/**
+ * @brief Функция поиска от узла, метка которого уже совпала с uri до pos
+ * Возврат к параметру или '*' выполняется только если статическая ветка не подошла
+ */
+static HTTP_ROUTE_RESULT http_route_match_node(const struct http_router* router, uint16_t index, const char* uri, uint32_t pos, uint32_t length, uint8_t method, struct http_route_match* match)
+{
+	const struct http_route_node* node = &router->nodes[index];
+	HTTP_ROUTE_RESULT result = HTTP_ROUTE_NOT_FOUND;
+	HTTP_ROUTE_RESULT found;
+
+	if(pos == length)
+	{
+		if((found = http_route_select(router, node->route, method, match)) == HTTP_ROUTE_FOUND)
+		{
+			return found;
+		}
+		result = found;
+	}
+	else
+	{
+		for(uint16_t child = node->child; child != HTTP_ROUTE_NONE; child = router->nodes[child].sibling)
+		{
+			const struct http_route_node* next = &router->nodes[child];
+			if(next->label[0] != uri[pos])
+			{
+				continue;
+			}
+
+			// у потомков разные первые символы, подходить может только один
+			if(next->label_length <= length - pos && memcmp(next->label, uri + pos, next->label_length) == 0)
+			{
+				if((found = http_route_match_node(router, child, uri, pos + next->label_length, length, method, match)) == HTTP_ROUTE_FOUND)
+				{
+					return found;
+				}
+				result = found != HTTP_ROUTE_NOT_FOUND ? found : result;
+			}
+			break;
+		}
+
+		if(node->param != HTTP_ROUTE_NONE && uri[pos] != '/' && match->params_count < HTTP_ROUTER_MAX_PARAMS)
+		{
+			uint32_t end = pos;
+			while(end < length && uri[end] != '/')
+			{
+				++end;
+			}
+
+			uint8_t param = match->params_count++;
+			match->params[param].start = pos;
+			match->params[param].length = end - pos;
+			if((found = http_route_match_node(router, node->param, uri, end, length, method, match)) == HTTP_ROUTE_FOUND)
+			{
+				return found;
+			}
+			match->params_count = param;
+			result = found != HTTP_ROUTE_NOT_FOUND ? found : result;
+		}
+	}
+
+	if(node->wildcard != HTTP_ROUTE_NONE && match->params_count < HTTP_ROUTER_MAX_PARAMS)
+	{
+		uint8_t param = match->params_count++;
+		match->params[param].start = pos;
+		match->params[param].length = length - pos;
+		if((found = http_route_select(router, node->wildcard, method, match)) == HTTP_ROUTE_FOUND)
+		{
+			return found;
+		}
+		match->params_count = param;
+		result = found != HTTP_ROUTE_NOT_FOUND ? found : result;
+	}
+	return result;
+}
+
+HTTP_ROUTE_RESULT http_router_match(const struct http_router* router, const char* uri, uint32_t length, REQUEST_METHOD method, struct http_route_match* match)
+{
+	match->rule = NULL;
+	match->params_count = 0;
+	if(router->nodes == NULL)
+	{
+		return HTTP_ROUTE_NOT_FOUND;
+	}
+
+	uint8_t mask = method < 8 ? (uint8_t)(1 << method) : 0;
+	return http_route_match_node(router, 0, uri, 0, length, mask, match);
+}
+
+bool http_route_table_check(const struct http_route_table* table, const struct http_handler_rule* rules, bool* complete)
+{
+	uint32_t rules_count = 0;
+	uint32_t exact_count = 0;
+	for(const struct http_handler_rule* rule = rules; rule->uri != NULL && rule->handler != NULL; ++rule)
+	{
+		uint32_t params = 0;
+		if(!http_route_valid(rule->uri, &params) || params == 0)
+		{
+			++exact_count;
+		}
+		++rules_count;
+	}
+
+	uint32_t count = 0;
+	for(uint32_t slot = 0; slot <= table->mask; ++slot)
+	{
+		uint32_t index = table->slots[slot];
+		if(index == HTTP_ROUTE_NONE)
+		{
+			continue;
+		}
+
+		if(index >= rules_count)
+		{
+			return false;
+		}
+
+		const char* uri = rules[index].uri;
+		if((http_route_hash(table->seed, uri, strlen(uri)) & table->mask) != slot)
+		{
+			return false;
+		}
+		++count;
+	}
+
+	*complete = count == rules_count;
+	return count == table->count && count <= exact_count;
+}
+
+HTTP_ROUTE_RESULT http_route_table_match(const struct http_route_table* table, const struct http_handler_rule* rules, const char* uri, uint32_t length, REQUEST_METHOD method, struct http_route_match* match)
+{
+	match->rule = NULL;
+	match->params_count = 0;
+
+	uint32_t index = table->slots[http_route_hash(table->seed, uri, length) & table->mask];
+	if(index == HTTP_ROUTE_NONE)
+	{
+		return HTTP_ROUTE_NOT_FOUND;
+	}
+
+	const struct http_handler_rule* rule = &rules[index];
+	// strncmp не читает правило дальше его конца, если оно короче uri
+	if(strncmp(rule->uri, uri, length) != 0 || rule->uri[length] != '\0')
+	{
+		return HTTP_ROUTE_NOT_FOUND;
+	}
+
+	if(rule->methods != HTTP_METHOD_ANY && (method >= 8 || (rule->methods & (1 << method)) == 0))
+	{
+		return HTTP_ROUTE_METHOD_NOT_ALLOWED;
+	}
+
+	match->rule = rule;
+	return HTTP_ROUTE_FOUND;
+}
+
+const char* http_router_param_name(const struct http_handler_rule* rule, uint32_t index, uint32_t* length)
+{
+	const char* uri = rule->uri;
+	for(uint32_t i = 0; uri[i] != '\0'; ++i)
+	{
+		if(http_route_is_wildcard(uri, i))
+		{
+			if(index == 0)
+			{
+				*length = 1;
+				return uri + i;
+			}
+			--index;
+		}
+		else if(http_route_is_param(uri, i))
+		{
+			if(index == 0)
+			{
+				uint32_t end = i + 1;
+				while(uri[end] != '\0' && uri[end] != '/')
+				{
+					++end;
+				}
+				*length = end - i - 1;
+				return uri + i + 1;
+			}
+			--index;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,148 @@
+#ifndef __HTTP_ROUTER_H__
+#define __HTTP_ROUTER_H__
+
+#include "light_http.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http
+ * @brief HTTP сервер
+ *
+ * @addtogroup light_http
+ * @{
+ */
+
+/**
+ * @brief Результат поиска обработчика
+ */
+typedef enum
+{
+	HTTP_ROUTE_NOT_FOUND = 0,		///< uri не подходит ни под одно правило
+	HTTP_ROUTE_FOUND = 1,			///< найдено правило для uri и метода
+	HTTP_ROUTE_METHOD_NOT_ALLOWED = 2	///< uri подходит, но не для этого метода
+} HTTP_ROUTE_RESULT;
+
+/**
+ * @brief Узел дерева маршрутов
+ *
+ * Статические фрагменты uri хранятся сжатыми (radix), метка ссылается на строку правила.
+ * Потомки-параметры (':name') и '*' хранятся отдельно от статических потомков.
+ */
+struct http_route_node
+{
+	const char* label;			///< статический фрагмент uri
+	uint16_t label_length;		///< длина фрагмента
+	uint16_t child;				///< первый статический потомок
+	uint16_t sibling;			///< следующий статический потомок родителя, первые символы меток различны
+	uint16_t param;				///< потомок-параметр, совпадает с сегментом до '/'
+	uint16_t route;				///< первое правило заканчивающееся в узле
+	uint16_t wildcard;			///< первое правило с '*' после узла
+};
+
+/**
+ * @brief Дерево маршрутов, строится один раз из списка правил
+ */
+struct http_router
+{
+	const struct http_handler_rule* rules;	///< правила, на строки uri ссылаются метки узлов
+	struct http_route_node* nodes;			///< узлы, 0 - корень
+	uint16_t* next;							///< следующее правило того же узла, порядок как в списке
+	uint16_t nodes_count;					///< кол-во использованных узлов
+	uint16_t nodes_size;					///< кол-во выделенных узлов
+};
+
+/**
+ * @brief Найденный обработчик и параметры пути, смещения относительно начала uri
+ */
+struct http_route_match
+{
+	const struct http_handler_rule* rule;	///< правило
+	uint8_t params_count;					///< кол-во параметров, включая '*'
+	struct
+	{
+		uint16_t start;						///< начало значения
+		uint16_t length;					///< длина значения
+	} params[HTTP_ROUTER_MAX_PARAMS];
+};
+
+/**
+ * @brief Хеш uri для struct http_route_table, общий для генератора и сервера
+ * Только сдвиги, xor и умножение: у Xtensa lx106 нет деления, слот берется маской
+ */
+static inline uint32_t http_route_hash(uint32_t seed, const char* data, uint32_t length)
+{
+	uint32_t hash = seed ^ length;
+	for(uint32_t i = 0; i < length; ++i)
+	{
+		hash = (hash ^ (uint8_t) data[i]) * 0x01000193u;
+	}
+	return hash ^ (hash >> 15);
+}
+
+/**
+ * @brief Функция проверки таблицы по списку правил
+ * @param[in] table Таблица
+ * @param[in] rules Правила, по которым таблица сгенерирована
+ * @param[out] complete true если в таблице все правила и дерево не нужно
+ * @return false если таблица не соответствует правилам
+ */
+bool http_route_table_check(const struct http_route_table* table, const struct http_handler_rule* rules, bool* complete);
+
+/**
+ * @brief Функция поиска правила по таблице, параметров пути у таких правил нет
+ * @return HTTP_ROUTE_NOT_FOUND если uri нет в таблице
+ */
+HTTP_ROUTE_RESULT http_route_table_match(const struct http_route_table* table, const struct http_handler_rule* rules, const char* uri, uint32_t length, REQUEST_METHOD method, struct http_route_match* match);
+
+/**
+ * @brief Функция построения дерева
+ * Правила с ошибками в шаблоне пропускаются
+ * @param[in] router Дерево
+ * @param[in] rules Правила, список заканчивается { NULL, NULL }, должны жить пока жив router
+ * @return false если не хватило памяти
+ */
+bool http_router_init(struct http_router* router, const struct http_handler_rule* rules);
+
+/**
+ * @brief Функция освобождения дерева
+ */
+void http_router_free(struct http_router* router);
+
+/**
+ * @brief Функция поиска правила
+ *
+ * Сложность зависит от длины uri, а не от кол-ва правил. При неоднозначности
+ * статический фрагмент приоритетнее параметра, параметр приоритетнее '*'.
+ *
+ * @param[in] router Дерево
+ * @param[in] uri Путь без параметров запроса
+ * @param[in] length Длина пути
+ * @param[in] method Метод запроса
+ * @param[out] match Правило и параметры пути
+ */
+HTTP_ROUTE_RESULT http_router_match(const struct http_router* router, const char* uri, uint32_t length, REQUEST_METHOD method, struct http_route_match* match);
+
+/**
+ * @brief Функция получения имени параметра правила по номеру
+ * @param[in] rule Правило
+ * @param[in] index Номер параметра в шаблоне uri
+ * @param[out] length Длина имени
+ * @return Имя без ':' (не завершено нулем), "*" для остатка пути, NULL если параметра нет
+ */
+const char* http_router_param_name(const struct http_handler_rule* rule, uint32_t index, uint32_t* length);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
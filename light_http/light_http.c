@@ -1,7 +1,9 @@
 #include "light_http.h"
+#include "http_parser.h"
+#include "http_arena.h"
+#include "http_router.h"
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
 #include "freertos/task.h"
 
 #include "lwip/debug.h"
@@ -29,23 +31,52 @@
  */
 #define STATIC_STRLEN(x) (sizeof(x) - 1)
 
+/**
+ * @brief Место перед данными части chunked под размер: до 6 hex цифр и "\r\n"
+ */
+#define HTTP_CHUNK_HEADER_SIZE 8
+
+/**
+ * @brief Место после данных части chunked: "\r\n" и последняя часть "0\r\n\r\n"
+ */
+#define HTTP_CHUNK_TRAILER_SIZE (STATIC_STRLEN("\r\n") + STATIC_STRLEN("0\r\n\r\n"))
+
+/**
+ * @brief Минимальное место в tcp_sndbuf для следующей части потокового ответа, иначе ожидание sent
+ */
+#define HTTP_CHUNK_MIN_SIZE 64
+
 /**
  * @brief Обрабочики запросов
  * Инициализируется при старте web сервера
  */
 static struct http_handler_rule *handlers = NULL;
 
+/**
+ * @brief Дерево маршрутов по handlers, строится при старте web сервера
+ */
+static struct http_router router = { NULL, NULL, NULL, 0, 0 };
+
+/**
+ * @brief Таблица точных uri, NULL если не задана при старте
+ */
+static const struct http_route_table* route_table = NULL;
+
 static struct tcp_pcb* listen_pcb = NULL;
 
-static xQueueHandle webserver_client_task_stop = NULL;
-static xQueueHandle socket_queue = NULL;
+/**
+ * @brief Задача обработчиков (поток LwIP) и арена выполняемого в ней запроса
+ * Арена задана только на время вызова обработчика, см. light_http_malloc
+ */
+static xTaskHandle handler_task = NULL;
+static struct http_arena* handler_arena = NULL;
 
 /**
  * @brief Структура для заголовка
  *
  * Поля структуры ссылаются на область памяти используюмую 
- * при чтении данных, таким образом сами поля удалять не надо,
- * буффер чиститься по завершении запроса.
+ * при чтении данных, сами пары выделяются из арены соединения,
+ * таким образом удалять ничего не надо.
  */
 struct query_pair
 {
@@ -69,6 +100,7 @@ struct query
 	struct query_pair** request_headers;		///< заголовки запроса
 	struct query_pair** get_params;				///< параметры из uri
 	struct query_pair** post_params;			///< параметры из post
+	struct query_pair** path_params;			///< параметры пути из шаблона правила
 
 	char* body;									///< тело запроса
 	uint32_t body_length;						///< длинна тела запроса
@@ -78,6 +110,27 @@ struct query
 	uint32_t response_body_offset;				///< смещение относительно начала response_body, 
 												///< используется при отправки данных по частям
 	uint32_t done;
+	uint32_t keep_alive;						///< соединение сохраняется после ответа
+	uint32_t response_body_started;				///< заголовки ответа завершены query_response_body
+	uint32_t chunked;							///< клиент HTTP/1.1, потоковое тело размечается chunked
+
+	stream_handler stream;						///< функция записи потокового тела, NULL когда тело целиком в response_body
+	void* stream_data;							///< пользовательские данные stream
+	uint32_t stream_limit;						///< граница места под часть в response_body, 0 вне вызова stream
+
+	struct http_arena* arena;					///< арена соединения, из нее выделены query и все поля
+};
+
+/**
+ * @brief Состояние подключения
+ */
+enum http_ctx_state
+{
+	HTTP_CTX_READING = 0,			///< прием запроса, в том числе ожидание следующего запроса keep-alive
+	HTTP_CTX_DISPATCH,				///< запрос принят целиком, вызывается обработчик
+	HTTP_CTX_ASYNC_WAIT,			///< обработчик вернул 0, ответ будет готов после query_done из другой задачи
+	HTTP_CTX_SENDING,				///< ответ передается частями по мере освобождения tcp_sndbuf
+	HTTP_CTX_CLOSING				///< ответ отправлен, соединение закрывается
 };
 
 /**
@@ -85,17 +138,50 @@ struct query
  */
 struct http_ctx
 {
-	int32_t processed;				///< флаг отвечающий за процессинг
-	int32_t retries;				///< количество попыток отправить данные
+	uint8_t state;					///< http_ctx_state
+	int32_t retries;				///< количество вызовов poll в текущем состоянии
 
 	struct tcp_pcb* pcb;			///< ассоциированный сокет
 
 	char* receive_buffer;			///< буффер с данными прочитанными из сокета
-	int32_t receive_buffer_size;	///< размер буфера с данными
+	int32_t receive_buffer_size;	///< размер данных в буфере
+	uint32_t request_start;			///< начало текущего запроса в буфере, следующие за ним запросы (pipelining) остаются на месте
+	char request_next;				///< байт после запроса, на его месте завершающий ноль тела
+	struct http_parser parser;		///< разбор запроса по мере поступления сегментов, смещения от request_start
 
 	struct query* query;			///< объект запроса, создается после первичного парсинга запроса иначе NULL
+	struct http_arena arena;		///< память запроса, сбрасывается после каждого ответа
+	struct pbuf* pending;			///< данные принятые во время обработки запроса
+	uint32_t requests;				///< кол-во отправленных ответов в соединении
+	bool remote_closed;				///< клиент закрыл передачу, соединение закрывается после принятых запросов
+
+	struct http_ctx* next_free;		///< следующий свободный слот пула, NULL у занятого
 };
 
+/**
+ * @brief Размер слота пула: контекст, буфер приема и арена, кратно 8 для выравнивания соседнего слота
+ */
+#define HTTP_CTX_SLOT_SIZE ((sizeof(struct http_ctx) + RECV_BUF_SIZE + HTTP_ARENA_SIZE + 7) & ~7u)
+
+/**
+ * @brief Пул соединений
+ * CONNECTION_POOL_SIZE слотов выделяются одним блоком при старте сервера и не освобождаются,
+ * свободные слоты связаны в стек через next_free. Используется только в потоке LwIP.
+ */
+static uint8_t* ctx_pool = NULL;
+static struct http_ctx* ctx_pool_free = NULL;
+
+/**
+ * @brief Ответ при исчерпании пула, отправляется без слота
+ */
+static const char http_response_unavailable[] =
+	"HTTP/1.1 503 Service Unavailable\r\n"
+	"Server: light-httpd/0.1\r\n"
+	"Connection: close\r\n"
+	"Retry-After: 1\r\n"
+	"Content-Length: 0\r\n"
+	"\r\n";
+
 
 const char* query_get_header(const char* name, struct query* query)
 {
@@ -145,6 +231,24 @@ const char* query_get_param(const char* name, struct query* query, REQUEST_METHO
 	return NULL;
 }
 
+const char* query_get_path_param(const char* name, struct query* query)
+{
+	if(query == NULL || query->path_params == NULL)
+	{
+		return NULL;
+	}
+
+	for(struct query_pair** iter = query->path_params; *iter != NULL; ++iter)
+	{
+		struct query_pair* ptr = *iter;
+		if(strcmp(ptr->name, name) == 0)
+		{
+			return ptr->value;
+		}
+	}
+	return NULL;
+}
+
 REQUEST_METHOD query_get_method(struct query* query)
 {
 	if(query == NULL)
@@ -188,8 +292,7 @@ void query_response_status(int32_t status, struct query* query)
 		char buff[PRINT_BUFFER_SIZE] = { 0 };
 		int size = sprintf(buff, 
 				"HTTP/1.1 %d OK\r\n"
-				"Server: light-httpd/0.1\r\n"
-				"Connection: close\r\n", status);
+				"Server: light-httpd/0.1\r\n", status);
 
 		query_response_append(buff, size, query);
 	}
@@ -199,6 +302,23 @@ void query_response_status(int32_t status, struct query* query)
 	}
 }
 
+/**
+ * @brief Функция завершения заголовков ответа
+ * Connection пишется последним: до начала тела keep_alive еще может сброситься
+ * (переполнение буфера, поток без chunked)
+ */
+static void query_response_headers_end(struct query* query)
+{
+	if(query->keep_alive)
+	{
+		query_response_append("Connection: keep-alive\r\n\r\n", STATIC_STRLEN("Connection: keep-alive\r\n\r\n"), query);
+	}
+	else
+	{
+		query_response_append("Connection: close\r\n\r\n", STATIC_STRLEN("Connection: close\r\n\r\n"), query);
+	}
+}
+
 void query_response_header(const char* name, const char* value, struct query* query)
 {
 	if(query != NULL)
@@ -215,17 +335,70 @@ void query_response_body(const char* data, int32_t length, struct query* query)
 	{
 		char buff[PRINT_BUFFER_SIZE] = { 0 };
 		int32_t size = sprintf(buff, "Content-Length: %u\r\n", length);
+		if(query->response_body_length + size + STATIC_STRLEN("Connection: keep-alive\r\n\r\n") + length >= SEND_BUF_SIZE)
+		{
+			// тело не поместится, а Content-Length уже не совпадет с отправленным:
+			// ответ заменяется на 500, соединение закрывается
+			os_printf("query_response_body: body %d does not fit response buffer %d\n", length, SEND_BUF_SIZE);
+			query->keep_alive = false;
+			query->response_body_length = 0;
+			query_response_status(500, query);
+			size = sprintf(buff, "Content-Length: 0\r\n");
+			length = 0;
+		}
+
 		query_response_append(buff, size, query);
+		query->response_body_started = true;
 
-		query_response_append("\r\n", STATIC_STRLEN("\r\n"), query);
+		query_response_headers_end(query);
 		query_response_append(data, length, query);
 	}
 }
 
+void query_response_stream(stream_handler handler, void* user_data, struct query* query)
+{
+	if(query != NULL && handler != NULL)
+	{
+		if(query->chunked)
+		{
+			query_response_append("Transfer-Encoding: chunked\r\n", STATIC_STRLEN("Transfer-Encoding: chunked\r\n"), query);
+		}
+		else
+		{	// без Content-Length и chunked конец тела HTTP/1.0 обозначается закрытием соединения
+			query->keep_alive = false;
+		}
+		query->response_body_started = true;
+		query_response_headers_end(query);
+
+		query->stream = handler;
+		query->stream_data = user_data;
+	}
+}
+
+uint32_t query_response_write(const char* data, uint32_t length, struct query* query)
+{
+	if(query == NULL || query->stream_limit == 0)
+	{
+		os_printf("query_response_write: called outside stream handler\n");
+		return 0;
+	}
+
+	uint32_t room = query->stream_limit - query->response_body_length;
+	uint32_t size = length < room ? length : room;
+	memcpy(query->response_body + query->response_body_length, data, size);
+	query->response_body_length += size;
+	return size;
+}
+
 void query_done(struct query* query)
 {
 	if(query != NULL)
 	{
+		// без Content-Length клиент не найдет конец ответа в сохраненном соединении
+		if(!query->response_body_started)
+		{
+			query_response_body("", 0, query);
+		}
 		query->done = true;
 	}
 }
@@ -239,20 +412,62 @@ void query_register_after_response(struct query* query, response_done_callback c
 	}
 }
 
+void* query_alloc(struct query* query, uint32_t size)
+{
+	if(query == NULL)
+	{
+		return NULL;
+	}
+	return http_arena_alloc(query->arena, size);
+}
+
+void* light_http_malloc(size_t size)
+{	// обработчики асинхронных запросов могут выполняться в других задачах, им арена не принадлежит
+	if(handler_arena != NULL && xTaskGetCurrentTaskHandle() == handler_task)
+	{
+		void* ptr = http_arena_alloc(handler_arena, size);
+		if(ptr != NULL)
+		{
+			return ptr;
+		}
+	}
+	return malloc(size);
+}
+
+void light_http_free(void* ptr)
+{
+	if(handler_arena != NULL && xTaskGetCurrentTaskHandle() == handler_task && http_arena_owns(handler_arena, ptr))
+	{	// блок арены освобождается вместе с соединением
+		return;
+	}
+	free(ptr);
+}
+
 
 static err_t asio_http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
 static err_t asio_http_poll(void *arg, struct tcp_pcb *pcb);
 static void asio_http_err(void *arg, err_t err);
 static err_t asio_http_sent(void *arg, struct tcp_pcb *pcb, u16_t len);
 
-static struct query* init_query()
+/**
+ * @brief Функция создания запроса в арене соединения
+ * query и буфер ответа выделяются из арены, отдельно не освобождаются
+ */
+static struct query* init_query(struct http_ctx* ctx)
 {
-	struct query* query = (struct query*) zalloc(sizeof(struct query));
+	struct query* query = (struct query*) http_arena_zalloc(&ctx->arena, sizeof(struct query));
+	if(query == NULL)
+	{
+		return NULL;
+	}
 
 	query->uri = NULL;
 	query->uri_length = 0;
 
 	query->done = false;
+	query->keep_alive = false;
+	query->response_body_started = false;
+	query->chunked = false;
 	query->user_data = NULL;
 	query->after_response = NULL;
 
@@ -262,60 +477,74 @@ static struct query* init_query()
 	query->request_headers = NULL;
 	query->get_params = NULL;
 	query->post_params = NULL;
+	query->path_params = NULL;
 
-	query->response_body = (char*)zalloc(SEND_BUF_SIZE);
+	query->response_body = (char*) http_arena_alloc(&ctx->arena, SEND_BUF_SIZE);
 	query->response_body_length = 0;
 	query->response_body_offset = 0;
 
-	return query;
+	query->stream = NULL;
+	query->stream_data = NULL;
+	query->stream_limit = 0;
+
+	query->arena = &ctx->arena;
+	return query->response_body != NULL ? query : NULL;
 }
 
-static void free_query(struct query *query)
+/**
+ * @brief Функция резервирования пула соединений
+ * @return false если памяти под пул нет
+ */
+static bool init_ctx_pool()
 {
-	if(query != NULL)
+	if(ctx_pool != NULL)
 	{
-		if(query->request_headers != NULL)
-		{
-			for(struct query_pair** iter = query->request_headers; *iter != NULL; ++iter)
-			{
-				free((struct query_pair*)(*iter));
-			}
-			free(query->request_headers);
-		}
-
-		if(query->get_params != NULL)
-		{
-			for(struct query_pair** iter = query->get_params; *iter != NULL; ++iter)
-			{
-				free((struct query_pair*)(*iter));
-			}
-			free(query->get_params);
-		}
+		return true;
+	}
 
-		if(query->post_params != NULL)
-		{
-			for(struct query_pair** iter = query->post_params; *iter != NULL; ++iter)
-			{
-				free((struct query_pair*)(*iter));
-			}
-			free(query->post_params);
-		}
+	if((ctx_pool = (uint8_t*) zalloc(HTTP_CTX_SLOT_SIZE * CONNECTION_POOL_SIZE)) == NULL)
+	{
+		os_printf("webserver: can't reserve %d connection slots\n", CONNECTION_POOL_SIZE);
+		return false;
+	}
 
-		if(query->response_body != NULL)
-		{
-			free(query->response_body);
-		}
-		free(query);
+	ctx_pool_free = NULL;
+	for(int32_t i = CONNECTION_POOL_SIZE - 1; i >= 0; --i)
+	{
+		struct http_ctx* ctx = (struct http_ctx*)(ctx_pool + HTTP_CTX_SLOT_SIZE * i);
+		ctx->next_free = ctx_pool_free;
+		ctx_pool_free = ctx;
 	}
+	os_printf("webserver: reserved %d connection slots by %d bytes\n", CONNECTION_POOL_SIZE, HTTP_CTX_SLOT_SIZE);
+	return true;
 }
 
+/**
+ * @brief Функция получения свободного слота пула
+ * @return NULL если все слоты заняты
+ */
 static struct http_ctx* init_ctx()
 {
-	struct http_ctx* ctx = (struct http_ctx*) zalloc(sizeof(struct http_ctx));
-	ctx->processed = 0;
+	struct http_ctx* ctx = ctx_pool_free;
+	if(ctx == NULL)
+	{
+		return NULL;
+	}
+	ctx_pool_free = ctx->next_free;
+	ctx->next_free = NULL;
+	ctx->query = NULL;
+	ctx->pcb = NULL;
+
+	ctx->state = HTTP_CTX_READING;
 	ctx->retries = 0;
-	ctx->receive_buffer = (char*)zalloc(RECV_BUF_SIZE);
-	ctx->receive_buffer_size = RECV_BUF_SIZE;
+	ctx->receive_buffer = (char*)(ctx + 1);
+	ctx->receive_buffer_size = 0;
+	ctx->request_start = 0;
+	ctx->pending = NULL;
+	ctx->requests = 0;
+	ctx->remote_closed = false;
+	http_parser_init(&ctx->parser);
+	http_arena_init(&ctx->arena, ctx->receive_buffer + RECV_BUF_SIZE, HTTP_ARENA_SIZE);
 	return ctx;
 }
 
@@ -323,22 +552,25 @@ static void free_ctx(struct http_ctx* ctx)
 {
 	if(ctx != NULL)
 	{
-		if(ctx->receive_buffer != NULL)
-		{
-			free(ctx->receive_buffer);
-			ctx->receive_buffer = NULL;
-		}
+		os_printf("free_ctx: arena peak %d of %d\n", ctx->arena.peak, HTTP_ARENA_SIZE);
+		http_arena_reset(&ctx->arena);
+		ctx->receive_buffer = NULL;
+		ctx->query = NULL;
 
-		if(ctx->query != NULL)
+		if(ctx->pending != NULL)
 		{
-			free_query(ctx->query);
+			pbuf_free(ctx->pending);
+			ctx->pending = NULL;
 		}
-		ctx->query = NULL;
 
-		ctx->processed = 0;
+		ctx->state = HTTP_CTX_READING;
 		ctx->retries = 0;
 		ctx->pcb = NULL;
-		free(ctx);
+
+		// слот возвращается в пул, буферы остаются зарезервированными;
+		// неподтвержденные данные уже скопированы в сегменты lwIP, см. http_send_data
+		ctx->next_free = ctx_pool_free;
+		ctx_pool_free = ctx;
 	}
 	else
 	{
@@ -346,28 +578,58 @@ static void free_ctx(struct http_ctx* ctx)
 	}
 }
 
-static const struct http_handler_rule* get_handler(struct query *query)
+/**
+ * @brief Функция поиска обработчика и заполнения параметров пути
+ * Имена и значения копируются в арену с завершающим нулем, uri в буфере запроса не меняется
+ * @return false если не хватило арены
+ */
+static bool get_handler(struct query* query, const struct http_handler_rule** handler, HTTP_ROUTE_RESULT* result)
 {
-	struct http_handler_rule* handler = NULL;
-	if(handlers != NULL)
+	struct http_route_match match;
+	*result = HTTP_ROUTE_NOT_FOUND;
+	if(route_table != NULL)
+	{	// при 405 дерево может найти шаблон, допускающий метод
+		*result = http_route_table_match(route_table, handlers, query->uri, query->uri_length, query->method, &match);
+	}
+
+	if(*result != HTTP_ROUTE_FOUND && router.nodes != NULL)
 	{
-		handler = handlers;
-		const char* uri = query_get_uri(query);
-		while(handler != NULL && handler->uri != NULL && handler->handler != NULL)
-		{
-			if(strcmp(uri, handler->uri) == 0)
-			{
-				break;
-			}
-			++handler;
-		}
-		// checking end of handlers list
-		if(handler->uri == NULL || handler->handler == NULL)
+		HTTP_ROUTE_RESULT found = http_router_match(&router, query->uri, query->uri_length, query->method, &match);
+		*result = found != HTTP_ROUTE_NOT_FOUND ? found : *result;
+	}
+	*handler = match.rule;
+	if(*result != HTTP_ROUTE_FOUND || match.params_count == 0)
+	{
+		return true;
+	}
+
+	struct query_pair** target = (struct query_pair**) query_alloc(query, sizeof(struct query_pair*) * (match.params_count + 1));
+	struct query_pair* pairs = (struct query_pair*) query_alloc(query, sizeof(struct query_pair) * match.params_count);
+	if(target == NULL || pairs == NULL)
+	{
+		return false;
+	}
+
+	for(uint8_t i = 0; i < match.params_count; ++i)
+	{
+		uint32_t name_length = 0;
+		const char* name = http_router_param_name(match.rule, i, &name_length);
+		pairs[i].name = (char*) query_alloc(query, name_length + 1);
+		pairs[i].value = (char*) query_alloc(query, match.params[i].length + 1);
+		if(pairs[i].name == NULL || pairs[i].value == NULL)
 		{
-			handler = NULL;
+			return false;
 		}
+
+		memcpy(pairs[i].name, name, name_length);
+		pairs[i].name[name_length] = '\0';
+		memcpy(pairs[i].value, query->uri + match.params[i].start, match.params[i].length);
+		pairs[i].value[match.params[i].length] = '\0';
+		target[i] = &pairs[i];
 	}
-	return handler;
+	target[match.params_count] = NULL;
+	query->path_params = target;
+	return true;
 }
 
 static err_t http_close_conn(struct tcp_pcb *pcb, struct http_ctx* ctx)
@@ -380,14 +642,8 @@ static err_t http_close_conn(struct tcp_pcb *pcb, struct http_ctx* ctx)
 	tcp_poll(pcb, NULL, 0);
 	tcp_sent(pcb, NULL);
 
-	err_t err = tcp_close(pcb);
-	if (err != ERR_OK) 
-	{
-		os_printf("asio_http: Error %d closing %p\n", err, (void*)pcb);
-		/* error closing, try again later in poll */
-		tcp_poll(pcb, asio_http_poll, HTTPD_POLL_INTERVAL);
-	}
-	else if(ctx != NULL) 
+	// callbacks уже отключены, слот возвращается в пул даже если закрытие повторится в poll
+	if(ctx != NULL) 
 	{
 		if(ctx->query != NULL && ctx->query->after_response != NULL)
 		{
@@ -395,111 +651,72 @@ static err_t http_close_conn(struct tcp_pcb *pcb, struct http_ctx* ctx)
 		}
 		free_ctx(ctx);
 	}
+
+	err_t err = tcp_close(pcb);
+	if (err != ERR_OK) 
+	{
+		os_printf("asio_http: Error %d closing %p\n", err, (void*)pcb);
+		/* error closing, try again later in poll */
+		tcp_poll(pcb, asio_http_poll, HTTPD_POLL_INTERVAL);
+	}
 	return err;
 }
 
+/**
+ * @brief Функция заполнения query по разметке парсера
+ * Метод, uri и заголовки уже выделены за один проход в http_parser_execute,
+ * здесь они только завершаются нулем в буфере запроса
+ */
 static bool webserver_parse_request_headers(struct http_ctx* ctx, char* data)
 {
-	char *header_name = NULL, *header_value = NULL;
-	char *iter = data;
+	const struct http_parser* parser = &ctx->parser;
 
-	if(strncmp(iter, "GET ", STATIC_STRLEN("GET ")) == 0)
+	if(parser->method_end == STATIC_STRLEN("GET") && memcmp(data, "GET", STATIC_STRLEN("GET")) == 0)
 	{
 		ctx->query->method = REQUEST_GET;
-		iter += STATIC_STRLEN("GET ");
 	}
-	else if(strncmp(iter, "POST ", STATIC_STRLEN("POST ")) == 0)
+	else if(parser->method_end == STATIC_STRLEN("POST") && memcmp(data, "POST", STATIC_STRLEN("POST")) == 0)
 	{
 		ctx->query->method = REQUEST_POST;
-		iter += STATIC_STRLEN("POST ");
 	}
 	else
 	{
-		os_printf("webserver: failed parse method\n");
-		if((iter = strstr(iter, " ")) != NULL)
-		{
-			*iter = '\0';
-		}
-		os_printf("webserver: unsupported request method: %s\n", 
-				(iter != NULL ? ctx->receive_buffer : "unknown"));
+		data[parser->method_end] = '\0';
+		os_printf("webserver: unsupported request method: %s\n", data);
 		return false;
 	}
 	os_printf("webserver: method: `%s`\n", (ctx->query->method == REQUEST_GET ? "GET" : "POST"));
 
-	header_name = iter;
-	if((iter = strstr(iter, " HTTP/1.1")) == NULL)
-	{
-		os_printf("webserver: http version tag not found\n");
-		return false;
-	}
-	os_printf("webserver: HTTP tag parsed\n");
-
-	ctx->query->uri = header_name;
-	ctx->query->uri_length = iter - header_name;
-	*iter = '\0'; ++iter;
+	ctx->query->uri = data + parser->uri_start;
+	ctx->query->uri_length = parser->uri_end - parser->uri_start;
+	data[parser->uri_end] = '\0';
 
 	os_printf("webserver: uri: `%s`\n", ctx->query->uri);
 
-	// safe position when using
-	// it afte headers_count calculation
-	header_name = iter;
-
-	// calculate headers count
-	// count > size by 1 because calculated method row
-	// but count usage for headers array ending with NULL
-	int32_t headers_count = 0;
-	while((iter = strstr(iter, "\r\n")) != NULL)
-	{
-		iter += STATIC_STRLEN("\r\n");
-		++headers_count;
-	}
-	os_printf("webserver: headers counted: %d\n", headers_count);
-
-	ctx->query->request_headers = (struct query_pair **) zalloc(sizeof(struct query_pair*) * (headers_count + 1));
-	ctx->query->request_headers[headers_count] = NULL;
-	for(int32_t i = 0; i < headers_count; ++i)
+	uint32_t headers_count = parser->headers_count;
+	struct query_pair** headers = (struct query_pair **) http_arena_alloc(&ctx->arena, sizeof(struct query_pair*) * (headers_count + 1));
+	struct query_pair* pairs = (struct query_pair*) http_arena_alloc(&ctx->arena, sizeof(struct query_pair) * headers_count);
+	if(headers == NULL || pairs == NULL)
 	{
-		ctx->query->request_headers[i] = (struct query_pair*)zalloc(sizeof(struct query_pair));
+		os_printf("webserver: arena exhausted by %d headers\n", headers_count);
+		return false;
 	}
+	headers[headers_count] = NULL;
+	ctx->query->request_headers = headers;
 
-	// restore saved position
-	iter = header_name;
-	headers_count = 0;
-	while((iter = strstr(iter, "\r\n")) != NULL)
+	for(uint32_t i = 0; i < headers_count; ++i)
 	{
-		// set stop value for header_value 
-		// from prev iteration
-		if(headers_count != 0)
-		{
-			*iter = '\0';
-		}
-
-		iter += STATIC_STRLEN("\r\n");
-		header_name = iter;
-
-		if((iter = strstr(iter, ":")) == NULL)
-		{
-			os_printf("webserver: can't find header separator\n");
-			continue;
-		}
+		const struct http_header_token* token = &parser->headers[i];
 
-		// set header_name stop value
-		// end go to next char
-		*iter = '\0'; ++iter;
-		while(*iter == ' ' || *iter == '\t')
-		{
-			++iter;
-		}
-		header_value = iter;
+		// на месте ':' (или пробела перед ним) и '\r' (или пробела) ставится 0
+		struct query_pair* pair = &pairs[i];
+		pair->name = data + token->name;
+		pair->name[token->name_length] = '\0';
+		pair->value = data + token->value;
+		pair->value[token->value_length] = '\0';
 
-		ctx->query->request_headers[headers_count]->name = header_name;
-		ctx->query->request_headers[headers_count]->value = header_value;
-		++headers_count;
-	}
-	for(struct query_pair** iter = ctx->query->request_headers; *iter != NULL; ++iter)
-	{
-		struct query_pair* ptr = *iter;
-		os_printf("webserver: header name: `%s` - `%s`\n", ptr->name, ptr->value);
+		ctx->query->request_headers[i] = pair;
+		os_printf("webserver: header name: `%s` - `%s`\n", pair->name, pair->value);
 	}
 	return true;
 }
@@ -551,24 +768,27 @@ static bool webserver_parse_params(struct http_ctx* ctx, REQUEST_METHOD m, char*
 		return true;
 	}
 
-	if(m == REQUEST_GET)
+	struct query_pair** target = (struct query_pair **) http_arena_alloc(&ctx->arena, sizeof(struct query_pair*) * (params_counter + 1));
+	struct query_pair* pairs = (struct query_pair*) http_arena_zalloc(&ctx->arena, sizeof(struct query_pair) * params_counter);
+	if(target == NULL || pairs == NULL)
 	{
-		ctx->query->get_params = (struct query_pair **) zalloc(sizeof(struct query_pair*) * (params_counter + 1));
-		ctx->query->get_params[params_counter] = NULL;
+		os_printf("webserver: arena exhausted by %d params\n", params_counter);
+		return false;
 	}
-	else
+
+	for(uint32_t i = 0; i < params_counter; ++i)
 	{
-		ctx->query->post_params = (struct query_pair **) zalloc(sizeof(struct query_pair*) * (params_counter + 1));
-		ctx->query->post_params[params_counter] = NULL;
+		target[i] = &pairs[i];
 	}
+	target[params_counter] = NULL;
 
-	struct query_pair** target = m == REQUEST_GET 
-		? ctx->query->get_params
-		: ctx->query->post_params;
-
-	for(uint32_t i = 0; i < params_counter; ++i)
+	if(m == REQUEST_GET)
+	{
+		ctx->query->get_params = target;
+	}
+	else
 	{
-		target[i] = (struct query_pair*)zalloc(sizeof(struct query_pair));
+		ctx->query->post_params = target;
 	}
 
 	iter = last;
@@ -606,6 +826,7 @@ static bool webserver_parse_request(struct http_ctx* ctx)
 	{
 		return false;
 	}
+	char* request = ctx->receive_buffer + ctx->request_start;
 
 	if(ctx->query == NULL)
 	{
@@ -613,34 +834,21 @@ static bool webserver_parse_request(struct http_ctx* ctx)
 		return false;
 	}
 
-	char* iter = strstr(ctx->receive_buffer, "\r\n\r\n");
-	if(iter != NULL)
-	{
-		*iter = '\0';
-		iter += STATIC_STRLEN("\r\n\r\n");
-	}
+	// границы запроса уже известны парсеру, тело завершается нулем для разбора параметров
+	// байт после запроса сохранен в request_next при приеме
+	char* iter = request + ctx->parser.headers_end;
+	iter[ctx->parser.content_length] = '\0';
 
-	if(!webserver_parse_request_headers(ctx, ctx->receive_buffer))
+	if(!webserver_parse_request_headers(ctx, request))
 	{
 		os_printf("webserver: parse request headers failed\n");
 		return false;
 	}
 
-	const char* content_length = query_get_header("Content-Length", ctx->query);
-	if(content_length != NULL)
+	// заголовок парсер принимает в любом регистре, поэтому тело берется по его разметке
+	if(ctx->parser.content_length_set)
 	{
-		uint32_t header_size = atoi(content_length);
-		if(header_size != 0)
-		{
-			// total size - header_size
-			uint32_t body_size = ctx->receive_buffer_size - (iter - ctx->receive_buffer);
-			if(body_size != header_size)
-			{
-				os_printf("webserver: Content-Length: %d, body_size: %d\n", header_size, body_size);
-				return false;
-			}
-		}
-		ctx->query->body_length = atoi(content_length);
+		ctx->query->body_length = ctx->parser.content_length;
 		ctx->query->body = iter;
 	}
 
@@ -659,11 +867,12 @@ static bool webserver_parse_request(struct http_ctx* ctx)
 		}
 	}
 
-	// parse uri args
-	if((iter = strstr(ctx->query->uri, "?")) != NULL)
+	// parse uri args, позиция '?' найдена парсером
+	if(ctx->parser.uri_query != 0)
 	{	// remove params from uri
-		os_printf("webserver: try parse get %p, %p\n", iter, ctx->query->uri + ctx->query->uri_length);
+		iter = request + ctx->parser.uri_query;
 		*iter = '\0'; ++iter;
+		ctx->query->uri_length = ctx->parser.uri_query - ctx->parser.uri_start;
 		if(!webserver_parse_params(ctx, REQUEST_GET, iter))
 		{
 			os_printf("webserver: Can't parse params: %s\n", iter);
@@ -680,17 +889,29 @@ static err_t http_perform_request(struct http_ctx* ctx)
 	err_t code = ERR_OK;
 	if(ctx != NULL && ctx->receive_buffer != NULL)
 	{
-		os_printf("http_perform_request: data: %s\n", ctx->receive_buffer);
+		os_printf("http_perform_request: data: %s\n", ctx->receive_buffer + ctx->request_start);
 		if(!webserver_parse_request(ctx))
 		{
 			query_response_status(500, ctx->query);
 		}
 		else
 		{
-			const struct http_handler_rule *handler = get_handler(ctx->query);
-			if(handler != NULL && handler->handler != NULL)
+			const struct http_handler_rule *handler = NULL;
+			HTTP_ROUTE_RESULT result = HTTP_ROUTE_NOT_FOUND;
+			if(!get_handler(ctx->query, &handler, &result))
+			{
+				query_response_status(500, ctx->query);
+			}
+			else if(result == HTTP_ROUTE_FOUND)
 			{	
+				handler_task = xTaskGetCurrentTaskHandle();
+				handler_arena = &ctx->arena;
 				code = handler->handler(ctx->query) ? ERR_OK : ERR_INPROGRESS;
+				handler_arena = NULL;
+			}
+			else if(result == HTTP_ROUTE_METHOD_NOT_ALLOWED)
+			{	// uri известен, метод нет
+				query_response_status(405, ctx->query);
 			}
 			else
 			{	// не найден обработчик
@@ -711,37 +932,117 @@ static err_t http_perform_request(struct http_ctx* ctx)
 	return code;
 }
 
-static uint32_t http_send_data(struct http_ctx* ctx)
+/**
+ * @brief Функция перехода в новое состояние, poll отсчитывает таймаут от перехода
+ */
+static void http_set_state(struct http_ctx* ctx, enum http_ctx_state state)
 {
-	if(ctx == NULL)
+	ctx->state = state;
+	ctx->retries = 0;
+}
+
+/**
+ * @brief Соединение сохранено после ответа и ждет следующий запрос
+ */
+static bool http_ctx_idle(const struct http_ctx* ctx)
+{
+	return ctx->state == HTTP_CTX_READING && ctx->requests != 0 && ctx->request_start == (uint32_t) ctx->receive_buffer_size;
+}
+
+/**
+ * @brief Функция копирования принятых данных в конец буфера
+ *
+ * Следующие запросы разбираются на месте, начало неразобранных данных
+ * сдвигается в начало буфера только если не хватает места.
+ * Вызывается только в HTTP_CTX_READING, query ссылается на буфер.
+ *
+ * @return false если данные не помещаются в буфер
+ */
+static bool http_receive(struct http_ctx* ctx, struct pbuf* p)
+{
+	uint32_t length = p->tot_len;
+	if(ctx->receive_buffer_size + length > RECV_BUF_SIZE - 1 && ctx->request_start != 0)
 	{
-		os_printf("http_send_data: ctx is null\n");
-		return 0;
+		ctx->receive_buffer_size -= ctx->request_start;
+		memmove(ctx->receive_buffer, ctx->receive_buffer + ctx->request_start, ctx->receive_buffer_size);
+		ctx->request_start = 0;
 	}
 
-	if(ctx->query == NULL)
+	// последний байт буфера резервируется под завершающий ноль
+	bool fits = ctx->receive_buffer_size + length <= RECV_BUF_SIZE - 1;
+	if(fits)
+	{	// копирование всей цепочки сегментов в конец уже принятых данных
+		ctx->receive_buffer_size += pbuf_copy_partial(p, ctx->receive_buffer + ctx->receive_buffer_size, length, 0);
+		ctx->receive_buffer[ctx->receive_buffer_size] = '\0';
+	}
+	else
 	{
-		os_printf("http_send_data: query is null\n");
-		return 0;
+		os_printf("http_receive: received data so big, total_len: %d, buffer_size: %d\n", ctx->receive_buffer_size + length, RECV_BUF_SIZE);
+	}
+
+	tcp_recved(ctx->pcb, length);
+	pbuf_free(p);
+	return fits;
+}
+
+/**
+ * @brief Функция разбора данных текущего запроса
+ * @return false если запрос принят не целиком либо соединение закрыто
+ */
+static bool http_read_request(struct http_ctx* ctx)
+{
+	char* request = ctx->receive_buffer + ctx->request_start;
+	HTTP_PARSE_RESULT parsed = http_parser_execute(&ctx->parser, request, ctx->receive_buffer_size - ctx->request_start);
+	if(parsed == HTTP_PARSE_NEED_MORE)
+	{
+		os_printf("http_read_request: request incomplete, received: %d\n", ctx->receive_buffer_size - ctx->request_start);
+		return false;
 	}
 
+	if((ctx->query = init_query(ctx)) == NULL)
+	{
+		os_printf("http_read_request: init_query failed\n");
+		http_close_conn(ctx->pcb, ctx);
+		return false;
+	}
+
+	if(parsed == HTTP_PARSE_FAILED)
+	{	// границу следующего запроса найти нельзя, соединение закрывается после ответа
+		os_printf("http_read_request: rejected request at offset %d, status %d\n", ctx->parser.offset, ctx->parser.error_status);
+		query_response_status(ctx->parser.error_status, ctx->query);
+		query_done(ctx->query);
+		http_set_state(ctx, HTTP_CTX_SENDING);
+		return true;
+	}
+
+	ctx->query->keep_alive = http_parser_keep_alive(&ctx->parser) && ctx->requests + 1 < HTTPD_KEEP_ALIVE_MAX;
+	ctx->query->chunked = ctx->parser.version_minor >= 1;
+	ctx->request_next = request[http_parser_message_size(&ctx->parser)];
+	http_set_state(ctx, HTTP_CTX_DISPATCH);
+	return true;
+}
+
+/**
+ * @brief Функция передачи очередной части ответа в tcp_write, размером не больше tcp_sndbuf
+ * Данные копируются в сегменты lwIP: до подтверждения отправленного response_body
+ * переиспользуется следующей частью потокового ответа и следующим запросом,
+ * а слот после закрытия уходит другому соединению
+ * @return кол-во переданных байт
+ */
+static uint32_t http_send_data(struct http_ctx* ctx)
+{
 	uint32_t left_data = ctx->query->response_body_length - ctx->query->response_body_offset;
 	os_printf("http_send_data: pcb=%p hs=%p size=%d left=%d offset=%d\n", 
 			(void*)ctx->pcb, (void*)ctx, ctx->query->response_body_length, left_data, ctx->query->response_body_offset);
 
-	uint32_t buffer_size = tcp_sndbuf(ctx->pcb) > left_data ? left_data : buffer_size;
-	/*uint32_t buffer_size = tcp_sndbuf(ctx->pcb);*/
+	uint32_t buffer_size = tcp_sndbuf(ctx->pcb) > left_data ? left_data : tcp_sndbuf(ctx->pcb);
 
 	os_printf("http_send_data: snd_buff: %d, buff_selected: %d, delta: %d\n", tcp_sndbuf(ctx->pcb), buffer_size, tcp_sndbuf(ctx->pcb) - buffer_size);
 
-	err_t code = tcp_write(ctx->pcb, (const void*)(ctx->query->response_body + ctx->query->response_body_offset), buffer_size, 0);
+	err_t code = tcp_write(ctx->pcb, (const void*)(ctx->query->response_body + ctx->query->response_body_offset), buffer_size, TCP_WRITE_FLAG_COPY);
 	if(code == ERR_OK)
 	{
 		ctx->query->response_body_offset += buffer_size;
-		if(ctx->query->response_body_offset >= ctx->query->response_body_length)
-		{
-			http_close_conn(ctx->pcb, ctx);
-		}
 	}
 	else
 	{
@@ -750,6 +1051,204 @@ static uint32_t http_send_data(struct http_ctx* ctx)
 	return buffer_size;
 }
 
+/**
+ * @brief Функция записи следующей части потокового ответа в response_body
+ *
+ * Часть не больше tcp_sndbuf, поэтому уходит одним tcp_write, а stream вызывается
+ * снова только после подтверждения (sent). Размер части записывается перед
+ * данными в зарезервированное место, данные не сдвигаются.
+ *
+ * @return false если места в tcp_sndbuf нет либо stream не записал данных
+ */
+static bool http_stream_next(struct http_ctx* ctx)
+{
+	struct query* query = ctx->query;
+	uint32_t room = tcp_sndbuf(ctx->pcb) < SEND_BUF_SIZE ? tcp_sndbuf(ctx->pcb) : SEND_BUF_SIZE;
+	if(room < HTTP_CHUNK_MIN_SIZE)
+	{
+		return false;
+	}
+
+	uint32_t header = query->chunked ? HTTP_CHUNK_HEADER_SIZE : 0;
+	query->response_body_offset = header;
+	query->response_body_length = header;
+	query->stream_limit = room - (query->chunked ? HTTP_CHUNK_TRAILER_SIZE : 0);
+
+	handler_task = xTaskGetCurrentTaskHandle();
+	handler_arena = &ctx->arena;
+	bool finished = query->stream(query, query->stream_data) != 0;
+	handler_arena = NULL;
+	query->stream_limit = 0;
+
+	if(finished)
+	{
+		query->stream = NULL;
+	}
+
+	uint32_t size = query->response_body_length - header;
+	if(query->chunked && size != 0)
+	{
+		char buff[sizeof("ffffffff\r\n")];	// размер по типу size, фактически не больше HTTP_CHUNK_HEADER_SIZE
+		int32_t length = sprintf(buff, "%x\r\n", size);
+		query->response_body_offset = header - length;
+		memcpy(query->response_body + query->response_body_offset, buff, length);
+		memcpy(query->response_body + query->response_body_length, "\r\n", STATIC_STRLEN("\r\n"));
+		query->response_body_length += STATIC_STRLEN("\r\n");
+	}
+
+	if(query->chunked && finished)
+	{
+		memcpy(query->response_body + query->response_body_length, "0\r\n\r\n", STATIC_STRLEN("0\r\n\r\n"));
+		query->response_body_length += STATIC_STRLEN("0\r\n\r\n");
+	}
+	return size != 0 || finished;
+}
+
+/**
+ * @brief Функция перехода к следующему запросу сохраненного соединения
+ * Память запроса освобождается сбросом арены, следующий запрос разбирается с места окончания текущего
+ * @return false если соединение закрыто
+ */
+static bool http_next_request(struct http_ctx* ctx)
+{
+	if(ctx->query->after_response != NULL)
+	{
+		ctx->query->after_response(ctx->query, ctx->query->user_data);
+	}
+
+	uint32_t end = ctx->request_start + http_parser_message_size(&ctx->parser);
+	ctx->receive_buffer[end] = ctx->request_next;
+	if(end == (uint32_t) ctx->receive_buffer_size)
+	{
+		ctx->receive_buffer_size = 0;
+		end = 0;
+	}
+	ctx->request_start = end;
+
+	++ctx->requests;
+	ctx->query = NULL;
+	http_arena_reset(&ctx->arena);
+	http_parser_init(&ctx->parser);
+	http_set_state(ctx, HTTP_CTX_READING);
+
+	if(ctx->pending != NULL)
+	{
+		struct pbuf* p = ctx->pending;
+		ctx->pending = NULL;
+		if(!http_receive(ctx, p))
+		{
+			http_close_conn(ctx->pcb, ctx);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Функция продвижения соединения по состояниям до ожидания события
+ *
+ * Все переходы выполняются в потоке LwIP из recv, sent и poll. Синхронный обработчик
+ * выполняется сразу и ответ уходит без ожидания poll, асинхронный (вернул 0) не
+ * блокирует другие соединения: готовность query_done проверяется в poll.
+ * Запросы из одного буфера (pipelining) обрабатываются в цикле без рекурсии.
+ * После закрытия ctx недействителен, функция сразу возвращается.
+ */
+static void http_advance(struct http_ctx* ctx)
+{
+	while(true)
+	{
+		switch(ctx->state)
+		{
+			case HTTP_CTX_READING:
+				if(ctx->request_start == (uint32_t) ctx->receive_buffer_size)
+				{
+					if(ctx->remote_closed)
+					{
+						http_close_conn(ctx->pcb, ctx);
+					}
+					return;
+				}
+
+				if(!http_read_request(ctx))
+				{
+					return;
+				}
+				break;
+
+			case HTTP_CTX_DISPATCH:
+				http_perform_request(ctx);
+				http_set_state(ctx, ctx->query->done ? HTTP_CTX_SENDING : HTTP_CTX_ASYNC_WAIT);
+				break;
+
+			case HTTP_CTX_ASYNC_WAIT:
+				if(!ctx->query->done)
+				{
+					return;
+				}
+				http_set_state(ctx, HTTP_CTX_SENDING);
+				break;
+
+			case HTTP_CTX_SENDING:
+				if(ctx->query->response_body_offset < ctx->query->response_body_length)
+				{
+					if(http_send_data(ctx) == 0)
+					{	// tcp_sndbuf заполнен, продолжение в sent либо poll
+						return;
+					}
+					tcp_output(ctx->pcb);
+
+					if(ctx->query->response_body_offset < ctx->query->response_body_length)
+					{
+						return;
+					}
+				}
+
+				if(ctx->query->stream != NULL)
+				{	// следующая часть после освобождения tcp_sndbuf, stream ждет в sent либо poll
+					if(!http_stream_next(ctx))
+					{
+						return;
+					}
+					break;
+				}
+
+				if(!ctx->query->keep_alive)
+				{
+					http_set_state(ctx, HTTP_CTX_CLOSING);
+					http_close_conn(ctx->pcb, ctx);
+					return;
+				}
+
+				if(!http_next_request(ctx))
+				{
+					return;
+				}
+				break;
+
+			case HTTP_CTX_CLOSING:
+			default:
+				return;
+		}
+	}
+}
+
+/**
+ * @brief Функция закрытия сохраненного соединения без запроса для освобождения слота
+ */
+static void http_evict_idle()
+{
+	for(uint32_t i = 0; i < CONNECTION_POOL_SIZE; ++i)
+	{
+		struct http_ctx* ctx = (struct http_ctx*)(ctx_pool + HTTP_CTX_SLOT_SIZE * i);
+		if(ctx->pcb != NULL && http_ctx_idle(ctx))
+		{
+			os_printf("http_evict_idle: close idle %p\n", (void*)ctx->pcb);
+			http_close_conn(ctx->pcb, ctx);
+			return;
+		}
+	}
+}
+
 static err_t asio_http_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
 {
 	struct http_ctx* ctx = (struct http_ctx*) arg;
@@ -762,8 +1261,12 @@ static err_t asio_http_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
 		return ERR_OK;
 	}
 
-	ctx->retries = 0;
-	http_send_data(ctx);
+	// подтверждение прошлого ответа может прийти во время обработки следующего запроса
+	if(ctx->state == HTTP_CTX_SENDING)
+	{
+		ctx->retries = 0;
+		http_advance(ctx);
+	}
 
 	return ERR_OK;
 }
@@ -775,8 +1278,13 @@ static void asio_http_err(void *arg, err_t err)
 
 	os_printf("http_err: %s", lwip_strerr(err));
 
+	// pcb уже освобожден lwIP, обработчик ответа получает шанс освободить свои данные как при закрытии
 	if (ctx != NULL) 
 	{
+		if(ctx->query != NULL && ctx->query->after_response != NULL)
+		{
+			ctx->query->after_response(ctx->query, ctx->query->user_data);
+		}
 		free_ctx(ctx);
 	}
 }
@@ -805,37 +1313,25 @@ static err_t asio_http_poll(void *arg, struct tcp_pcb *pcb)
 		}
 		return ERR_OK;
 	} 
-	else 
+
+	// сохраненное соединение без запроса ограничено своим таймаутом
+	bool idle = http_ctx_idle(ctx);
+	ctx->retries++;
+	if (ctx->retries >= (idle ? HTTPD_KEEP_ALIVE_TIMEOUT : HTTPD_MAX_RETRIES)) 
 	{
-		ctx->retries++;
-		if (ctx->retries == HTTPD_MAX_RETRIES) 
-		{
-			os_printf("asio_http_poll: too many retries, close\n");
-			http_close_conn(pcb, ctx);
-			return ERR_OK;
-		}
+		os_printf("asio_http_poll: %s in state %d, close\n", idle ? "keep-alive timeout" : "too many retries", ctx->state);
+		http_close_conn(pcb, ctx);
+		return ERR_OK;
 	}
 
-	/* If this connection has a file open, try to send some more data. If
-	* it has not yet received a GET request, don't do this since it will
-	* cause the connection to close immediately. */
-	if(ctx && ctx->query != NULL && ctx->query->done) 
+	// готовность асинхронного ответа и продолжение отправки
+	if(ctx->state == HTTP_CTX_ASYNC_WAIT || ctx->state == HTTP_CTX_SENDING) 
 	{
-		os_printf("asio_http_poll: try to send more data\n");
-		if(http_send_data(ctx)) 
-		{
-			/* If we wrote anything to be sent, go ahead and send it now. */
-			os_printf("tcp_output\n");
-			tcp_output(pcb);
-		}
+		http_advance(ctx);
 	}
 	return ERR_OK;
 }
 
-/**
- * @todo Реализовать чтение данных в несколько этапов. В данный момент данные читаются одним куском,
- * но LwIP не всегда дает все данные в буфере
- */
 static err_t asio_http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 {
 	struct http_ctx* ctx = (struct http_ctx*) arg;
@@ -843,6 +1339,13 @@ static err_t asio_http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_
 	os_printf("asio_http_recv: pcb=%p pbuf=%p err=%s len=%d tot_len=%d\n", 
 				(void*)pcb, (void*)p, lwip_strerr(err), (p!=NULL ? p->len : 0), (p!=NULL ? p->tot_len : 0));
 
+	if(err == ERR_OK && p == NULL && ctx != NULL && ctx->state != HTTP_CTX_READING)
+	{	// клиент отправил запросы и закрыл передачу (half-close), ответы еще нужно отправить
+		os_printf("asio_http_recv: remote closed, finish %d requests\n", ctx->pending != NULL ? 2 : 1);
+		ctx->remote_closed = true;
+		return ERR_OK;
+	}
+
 	if ((err != ERR_OK) || (p == NULL) || (ctx == NULL)) 
 	{
 		/* error or closed by other side? */
@@ -862,55 +1365,60 @@ static err_t asio_http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_
 		return ERR_OK;
 	}
 
-	if(p->tot_len > RECV_BUF_SIZE)
-	{
-		os_printf("asio_http_recv: received data so big, total_len: %d, buffer_size: %d\n", p->tot_len, RECV_BUF_SIZE);
-		tcp_recved(pcb, p->tot_len);
-		pbuf_free(p);
-		http_close_conn(pcb, ctx);
+	if(ctx->state != HTTP_CTX_READING)
+	{	// следующий запрос (pipelining) копируется в буфер после отправки текущего ответа
+		if(ctx->pending != NULL)
+		{
+			os_printf("asio_http_recv: received data while request perform\n");
+			return ERR_USE;
+		}
+		ctx->pending = p;
 		return ERR_OK;
 	}
 
-	if (p->len != p->tot_len) 
+	if(!http_receive(ctx, p))
 	{
-		os_printf("Warning: incomplete header due to chained pbufs\n");
+		http_close_conn(pcb, ctx);
+		return ERR_OK;
 	}
+	http_advance(ctx);
+	return ERR_OK;
+}
 
-	if(ctx->query != NULL)
+/**
+ * @brief Функция приема данных соединения без слота пула
+ *
+ * Данные запроса отбрасываются, на первую порцию отправляется 503 и соединение закрывается.
+ * Закрытие до прихода запроса сбросило бы соединение (RST) вместе с ответом,
+ * поэтому без данных соединение закрывается только по истечении времени на запрос.
+ */
+static err_t asio_http_unavailable_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+	LWIP_UNUSED_ARG(arg);
+
+	if(p != NULL)
 	{
-		os_printf("asio_http_recv: received data while request perform\n");
-		return ERR_USE;
+		tcp_recved(pcb, p->tot_len);
+		pbuf_free(p);
 	}
 
-	if((ctx->query = init_query()) == NULL)
+	if(err == ERR_OK && p != NULL)
 	{
-		os_printf("asio_http_recv: init_query failed\n");
-		return ERR_MEM;
+		tcp_write(pcb, http_response_unavailable, STATIC_STRLEN(http_response_unavailable), 0);
 	}
+	http_close_conn(pcb, NULL);
+	return ERR_OK;
+}
 
-	// копирование данных для парсинга
-	memcpy(ctx->receive_buffer, p->payload, p->len);
-	ctx->receive_buffer_size = p->len;
-	ctx->pcb = pcb;
-
-	/**
-	 * @todo Избавиться от очереди для экономии памяти, 
-	 * всю логику по управленю соеденением реализовать в asio_http_poll в виде конечного автомата
-	 */
-	uintptr_t item = (uintptr_t)ctx;
-	if(!xQueueSend(socket_queue, &item, STOP_TIMER / portTICK_RATE_MS))
-	{
-		os_printf("webserver: can't push client ctx to queue\n");
+static err_t asio_http_unavailable_poll(void *arg, struct tcp_pcb *pcb)
+{
+	LWIP_UNUSED_ARG(arg);
 
-		tcp_recved(pcb, p->tot_len);
-		pbuf_free(p);
-		http_close_conn(pcb, ctx);
-	}
-	else
+	os_printf("asio_http_unavailable_poll: request timeout, close %p\n", (void*)pcb);
+	if(http_close_conn(pcb, NULL) == ERR_MEM)
 	{
-		os_printf("asio_http_recv: pcb tcp_recved\n");
-		tcp_recved(pcb, p->tot_len);
-		pbuf_free(p);
+		tcp_abort(pcb);
+		return ERR_ABRT;
 	}
 	return ERR_OK;
 }
@@ -928,15 +1436,24 @@ static err_t asio_http_accept(void *arg, struct tcp_pcb *pcb, err_t err)
 
 	/* Allocate memory for the structure that holds the state of the
 	connection - initialized by that function. */
+	if(ctx_pool_free == NULL)
+	{
+		http_evict_idle();
+	}
+
 	struct http_ctx* ctx = init_ctx();
 	if (ctx == NULL) 
-	{
-		os_printf("http_accept: Out of memory, RST\n");
-		return ERR_MEM;
+	{	// запрос дочитывается без слота, ответ 503 вместо RST
+		os_printf("http_accept: connection pool exhausted, 503\n");
+		tcp_arg(pcb, NULL);
+		tcp_recv(pcb, asio_http_unavailable_recv);
+		tcp_poll(pcb, asio_http_unavailable_poll, HTTPD_POLL_INTERVAL * HTTPD_MAX_RETRIES);
+		return ERR_OK;
 	}
 
 	/* Tell TCP that this is the structure we wish to be passed for our
 	callbacks. */
+	ctx->pcb = pcb;
 	tcp_arg(pcb, ctx);
 
 	/* Set up the various callback functions */
@@ -966,82 +1483,33 @@ static void asio_init_ctx(ip_addr_t *local_addr)
 	tcp_accept(listen_pcb, asio_http_accept);
 }
 
-static bool check_stop_condition(xQueueHandle *queue)
+void asio_webserver_start(struct http_handler_rule* user_handlers)
 {
-	bool result = true;
-	if(queue != NULL)
-	{
-		portBASE_TYPE xStatus = xQueueReceive(*queue, &result, 0);
-		if (pdPASS == xStatus && result == TRUE)
-		{
-			result = true;
-		}
-		else
-		{
-			result = false;
-		}
-	}
-	else
-	{
-		os_printf("webserver: check_stop_condition invalid pointer\n");
-	}
-	return result;
+	asio_webserver_start_table(user_handlers, NULL);
 }
 
-static void webserver_client_task(void *pvParameters)
+void asio_webserver_start_table(struct http_handler_rule* user_handlers, const struct http_route_table* table)
 {
-	while(true)
+	if(handlers == NULL)
 	{
-		// checking stop flag
-		if(check_stop_condition(&webserver_client_task_stop))
+		bool complete = false;
+		if(table != NULL && !http_route_table_check(table, user_handlers, &complete))
 		{
-			os_printf("webserver: webserver_client_task rcv exit signal!\n");
-			break;
+			os_printf("asio_webserver: route table does not match handlers, regenerate it\n");
+			table = NULL;
+			complete = false;
 		}
 
-		uintptr_t item = 0;
-		if(!xQueueReceive(socket_queue, &item, STOP_TIMER / portTICK_RATE_MS))
-		{
-			taskYIELD();
-		}
-		else
+		if(complete || http_router_init(&router, user_handlers))
 		{
-			struct http_ctx* ctx = (struct http_ctx*) item;
-
-			os_printf("webserver: ctx ptr: %p\n", (void*)ctx);
-			if(ctx != NULL)
-			{
-				http_perform_request(ctx);
-			}
+			handlers = user_handlers;
+			route_table = table;
 		}
 	}
-    vQueueDelete(webserver_client_task_stop);
-    webserver_client_task_stop = NULL;
-    vTaskDelete(NULL);
-}
-
-
-void asio_webserver_start(struct http_handler_rule* user_handlers)
-{
-	if(handlers == NULL)
-	{
-		handlers = user_handlers;
-	}
-
-    if(webserver_client_task_stop == NULL)
-	{
-        webserver_client_task_stop = xQueueCreate(1, sizeof(bool));
-	}
-
-	if(socket_queue == NULL)
-	{
-		socket_queue = xQueueCreate(CONNECTION_POOL_SIZE, sizeof(uintptr_t));
-	}
 
-	if(listen_pcb == NULL)
+	if(listen_pcb == NULL && handlers != NULL && init_ctx_pool())
 	{
 		asio_init_ctx(IP_ADDR_ANY);
-		xTaskCreate(webserver_client_task, "webserver_client", WEB_HANLDERS_STACK_SIZE, NULL, WEB_HANLDERS_PRIO, NULL);
 	}
 }
 
@@ -1051,7 +1519,9 @@ int8_t asio_webserver_stop(void)
 	{
 		tcp_accept(listen_pcb, NULL);
 		tcp_close(listen_pcb);
+		listen_pcb = NULL;
 	}
+	return 0;
 }
 
 /**
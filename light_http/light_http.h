@@ -6,6 +6,10 @@
 #include "user_light_http_config.h"
 #include "light_http_config.h"
 
+#if defined __cplusplus
+extern "C" {
+#endif
+
 /**
  * @defgroup light_http 
  * @brief HTTP сервер
@@ -26,8 +30,17 @@ struct query;
  * 1 - синхронный ответ
  * 0 - асинхронный ответ
  *
- * Синхроннвый ответ - запрос помечается как обработанный и при первем же
- * вызове poll, данные будут отправленны, а соеденение закрыто
+ * Обработчик вызывается в потоке LwIP сразу после приема запроса и не должен
+ * блокироваться, долгие операции выполняются асинхронно.
+ *
+ * @warning На время синхронного обработчика останавливается весь LwIP: прием и
+ * подтверждения на всех соединениях. Обработчики прошивки /setWifi и /setDeviceName
+ * пишут flash прямо в этом потоке (десятки мс на стирание сектора), это допустимо
+ * только для редких запросов настройки. Частые или долгие записи нужно переносить
+ * в отдельную задачу и отвечать асинхронно через query_done.
+ *
+ * Синхроннвый ответ - запрос помечается как обработанный и данные
+ * отправляются сразу после возврата из обработчика
  *
  * Асинхроннвый ответ - запрос остается в работе и
  * в каждом вызове poll проверяется его завершенность,
@@ -39,6 +52,18 @@ struct query;
  */
 typedef int (* cgi_handler)(struct query *query);
 
+/**
+ * @brief Сигнатура функции потоковой записи тела ответа
+ *
+ * Вызывается в потоке LwIP каждый раз, когда в tcp_sndbuf освобождается место,
+ * и пишет очередную часть тела через query_response_write. Позицию в данных
+ * функция хранит сама в user_data: query_response_write принимает не больше
+ * свободного места.
+ *
+ * @return 1 - тело записано целиком, 0 - продолжить после подтверждения отправленных данных
+ */
+typedef int (* stream_handler)(struct query *query, void* user_data);
+
 /**
  * @brief Сигнатура callback вызываемого перед разрушением query
  */
@@ -46,13 +71,48 @@ typedef void (* response_done_callback)(struct query *query, void* user_data);
 
 /**
  * @brief Правило обработки урла
- * @note В данный момент точное совпадение path (strcmp)
- * @todo Добавить маски в uri
+ *
+ * Шаблон uri состоит из сегментов:
+ * - статический текст, совпадает точно: "/status"
+ * - параметр ':name' на весь сегмент до '/': "/device/:id/on", см. query_get_path_param
+ * - '*' последним сегментом, совпадает с остатком пути, например /static/ и '*' за ним; значение доступно по имени "*"
+ *
+ * Поиск выполняется по дереву, построенному при старте сервера. Статический сегмент
+ * приоритетнее параметра, параметр приоритетнее '*', при равных шаблонах выбирается
+ * правило объявленное раньше.
  */
 struct http_handler_rule
 {
 	const char* uri;		///< url для обработки 
 	cgi_handler handler;	///< функция для обработки запроса
+	uint8_t methods;		///< маска HTTP_METHOD_*, HTTP_METHOD_ANY - любой метод, иначе на другие методы ответ 405
+};
+
+/**
+ * @brief Маски методов для http_handler_rule
+ */
+#define HTTP_METHOD_ANY 0
+#define HTTP_METHOD_GET (1 << REQUEST_GET)
+#define HTTP_METHOD_POST (1 << REQUEST_POST)
+
+/**
+ * @brief Индекс отсутствующего узла или правила
+ */
+#define HTTP_ROUTE_NONE 0xFFFF
+
+/**
+ * @brief Таблица точных uri с идеальным хешем, генерируется http_route_gen по списку правил
+ *
+ * Для uri без ':' и '*' поиск обработчика сводится к одному хешу http_route_hash
+ * и одному сравнению строк. Все поля 32 битные: таблица лежит во flash (ICACHE_RODATA_ATTR),
+ * откуда ESP8266 читает только выровненные слова.
+ */
+struct http_route_table
+{
+	uint32_t seed;			///< начальное значение хеша, подобрано генератором
+	uint32_t mask;			///< размер таблицы - 1, размер степень двойки
+	uint32_t count;			///< кол-во правил в таблице
+	const uint32_t* slots;	///< номер правила в списке обработчиков, HTTP_ROUTE_NONE - пусто
 };
 
 /**
@@ -86,6 +146,13 @@ REQUEST_METHOD query_get_method(struct query* query);
  */
 const char* query_get_param(const char* name, struct query* query, REQUEST_METHOD m);
 
+/**
+ * @brief Метод для получения параметра пути из шаблона правила
+ * @param[in] name Имя параметра без ':', "*" для остатка пути
+ * @param[in] query Указатель на запрос
+ */
+const char* query_get_path_param(const char* name, struct query* query);
+
 /**
  * @brief Метод для получения параметров запроса
  * @param[in] query Указатель на запрос
@@ -94,6 +161,7 @@ const char* query_get_uri(struct query* query);
 
 /**
  * @brief Метод для отправки статуса ответа
+ * Заголовок Connection добавляется в начале тела, когда режим соединения уже известен
  * @param[in] status Статус ответа
  * @param[in] query Указатель на запрос
  */
@@ -108,12 +176,40 @@ void query_response_header(const char* name, const char* value, struct query* qu
 
 /**
  * @brief Метод для отправки тела ответа
+ * Если ответ не помещается в SEND_BUF_SIZE, он заменяется на 500 с закрытием соединения,
+ * большие тела отдаются через query_response_stream
  * @param[in] data Тело ответа
  * @param[in] length Размер тела
  * @param[in] query Указатель на запрос
  */
 void query_response_body(const char* data, int32_t length, struct query* query);
 
+/**
+ * @brief Метод для потоковой отправки тела ответа
+ *
+ * Вызывается вместо query_response_body после статуса и заголовков. Тело
+ * передается частями по Transfer-Encoding: chunked, каждая часть не больше
+ * tcp_sndbuf и SEND_BUF_SIZE, поэтому память не зависит от размера ответа.
+ * Клиенту HTTP/1.0 тело передается без разметки и соединение закрывается.
+ * Если handler долго не пишет данные, соединение закрывается по HTTPD_MAX_RETRIES.
+ * Освобождать user_data следует в query_register_after_response: соединение
+ * может закрыться до завершения записи.
+ *
+ * @param[in] handler Функция записи частей тела
+ * @param[in] user_data Указатель на пользовательские данные
+ * @param[in] query Указатель на запрос
+ */
+void query_response_stream(stream_handler handler, void* user_data, struct query* query);
+
+/**
+ * @brief Метод для записи части тела из stream_handler
+ * @param[in] data Данные
+ * @param[in] length Размер данных
+ * @param[in] query Указатель на запрос
+ * @return Кол-во принятых байт, меньше length если место в текущей части закончилось
+ */
+uint32_t query_response_write(const char* data, uint32_t length, struct query* query);
+
 /**
  * @brief Функция помечает запрос как обработанный
  *
@@ -131,12 +227,47 @@ void query_done(struct query* query);
  */
 void query_register_after_response(struct query* query, response_done_callback callback, void* user_data);
 
+/**
+ * @brief Функция выделения памяти из арены запроса
+ *
+ * Память действительна до закрытия соединения и освобождается вместе с ним,
+ * free для нее не вызывается.
+ *
+ * @param[in] query Указатель на запрос
+ * @param[in] size Размер блока
+ * @return NULL если арена исчерпана
+ */
+void* query_alloc(struct query* query, uint32_t size);
+
+/**
+ * @brief Функции выделения памяти для cJSON_InitHooks
+ *
+ * Во время вызова обработчика в задаче сервера память выделяется из арены
+ * обрабатываемого запроса, в остальных случаях и при нехватке арены из кучи.
+ * Блоки арены не должны переживать обработчик: объекты cJSON создаются,
+ * печатаются и удаляются в нем же.
+ */
+void* light_http_malloc(size_t size);
+void light_http_free(void* ptr);
+
 /**
  * @brief Метод для запуска сервера
  * @param handlers Список обработчиков
  */
 void asio_webserver_start(struct http_handler_rule *handlers);
 
+/**
+ * @brief Метод для запуска сервера с таблицей точных uri
+ *
+ * Таблица проверяется при старте, устаревшая (список правил изменен без
+ * повторной генерации) игнорируется. Если таблица покрывает все правила,
+ * дерево маршрутов не строится и память под него не выделяется.
+ *
+ * @param handlers Список обработчиков
+ * @param table Таблица, сгенерированная по этому же списку
+ */
+void asio_webserver_start_table(struct http_handler_rule *handlers, const struct http_route_table* table);
+
 /**
  * @brief Метод для остановки http сервера
  */
@@ -146,5 +277,8 @@ int8_t asio_webserver_stop(void);
  * @}
  */
 
+#if defined __cplusplus
+}
+#endif
 
 #endif
@@ -9,13 +9,6 @@
  * @{
  */
 
-/**
- * @brief Время на обработку запроса millisecond
- */
-#ifndef STOP_TIMER
-	#define STOP_TIMER 10000
-#endif
-
 /**
  * @brief Размер буфера приемки
  */
@@ -30,6 +23,20 @@
 	#define SEND_BUF_SIZE 2048
 #endif
 
+/**
+ * @brief Размер арены запроса: query, буфер ответа, заголовки, параметры и узлы cJSON обработчиков
+ */
+#ifndef HTTP_ARENA_SIZE
+	#define HTTP_ARENA_SIZE (SEND_BUF_SIZE + 1024)
+#endif
+
+/**
+ * @brief Максимальное кол-во параметров пути (':name' и '*') в шаблоне правила
+ */
+#ifndef HTTP_ROUTER_MAX_PARAMS
+	#define HTTP_ROUTER_MAX_PARAMS 4
+#endif
+
 /**
  * @brief размер буфера для рендера частей ответа сервера
  */
@@ -59,6 +66,21 @@
 	#define HTTPD_MAX_RETRIES 15
 #endif
 
+/**
+ * @brief Количество вызовов poll без запроса,
+ * после которого сохраненное (keep-alive) соединение закрывается
+ */
+#ifndef HTTPD_KEEP_ALIVE_TIMEOUT
+	#define HTTPD_KEEP_ALIVE_TIMEOUT 10
+#endif
+
+/**
+ * @brief Максимальное количество запросов в одном соединении
+ */
+#ifndef HTTPD_KEEP_ALIVE_MAX
+	#define HTTPD_KEEP_ALIVE_MAX 100
+#endif
+
 /**
  * @brief Таймаут между вызовами pool
  * общая задержка X*500ms
@@ -77,21 +99,6 @@
 	#define HTTPD_TCP_PRIO TCP_PRIO_MIN
 #endif
 
-/**
- * @brief Размер стека таска выполняющего пользовательские обработчики
- */
-#ifndef WEB_HANLDERS_STACK_SIZE 
-	#define WEB_HANLDERS_STACK_SIZE (SEND_BUF_SIZE + RECV_BUF_SIZE + 2 * 1024) / 4
-#endif
-
-/**
- * @brief Приоритет таска выполнающим пользовательские обработчики
- *
- */
-#ifndef WEB_HANLDERS_PRIO 
-	#define WEB_HANLDERS_PRIO HTTPD_TCP_PRIO
-#endif
-
 /**
  * @}
  */
@@ -0,0 +1,69 @@
+#ifndef __ESP_COMMON_H__
+#define __ESP_COMMON_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @brief Сборка light_http для PC
+ *
+ * Заголовки каталога sdk заменяют ESP8266 RTOS SDK ровно в том объеме,
+ * который использует light_http, код сервера собирается без изменений.
+ *
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+#ifndef TRUE
+	#define TRUE 1
+#endif
+
+#ifndef FALSE
+	#define FALSE 0
+#endif
+
+/**
+ * @brief Атрибуты размещения кода и данных во flash, на PC не нужны
+ */
+#define ICACHE_FLASH_ATTR
+#define ICACHE_RODATA_ATTR
+
+/**
+ * @brief Функция вывода логов light_http для PC
+ * В отличии от printf может быть отключена, например при замерах
+ */
+int light_http_stub_log(const char* format, ...);
+
+/**
+ * @brief Функция включения/отключения логов
+ */
+void light_http_stub_log_enable(int enable);
+
+#define os_printf light_http_stub_log
+
+/**
+ * @brief Выделение обнуленной памяти как в SDK
+ */
+static inline void* zalloc(size_t size)
+{
+	return calloc(1, size);
+}
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
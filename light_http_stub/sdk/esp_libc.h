@@ -0,0 +1,6 @@
+#ifndef __ESP_LIBC_H__
+#define __ESP_LIBC_H__
+
+#include "esp_common.h"
+
+#endif
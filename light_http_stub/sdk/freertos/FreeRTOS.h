@@ -0,0 +1,49 @@
+#ifndef __FREERTOS_H__
+#define __FREERTOS_H__
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+typedef long portBASE_TYPE;
+typedef unsigned long portTickType;
+
+/**
+ * @brief Длительность тика в ms, как на ESP8266 (configTICK_RATE_HZ 100)
+ */
+#define portTICK_RATE_MS 10
+
+#define portMAX_DELAY ((portTickType) 0xFFFFFFFF)
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+/**
+ * @brief Очередь (реализация на pthread, freertos_shim.cpp)
+ */
+typedef struct freertos_queue* xQueueHandle;
+
+/**
+ * @brief Задача (поток pthread)
+ */
+typedef struct freertos_task* xTaskHandle;
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
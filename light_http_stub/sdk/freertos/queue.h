@@ -0,0 +1,55 @@
+#ifndef __FREERTOS_QUEUE_H__
+#define __FREERTOS_QUEUE_H__
+
+#include "FreeRTOS.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Функция создания очереди фиксированной длины
+ * @param[in] length Кол-во элементов
+ * @param[in] item_size Размер элемента
+ */
+xQueueHandle xQueueCreate(unsigned long length, unsigned long item_size);
+
+/**
+ * @brief Функция удаления очереди
+ */
+void vQueueDelete(xQueueHandle queue);
+
+/**
+ * @brief Функция добавления элемента в конец очереди
+ * @param[in] wait Ожидание места в тиках
+ * @return pdPASS либо pdFAIL если место не появилось
+ */
+portBASE_TYPE xQueueSend(xQueueHandle queue, const void* item, portTickType wait);
+
+/**
+ * @brief Функция извлечения элемента из начала очереди
+ * @param[in] wait Ожидание элемента в тиках
+ * @return pdPASS либо pdFAIL если очередь пуста
+ */
+portBASE_TYPE xQueueReceive(xQueueHandle queue, void* item, portTickType wait);
+
+/**
+ * @brief Функция получения кол-ва элементов очереди
+ */
+unsigned long uxQueueMessagesWaiting(xQueueHandle queue);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __FREERTOS_TASK_H__
+#define __FREERTOS_TASK_H__
+
+#include "FreeRTOS.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+typedef void (* pdTASK_CODE)(void* parameters);
+
+/**
+ * @brief Функция создания задачи, задача выполняется в отдельном потоке
+ * Размер стека и приоритет на PC не используются
+ */
+portBASE_TYPE xTaskCreate(pdTASK_CODE code, const char* name, unsigned short stack, void* parameters, unsigned long priority, xTaskHandle* task);
+
+/**
+ * @brief Функция завершения задачи, только NULL (текущая задача)
+ */
+void vTaskDelete(xTaskHandle task);
+
+/**
+ * @brief Функция получения текущей задачи, у каждого потока свой handle
+ */
+xTaskHandle xTaskGetCurrentTaskHandle(void);
+
+/**
+ * @brief Функция ожидания в тиках
+ */
+void vTaskDelay(portTickType ticks);
+
+/**
+ * @brief Функция передачи управления другим задачам
+ */
+void taskYIELD(void);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __LWIP_DEBUG_H__
+#define __LWIP_DEBUG_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LWIP_ASSERT(message, assertion) \
+	do \
+	{ \
+		if(!(assertion)) \
+		{ \
+			fprintf(stderr, "%s\n", message); \
+			abort(); \
+		} \
+	} while(0)
+
+#define LWIP_UNUSED_ARG(x) (void) (x)
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef __LWIP_ERR_H__
+#define __LWIP_ERR_H__
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+typedef uint8_t u8_t;
+typedef int8_t s8_t;
+typedef uint16_t u16_t;
+typedef int16_t s16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+typedef s8_t err_t;
+
+/**
+ * @brief Коды ошибок lwIP 1.4
+ */
+#define ERR_OK          0
+#define ERR_MEM        -1
+#define ERR_BUF        -2
+#define ERR_TIMEOUT    -3
+#define ERR_RTE        -4
+#define ERR_INPROGRESS -5
+#define ERR_VAL        -6
+#define ERR_WOULDBLOCK -7
+#define ERR_USE        -8
+#define ERR_ISCONN     -9
+#define ERR_ABRT       -10
+#define ERR_RST        -11
+#define ERR_CLSD       -12
+#define ERR_CONN       -13
+#define ERR_ARG        -14
+#define ERR_IF         -15
+
+/**
+ * @brief Функция получения текста ошибки
+ */
+const char* lwip_strerr(err_t err);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
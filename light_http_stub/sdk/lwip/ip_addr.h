@@ -0,0 +1,33 @@
+#ifndef __LWIP_IP_ADDR_H__
+#define __LWIP_IP_ADDR_H__
+
+#include "err.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+typedef struct ip_addr
+{
+	u32_t addr;		///< адрес в сетевом порядке байт
+} ip_addr_t;
+
+extern const ip_addr_t ip_addr_any;
+
+#define IP_ADDR_ANY ((ip_addr_t*) &ip_addr_any)
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
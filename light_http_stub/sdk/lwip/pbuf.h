@@ -0,0 +1,59 @@
+#ifndef __LWIP_PBUF_H__
+#define __LWIP_PBUF_H__
+
+#include "err.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Буфер пакета lwIP, принятые данные приходят цепочкой по сегментам не больше TCP_MSS
+ */
+struct pbuf
+{
+	struct pbuf* next;		///< следующий буфер цепочки
+	void* payload;			///< данные буфера
+	u16_t tot_len;			///< размер данных этого и всех следующих буферов
+	u16_t len;				///< размер данных этого буфера
+	u8_t type;				///< не используется
+	u8_t flags;				///< не используется
+	u16_t ref;				///< кол-во ссылок
+};
+
+/**
+ * @brief Функция освобождения цепочки
+ * @return Кол-во освобожденных буферов
+ */
+u8_t pbuf_free(struct pbuf* p);
+
+/**
+ * @brief Функция увеличения счетчика ссылок
+ */
+void pbuf_ref(struct pbuf* p);
+
+/**
+ * @brief Функция копирования данных цепочки
+ * @param[in] buf Цепочка
+ * @param[out] data Буфер назначения
+ * @param[in] len Сколько скопировать
+ * @param[in] offset Смещение от начала цепочки
+ * @return Кол-во скопированных байт
+ */
+u16_t pbuf_copy_partial(struct pbuf* buf, void* data, u16_t len, u16_t offset);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
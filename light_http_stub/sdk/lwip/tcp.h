@@ -0,0 +1,115 @@
+#ifndef __LWIP_TCP_H__
+#define __LWIP_TCP_H__
+
+#include "err.h"
+#include "ip_addr.h"
+#include "pbuf.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Параметры TCP как в lwIP ESP8266 SDK
+ */
+#define TCP_MSS 1460
+#define TCP_SND_BUF (2 * TCP_MSS)
+#define TCP_WND (4 * TCP_MSS)
+
+/**
+ * @brief Кол-во одновременно открытых соединений (MEMP_NUM_TCP_PCB),
+ * следующие ждут в очереди ядра как SYN без свободного pcb
+ */
+#ifndef MEMP_NUM_TCP_PCB
+	#define MEMP_NUM_TCP_PCB 5
+#endif
+
+/**
+ * @brief Период tcp_slowtmr (вызовы poll) и tcp_fasttmr (повтор отклоненных данных) в ms
+ */
+#define TCP_SLOW_INTERVAL 500
+#define TCP_FAST_INTERVAL 250
+
+#define TCP_PRIO_MIN 1
+#define TCP_PRIO_NORMAL 64
+#define TCP_PRIO_MAX 127
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+
+/**
+ * @brief Соединение (реализация поверх сокетов, lwip_shim.cpp)
+ */
+struct tcp_pcb;
+
+/**
+ * @brief Слушающее соединение, в lwIP отдельный тип
+ */
+struct tcp_pcb_listen;
+
+typedef err_t (* tcp_accept_fn)(void* arg, struct tcp_pcb* newpcb, err_t err);
+typedef err_t (* tcp_recv_fn)(void* arg, struct tcp_pcb* tpcb, struct pbuf* p, err_t err);
+typedef err_t (* tcp_sent_fn)(void* arg, struct tcp_pcb* tpcb, u16_t len);
+typedef err_t (* tcp_poll_fn)(void* arg, struct tcp_pcb* tpcb);
+typedef void (* tcp_err_fn)(void* arg, err_t err);
+
+struct tcp_pcb* tcp_new(void);
+err_t tcp_bind(struct tcp_pcb* pcb, ip_addr_t* ipaddr, u16_t port);
+struct tcp_pcb* tcp_listen(struct tcp_pcb* pcb);
+void tcp_accepted(struct tcp_pcb_listen* pcb);
+
+void tcp_arg(struct tcp_pcb* pcb, void* arg);
+void tcp_accept(struct tcp_pcb* pcb, tcp_accept_fn accept);
+void tcp_recv(struct tcp_pcb* pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb* pcb, tcp_sent_fn sent);
+void tcp_poll(struct tcp_pcb* pcb, tcp_poll_fn poll, u8_t interval);
+void tcp_err(struct tcp_pcb* pcb, tcp_err_fn err);
+void tcp_setprio(struct tcp_pcb* pcb, u8_t prio);
+
+/**
+ * @brief Функция подтверждения обработки принятых данных (окно приема)
+ */
+void tcp_recved(struct tcp_pcb* pcb, u16_t len);
+
+/**
+ * @brief Функция постановки данных в очередь отправки
+ * Данные всегда копируются, ERR_MEM если len больше tcp_sndbuf
+ */
+err_t tcp_write(struct tcp_pcb* pcb, const void* data, u16_t len, u8_t apiflags);
+
+/**
+ * @brief Функция отправки очереди
+ */
+err_t tcp_output(struct tcp_pcb* pcb);
+
+/**
+ * @brief Функция получения свободного места в очереди отправки
+ * Место освобождается после передачи данных ядру, о чем сообщает tcp_sent
+ */
+u16_t tcp_sndbuf(struct tcp_pcb* pcb);
+
+/**
+ * @brief Функция закрытия соединения, очередь отправки будет передана до закрытия
+ */
+err_t tcp_close(struct tcp_pcb* pcb);
+
+/**
+ * @brief Функция разрыва соединения (RST), вызывает tcp_err с ERR_ABRT
+ */
+void tcp_abort(struct tcp_pcb* pcb);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
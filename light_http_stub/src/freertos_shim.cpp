@@ -0,0 +1,201 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Очередь FreeRTOS: кольцевой буфер элементов фиксированного размера
+ */
+struct freertos_queue
+{
+	std::mutex lock;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+
+	std::vector<uint8_t> items;		///< буфер на length элементов
+	unsigned long item_size;		///< размер элемента
+	unsigned long length;			///< емкость очереди
+	unsigned long head;				///< индекс первого элемента
+	unsigned long count;			///< кол-во элементов
+};
+
+/**
+ * @brief Задача: параметры запуска, живет до vTaskDelete(NULL)
+ */
+struct freertos_task
+{
+	pdTASK_CODE code;
+	void* parameters;
+};
+
+/**
+ * @brief Задача текущего потока, NULL для потоков созданных не через xTaskCreate (в том числе поток LwIP)
+ */
+static thread_local struct freertos_task* current_task = NULL;
+
+/**
+ * @brief Функция ожидания условия с таймаутом в тиках, portMAX_DELAY без ограничения
+ */
+template<typename Predicate>
+static bool wait_ticks(std::condition_variable& cv, std::unique_lock<std::mutex>& guard, portTickType wait, Predicate predicate)
+{
+	if(wait == portMAX_DELAY)
+	{
+		cv.wait(guard, predicate);
+		return true;
+	}
+	return cv.wait_for(guard, std::chrono::milliseconds(wait * portTICK_RATE_MS), predicate);
+}
+
+xQueueHandle xQueueCreate(unsigned long length, unsigned long item_size)
+{
+	if(length == 0 || item_size == 0)
+	{
+		return NULL;
+	}
+
+	struct freertos_queue* queue = new freertos_queue;
+	queue->items.resize(length * item_size);
+	queue->item_size = item_size;
+	queue->length = length;
+	queue->head = 0;
+	queue->count = 0;
+	return queue;
+}
+
+void vQueueDelete(xQueueHandle queue)
+{
+	delete queue;
+}
+
+portBASE_TYPE xQueueSend(xQueueHandle queue, const void* item, portTickType wait)
+{
+	if(queue == NULL)
+	{
+		return pdFAIL;
+	}
+
+	std::unique_lock<std::mutex> guard(queue->lock);
+	if(!wait_ticks(queue->not_full, guard, wait, [queue]() { return queue->count < queue->length; }))
+	{
+		return pdFAIL;
+	}
+
+	unsigned long tail = (queue->head + queue->count) % queue->length;
+	memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+	++queue->count;
+
+	guard.unlock();
+	queue->not_empty.notify_one();
+	return pdPASS;
+}
+
+portBASE_TYPE xQueueReceive(xQueueHandle queue, void* item, portTickType wait)
+{
+	if(queue == NULL)
+	{
+		return pdFAIL;
+	}
+
+	std::unique_lock<std::mutex> guard(queue->lock);
+	if(!wait_ticks(queue->not_empty, guard, wait, [queue]() { return queue->count != 0; }))
+	{
+		return pdFAIL;
+	}
+
+	memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+	queue->head = (queue->head + 1) % queue->length;
+	--queue->count;
+
+	guard.unlock();
+	queue->not_full.notify_one();
+	return pdPASS;
+}
+
+unsigned long uxQueueMessagesWaiting(xQueueHandle queue)
+{
+	if(queue == NULL)
+	{
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> guard(queue->lock);
+	return queue->count;
+}
+
+static void* task_main(void* arg)
+{
+	current_task = reinterpret_cast<struct freertos_task*>(arg);
+	current_task->code(current_task->parameters);
+	return NULL;
+}
+
+portBASE_TYPE xTaskCreate(pdTASK_CODE code, const char* name, unsigned short stack, void* parameters, unsigned long priority, xTaskHandle* task)
+{
+	(void) name;
+	(void) stack;
+	(void) priority;
+
+	struct freertos_task* handle = new freertos_task;
+	handle->code = code;
+	handle->parameters = parameters;
+
+	pthread_t thread;
+	if(pthread_create(&thread, NULL, task_main, handle) != 0)
+	{
+		delete handle;
+		return pdFAIL;
+	}
+	pthread_detach(thread);
+
+	if(task != NULL)
+	{
+		*task = handle;
+	}
+	return pdPASS;
+}
+
+void vTaskDelete(xTaskHandle task)
+{
+	if(task == NULL)
+	{
+		delete current_task;
+		current_task = NULL;
+		pthread_exit(NULL);
+	}
+}
+
+xTaskHandle xTaskGetCurrentTaskHandle(void)
+{	// на устройстве любой код выполняется в задаче, остальным потокам PC выдается собственный handle
+	static thread_local struct freertos_task foreign_task = { NULL, NULL };
+	return current_task != NULL ? current_task : &foreign_task;
+}
+
+void vTaskDelay(portTickType ticks)
+{
+	usleep(ticks * portTICK_RATE_MS * 1000);
+}
+
+void taskYIELD(void)
+{
+	sched_yield();
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,575 @@
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Параметры нагрузки
+ */
+struct load_config
+{
+	struct sockaddr_in addr;		///< адрес сервера
+	std::string request;			///< запрос целиком
+	uint32_t connections;			///< кол-во клиентов, каждый ждет ответ перед следующим запросом
+	uint32_t duration;				///< длительность в секундах, если requests == 0
+	uint64_t requests;				///< всего запросов
+	uint32_t timeout;				///< таймаут ответа в ms
+	bool keep_alive;				///< запросы в одном соединении
+	uint32_t pipeline;				///< запросов отправляется не дожидаясь ответов, только с keep_alive
+};
+
+/**
+ * @brief Результаты одного клиента
+ */
+struct load_result
+{
+	std::vector<uint64_t> latency;	///< задержки успешных запросов в ns
+	uint64_t errors = 0;			///< ошибки соединения и таймауты
+	uint64_t non_2xx = 0;			///< ответы со статусом не 2xx
+	uint64_t bytes = 0;				///< принято байт
+	uint64_t connects = 0;			///< установлено соединений
+};
+
+static std::atomic<bool> load_stop(false);
+static std::atomic<uint64_t> load_issued(0);
+
+static uint64_t load_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Функция резервирования следующего запроса, false если лимит исчерпан
+ */
+static bool load_next(const load_config* config)
+{
+	if(load_stop.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+	return config->requests == 0 || load_issued.fetch_add(1, std::memory_order_relaxed) < config->requests;
+}
+
+/**
+ * @brief Функция установки соединения
+ * @return сокет или -1
+ */
+static int load_connect(const load_config* config, load_result* result)
+{
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd < 0)
+	{
+		return -1;
+	}
+
+	int flag = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+	struct timeval tv;
+	tv.tv_sec = config->timeout / 1000;
+	tv.tv_usec = (config->timeout % 1000) * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	if(connect(fd, (const struct sockaddr*) &config->addr, sizeof(config->addr)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	++result->connects;
+	return fd;
+}
+
+/**
+ * @brief Функция отправки count копий запроса одним вызовом
+ */
+static bool load_send(const load_config* config, int fd, uint32_t count)
+{
+	std::string data;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		data += config->request;
+	}
+	return send(fd, data.data(), data.size(), MSG_NOSIGNAL) == (ssize_t) data.size();
+}
+
+/**
+ * @brief Функция поиска значения заголовка ответа без учета регистра имени
+ */
+static const char* load_header(const std::string& headers, const char* name)
+{
+	size_t length = strlen(name);
+	for(size_t line = headers.find("\r\n"); line != std::string::npos; line = headers.find("\r\n", line + 2))
+	{
+		if(strncasecmp(headers.c_str() + line + 2, name, length) == 0 && headers[line + 2 + length] == ':')
+		{
+			const char* value = headers.c_str() + line + 3 + length;
+			while(*value == ' ')
+			{
+				++value;
+			}
+			return value;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * @brief Функция поиска конца тела Transfer-Encoding: chunked
+ * @param[in] start Начало тела в buffer
+ * @return Конец ответа в buffer, 0 если тело принято не целиком
+ */
+static size_t load_chunked_end(const std::string& buffer, size_t start)
+{
+	while(true)
+	{
+		size_t line = buffer.find("\r\n", start);
+		if(line == std::string::npos)
+		{
+			return 0;
+		}
+
+		size_t size = strtoul(buffer.c_str() + start, nullptr, 16);
+		start = line + 2 + size + 2;
+		if(buffer.size() < start)
+		{
+			return 0;
+		}
+
+		if(size == 0)
+		{	// последняя часть без trailer заголовков
+			return start;
+		}
+	}
+}
+
+/**
+ * @brief Функция чтения одного ответа сохраненного соединения, конец ответа по Content-Length либо chunked
+ * Данные следующих ответов остаются в buffer
+ * @return код статуса ответа, 0 при ошибке
+ */
+static int load_response(int fd, std::string& buffer, bool* closed, load_result* result)
+{
+	size_t headers_end;
+	size_t total = 0;
+	size_t chunked = 0;
+	while(true)
+	{
+		if(total == 0 && chunked == 0 && (headers_end = buffer.find("\r\n\r\n")) != std::string::npos)
+		{
+			std::string headers = buffer.substr(0, headers_end + 2);
+			const char* length = load_header(headers, "Content-Length");
+			const char* encoding = load_header(headers, "Transfer-Encoding");
+			if(length != nullptr)
+			{
+				total = headers_end + 4 + strtoul(length, nullptr, 10);
+			}
+			else if(encoding != nullptr && strncasecmp(encoding, "chunked", 7) == 0)
+			{
+				chunked = headers_end + 4;
+			}
+			else
+			{
+				return 0;
+			}
+
+			const char* connection = load_header(headers, "Connection");
+			*closed = connection != nullptr && strncasecmp(connection, "close", 5) == 0;
+		}
+
+		if(chunked != 0)
+		{
+			total = load_chunked_end(buffer, chunked);
+		}
+
+		if(total != 0 && buffer.size() >= total)
+		{
+			int status = strncmp(buffer.c_str(), "HTTP/1.", 7) == 0 ? atoi(buffer.c_str() + 9) : 0;
+			buffer.erase(0, total);
+			return status;
+		}
+
+		char data[4096];
+		ssize_t received = recv(fd, data, sizeof(data), 0);
+		if(received < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if(received <= 0)
+		{
+			return 0;
+		}
+		buffer.append(data, received);
+		result->bytes += received;
+	}
+}
+
+/**
+ * @brief Функция выполнения одного запроса: соединение, запрос, ответ до закрытия сервером
+ * @return код статуса ответа, 0 при ошибке
+ */
+static int load_request(const load_config* config, load_result* result)
+{
+	int fd = load_connect(config, result);
+	if(fd < 0)
+	{
+		return 0;
+	}
+
+	int status = 0;
+	if(load_send(config, fd, 1))
+	{
+		char status_line[16] = { 0 };
+		char buffer[4096];
+		size_t size = 0;
+		while(true)
+		{
+			ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+			if(received < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			if(received <= 0)
+			{	// 0 - сервер закрыл соединение после ответа (Connection: close)
+				if(received == 0 && strncmp(status_line, "HTTP/1.", 7) == 0)
+				{
+					status = atoi(status_line + 9);
+				}
+				break;
+			}
+
+			// для статуса нужны первые байты "HTTP/1.1 200", остальное только считается
+			if(size < sizeof(status_line) - 1)
+			{
+				memcpy(status_line + size, buffer, std::min<size_t>(received, sizeof(status_line) - 1 - size));
+			}
+			size += received;
+		}
+		result->bytes += size;
+	}
+	close(fd);
+	return status;
+}
+
+static void load_record(load_result* result, int status, uint64_t elapsed)
+{
+	if(status == 0)
+	{
+		++result->errors;
+	}
+	else
+	{
+		if(status < 200 || status >= 300)
+		{
+			++result->non_2xx;
+		}
+		result->latency.push_back(elapsed);
+	}
+}
+
+/**
+ * @brief Клиент с сохраненным соединением: pipeline запросов подряд, затем чтение ответов
+ *
+ * Соединение переустанавливается если сервер его закрыл. Как в браузере, запросы без ответа
+ * повторяются в новом соединении, если сервер закрыл соединение после ответа (Connection: close)
+ * либо закрыл сохраненное соединение до первого ответа (таймаут, вытеснение).
+ */
+static void load_client_keep_alive(const load_config* config, load_result* result)
+{
+	int fd = -1;
+	std::string buffer;
+	uint32_t carry = 0;
+	while(true)
+	{
+		uint32_t count = carry;
+		carry = 0;
+		while(count < config->pipeline && load_next(config))
+		{
+			++count;
+		}
+
+		if(count == 0)
+		{
+			break;
+		}
+
+		uint64_t start = load_clock();
+		bool reused = fd >= 0;
+		if(fd < 0 && (fd = load_connect(config, result)) < 0)
+		{
+			result->errors += count;
+			continue;
+		}
+
+		bool closed = !load_send(config, fd, count);
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			if(closed && (i != 0 || reused))
+			{
+				carry = count - i;
+				break;
+			}
+
+			int status = closed ? 0 : load_response(fd, buffer, &closed, result);
+			if(status == 0 && (i != 0 || reused))
+			{
+				carry = count - i;
+				closed = true;
+				break;
+			}
+
+			load_record(result, status, load_clock() - start);
+			closed = closed || status == 0;
+		}
+
+		if(closed)
+		{
+			close(fd);
+			fd = -1;
+			buffer.clear();
+		}
+	}
+
+	if(fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+static void load_client(const load_config* config, load_result* result)
+{
+	if(config->keep_alive)
+	{
+		load_client_keep_alive(config, result);
+		return;
+	}
+
+	while(load_next(config))
+	{
+		uint64_t start = load_clock();
+		int status = load_request(config, result);
+		load_record(result, status, load_clock() - start);
+	}
+}
+
+static double percentile(const std::vector<uint64_t>& sorted, double p)
+{
+	if(sorted.empty())
+	{
+		return 0.;
+	}
+
+	size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[index] / 1e6;
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --host=ADDR              server address, default 127.0.0.1\n"
+			"  --port=PORT              server port, default 8080\n"
+			"  --path=URI               request uri, default /status\n"
+			"  --body=DATA              send POST with form urlencoded body\n"
+			"  --connections=N          concurrent closed-loop clients, default 4\n"
+			"  --duration=S             test duration in seconds, default 10\n"
+			"  --requests=N             total requests instead of duration\n"
+			"  --timeout=MS             response timeout, default 10000\n"
+			"  -k, --keep-alive         reuse connection for requests\n"
+			"  --pipeline=N             send N requests before reading responses, implies -k\n"
+			"  --csv                    machine readable output\n", name);
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	load_config config;
+	memset(&config.addr, 0, sizeof(config.addr));
+	config.addr.sin_family = AF_INET;
+	config.addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	config.addr.sin_port = htons(8080);
+	config.connections = 4;
+	config.duration = 10;
+	config.requests = 0;
+	config.timeout = 10000;
+	config.keep_alive = false;
+	config.pipeline = 1;
+
+	std::string path = "/status";
+	std::string body;
+	bool post = false;
+	bool csv = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--host")) != nullptr)
+		{
+			struct hostent* host = gethostbyname(value);
+			if(host == nullptr || host->h_addrtype != AF_INET)
+			{
+				fprintf(stderr, "http_load: unknown host %s\n", value);
+				return 1;
+			}
+			memcpy(&config.addr.sin_addr, host->h_addr_list[0], sizeof(config.addr.sin_addr));
+		}
+		else if((value = option_value(argv[i], "--port")) != nullptr)
+		{
+			config.addr.sin_port = htons(atoi(value));
+		}
+		else if((value = option_value(argv[i], "--path")) != nullptr)
+		{
+			path = value;
+		}
+		else if((value = option_value(argv[i], "--body")) != nullptr)
+		{
+			body = value;
+			post = true;
+		}
+		else if((value = option_value(argv[i], "--connections")) != nullptr)
+		{
+			config.connections = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--duration")) != nullptr)
+		{
+			config.duration = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--requests")) != nullptr)
+		{
+			config.requests = strtoull(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--timeout")) != nullptr)
+		{
+			config.timeout = strtoul(value, nullptr, 10);
+		}
+		else if(strcmp(argv[i], "-k") == 0 || strcmp(argv[i], "--keep-alive") == 0)
+		{
+			config.keep_alive = true;
+		}
+		else if((value = option_value(argv[i], "--pipeline")) != nullptr)
+		{
+			config.pipeline = strtoul(value, nullptr, 10);
+			config.keep_alive = true;
+		}
+		else if(strcmp(argv[i], "--csv") == 0)
+		{
+			csv = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(config.connections == 0 || (config.duration == 0 && config.requests == 0) || config.timeout == 0 || config.pipeline == 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	// light_http ищет заголовки по точному имени
+	config.request = (post ? "POST " : "GET ") + path + " HTTP/1.1\r\n"
+		"Host: " + inet_ntoa(config.addr.sin_addr) + "\r\n"
+		"Connection: " + (config.keep_alive ? "keep-alive" : "close") + "\r\n";
+	if(post)
+	{
+		config.request += "Content-Type: application/x-www-form-urlencoded\r\n"
+			"Content-Length: " + std::to_string(body.size()) + "\r\n";
+	}
+	config.request += "\r\n" + body;
+
+	std::vector<load_result> results(config.connections);
+	std::vector<std::thread> clients;
+
+	uint64_t start = load_clock();
+	for(uint32_t i = 0; i < config.connections; ++i)
+	{
+		clients.emplace_back(load_client, &config, &results[i]);
+	}
+
+	if(config.requests == 0)
+	{
+		std::this_thread::sleep_for(std::chrono::seconds(config.duration));
+		load_stop = true;
+	}
+
+	for(std::thread& client : clients)
+	{
+		client.join();
+	}
+	double seconds = (load_clock() - start) / 1e9;
+
+	load_result total;
+	for(const load_result& result : results)
+	{
+		total.latency.insert(total.latency.end(), result.latency.begin(), result.latency.end());
+		total.errors += result.errors;
+		total.non_2xx += result.non_2xx;
+		total.bytes += result.bytes;
+		total.connects += result.connects;
+	}
+	std::sort(total.latency.begin(), total.latency.end());
+
+	uint64_t completed = total.latency.size();
+	double rate = seconds > 0 ? completed / seconds : 0.;
+	double max = total.latency.empty() ? 0. : total.latency.back() / 1e6;
+
+	if(csv)
+	{
+		printf("path,connections,pipeline,requests,errors,non_2xx,connects,seconds,requests_per_second,p50_ms,p90_ms,p99_ms,max_ms\n");
+		printf("%s,%u,%u,%llu,%llu,%llu,%llu,%.3f,%.1f,%.3f,%.3f,%.3f,%.3f\n", path.c_str(), config.connections,
+				config.keep_alive ? config.pipeline : 0,
+				(unsigned long long) completed, (unsigned long long) total.errors, (unsigned long long) total.non_2xx,
+				(unsigned long long) total.connects,
+				seconds, rate, percentile(total.latency, 0.5), percentile(total.latency, 0.9),
+				percentile(total.latency, 0.99), max);
+	}
+	else
+	{
+		printf("%s, %u connections: %llu requests in %.3f s, %llu errors, %llu non-2xx, %llu connects, %.1f KiB received\n",
+				path.c_str(), config.connections, (unsigned long long) completed, seconds,
+				(unsigned long long) total.errors, (unsigned long long) total.non_2xx,
+				(unsigned long long) total.connects, total.bytes / 1024.);
+		printf("  %.1f req/s, latency ms: p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n", rate,
+				percentile(total.latency, 0.5), percentile(total.latency, 0.9),
+				percentile(total.latency, 0.99), max);
+	}
+	return total.errors != 0 ? 2 : 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,371 @@
+#include "http_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Запрос для замера
+ */
+struct bench_request
+{
+	const char* name;
+	const char* data;
+};
+
+/**
+ * @brief Запросы как у приложения и браузера к устройству
+ */
+static const bench_request bench_requests[] =
+{
+	{ "status", "GET /status?type=json HTTP/1.1\r\n"
+		"Host: 192.168.0.110\r\n"
+		"\r\n" },
+	{ "browser", "GET /getDeviceInfo HTTP/1.1\r\n"
+		"Host: 192.168.0.110\r\n"
+		"Connection: keep-alive\r\n"
+		"User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+		"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+		"Referer: http://192.168.0.110/\r\n"
+		"Accept-Encoding: gzip, deflate\r\n"
+		"Accept-Language: ru-RU,ru;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+		"\r\n" },
+	{ "set_wifi", "POST /setWifi HTTP/1.1\r\n"
+		"Host: 192.168.0.110\r\n"
+		"Content-Type: application/x-www-form-urlencoded\r\n"
+		"Content-Length: 72\r\n"
+		"\r\n"
+		"name=home&pass=secret&ip=192.168.0.110&mask=255.255.255.0&gw=192.168.0.1" },
+};
+
+/**
+ * @brief Разбор запроса
+ * @param[in] buffer Изменяемая копия запроса
+ * @param[in] segment Размер порции данных
+ * @return false если запрос не разобран
+ */
+typedef bool (* bench_parse_fn)(char* buffer, uint32_t size, uint32_t segment);
+
+/**
+ * @brief Реализация разбора
+ */
+struct bench_parser
+{
+	const char* name;
+	bench_parse_fn parse;
+};
+
+static uint64_t bench_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Разбор запроса порциями по segment байт, как при приходе по сегментам TCP
+ * @return false если запрос не разобран
+ */
+static bool bench_parse(char* data, uint32_t size, uint32_t segment)
+{
+	struct http_parser parser;
+	http_parser_init(&parser);
+
+	HTTP_PARSE_RESULT result = HTTP_PARSE_NEED_MORE;
+	for(uint32_t received = 0; received < size && result == HTTP_PARSE_NEED_MORE; )
+	{
+		received = received + segment < size ? received + segment : size;
+		result = http_parser_execute(&parser, data, received);
+	}
+	return result == HTTP_PARSE_COMPLETE && http_parser_message_size(&parser) == size;
+}
+
+/**
+ * @brief Поиск подстроки побайтно, как strstr ROM libc ESP8266
+ * strstr glibc на PC использует SIMD и не отражает стоимость на устройстве
+ */
+static char* rom_strstr(const char* haystack, const char* needle)
+{
+	for(; *haystack != '\0'; ++haystack)
+	{
+		const char* h = haystack;
+		const char* n = needle;
+		while(*n != '\0' && *h == *n)
+		{
+			++h;
+			++n;
+		}
+
+		if(*n == '\0')
+		{
+			return const_cast<char*>(haystack);
+		}
+	}
+	return *needle == '\0' ? const_cast<char*>(haystack) : nullptr;
+}
+
+static char* libc_strstr(const char* haystack, const char* needle)
+{
+	return const_cast<char*>(strstr(haystack, needle));
+}
+
+/**
+ * @brief Прежний разбор заголовков light_http через strstr, без выделений памяти
+ * Повторяет webserver_parse_request и webserver_parse_request_headers до однопроходного парсера:
+ * поиск "\r\n\r\n", " HTTP/1.1", подсчет строк, повторный проход с разбиением и поиск ':'.
+ * Порции не поддерживаются, запрос разбирается целиком
+ */
+template<char* (* find)(const char*, const char*)>
+static bool bench_parse_legacy(char* data, uint32_t size, uint32_t segment)
+{
+	(void) size;
+	(void) segment;
+
+	struct pair
+	{
+		char* name;
+		char* value;
+	};
+	pair headers[32];
+
+	char* iter = find(data, "\r\n\r\n");
+	if(iter != NULL)
+	{
+		*iter = '\0';
+	}
+
+	iter = data;
+	if(strncmp(iter, "GET ", 4) == 0)
+	{
+		iter += 4;
+	}
+	else if(strncmp(iter, "POST ", 5) == 0)
+	{
+		iter += 5;
+	}
+	else
+	{
+		return false;
+	}
+
+	char* uri = iter;
+	if((iter = find(iter, " HTTP/1.1")) == NULL)
+	{
+		return false;
+	}
+	*iter = '\0'; ++iter;
+
+	char* header_name = iter;
+	uint32_t headers_count = 0;
+	while((iter = find(iter, "\r\n")) != NULL)
+	{
+		iter += 2;
+		++headers_count;
+	}
+
+	if(headers_count > sizeof(headers) / sizeof(headers[0]))
+	{
+		return false;
+	}
+
+	iter = header_name;
+	headers_count = 0;
+	while((iter = find(iter, "\r\n")) != NULL)
+	{
+		if(headers_count != 0)
+		{
+			*iter = '\0';
+		}
+
+		iter += 2;
+		header_name = iter;
+		if((iter = find(iter, ":")) == NULL)
+		{
+			continue;
+		}
+
+		*iter = '\0'; ++iter;
+		while(*iter == ' ' || *iter == '\t')
+		{
+			++iter;
+		}
+
+		headers[headers_count].name = header_name;
+		headers[headers_count].value = iter;
+		++headers_count;
+	}
+
+	if((iter = find(uri, "?")) != NULL)
+	{
+		*iter = '\0';
+	}
+	asm volatile("" : : "r"(headers) : "memory");
+	return headers_count != 0;
+}
+
+static const bench_parser bench_parsers[] =
+{
+	{ "swar", bench_parse },
+	{ "legacy", bench_parse_legacy<libc_strstr> },
+	{ "legacy_rom", bench_parse_legacy<rom_strstr> },
+};
+
+static void bench_run(const bench_parser* parser, const bench_request* request, uint64_t iterations, uint32_t segment, bool csv)
+{
+	uint32_t size = strlen(request->data);
+	uint32_t chunk = segment != 0 ? segment : size;
+
+	// оба варианта разбирают изменяемую копию, как receive_buffer на устройстве
+	char buffer[4096];
+	memcpy(buffer, request->data, size + 1);
+	if(!parser->parse(buffer, size, chunk))
+	{
+		fprintf(stderr, "%s: %s parse failed\n", parser->name, request->name);
+		exit(1);
+	}
+
+	uint64_t parsed = 0;
+	uint64_t start = bench_clock();
+	for(uint64_t i = 0; i < iterations; ++i)
+	{
+		memcpy(buffer, request->data, size + 1);
+		parsed += parser->parse(buffer, size, chunk) ? 1 : 0;
+		asm volatile("" ::: "memory");
+	}
+	uint64_t elapsed = bench_clock() - start;
+
+	double seconds = elapsed / 1e9;
+	double bytes_rate = seconds > 0 ? parsed * size / seconds / (1024. * 1024.) : 0.;
+	double ns_per_request = parsed != 0 ? static_cast<double>(elapsed) / parsed : 0.;
+
+	if(csv)
+	{
+		printf("%s,%s,%u,%u,%llu,%.6f,%.1f,%.1f\n", parser->name, request->name, size, chunk,
+				(unsigned long long) parsed, seconds, bytes_rate, ns_per_request);
+	}
+	else
+	{
+		printf("%-6s %-10s %5u bytes by %5u: %10llu requests in %.3f s, %9.1f MiB/s, %8.1f ns/request\n",
+				parser->name, request->name, size, chunk, (unsigned long long) parsed, seconds, bytes_rate, ns_per_request);
+	}
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --request=NAME           run only this request (repeatable), default all\n"
+			"  --iterations=N           parses per request\n"
+			"  --segment=N              feed parser by N bytes, default whole request\n"
+			"  --parser=NAME            swar (current), legacy (strstr) or legacy_rom\n"
+			"                           (byte strstr as on device), default all\n"
+			"  --csv                    machine readable output\n"
+			"requests:", name);
+	for(const bench_request& request : bench_requests)
+	{
+		printf(" %s", request.name);
+	}
+	printf("\n");
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	uint64_t iterations = 1000000;
+	uint32_t segment = 0;
+	bool csv = false;
+	bool selected[sizeof(bench_requests) / sizeof(bench_request)] = { false };
+	bool any = false;
+	const char* parser_name = nullptr;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--request")) != nullptr)
+		{
+			bool found = false;
+			for(size_t j = 0; j < sizeof(bench_requests) / sizeof(bench_request); ++j)
+			{
+				if(strcmp(bench_requests[j].name, value) == 0)
+				{
+					selected[j] = true;
+					found = true;
+				}
+			}
+			if(!found)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+			any = true;
+		}
+		else if((value = option_value(argv[i], "--iterations")) != nullptr)
+		{
+			iterations = strtoull(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--segment")) != nullptr)
+		{
+			segment = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--parser")) != nullptr)
+		{
+			parser_name = value;
+		}
+		else if(strcmp(argv[i], "--csv") == 0)
+		{
+			csv = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(iterations == 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(csv)
+	{
+		printf("parser,request,bytes,segment,requests,seconds,mib_per_second,ns_per_request\n");
+	}
+
+	for(const bench_parser& parser : bench_parsers)
+	{
+		if(parser_name != nullptr && strcmp(parser.name, parser_name) != 0)
+		{
+			continue;
+		}
+
+		for(size_t i = 0; i < sizeof(bench_requests) / sizeof(bench_request); ++i)
+		{
+			if(!any || selected[i])
+			{
+				bench_run(&parser, &bench_requests[i], iterations, segment, csv);
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * @}
+ */
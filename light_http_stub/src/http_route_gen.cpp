@@ -0,0 +1,328 @@
+#include "http_router.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Сколько seed перебирается для одного размера таблицы, затем размер удваивается
+ */
+#define ROUTE_GEN_SEED_ATTEMPTS 1000000
+
+/**
+ * @brief Правило из списка обработчиков
+ */
+struct route_gen_rule
+{
+	std::string uri;
+	bool exact;		///< uri без ':' и '*', попадает в таблицу
+};
+
+static void route_gen_skip_space(const std::string& text, size_t& i)
+{
+	while(i < text.size())
+	{
+		if(isspace(static_cast<unsigned char>(text[i])))
+		{
+			++i;
+		}
+		else if(text.compare(i, 2, "//") == 0)
+		{
+			i = text.find('\n', i);
+			i = i == std::string::npos ? text.size() : i;
+		}
+		else if(text.compare(i, 2, "/*") == 0)
+		{
+			i = text.find("*/", i + 2);
+			i = i == std::string::npos ? text.size() : i + 2;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Функция чтения списка правил из исходника
+ *
+ * Ищется массив struct http_handler_rule (с именем array, если задано), из каждого
+ * элемента берется строковый литерал uri. Список заканчивается элементом с NULL.
+ *
+ * @return false если массив не найден или записан иначе
+ */
+static bool route_gen_parse(const std::string& text, const char* array, std::vector<route_gen_rule>& rules)
+{
+	size_t i = 0;
+	while((i = text.find("http_handler_rule", i)) != std::string::npos)
+	{
+		i += strlen("http_handler_rule");
+		route_gen_skip_space(text, i);
+		size_t name = i;
+		while(i < text.size() && (isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_'))
+		{
+			++i;
+		}
+
+		size_t name_end = i;
+		route_gen_skip_space(text, i);
+		if(name == name_end || text[i] != '[' || (array != nullptr && text.compare(name, name_end - name, array) != 0))
+		{
+			continue;
+		}
+
+		if((i = text.find('{', i)) == std::string::npos)
+		{
+			return false;
+		}
+		++i;
+
+		for(;;)
+		{
+			route_gen_skip_space(text, i);
+			if(i >= text.size() || text[i] != '{')
+			{
+				return false;
+			}
+			++i;
+			route_gen_skip_space(text, i);
+
+			if(text.compare(i, 4, "NULL") == 0 || text.compare(i, 7, "nullptr") == 0)
+			{
+				return !rules.empty();
+			}
+
+			if(text[i] != '"')
+			{
+				return false;
+			}
+
+			size_t end = text.find('"', i + 1);
+			if(end == std::string::npos)
+			{
+				return false;
+			}
+
+			route_gen_rule rule;
+			rule.uri = text.substr(i + 1, end - i - 1);
+			rule.exact = rule.uri.find('*') == std::string::npos && rule.uri.find("/:") == std::string::npos;
+			rules.push_back(rule);
+
+			if((i = text.find('}', end)) == std::string::npos)
+			{
+				return false;
+			}
+			++i;
+			route_gen_skip_space(text, i);
+			if(i < text.size() && text[i] == ',')
+			{
+				++i;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Функция подбора seed, при котором точные uri попадают в разные слоты
+ * @return false если seed не найден для этого размера
+ */
+static bool route_gen_find_seed(const std::vector<route_gen_rule>& rules, uint32_t mask, uint32_t* seed, std::vector<uint32_t>& slots)
+{
+	// seed перебирается через splitmix32, соседние значения дают независимые хеши
+	uint32_t state = 0x9E3779B9u;
+	for(uint32_t attempt = 0; attempt < ROUTE_GEN_SEED_ATTEMPTS; ++attempt)
+	{
+		uint32_t candidate = (state += 0x9E3779B9u);
+		candidate = (candidate ^ (candidate >> 16)) * 0x85EBCA6Bu;
+		candidate = (candidate ^ (candidate >> 13)) * 0xC2B2AE35u;
+		candidate ^= candidate >> 16;
+
+		slots.assign(mask + 1, HTTP_ROUTE_NONE);
+		bool collision = false;
+		for(size_t i = 0; i < rules.size() && !collision; ++i)
+		{
+			if(!rules[i].exact)
+			{
+				continue;
+			}
+
+			uint32_t slot = http_route_hash(candidate, rules[i].uri.c_str(), rules[i].uri.size()) & mask;
+			collision = slots[slot] != HTTP_ROUTE_NONE;
+			slots[slot] = i;
+		}
+
+		if(!collision)
+		{
+			*seed = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s --source=FILE --output=FILE [options]\n"
+			"  --source=FILE            C file with struct http_handler_rule array\n"
+			"  --array=NAME             array name, default first http_handler_rule array\n"
+			"  --output=FILE            generated header\n"
+			"  --name=NAME              table variable name, default http_routes\n"
+			"  --include=PATH           light_http.h include path, default light_http.h\n", name);
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	const char* source = nullptr;
+	const char* array = nullptr;
+	const char* output = nullptr;
+	const char* name = "http_routes";
+	const char* include = "light_http.h";
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--source")) != nullptr)
+		{
+			source = value;
+		}
+		else if((value = option_value(argv[i], "--array")) != nullptr)
+		{
+			array = value;
+		}
+		else if((value = option_value(argv[i], "--output")) != nullptr)
+		{
+			output = value;
+		}
+		else if((value = option_value(argv[i], "--name")) != nullptr)
+		{
+			name = value;
+		}
+		else if((value = option_value(argv[i], "--include")) != nullptr)
+		{
+			include = value;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(source == nullptr || output == nullptr)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	std::ifstream input(source);
+	std::stringstream text;
+	text << input.rdbuf();
+
+	std::vector<route_gen_rule> rules;
+	if(!input || !route_gen_parse(text.str(), array, rules))
+	{
+		fprintf(stderr, "%s: http_handler_rule array not found\n", source);
+		return 1;
+	}
+
+	uint32_t exact = 0;
+	for(const route_gen_rule& rule : rules)
+	{
+		exact += rule.exact ? 1 : 0;
+	}
+
+	// размер степень двойки: слот берется маской, у lx106 нет деления
+	uint32_t mask = 0;
+	while(mask + 1 < exact)
+	{
+		mask = (mask << 1) | 1;
+	}
+
+	uint32_t seed = 0;
+	std::vector<uint32_t> slots;
+	while(!route_gen_find_seed(rules, mask, &seed, slots))
+	{
+		mask = (mask << 1) | 1;
+	}
+
+	std::string guard = "__" + std::string(name) + "_H__";
+	for(char& c : guard)
+	{
+		c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+	}
+
+	FILE* file = fopen(output, "w");
+	if(file == nullptr)
+	{
+		fprintf(stderr, "%s: can't open\n", output);
+		return 1;
+	}
+
+	fprintf(file, "/**\n"
+			" * @file\n"
+			" * @brief Таблица точных uri для %s, сгенерирована http_route_gen, не редактировать\n"
+			" * Перегенерировать после изменения списка обработчиков:\n"
+			" * http_route_gen --source=%s%s%s --output=%s --name=%s --include=%s\n"
+			" */\n"
+			"#ifndef %s\n"
+			"#define %s\n"
+			"\n"
+			"#include \"%s\"\n"
+			"\n"
+			"static const uint32_t %s_slots[%u] ICACHE_RODATA_ATTR =\n"
+			"{\n",
+			source, source, array != nullptr ? " --array=" : "", array != nullptr ? array : "", output, name, include,
+			guard.c_str(), guard.c_str(), include, name, mask + 1);
+	for(uint32_t slot = 0; slot <= mask; ++slot)
+	{
+		if(slots[slot] == HTTP_ROUTE_NONE)
+		{
+			fprintf(file, "\tHTTP_ROUTE_NONE,\n");
+		}
+		else
+		{
+			fprintf(file, "\t%u,\t// %s\n", slots[slot], rules[slots[slot]].uri.c_str());
+		}
+	}
+	fprintf(file, "};\n"
+			"\n"
+			"static const struct http_route_table %s ICACHE_RODATA_ATTR =\n"
+			"{\n"
+			"\t0x%08Xu,\n"
+			"\t%u,\n"
+			"\t%u,\n"
+			"\t%s_slots\n"
+			"};\n"
+			"\n"
+			"#endif\n", name, seed, mask, exact, name);
+	fclose(file);
+
+	printf("%s: %u routes, %u exact in %u slots, seed 0x%08X\n", output, (uint32_t) rules.size(), exact, mask + 1, seed);
+	return 0;
+}
+
+/**
+ * @}
+ */
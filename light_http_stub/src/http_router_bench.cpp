@@ -0,0 +1,199 @@
+#include "http_router.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief uri устройства из user/user_main.c, к ним добавляются сгенерированные
+ */
+static const char* bench_device_uris[] =
+{
+	"/getSystemInfo",
+	"/getDeviceInfo",
+	"/getBroadcastNetworks",
+	"/setDeviceName",
+	"/setWifi",
+	"/getWifiError",
+	"/on",
+	"/off",
+	"/status",
+	"/testModeOn",
+	"/testModeOff",
+};
+
+static int bench_handler(struct query* query)
+{
+	(void) query;
+	return 1;
+}
+
+static uint64_t bench_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Прежний поиск light_http: перебор правил через strcmp
+ */
+static const http_handler_rule* bench_linear(const http_handler_rule* rules, const char* uri)
+{
+	for(const http_handler_rule* rule = rules; rule->uri != NULL && rule->handler != NULL; ++rule)
+	{
+		if(strcmp(uri, rule->uri) == 0)
+		{
+			return rule;
+		}
+	}
+	return nullptr;
+}
+
+static void bench_run(const http_router* router, const http_handler_rule* rules, const char* name, const char* uri, uint64_t iterations, uint32_t routes, bool csv)
+{
+	uint32_t length = strlen(uri);
+	http_route_match match;
+	HTTP_ROUTE_RESULT result = http_router_match(router, uri, length, REQUEST_GET, &match);
+	const http_handler_rule* expected = bench_linear(rules, uri);
+	if((result == HTTP_ROUTE_FOUND ? match.rule : nullptr) != expected)
+	{
+		fprintf(stderr, "%s: router and strcmp disagree on %s\n", name, uri);
+		exit(1);
+	}
+
+	uint64_t found = 0;
+	uint64_t start = bench_clock();
+	for(uint64_t i = 0; i < iterations; ++i)
+	{
+		found += http_router_match(router, uri, length, REQUEST_GET, &match) == HTTP_ROUTE_FOUND ? 1 : 0;
+		asm volatile("" ::: "memory");
+	}
+	double trie_ns = static_cast<double>(bench_clock() - start) / iterations;
+
+	start = bench_clock();
+	for(uint64_t i = 0; i < iterations; ++i)
+	{
+		found += bench_linear(rules, uri) != nullptr ? 1 : 0;
+		asm volatile("" ::: "memory");
+	}
+	double linear_ns = static_cast<double>(bench_clock() - start) / iterations;
+
+	if(csv)
+	{
+		printf("%u,%s,%s,%.1f,%.1f\n", routes, name, uri, trie_ns, linear_ns);
+	}
+	else
+	{
+		printf("%5u routes %-7s %-32s trie %8.1f ns, strcmp %8.1f ns\n", routes, name, uri, trie_ns, linear_ns);
+	}
+	asm volatile("" : : "r"(found));
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --routes=N               total routes, device uris plus generated /api/gN/itemM, default 11,32,128,512\n"
+			"  --iterations=N           lookups per uri\n"
+			"  --csv                    machine readable output\n", name);
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	uint64_t iterations = 1000000;
+	std::vector<uint32_t> counts;
+	bool csv = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--routes")) != nullptr)
+		{
+			counts.push_back(strtoul(value, nullptr, 10));
+		}
+		else if((value = option_value(argv[i], "--iterations")) != nullptr)
+		{
+			iterations = strtoull(value, nullptr, 10);
+		}
+		else if(strcmp(argv[i], "--csv") == 0)
+		{
+			csv = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(iterations == 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if(counts.empty())
+	{
+		counts = { 11, 32, 128, 512 };
+	}
+
+	if(csv)
+	{
+		printf("routes,lookup,uri,trie_ns,strcmp_ns\n");
+	}
+
+	const uint32_t device_count = sizeof(bench_device_uris) / sizeof(bench_device_uris[0]);
+	for(uint32_t count : counts)
+	{
+		std::vector<std::string> uris(bench_device_uris, bench_device_uris + device_count);
+		for(uint32_t i = device_count; i < count; ++i)
+		{
+			uris.push_back("/api/g" + std::to_string(i % 8) + "/item" + std::to_string(i));
+		}
+
+		std::vector<http_handler_rule> rules;
+		for(const std::string& uri : uris)
+		{
+			rules.push_back({ uri.c_str(), bench_handler, HTTP_METHOD_ANY });
+		}
+		rules.push_back({ NULL, NULL, HTTP_METHOD_ANY });
+
+		http_router router;
+		if(!http_router_init(&router, rules.data()))
+		{
+			fprintf(stderr, "http_router_init failed for %u routes\n", count);
+			return 1;
+		}
+
+		bench_run(&router, rules.data(), "first", uris.front().c_str(), iterations, uris.size(), csv);
+		bench_run(&router, rules.data(), "status", "/status", iterations, uris.size(), csv);
+		bench_run(&router, rules.data(), "last", uris.back().c_str(), iterations, uris.size(), csv);
+		bench_run(&router, rules.data(), "missing", "/favicon.ico", iterations, uris.size(), csv);
+		http_router_free(&router);
+	}
+	return 0;
+}
+
+/**
+ * @}
+ */
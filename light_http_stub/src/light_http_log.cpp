@@ -0,0 +1,34 @@
+#include "esp_common.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+static int log_enabled = 1;
+
+int light_http_stub_log(const char* format, ...)
+{
+	int result = 0;
+	if(log_enabled)
+	{
+		va_list args;
+		va_start(args, format);
+		result = vprintf(format, args);
+		va_end(args);
+	}
+	return result;
+}
+
+void light_http_stub_log_enable(int enable)
+{
+	log_enabled = enable;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,853 @@
+#include "lwip_shim.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Состояние соединения
+ */
+enum tcp_shim_state
+{
+	TCP_SHIM_NEW = 0,		///< создан tcp_new
+	TCP_SHIM_LISTEN,		///< слушающий сокет
+	TCP_SHIM_ACTIVE,		///< соединение установлено
+	TCP_SHIM_CLOSING,		///< вызван tcp_close, ожидается отправка очереди
+	TCP_SHIM_CLOSED			///< сокет закрыт, освобождается в конце итерации цикла
+};
+
+/**
+ * @brief Соединение поверх неблокирующего сокета
+ */
+struct tcp_pcb
+{
+	int fd;							///< сокет, -1 до tcp_listen
+	enum tcp_shim_state state;		///< состояние
+	uint32_t events;				///< события epoll на которые подписан сокет
+
+	ip_addr_t local_ip;				///< адрес tcp_bind
+	u16_t local_port;				///< порт tcp_bind
+
+	void* arg;						///< аргумент callback (tcp_arg)
+	tcp_accept_fn accept;
+	tcp_recv_fn recv;
+	tcp_sent_fn sent;
+	tcp_poll_fn poll;
+	tcp_err_fn errf;
+
+	u8_t pollinterval;				///< период poll в тиках tcp_slowtmr
+	u8_t polltmr;					///< тиков с последнего poll
+
+	u16_t snd_buf;					///< свободное место в очереди отправки
+	std::vector<uint8_t> unsent;	///< очередь отправки
+	size_t unsent_offset;			///< сколько из очереди уже передано ядру
+	uint32_t acked;					///< передано ядру, но еще не сообщено через tcp_sent
+
+	struct pbuf* refused;			///< данные от которых отказался recv
+	bool remote_closed;				///< клиент закрыл соединение
+	bool fin_delivered;				///< recv(NULL) уже вызван
+};
+
+/**
+ * @brief Состояние tcpip потока, в lwIP эти данные тоже глобальные
+ */
+struct lwip_shim
+{
+	int epoll = -1;
+	int wakeup = -1;					///< eventfd для lwip_shim_stop
+	volatile bool stop = false;
+
+	uint32_t slow_interval = TCP_SLOW_INTERVAL;
+	uint64_t next_slow = 0;
+	uint64_t next_fast = 0;
+
+	struct tcp_pcb* listener = NULL;
+	bool listener_paused = false;		///< слушающий сокет снят с epoll, все pcb заняты
+
+	std::vector<struct tcp_pcb*> pcbs;	///< активные соединения
+	std::vector<struct tcp_pcb*> dead;	///< закрытые, освобождаются в конце итерации
+
+	struct lwip_shim_stats stats = {};
+};
+
+static struct lwip_shim shim;
+
+const ip_addr_t ip_addr_any = { 0 };
+
+static uint64_t now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void shim_update_events(struct tcp_pcb* pcb)
+{
+	if(pcb->fd < 0 || pcb->state == TCP_SHIM_CLOSED)
+	{
+		return;
+	}
+
+	uint32_t events = 0;
+	if(pcb->state == TCP_SHIM_ACTIVE && pcb->refused == NULL && !pcb->remote_closed)
+	{	// пока recv не принял данные, новые не читаются, как закрытое окно lwIP
+		events |= EPOLLIN;
+	}
+
+	if(pcb->unsent_offset < pcb->unsent.size())
+	{
+		events |= EPOLLOUT;
+	}
+
+	if(events != pcb->events)
+	{
+		struct epoll_event ev;
+		ev.events = events;
+		ev.data.ptr = pcb;
+		epoll_ctl(shim.epoll, EPOLL_CTL_MOD, pcb->fd, &ev);
+		pcb->events = events;
+	}
+}
+
+static void shim_listener_watch(bool enable)
+{
+	if(shim.listener == NULL || enable == !shim.listener_paused)
+	{
+		return;
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = shim.listener;
+	epoll_ctl(shim.epoll, enable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, shim.listener->fd, &ev);
+	shim.listener_paused = !enable;
+}
+
+/**
+ * @brief Функция закрытия сокета, pcb освобождается в конце итерации цикла
+ */
+static void shim_release(struct tcp_pcb* pcb)
+{
+	if(pcb->state == TCP_SHIM_CLOSED)
+	{
+		return;
+	}
+
+	if(pcb->fd >= 0)
+	{
+		close(pcb->fd);
+		pcb->fd = -1;
+	}
+
+	if(pcb->refused != NULL)
+	{
+		pbuf_free(pcb->refused);
+		pcb->refused = NULL;
+	}
+
+	pcb->state = TCP_SHIM_CLOSED;
+	shim.dead.push_back(pcb);
+}
+
+/**
+ * @brief Функция разрыва соединения с уведомлением через tcp_err
+ */
+static void shim_reset(struct tcp_pcb* pcb, err_t err)
+{
+	tcp_err_fn errf = pcb->errf;
+	void* arg = pcb->arg;
+
+	shim_release(pcb);
+	++shim.stats.reset;
+
+	if(errf != NULL)
+	{
+		errf(arg, err);
+	}
+}
+
+/**
+ * @brief Функция передачи очереди отправки ядру
+ */
+static void shim_output(struct tcp_pcb* pcb)
+{
+	if(pcb->state != TCP_SHIM_ACTIVE && pcb->state != TCP_SHIM_CLOSING)
+	{
+		return;
+	}
+
+	while(pcb->unsent_offset < pcb->unsent.size())
+	{
+		ssize_t sent = send(pcb->fd, pcb->unsent.data() + pcb->unsent_offset, pcb->unsent.size() - pcb->unsent_offset, MSG_NOSIGNAL);
+		if(sent > 0)
+		{
+			pcb->unsent_offset += sent;
+			pcb->acked += sent;
+			shim.stats.bytes_sent += sent;
+		}
+		else if(sent < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+		else
+		{
+			shim_reset(pcb, ERR_RST);
+			return;
+		}
+	}
+
+	if(pcb->unsent_offset == pcb->unsent.size())
+	{
+		pcb->unsent.clear();
+		pcb->unsent_offset = 0;
+
+		if(pcb->state == TCP_SHIM_CLOSING)
+		{
+			shim_release(pcb);
+			return;
+		}
+	}
+	shim_update_events(pcb);
+}
+
+/**
+ * @brief Функция передачи данных в recv, как tcp_input
+ */
+static void shim_deliver(struct tcp_pcb* pcb, struct pbuf* p)
+{
+	if(pcb->state != TCP_SHIM_ACTIVE)
+	{
+		if(p != NULL)
+		{
+			pbuf_free(p);
+		}
+		return;
+	}
+
+	if(p == NULL)
+	{
+		pcb->fin_delivered = true;
+	}
+
+	if(pcb->recv == NULL)
+	{	// tcp_recv_null
+		if(p != NULL)
+		{
+			tcp_recved(pcb, p->tot_len);
+			pbuf_free(p);
+		}
+		else
+		{
+			tcp_close(pcb);
+		}
+		return;
+	}
+
+	err_t err = pcb->recv(pcb->arg, pcb, p, ERR_OK);
+	if(err == ERR_ABRT)
+	{
+		return;
+	}
+
+	if(p != NULL && err != ERR_OK)
+	{	// данные остаются за стеком и предлагаются повторно в tcp_fasttmr
+		if(pcb->state == TCP_SHIM_ACTIVE)
+		{
+			pcb->refused = p;
+			++shim.stats.refused;
+		}
+		else
+		{
+			pbuf_free(p);
+		}
+	}
+}
+
+static struct pbuf* shim_pbuf_chain(const uint8_t* data, size_t size)
+{
+	struct pbuf* head = NULL;
+	struct pbuf** tail = &head;
+	for(size_t offset = 0; offset < size; offset += TCP_MSS)
+	{
+		size_t len = std::min<size_t>(TCP_MSS, size - offset);
+
+		struct pbuf* p = (struct pbuf*) calloc(1, sizeof(struct pbuf) + len);
+		p->payload = (uint8_t*) p + sizeof(struct pbuf);
+		p->len = len;
+		p->tot_len = size - offset;
+		p->ref = 1;
+		memcpy(p->payload, data + offset, len);
+
+		*tail = p;
+		tail = &p->next;
+	}
+	return head;
+}
+
+static void shim_read(struct tcp_pcb* pcb)
+{
+	uint8_t buffer[TCP_WND];
+	ssize_t received = recv(pcb->fd, buffer, sizeof(buffer), 0);
+	if(received > 0)
+	{
+		shim.stats.bytes_received += received;
+		shim_deliver(pcb, shim_pbuf_chain(buffer, received));
+	}
+	else if(received == 0)
+	{
+		pcb->remote_closed = true;
+		if(pcb->refused == NULL)
+		{
+			shim_deliver(pcb, NULL);
+		}
+	}
+	else if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+	{
+		shim_reset(pcb, ERR_RST);
+		return;
+	}
+	shim_update_events(pcb);
+}
+
+static void shim_accept()
+{
+	struct tcp_pcb* listener = shim.listener;
+	while(shim.pcbs.size() < MEMP_NUM_TCP_PCB)
+	{
+		int fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if(fd < 0)
+		{
+			return;
+		}
+
+		int flag = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+		struct tcp_pcb* pcb = new tcp_pcb();
+		pcb->fd = fd;
+		pcb->state = TCP_SHIM_ACTIVE;
+		pcb->events = EPOLLIN;
+		pcb->snd_buf = TCP_SND_BUF;
+		pcb->pollinterval = 1;
+
+		struct epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.ptr = pcb;
+		epoll_ctl(shim.epoll, EPOLL_CTL_ADD, fd, &ev);
+
+		shim.pcbs.push_back(pcb);
+		++shim.stats.accepted;
+
+		err_t err = listener->accept != NULL
+			? listener->accept(listener->arg, pcb, ERR_OK)
+			: ERR_VAL;
+
+		if(err != ERR_OK && err != ERR_ABRT)
+		{
+			tcp_abort(pcb);
+		}
+	}
+
+	// свободных pcb нет, новые соединения ждут в backlog ядра
+	shim_listener_watch(false);
+}
+
+/**
+ * @brief tcp_slowtmr: вызов poll
+ */
+static void shim_slow_timer()
+{
+	std::vector<struct tcp_pcb*> pcbs = shim.pcbs;
+	for(struct tcp_pcb* pcb : pcbs)
+	{
+		if(pcb->state != TCP_SHIM_ACTIVE || pcb->poll == NULL)
+		{
+			continue;
+		}
+
+		if(++pcb->polltmr >= pcb->pollinterval)
+		{
+			pcb->polltmr = 0;
+			++shim.stats.polls;
+			pcb->poll(pcb->arg, pcb);
+		}
+	}
+}
+
+/**
+ * @brief tcp_fasttmr: повторная передача отклоненных данных
+ */
+static void shim_fast_timer()
+{
+	std::vector<struct tcp_pcb*> pcbs = shim.pcbs;
+	for(struct tcp_pcb* pcb : pcbs)
+	{
+		if(pcb->state != TCP_SHIM_ACTIVE)
+		{
+			continue;
+		}
+
+		if(pcb->refused != NULL)
+		{
+			struct pbuf* p = pcb->refused;
+			pcb->refused = NULL;
+			shim_deliver(pcb, p);
+		}
+
+		if(pcb->state == TCP_SHIM_ACTIVE && pcb->refused == NULL && pcb->remote_closed && !pcb->fin_delivered)
+		{
+			shim_deliver(pcb, NULL);
+		}
+		shim_update_events(pcb);
+	}
+}
+
+/**
+ * @brief Завершение итерации: отправка очередей, tcp_sent, освобождение закрытых pcb
+ */
+static void shim_flush()
+{
+	std::vector<struct tcp_pcb*> pcbs = shim.pcbs;
+	for(struct tcp_pcb* pcb : pcbs)
+	{
+		shim_output(pcb);
+
+		if(pcb->state == TCP_SHIM_ACTIVE && pcb->acked != 0)
+		{	// ядро приняло данные, для lwIP это ACK от клиента
+			u16_t len = pcb->acked;
+			pcb->acked = 0;
+			pcb->snd_buf += len;
+
+			if(pcb->sent != NULL)
+			{
+				pcb->sent(pcb->arg, pcb, len);
+				shim_output(pcb);
+			}
+		}
+	}
+
+	for(struct tcp_pcb* pcb : shim.dead)
+	{
+		shim.pcbs.erase(std::remove(shim.pcbs.begin(), shim.pcbs.end(), pcb), shim.pcbs.end());
+		delete pcb;
+	}
+	shim.dead.clear();
+
+	if(shim.listener != NULL && shim.pcbs.size() < MEMP_NUM_TCP_PCB)
+	{
+		shim_listener_watch(true);
+	}
+}
+
+bool lwip_shim_init(uint32_t slow_interval)
+{
+	if(shim.epoll >= 0)
+	{
+		return true;
+	}
+
+	shim.epoll = epoll_create1(EPOLL_CLOEXEC);
+	shim.wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(shim.epoll < 0 || shim.wakeup < 0)
+	{
+		perror("lwip_shim_init");
+		return false;
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	epoll_ctl(shim.epoll, EPOLL_CTL_ADD, shim.wakeup, &ev);
+
+	shim.slow_interval = slow_interval != 0 ? slow_interval : TCP_SLOW_INTERVAL;
+	return true;
+}
+
+/**
+ * @brief Есть ли переданные ядру данные, о которых еще не сообщено через tcp_sent
+ * Данные, записанные в tcp_sent, подтверждаются на следующей итерации без ожидания таймеров
+ */
+static bool shim_has_acked()
+{
+	for(struct tcp_pcb* pcb : shim.pcbs)
+	{
+		if(pcb->state == TCP_SHIM_ACTIVE && pcb->acked != 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void lwip_shim_run()
+{
+	uint64_t now = now_ms();
+	shim.next_slow = now + shim.slow_interval;
+	shim.next_fast = now + TCP_FAST_INTERVAL;
+
+	struct epoll_event events[64];
+	while(!shim.stop)
+	{
+		now = now_ms();
+		uint64_t deadline = std::min(shim.next_slow, shim.next_fast);
+		int timeout = deadline > now && !shim_has_acked() ? (int) (deadline - now) : 0;
+
+		int count = epoll_wait(shim.epoll, events, sizeof(events) / sizeof(events[0]), timeout);
+		for(int i = 0; i < count; ++i)
+		{
+			struct tcp_pcb* pcb = (struct tcp_pcb*) events[i].data.ptr;
+			if(pcb == NULL)
+			{
+				uint64_t value;
+				ssize_t ignored = read(shim.wakeup, &value, sizeof(value));
+				(void) ignored;
+			}
+			else if(pcb == shim.listener)
+			{
+				shim_accept();
+			}
+			else if(pcb->state == TCP_SHIM_ACTIVE || pcb->state == TCP_SHIM_CLOSING)
+			{
+				if(events[i].events & (EPOLLERR | EPOLLHUP))
+				{
+					int error = 0;
+					socklen_t size = sizeof(error);
+					getsockopt(pcb->fd, SOL_SOCKET, SO_ERROR, &error, &size);
+					if(error != 0 || pcb->state == TCP_SHIM_CLOSING)
+					{
+						shim_reset(pcb, ERR_RST);
+						continue;
+					}
+				}
+
+				if((events[i].events & (EPOLLIN | EPOLLHUP)) && pcb->state == TCP_SHIM_ACTIVE)
+				{
+					shim_read(pcb);
+				}
+
+				if(events[i].events & EPOLLOUT)
+				{
+					shim_output(pcb);
+				}
+			}
+		}
+
+		now = now_ms();
+		if(now >= shim.next_fast)
+		{
+			shim.next_fast = now + TCP_FAST_INTERVAL;
+			shim_fast_timer();
+		}
+
+		if(now >= shim.next_slow)
+		{
+			shim.next_slow = now + shim.slow_interval;
+			shim_slow_timer();
+		}
+		shim_flush();
+	}
+	shim.stop = false;
+}
+
+void lwip_shim_stop()
+{
+	shim.stop = true;
+
+	uint64_t value = 1;
+	ssize_t ignored = write(shim.wakeup, &value, sizeof(value));
+	(void) ignored;
+}
+
+struct lwip_shim_stats lwip_shim_get_stats()
+{
+	return shim.stats;
+}
+
+const char* lwip_strerr(err_t err)
+{
+	switch(err)
+	{
+		case ERR_OK: return "Ok.";
+		case ERR_MEM: return "Out of memory error.";
+		case ERR_BUF: return "Buffer error.";
+		case ERR_TIMEOUT: return "Timeout.";
+		case ERR_RTE: return "Routing problem.";
+		case ERR_INPROGRESS: return "Operation in progress.";
+		case ERR_VAL: return "Illegal value.";
+		case ERR_WOULDBLOCK: return "Operation would block.";
+		case ERR_USE: return "Address in use.";
+		case ERR_ISCONN: return "Already connected.";
+		case ERR_ABRT: return "Connection aborted.";
+		case ERR_RST: return "Connection reset.";
+		case ERR_CLSD: return "Connection closed.";
+		case ERR_CONN: return "Not connected.";
+		case ERR_ARG: return "Illegal argument.";
+		case ERR_IF: return "Low-level netif error.";
+	}
+	return "Unknown error.";
+}
+
+u8_t pbuf_free(struct pbuf* p)
+{
+	u8_t count = 0;
+	while(p != NULL)
+	{
+		if(--p->ref != 0)
+		{
+			break;
+		}
+
+		struct pbuf* next = p->next;
+		free(p);
+		p = next;
+		++count;
+	}
+	return count;
+}
+
+void pbuf_ref(struct pbuf* p)
+{
+	if(p != NULL)
+	{
+		++p->ref;
+	}
+}
+
+u16_t pbuf_copy_partial(struct pbuf* buf, void* data, u16_t len, u16_t offset)
+{
+	u16_t copied = 0;
+	for(struct pbuf* p = buf; p != NULL && len != 0; p = p->next)
+	{
+		if(offset >= p->len)
+		{
+			offset -= p->len;
+			continue;
+		}
+
+		u16_t size = std::min<u16_t>(p->len - offset, len);
+		memcpy((uint8_t*) data + copied, (uint8_t*) p->payload + offset, size);
+		copied += size;
+		len -= size;
+		offset = 0;
+	}
+	return copied;
+}
+
+struct tcp_pcb* tcp_new(void)
+{
+	struct tcp_pcb* pcb = new tcp_pcb();
+	pcb->fd = -1;
+	pcb->state = TCP_SHIM_NEW;
+	pcb->snd_buf = TCP_SND_BUF;
+	pcb->pollinterval = 1;
+	return pcb;
+}
+
+err_t tcp_bind(struct tcp_pcb* pcb, ip_addr_t* ipaddr, u16_t port)
+{
+	if(pcb == NULL || pcb->state != TCP_SHIM_NEW)
+	{
+		return ERR_VAL;
+	}
+
+	pcb->local_ip = ipaddr != NULL ? *ipaddr : ip_addr_any;
+	pcb->local_port = port;
+	return ERR_OK;
+}
+
+struct tcp_pcb* tcp_listen(struct tcp_pcb* pcb)
+{
+	if(pcb == NULL || pcb->state != TCP_SHIM_NEW || shim.epoll < 0)
+	{
+		return NULL;
+	}
+
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(fd < 0)
+	{
+		perror("tcp_listen");
+		return NULL;
+	}
+
+	int flag = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = pcb->local_ip.addr;
+	addr.sin_port = htons(pcb->local_port);
+
+	if(bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+	{
+		perror("tcp_listen");
+		close(fd);
+		return NULL;
+	}
+
+	pcb->fd = fd;
+	pcb->state = TCP_SHIM_LISTEN;
+	shim.listener = pcb;
+	shim.listener_paused = true;
+	shim_listener_watch(true);
+	return pcb;
+}
+
+void tcp_accepted(struct tcp_pcb_listen* pcb)
+{
+	(void) pcb;
+}
+
+void tcp_arg(struct tcp_pcb* pcb, void* arg)
+{
+	pcb->arg = arg;
+}
+
+void tcp_accept(struct tcp_pcb* pcb, tcp_accept_fn accept)
+{
+	pcb->accept = accept;
+}
+
+void tcp_recv(struct tcp_pcb* pcb, tcp_recv_fn recv)
+{
+	pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb* pcb, tcp_sent_fn sent)
+{
+	pcb->sent = sent;
+}
+
+void tcp_poll(struct tcp_pcb* pcb, tcp_poll_fn poll, u8_t interval)
+{
+	pcb->poll = poll;
+	pcb->pollinterval = interval;
+}
+
+void tcp_err(struct tcp_pcb* pcb, tcp_err_fn err)
+{
+	pcb->errf = err;
+}
+
+void tcp_setprio(struct tcp_pcb* pcb, u8_t prio)
+{
+	(void) pcb;
+	(void) prio;
+}
+
+void tcp_recved(struct tcp_pcb* pcb, u16_t len)
+{
+	(void) pcb;
+	(void) len;
+}
+
+err_t tcp_write(struct tcp_pcb* pcb, const void* data, u16_t len, u8_t apiflags)
+{
+	(void) apiflags;
+
+	if(pcb->state != TCP_SHIM_ACTIVE)
+	{
+		return ERR_CONN;
+	}
+
+	if(len > pcb->snd_buf)
+	{
+		return ERR_MEM;
+	}
+
+	const uint8_t* bytes = (const uint8_t*) data;
+	pcb->unsent.insert(pcb->unsent.end(), bytes, bytes + len);
+	pcb->snd_buf -= len;
+	return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb* pcb)
+{
+	// очередь отправляется в shim_flush в конце итерации: как и в lwIP, ошибка
+	// соединения не вызывает tcp_err внутри callback, из которого вызван tcp_output
+	(void) pcb;
+	return ERR_OK;
+}
+
+u16_t tcp_sndbuf(struct tcp_pcb* pcb)
+{
+	return pcb->snd_buf;
+}
+
+err_t tcp_close(struct tcp_pcb* pcb)
+{
+	if(pcb->state == TCP_SHIM_LISTEN)
+	{
+		shim_listener_watch(false);
+		close(pcb->fd);
+		shim.listener = NULL;
+		delete pcb;
+		return ERR_OK;
+	}
+
+	if(pcb->state == TCP_SHIM_NEW)
+	{
+		delete pcb;
+		return ERR_OK;
+	}
+
+	if(pcb->state != TCP_SHIM_ACTIVE)
+	{
+		return ERR_OK;
+	}
+
+	pcb->state = TCP_SHIM_CLOSING;
+	++shim.stats.closed;
+	shim_output(pcb);
+	return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb* pcb)
+{
+	if(pcb->state != TCP_SHIM_ACTIVE && pcb->state != TCP_SHIM_CLOSING)
+	{
+		return;
+	}
+
+	// SO_LINGER 0: close отправляет RST
+	struct linger linger = { 1, 0 };
+	setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+
+	tcp_err_fn errf = pcb->errf;
+	void* arg = pcb->arg;
+
+	shim_release(pcb);
+	++shim.stats.aborted;
+
+	if(errf != NULL)
+	{
+		errf(arg, ERR_ABRT);
+	}
+}
+
+/**
+ * @}
+ */
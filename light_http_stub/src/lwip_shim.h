@@ -0,0 +1,54 @@
+#pragma once
+
+#include "lwip/tcp.h"
+
+#include <stdint.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Статистика tcpip потока
+ */
+struct lwip_shim_stats
+{
+	uint64_t accepted;			///< принято соединений
+	uint64_t closed;			///< закрыто сервером (tcp_close)
+	uint64_t aborted;			///< разорвано сервером (tcp_abort)
+	uint64_t reset;				///< разорвано клиентом
+	uint64_t refused;			///< recv отказался принять данные (повтор в tcp_fasttmr)
+	uint64_t bytes_received;	///< принято байт
+	uint64_t bytes_sent;		///< отправлено байт
+	uint64_t polls;				///< вызовов poll
+};
+
+/**
+ * @brief Функция инициализации tcpip потока, вызывается до первого tcp_*
+ * @param[in] slow_interval Период tcp_slowtmr в ms, на устройстве TCP_SLOW_INTERVAL
+ * @return false если не удалось создать epoll
+ */
+bool lwip_shim_init(uint32_t slow_interval);
+
+/**
+ * @brief Функция запуска цикла tcpip потока в текущем потоке
+ * Все callback lwIP вызываются из этого потока, как из tcpip task на устройстве.
+ * Возвращает управление после lwip_shim_stop
+ */
+void lwip_shim_run();
+
+/**
+ * @brief Функция остановки цикла, можно вызывать из обработчика сигнала
+ */
+void lwip_shim_stop();
+
+/**
+ * @brief Функция получения статистики
+ */
+struct lwip_shim_stats lwip_shim_get_stats();
+
+/**
+ * @}
+ */
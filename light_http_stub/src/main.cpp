@@ -0,0 +1,362 @@
+#include "light_http.h"
+#include "lwip_shim.h"
+#include "stub_http_routes.h"
+
+#include <iostream>
+#include <thread>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+#define STATIC_STRLEN(x) (sizeof(x) - 1)
+
+uint16_t light_http_stub_port = 8080;
+
+/**
+ * @brief Состояние виртуальной нагрузки
+ */
+static bool stub_power = false;
+
+/**
+ * @brief Имя устройства (/setDeviceName)
+ */
+static char stub_name[32] = "PC-stub";
+
+/**
+ * @brief Задержка ответа сканирования сетей, ответ асинхронный как у прошивки
+ */
+static uint32_t stub_scan_delay = 100;
+
+static void response_json(struct query* query, const char* data)
+{
+	query_response_status(200, query);
+	query_response_header("Content-Type", "application/json", query);
+	query_response_body(data, strlen(data), query);
+}
+
+static void response_text(struct query* query, const char* data)
+{
+	query_response_status(200, query);
+	query_response_header("Content-Type", "text/html", query);
+	query_response_body(data, strlen(data), query);
+}
+
+/**
+ * @brief Ответ /on, /off, /status в формате параметра type как у прошивки
+ */
+static void response_power(struct query* query, const char* string, const char* flag)
+{
+	const char* type = query_get_param("type", query, REQUEST_GET);
+	if(type == NULL || strncasecmp(type, "string", STATIC_STRLEN("string")) == 0)
+	{
+		response_text(query, string);
+	}
+	else if(strncasecmp(type, "bool", STATIC_STRLEN("bool")) == 0)
+	{
+		response_text(query, flag);
+	}
+	else if(strncasecmp(type, "json", STATIC_STRLEN("json")) == 0)
+	{
+		char data[64];
+		snprintf(data, sizeof(data), "{\"success\":true,\"data\":{\"power\":%s}}", stub_power ? "true" : "false");
+		response_json(query, data);
+	}
+	else
+	{
+		query_response_status(400, query);
+	}
+}
+
+static int http_system_info_handler(struct query* query)
+{
+	response_json(query, "{\"success\":true,\"data\":{\"sdk_version\":\"host\",\"chip_id\":0,\"cpu\":80,\"heap_size\":0}}");
+	return 1;
+}
+
+static int http_get_device_info_handler(struct query* query)
+{
+	char data[128];
+	snprintf(data, sizeof(data), "{\"data\":{\"powered\":%d,\"type\":3,\"name\":\"%s\",\"ip\":\"127.0.0.1\"},\"success\":true}",
+			stub_power ? 1 : 0, stub_name);
+	response_json(query, data);
+	return 1;
+}
+
+static int http_scan_wifi_info_list_handler(struct query* query)
+{	// на устройстве ответ формирует callback сканирования из другой задачи
+	std::thread([query]()
+	{
+		usleep(stub_scan_delay * 1000);
+		response_json(query, "{\"success\":true,\"data\":[\"stub-ap\"]}");
+		query_done(query);
+	}).detach();
+	return 0;
+}
+
+static int http_set_device_name_handler(struct query* query)
+{
+	const char* name = query_get_param("name", query, REQUEST_POST);
+	bool result = name != NULL && strlen(name) < sizeof(stub_name);
+	if(result)
+	{
+		snprintf(stub_name, sizeof(stub_name), "%s", name);
+	}
+	response_json(query, result ? "{\"success\":true}" : "{\"success\":false}");
+	return 1;
+}
+
+static int http_set_main_wifi_handler(struct query* query)
+{
+	bool result = query_get_param("name", query, REQUEST_POST) != NULL
+		&& query_get_param("pass", query, REQUEST_POST) != NULL;
+	response_json(query, result ? "{\"success\":true}" : "{\"success\":false}");
+	return 1;
+}
+
+static int http_get_wifi_error_handler(struct query* query)
+{
+	response_json(query, "{\"success\":false}");
+	return 1;
+}
+
+static int http_on_handler(struct query* query)
+{
+	stub_power = true;
+	response_power(query, "success", "255");
+	return 1;
+}
+
+static int http_off_handler(struct query* query)
+{
+	stub_power = false;
+	response_power(query, "success", "255");
+	return 1;
+}
+
+static int http_status_handler(struct query* query)
+{
+	response_power(query, stub_power ? "on" : "off", stub_power ? "255" : "0");
+	return 1;
+}
+
+static int http_test_mode_handler(struct query* query)
+{
+	response_json(query, "{\"success\":true}");
+	return 1;
+}
+
+/**
+ * @brief Состояние потоковой записи списка устройств
+ */
+struct stub_devices_stream
+{
+	uint32_t count;			///< кол-во устройств в ответе
+	uint32_t piece;			///< следующая часть: 0 - начало, 1..count - устройства, count + 1 - конец
+	char buff[96];			///< текущая часть
+	uint32_t length;		///< размер текущей части
+	uint32_t offset;		///< сколько байт текущей части уже записано
+};
+
+static int http_devices_stream(struct query* query, void* user_data)
+{
+	stub_devices_stream* stream = static_cast<stub_devices_stream*>(user_data);
+	while(true)
+	{
+		if(stream->offset == stream->length)
+		{
+			if(stream->piece == stream->count + 2)
+			{
+				return 1;
+			}
+
+			if(stream->piece == 0)
+			{
+				stream->length = snprintf(stream->buff, sizeof(stream->buff), "{\"success\":true,\"data\":[");
+			}
+			else if(stream->piece <= stream->count)
+			{
+				stream->length = snprintf(stream->buff, sizeof(stream->buff), "%s{\"id\":%u,\"name\":\"device-%u\",\"power\":%s}",
+						stream->piece > 1 ? "," : "", stream->piece, stream->piece, stub_power ? "true" : "false");
+			}
+			else
+			{
+				stream->length = snprintf(stream->buff, sizeof(stream->buff), "]}");
+			}
+			stream->offset = 0;
+			++stream->piece;
+		}
+
+		stream->offset += query_response_write(stream->buff + stream->offset, stream->length - stream->offset, query);
+		if(stream->offset < stream->length)
+		{	// место в части закончилось, продолжение после подтверждения
+			return 0;
+		}
+	}
+}
+
+/**
+ * @brief Список устройств произвольного размера, проверка потокового ответа
+ */
+static int http_devices_handler(struct query* query)
+{
+	const char* count = query_get_param("count", query, REQUEST_GET);
+	stub_devices_stream* stream = static_cast<stub_devices_stream*>(query_alloc(query, sizeof(stub_devices_stream)));
+	if(stream == NULL)
+	{
+		query_response_status(500, query);
+		return 1;
+	}
+
+	stream->count = count != NULL ? strtoul(count, nullptr, 10) : 16;
+	stream->piece = 0;
+	stream->length = 0;
+	stream->offset = 0;
+
+	query_response_status(200, query);
+	query_response_header("Content-Type", "application/json", query);
+	query_response_stream(http_devices_stream, stream, query);
+	return 1;
+}
+
+/**
+ * @brief Проверка параметров пути, на устройстве таких uri нет
+ */
+static int http_device_status_handler(struct query* query)
+{
+	char buff[128];
+	snprintf(buff, sizeof(buff), "{\"id\":\"%s\",\"status\":\"%s\"}",
+			query_get_path_param("id", query), stub_power ? "on" : "off");
+	response_json(query, buff);
+	return 1;
+}
+
+static int http_files_handler(struct query* query)
+{
+	char buff[128];
+	snprintf(buff, sizeof(buff), "{\"path\":\"%s\"}", query_get_path_param("*", query));
+	response_json(query, buff);
+	return 1;
+}
+
+/**
+ * @brief Обработчики с теми же uri что и user/user_main.c
+ */
+static struct http_handler_rule http_handlers[] =
+{
+	{ "/getSystemInfo", http_system_info_handler, HTTP_METHOD_ANY },
+	{ "/getDeviceInfo", http_get_device_info_handler, HTTP_METHOD_ANY },
+	{ "/getBroadcastNetworks", http_scan_wifi_info_list_handler, HTTP_METHOD_ANY },
+	{ "/setDeviceName", http_set_device_name_handler, HTTP_METHOD_ANY },
+	{ "/setWifi", http_set_main_wifi_handler, HTTP_METHOD_ANY },
+	{ "/getWifiError", http_get_wifi_error_handler, HTTP_METHOD_ANY },
+	{ "/on", http_on_handler, HTTP_METHOD_ANY },
+	{ "/off", http_off_handler, HTTP_METHOD_ANY },
+	{ "/status", http_status_handler, HTTP_METHOD_ANY },
+	{ "/testModeOn", http_test_mode_handler, HTTP_METHOD_ANY },
+	{ "/testModeOff", http_test_mode_handler, HTTP_METHOD_ANY },
+	{ "/devices", http_devices_handler, HTTP_METHOD_GET },
+	{ "/device/:id/status", http_device_status_handler, HTTP_METHOD_GET },
+	{ "/files/*", http_files_handler, HTTP_METHOD_GET },
+	{ NULL, NULL, HTTP_METHOD_ANY }
+};
+
+static void on_signal(int signal)
+{
+	(void) signal;
+	lwip_shim_stop();
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --port=PORT              listen port, default 8080\n"
+			"  --slow-interval=MS       lwIP poll period, default %d ms as on device\n"
+			"  --scan-delay=MS          /getBroadcastNetworks async answer delay, default 100\n"
+			"  --no-route-table         find handlers by route tree only, without generated table\n"
+			"  --quiet                  disable light_http logs\n", name, TCP_SLOW_INTERVAL);
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	uint32_t slow_interval = TCP_SLOW_INTERVAL;
+	bool route_table = true;
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--port")) != nullptr)
+		{
+			light_http_stub_port = atoi(value);
+		}
+		else if((value = option_value(argv[i], "--slow-interval")) != nullptr)
+		{
+			slow_interval = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--scan-delay")) != nullptr)
+		{
+			stub_scan_delay = strtoul(value, nullptr, 10);
+		}
+		else if(strcmp(argv[i], "--no-route-table") == 0)
+		{
+			route_table = false;
+		}
+		else if(strcmp(argv[i], "--quiet") == 0)
+		{
+			light_http_stub_log_enable(0);
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(!lwip_shim_init(slow_interval))
+	{
+		return 1;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	asio_webserver_start_table(http_handlers, route_table ? &stub_http_routes : NULL);
+	std::cout << "light_http: listen on " << light_http_stub_port << ", poll every " << slow_interval << " ms" << std::endl;
+
+	lwip_shim_run();
+	asio_webserver_stop();
+
+	struct lwip_shim_stats stats = lwip_shim_get_stats();
+	std::cout << "light_http: accepted " << stats.accepted
+		<< ", closed " << stats.closed
+		<< ", aborted " << stats.aborted
+		<< ", reset " << stats.reset
+		<< ", refused " << stats.refused
+		<< ", polls " << stats.polls
+		<< ", received " << stats.bytes_received
+		<< ", sent " << stats.bytes_sent << std::endl;
+	return 0;
+}
+
+/**
+ * @}
+ */
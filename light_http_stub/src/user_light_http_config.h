@@ -0,0 +1,39 @@
+#ifndef __USER_LIGHT_HTTP_CONFIG_H__
+#define __USER_LIGHT_HTTP_CONFIG_H__
+
+#include "esp_common.h"
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup light_http_stub Light http stub
+ * @addtogroup light_http_stub
+ * @{
+ */
+
+/**
+ * @brief Порт сервера задается из командной строки, на PC 80 порт недоступен без root
+ */
+extern uint16_t light_http_stub_port;
+
+/**
+ * @brief Параметры как у прошивки (user/user_light_http_config.h)
+ */
+#define RECV_BUF_SIZE 1024
+#define SEND_BUF_SIZE 1024 * 2
+#define CONNECTION_POOL_SIZE 2
+#define WEB_SERVER_PORT light_http_stub_port
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+#include "mesh.h"
+#include "mesh_wire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+void mesh_init(struct mesh_ctx* ctx, const struct mesh_transport* transport, struct mesh_message_handlers* handlers)
+{
+	if(ctx != NULL)
+	{
+		ctx->transport = transport;
+		ctx->handlers = handlers;
+		ctx->user_data = NULL;
+	}
+}
+
+void mesh_stop(struct mesh_ctx* ctx)
+{
+	if(ctx != NULL && ctx->transport != NULL && ctx->transport->stop != NULL)
+	{
+		ctx->transport->stop(ctx);
+	}
+	else
+	{
+		LOG("mesh[mesh_stop]: invalid ctx\n");
+	}
+}
+
+uint32_t mesh_send_data(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_t ip)
+{
+	if(ctx == NULL || ctx->transport == NULL || ctx->transport->send == NULL)
+	{
+		LOG("mesh[mesh_send_data]: invalid ctx\n");
+		return 0;
+	}
+	return ctx->transport->send(ctx, data, size, ip);
+}
+
+uint32_t mesh_send_batch(struct mesh_ctx* ctx, struct mesh_packet* packets, uint32_t count)
+{
+	if(ctx == NULL || ctx->transport == NULL)
+	{
+		LOG("mesh[mesh_send_batch]: invalid ctx\n");
+		return 0;
+	}
+
+	if(ctx->transport->send_batch != NULL)
+	{
+		return ctx->transport->send_batch(ctx, packets, count);
+	}
+
+	// транспорт не умеет пакетную отправку, отправляем по одному
+	uint32_t sended = 0;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(mesh_send_data(ctx, packets[i].data, packets[i].size, packets[i].ip) == packets[i].size)
+		{
+			++sended;
+		}
+	}
+	return sended;
+}
+
+uint32_t mesh_receive_data(struct mesh_ctx* ctx, void* data, uint32_t size)
+{
+	if(ctx == NULL || ctx->transport == NULL || ctx->transport->receive == NULL)
+	{
+		LOG("mesh[mesh_receive_data]: not supported by transport\n");
+		return 0;
+	}
+	return ctx->transport->receive(ctx, data, size);
+}
+
+uint32_t mesh_now(struct mesh_ctx* ctx)
+{
+	if(ctx == NULL || ctx->transport == NULL || ctx->transport->now == NULL)
+	{
+		return 0;
+	}
+	return ctx->transport->now(ctx);
+}
+
+uint64_t mesh_clock(struct mesh_ctx* ctx)
+{
+	if(ctx == NULL || ctx->transport == NULL)
+	{
+		return 0;
+	}
+
+	if(ctx->transport->clock == NULL)
+	{
+		return (uint64_t) mesh_now(ctx) * 1000;
+	}
+	return ctx->transport->clock(ctx);
+}
+
+struct mesh_timer* mesh_timer_start(struct mesh_ctx* ctx, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg)
+{
+	if(ctx == NULL || ctx->transport == NULL || ctx->transport->timer_start == NULL)
+	{
+		LOG("mesh[mesh_timer_start]: timers not supported by transport\n");
+		return NULL;
+	}
+	return ctx->transport->timer_start(ctx, ms, repeat, callback, arg);
+}
+
+void mesh_timer_stop(struct mesh_ctx* ctx, struct mesh_timer* timer)
+{
+	if(ctx != NULL && ctx->transport != NULL && ctx->transport->timer_stop != NULL && timer != NULL)
+	{
+		ctx->transport->timer_stop(ctx, timer);
+	}
+}
+
+void mesh_dispatch(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	if(ctx != NULL)
+	{
+		if(mesh_wire_decode(msg))
+		{
+			call_handler(ctx->handlers, ctx, sender, msg);
+		}
+	}
+	else
+	{
+		LOG("mesh[mesh_dispatch]: ctx is null\n");
+	}
+}
+
+/**
+ * @}
+ */
@@ -20,7 +20,7 @@ extern "C" {
  * Данная библиотека предаставляет небольшое api 
  * для рассылки сообщений и их первичной обработки
  *
- * Для того, чтобы запустить mesh придется реализовать ряд функция
+ * Для того, чтобы запустить mesh придется реализовать транспорт (struct mesh_transport)
  * для используемой платформы. Примером может служить @mesh_stub или @user_mesh
  *
  * @addtogroup mesh
@@ -28,9 +28,7 @@ extern "C" {
  */
 
 /**
- * @brief Контекст mesh сети
- * Данная структура не имеет реализации и реализуется в порте. 
- * В общем случае mesh_ctx содежит хендлер сокета, номер порта, список обработчиков сообщений
+ * @see mesh_ctx
  */
 struct mesh_ctx;
 
@@ -48,31 +46,140 @@ struct mesh_message_handlers
 	mesh_message_handler handler;		///< обработчик сообщения
 };
 
+/**
+ * @brief Пакет для пакетной отправки (mesh_send_batch)
+ */
+struct mesh_packet
+{
+	void* data;			///< отправляемые данные
+	uint32_t size;		///< размер данных
+	uint32_t ip;		///< адрес назначения
+};
+
+/**
+ * @brief Таймер транспорта
+ * Данная структура не имеет реализации и реализуется в транспорте
+ */
+struct mesh_timer;
 
 /**
- * @brief Сигнатура функции для запуска mesh
- * @note Это только сигнатура, сама реализация делается под каждый проект и платформу своя
+ * @brief Сигнатура callback таймера
  */
-struct mesh_ctx* mesh_start(struct mesh_message_handlers* handlers, uint32_t addr, uint32_t port);
+typedef void (* mesh_timer_callback)(struct mesh_ctx* ctx, void* arg);
 
 /**
- * @brief Сигнатура остановки mesh
- * @note Это только сигнатура, сама реализация делается под каждый проект и платформу своя
+ * @brief Интерфейс транспорта mesh
+ *
+ * Каждый порт (LwIP, UDP/libev, in-memory) заполняет данную таблицу своими функциями,
+ * благодаря чему в одном процессе могут одновременно работать несколько транспортов.
+ * Необязательные поля могут быть NULL, в этом случае используется поведение по умолчанию
+ * (см. описание полей).
+ */
+struct mesh_transport
+{
+	const char* name;																		///< имя транспорта (для логов)
+
+	uint32_t (* send)(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_t ip);		///< отправка данных
+	uint32_t (* send_batch)(struct mesh_ctx* ctx, struct mesh_packet* packets, uint32_t count);	///< пакетная отправка, если NULL то send в цикле
+	uint32_t (* receive)(struct mesh_ctx* ctx, void* data, uint32_t size);				///< чтение данных, если NULL то транспорт работает только через callback
+
+	uint32_t (* now)(struct mesh_ctx* ctx);												///< текущее время транспорта в ms
+	uint64_t (* clock)(struct mesh_ctx* ctx);												///< локальные часы узла в us (монотонные), если NULL то now * 1000
+	struct mesh_timer* (* timer_start)(struct mesh_ctx* ctx, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg);	///< запуск таймера
+	void (* timer_stop)(struct mesh_ctx* ctx, struct mesh_timer* timer);					///< остановка и удаление таймера
+
+	void (* stop)(struct mesh_ctx* ctx);													///< остановка транспорта и удаление контекста
+};
+
+/**
+ * @brief Контекст mesh сети
+ *
+ * Общая часть контекста, транспорт расширяет ее своими полями
+ * размещая struct mesh_ctx первым полем своей структуры:
+ * @code{c}
+ *	struct mesh_udp_ctx
+ *	{
+ *		struct mesh_ctx base;
+ *		int socket;
+ *	};
+ * @endcode
+ */
+struct mesh_ctx
+{
+	const struct mesh_transport* transport;		///< используемый транспорт
+	struct mesh_message_handlers* handlers;		///< обработчики mesh сообщений
+	void* user_data;							///< пользовательские данные (состояние узла)
+};
+
+/**
+ * @brief Функция инициализации общей части контекста
+ * Вызывается транспортом при создании своего контекста
+ * @param[in] ctx Контекст
+ * @param[in] transport Транспорт
+ * @param[in] handlers Список обработчиков сообщений
+ */
+void mesh_init(struct mesh_ctx* ctx, const struct mesh_transport* transport, struct mesh_message_handlers* handlers);
+
+/**
+ * @brief Функция остановки mesh
+ * После вызова контекст удален транспортом и более не валиден
  */
 void mesh_stop(struct mesh_ctx* ctx);
 
 /**
- * @brief Сигнатура функции отправки данных в mesh
- * @note Это только сигнатура, сама реализация делается под каждый проект и платформу своя
+ * @brief Функция отправки данных в mesh
+ * @return Количество отправленных байт
  */
 uint32_t mesh_send_data(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_t ip);
 
 /**
- * @brief Сигнатура функции получения данных из mesh
- * @note Это только сигнатура, сама реализация делается под каждый проект и платформу своя
+ * @brief Функция пакетной отправки данных в mesh
+ * @return Количество отправленных пакетов
+ */
+uint32_t mesh_send_batch(struct mesh_ctx* ctx, struct mesh_packet* packets, uint32_t count);
+
+/**
+ * @brief Функция получения данных из mesh
+ * @return Количество прочитанных байт
  */
 uint32_t mesh_receive_data(struct mesh_ctx* ctx, void* data, uint32_t size);
 
+/**
+ * @brief Функция получения текущего времени транспорта в ms
+ * @note Для in-memory транспорта время виртуальное
+ */
+uint32_t mesh_now(struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция получения локальных часов узла в us
+ * Точнее mesh_now, используется синхронизацией времени (mesh_time.h)
+ */
+uint64_t mesh_clock(struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция запуска таймера транспорта
+ * @param[in] ctx Контекст
+ * @param[in] ms Период срабатывания
+ * @param[in] repeat 1 - периодический, 0 - однократный
+ * @param[in] callback Функция вызываемая при срабатывании
+ * @param[in] arg Аргумент для callback
+ * @return Таймер либо NULL
+ * @note Однократный таймер удаляется транспортом после срабатывания
+ */
+struct mesh_timer* mesh_timer_start(struct mesh_ctx* ctx, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg);
+
+/**
+ * @brief Функция остановки таймера
+ */
+void mesh_timer_stop(struct mesh_ctx* ctx, struct mesh_timer* timer);
+
+/**
+ * @brief Функция передачи полученного сообщения обработчикам контекста
+ * Вызывается транспортом после получения и проверки размера сообщения,
+ * сообщение декодируется на месте (mesh_wire_decode), неверное отбрасывается
+ */
+void mesh_dispatch(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg);
+
 /**
  * @}
  */
@@ -53,6 +53,14 @@
 	#define MESH_MESSAGE_DATA_SIZE 512
 #endif
 
+/**
+ * @brief Размер таблицы устройств лидера сегмента, struct mesh_election
+ * Таблица хранится в состоянии выборов, на esp ограничена памятью
+ */
+#ifndef MESH_ELECTION_MAX_DEVICES
+	#define MESH_ELECTION_MAX_DEVICES 32
+#endif
+
 /**
  * @}
  */
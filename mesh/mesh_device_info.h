@@ -15,12 +15,14 @@
 /**
  * @brief Структура инсормации об устройстве в сети
  * Данные структуры пересылаются в поле data некоторых сообщений: mesh_keep_alive, mesh_device_info_response 
+ * Формат в сети фиксирован, см. mesh_wire.h
  */
 struct mesh_device_info
 {
 	uint8_t type;						///< тип устройства (разеточное, автономное)
 	uint8_t id;							///< id устройства
-	uint32_t ip;						///< ip устройства
+	uint8_t reserved[2];				///< выравнивание
+	uint32_t ip;						///< ip устройства в сетевом порядке байт (как ip_addr lwIP)
 	char name[MESH_DEVICE_NAME_SIZE];		///< имя устройства
 };
 
@@ -0,0 +1,326 @@
+#include "mesh_election.h"
+#include "mesh.h"
+
+#include <string.h>
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+static void mesh_election_send(struct mesh_ctx* ctx, mesh_message_command command, void* data, uint8_t size, uint32_t dst)
+{
+	struct mesh_message* msg = new_message(command, data, size);
+	if(msg == NULL)
+	{
+		LOG("mesh[mesh_election_send]: failed create message\n");
+		return;
+	}
+
+	uint32_t msg_size = sizeof(struct mesh_message);
+	uint32_t sended_data = mesh_send_data(ctx, (void*) msg, msg_size, dst);
+	if(msg_size != sended_data)
+	{
+		LOG("mesh[mesh_election_send]: sending less data msg_size: %u, sended: %u\n", msg_size, sended_data);
+	}
+	free_message(msg);
+}
+
+static void mesh_election_send_announce(struct mesh_election* election, struct mesh_ctx* ctx)
+{
+	election->announced = mesh_now(ctx);
+
+	struct mesh_election_announce announce;
+	memset(&announce, 0, sizeof(struct mesh_election_announce));
+	announce.node = election->node;
+	announce.priority = election->priority;
+	announce.role = election->role;
+	announce.count = election->count;
+	mesh_election_send(ctx, mesh_election_announce, &announce, sizeof(struct mesh_election_announce), BROADCAST_ADDR);
+}
+
+/**
+ * @brief Функция сравнения старшинства узла с узлом выборов
+ * @return 1 если (priority, node) старше узла election
+ */
+static uint8_t mesh_election_senior(struct mesh_election* election, uint32_t priority, uint32_t node)
+{
+	return priority > election->priority || (priority == election->priority && node > election->node);
+}
+
+static void mesh_election_send_keep_alive(struct mesh_election* election, struct mesh_ctx* ctx, uint32_t now)
+{
+	struct mesh_device_info info;
+	memset(&info, 0, sizeof(struct mesh_device_info));
+	if(election->info == NULL || !election->info(election->arg, &info))
+	{
+		return;
+	}
+	election->keep_alive = now;
+
+	// ведомый отправляет keep_alive только лидеру, сегмент слышит одного лидера
+	uint32_t dst = election->role == mesh_election_follower && election->leader != 0 ? election->leader : BROADCAST_ADDR;
+	mesh_election_send(ctx, mesh_keep_alive, &info, sizeof(struct mesh_device_info), dst);
+}
+
+static void mesh_election_expire(struct mesh_election* election, uint32_t now)
+{
+	uint32_t i = 0;
+	while(i < election->count)
+	{
+		if(now - election->devices[i].last_seen > MESH_ELECTION_DEVICE_TIMEOUT)
+		{
+			election->devices[i] = election->devices[--election->count];
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+static void mesh_election_tick(struct mesh_ctx* ctx, void* arg)
+{
+	struct mesh_election* election = (struct mesh_election*) arg;
+	uint32_t now = mesh_now(ctx);
+
+	switch(election->role)
+	{
+		case mesh_election_follower:
+			if(election->leader != 0 && now - election->leader_seen > MESH_ELECTION_LEASE)
+			{
+				LOG("mesh[mesh_election_tick]: leader lost\n");
+				election->leader = 0;
+				// выборы не ждут следующего keep_alive, чтобы оставшиеся без лидера были слышны
+				election->keep_alive = now - MESH_ELECTION_KEEP_ALIVE;
+			}
+
+			if(election->leader == 0 && election->eligible && now - election->since > MESH_ELECTION_LEASE)
+			{
+				election->role = mesh_election_candidate;
+				election->since = now;
+				mesh_election_send_announce(election, ctx);
+			}
+			break;
+
+		case mesh_election_candidate:
+			if(now - election->since >= MESH_ELECTION_CLAIM)
+			{
+				LOG("mesh[mesh_election_tick]: became leader\n");
+				election->role = mesh_election_leader;
+				election->leader = 0;
+				election->count = 0;
+				election->since = now;
+				mesh_election_send_announce(election, ctx);
+			}
+			break;
+
+		case mesh_election_leader:
+			if(now - election->since >= MESH_ELECTION_HEARTBEAT)
+			{
+				election->since = now;
+				mesh_election_expire(election, now);
+				mesh_election_send_announce(election, ctx);
+			}
+			break;
+	}
+
+	if(now - election->keep_alive >= MESH_ELECTION_KEEP_ALIVE)
+	{
+		mesh_election_send_keep_alive(election, ctx, now);
+	}
+}
+
+void mesh_election_init(struct mesh_election* election, uint32_t node, uint32_t priority, uint8_t eligible, mesh_election_info info, void* arg)
+{
+	if(election != NULL)
+	{
+		memset(election, 0, sizeof(struct mesh_election));
+		election->node = node;
+		election->priority = priority;
+		election->eligible = eligible;
+		election->role = mesh_election_follower;
+		election->info = info;
+		election->arg = arg;
+	}
+}
+
+uint8_t mesh_election_start(struct mesh_election* election, struct mesh_ctx* ctx)
+{
+	if(election == NULL || ctx == NULL)
+	{
+		return 0;
+	}
+
+	uint32_t now = mesh_now(ctx);
+	election->role = mesh_election_follower;
+	election->leader = 0;
+	// при старте ждем анонса действующего лидера в течении аренды
+	election->since = now;
+	election->keep_alive = now - MESH_ELECTION_KEEP_ALIVE;
+
+	election->timer = mesh_timer_start(ctx, MESH_ELECTION_TICK, 1, mesh_election_tick, election);
+	return election->timer != NULL;
+}
+
+void mesh_election_stop(struct mesh_election* election, struct mesh_ctx* ctx)
+{
+	if(election != NULL && election->timer != NULL)
+	{
+		mesh_timer_stop(ctx, election->timer);
+		election->timer = NULL;
+	}
+}
+
+void mesh_election_on_announce(struct mesh_election* election, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	if(election == NULL || sender == NULL || msg == NULL || msg->data_size != sizeof(struct mesh_election_announce))
+	{
+		LOG("mesh[mesh_election_on_announce]: invalid announce\n");
+		return;
+	}
+
+	struct mesh_election_announce announce;
+	memcpy(&announce, msg->data, sizeof(struct mesh_election_announce));
+	if(announce.node == election->node)
+	{	// собственный широковещательный анонс
+		return;
+	}
+
+	uint32_t now = mesh_now(ctx);
+	if(!election->eligible || mesh_election_senior(election, announce.priority, announce.node))
+	{
+		if(election->role != mesh_election_follower)
+		{
+			LOG("mesh[mesh_election_on_announce]: yield to senior node\n");
+			election->role = mesh_election_follower;
+			election->count = 0;
+		}
+
+		if(announce.role == mesh_election_leader)
+		{
+			uint8_t senior = election->leader == 0 || now - election->leader_seen > MESH_ELECTION_LEASE
+					|| announce.priority > election->leader_priority
+					|| (announce.priority == election->leader_priority && announce.node >= election->leader_node);
+			if(senior)
+			{
+				uint8_t changed = election->leader != sender->ip;
+				election->leader = sender->ip;
+				election->leader_node = announce.node;
+				election->leader_priority = announce.priority;
+				election->leader_seen = now;
+				if(changed)
+				{	// новый лидер сразу узнает об узле
+					mesh_election_send_keep_alive(election, ctx, now);
+				}
+			}
+		}
+		// старший кандидат станет лидером, заявку откладываем на срок аренды
+		election->since = now;
+		return;
+	}
+
+	// заявка младшего узла, на заявки всех младших хватит одного ответа
+	switch(election->role)
+	{
+		case mesh_election_leader:
+		case mesh_election_candidate:
+			if(now - election->announced >= MESH_ELECTION_CLAIM / 2)
+			{
+				mesh_election_send_announce(election, ctx);
+			}
+			break;
+
+		case mesh_election_follower:
+			// старший узел недавно был слышен, младшему ответит он
+			if(election->leader == 0 && now - election->since > MESH_ELECTION_LEASE)
+			{
+				election->role = mesh_election_candidate;
+				election->since = now;
+				mesh_election_send_announce(election, ctx);
+			}
+			break;
+	}
+}
+
+void mesh_election_on_keep_alive(struct mesh_election* election, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	if(election == NULL || election->role != mesh_election_leader || sender == NULL || msg == NULL || msg->data_size != sizeof(struct mesh_device_info))
+	{
+		return;
+	}
+
+	struct mesh_election_device* device = NULL;
+	for(uint32_t i = 0; i < election->count; ++i)
+	{
+		if(election->devices[i].entry.ip == sender->ip)
+		{
+			device = &election->devices[i];
+			break;
+		}
+	}
+
+	if(device == NULL)
+	{
+		if(election->count == MESH_ELECTION_MAX_DEVICES)
+		{
+			LOG("mesh[mesh_election_on_keep_alive]: device table is full\n");
+			return;
+		}
+		device = &election->devices[election->count++];
+		device->entry.ip = sender->ip;
+	}
+
+	memcpy(&device->entry.info, msg->data, sizeof(struct mesh_device_info));
+	device->last_seen = mesh_now(ctx);
+}
+
+uint8_t mesh_election_on_discovery(struct mesh_election* election, struct mesh_ctx* ctx, struct mesh_sender_info* sender)
+{
+	if(election == NULL || sender == NULL)
+	{
+		return 0;
+	}
+
+	uint32_t now = mesh_now(ctx);
+	if(election->role == mesh_election_follower)
+	{
+		return election->leader != 0 && now - election->leader_seen <= MESH_ELECTION_LEASE;
+	}
+
+	if(election->role != mesh_election_leader)
+	{
+		return 0;
+	}
+
+	struct mesh_device_info info;
+	memset(&info, 0, sizeof(struct mesh_device_info));
+	if(election->info != NULL && election->info(election->arg, &info))
+	{
+		mesh_send_device_info(ctx, &info, sender->ip);
+	}
+
+	mesh_election_expire(election, now);
+
+	struct mesh_election_table table;
+	for(uint32_t i = 0; i < election->count; i += MESH_ELECTION_TABLE_SIZE)
+	{
+		memset(&table, 0, sizeof(struct mesh_election_table));
+		for(uint32_t j = i; j < election->count && table.count < MESH_ELECTION_TABLE_SIZE; ++j)
+		{
+			table.entries[table.count++] = election->devices[j].entry;
+		}
+		mesh_election_send(ctx, mesh_election_table, &table, sizeof(struct mesh_election_table), sender->ip);
+	}
+	return 1;
+}
+
+uint32_t mesh_election_get_leader(struct mesh_election* election)
+{
+	return election != NULL && election->role == mesh_election_follower ? election->leader : 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,221 @@
+#ifndef __MESH_ELECTION_H__
+#define __MESH_ELECTION_H__
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include "mesh_config.h"
+#include "mesh_device_info.h"
+#include "mesh_sender_info.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+/**
+ * @see mesh.h
+ */
+struct mesh_ctx;
+
+/**
+ * @see mesh.h
+ */
+struct mesh_timer;
+
+/**
+ * @see mesh_message.h
+ */
+struct mesh_message;
+
+/**
+ * @brief Период обработки состояния выборов в ms
+ */
+#define MESH_ELECTION_TICK 250
+
+/**
+ * @brief Период анонса лидера в ms
+ */
+#define MESH_ELECTION_HEARTBEAT 2000
+
+/**
+ * @brief Время без анонса лидера в ms, после которого лидер считается пропавшим
+ */
+#define MESH_ELECTION_LEASE (3 * MESH_ELECTION_HEARTBEAT)
+
+/**
+ * @brief Время в ms, за которое кандидат должен услышать кандидата старше себя
+ */
+#define MESH_ELECTION_CLAIM 500
+
+/**
+ * @brief Период keep_alive узла в ms
+ */
+#define MESH_ELECTION_KEEP_ALIVE 4000
+
+/**
+ * @brief Время без keep_alive в ms, после которого лидер удаляет устройство из таблицы
+ */
+#define MESH_ELECTION_DEVICE_TIMEOUT (3 * MESH_ELECTION_KEEP_ALIVE)
+
+/**
+ * @brief Кол-во устройств в одном сообщении mesh_election_table, data_size сообщения - uint8_t
+ */
+#define MESH_ELECTION_TABLE_SIZE 3
+
+/**
+ * @brief Роль узла
+ */
+typedef enum
+{
+	mesh_election_follower = 0,		///< ведомый, keep_alive уходят лидеру
+	mesh_election_candidate = 1,	///< заявил о себе, ждет заявок старше
+	mesh_election_leader = 2		///< лидер сегмента
+} mesh_election_role;
+
+/**
+ * @brief Анонс, поле data сообщения mesh_election_announce
+ * Старшинство узла - пара (priority, node), старший побеждает
+ */
+struct mesh_election_announce
+{
+	uint32_t node;				///< уникальный номер узла (chip id)
+	uint32_t priority;			///< приоритет узла
+	uint8_t role;				///< mesh_election_candidate либо mesh_election_leader
+	uint8_t count;				///< кол-во устройств в таблице лидера
+	uint8_t reserved[2];		///< выравнивание
+};
+
+/**
+ * @brief Устройство в таблице лидера
+ */
+struct mesh_election_entry
+{
+	uint32_t ip;						///< адрес отправителя keep_alive (как mesh_sender_info::ip)
+	struct mesh_device_info info;		///< последняя информация об устройстве
+};
+
+/**
+ * @brief Часть таблицы лидера, поле data сообщения mesh_election_table
+ * Отправляется лидером в ответ на mesh_devices_info_request вместо ответов всех устройств
+ */
+struct mesh_election_table
+{
+	uint8_t count;												///< кол-во устройств в сообщении
+	uint8_t reserved[3];										///< выравнивание
+	struct mesh_election_entry entries[MESH_ELECTION_TABLE_SIZE];	///< устройства
+};
+
+/**
+ * @brief Запись таблицы устройств лидера
+ */
+struct mesh_election_device
+{
+	struct mesh_election_entry entry;	///< устройство
+	uint32_t last_seen;					///< время последнего keep_alive, ms (mesh_now)
+};
+
+/**
+ * @brief Функция заполнения информации об узле для keep_alive и ответа на опрос
+ * @param[in] arg Аргумент из mesh_election_init
+ * @param[out] info Информация об узле
+ * @return 0 если информацию получить не удалось
+ */
+typedef uint8_t (* mesh_election_info)(void* arg, struct mesh_device_info* info);
+
+/**
+ * @brief Выборы лидера сегмента (bully с арендой)
+ *
+ * Кандидатами могут быть только устройства с постоянным питанием (eligible).
+ * Не услышав лидера в течении MESH_ELECTION_LEASE кандидат заявляет о себе
+ * и через MESH_ELECTION_CLAIM становится лидером, если не услышал заявки старше.
+ * Младший лидер или кандидат, услышав старшего, уступает, старший лидер в ответ
+ * на заявку младшего сразу повторяет анонс.
+ *
+ * Лидер раз в MESH_ELECTION_HEARTBEAT рассылает анонс, собирает keep_alive
+ * сегмента и отвечает на опрос устройств за весь сегмент (mesh_election_table).
+ * Ведомые отправляют keep_alive лидеру напрямую и на опрос не отвечают.
+ * Без лидера узлы работают как раньше: широковещательный keep_alive и ответ на опрос.
+ */
+struct mesh_election
+{
+	uint32_t node;										///< номер узла
+	uint32_t priority;									///< приоритет узла
+	uint8_t eligible;									///< узел может быть лидером
+	uint8_t role;										///< mesh_election_role
+	uint32_t since;										///< начало заявки либо время последнего анонса лидера, ms
+	uint32_t announced;									///< время последней отправки анонса, ms
+
+	uint32_t leader;									///< адрес лидера, 0 - лидера нет
+	uint32_t leader_node;								///< номер узла лидера
+	uint32_t leader_priority;							///< приоритет лидера
+	uint32_t leader_seen;								///< время последнего анонса лидера, ms
+
+	mesh_election_info info;							///< информация об узле, NULL - узел не шлет keep_alive
+	void* arg;											///< аргумент info
+	uint32_t keep_alive;								///< время последнего keep_alive, ms
+	struct mesh_timer* timer;							///< таймер MESH_ELECTION_TICK
+
+	struct mesh_election_device devices[MESH_ELECTION_MAX_DEVICES];	///< таблица устройств лидера
+	uint32_t count;										///< кол-во устройств в таблице
+};
+
+/**
+ * @brief Функция инициализации состояния
+ * @param[in] election Состояние
+ * @param[in] node Уникальный номер узла
+ * @param[in] priority Приоритет узла
+ * @param[in] eligible Узел может быть лидером (постоянное питание)
+ * @param[in] info Информация об узле для keep_alive либо NULL
+ * @param[in] arg Аргумент info
+ */
+void mesh_election_init(struct mesh_election* election, uint32_t node, uint32_t priority, uint8_t eligible, mesh_election_info info, void* arg);
+
+/**
+ * @brief Функция запуска выборов, узел стартует ведомым без лидера
+ * @return 0 если не удалось запустить таймер
+ */
+uint8_t mesh_election_start(struct mesh_election* election, struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция остановки выборов
+ */
+void mesh_election_stop(struct mesh_election* election, struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция обработки сообщения mesh_election_announce
+ */
+void mesh_election_on_announce(struct mesh_election* election, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg);
+
+/**
+ * @brief Функция обработки keep_alive, лидер запоминает устройство
+ */
+void mesh_election_on_keep_alive(struct mesh_election* election, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg);
+
+/**
+ * @brief Функция обработки mesh_devices_info_request
+ * Лидер отвечает информацией о себе и таблицей сегмента, ведомый при живом лидере молчит
+ * @return 1 если запрос обработан, 0 если узел должен ответить сам
+ */
+uint8_t mesh_election_on_discovery(struct mesh_election* election, struct mesh_ctx* ctx, struct mesh_sender_info* sender);
+
+/**
+ * @brief Функция получения адреса лидера
+ * @return Адрес лидера, 0 если лидера нет либо лидер - сам узел
+ */
+uint32_t mesh_election_get_leader(struct mesh_election* election);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
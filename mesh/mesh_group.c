@@ -0,0 +1,55 @@
+#include "mesh_group.h"
+
+#include <string.h>
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+void mesh_group_add_id(struct mesh_group_command* command, uint8_t id)
+{
+	if(command != NULL)
+	{
+		command->ids[id >> 3] |= 1 << (id & 7);
+	}
+}
+
+uint8_t mesh_group_has_id(const uint8_t* ids, uint8_t id)
+{
+	return ids != NULL && (ids[id >> 3] & (1 << (id & 7))) != 0;
+}
+
+uint8_t mesh_group_match(const struct mesh_group_command* command, uint8_t id, uint8_t group)
+{
+	if(command == NULL)
+	{
+		return 0;
+	}
+
+	if(command->group != MESH_GROUP_NONE)
+	{
+		return command->group == group;
+	}
+	return mesh_group_has_id(command->ids, id);
+}
+
+uint32_t mesh_group_count(const uint8_t* ids)
+{
+	uint32_t count = 0;
+	for(uint32_t i = 0; ids != NULL && i < MESH_GROUP_BITMAP_SIZE; ++i)
+	{
+		uint8_t bits = ids[i];
+		while(bits != 0)
+		{
+			bits &= bits - 1;
+			++count;
+		}
+	}
+	return count;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,115 @@
+#ifndef __MESH_GROUP_H__
+#define __MESH_GROUP_H__
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include "mesh_config.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh Mesh 
+ * @addtogroup mesh
+ * @{
+ */
+
+/**
+ * @brief Размер bitmap id устройств групповой команды (id 0..255)
+ */
+#define MESH_GROUP_BITMAP_SIZE 32
+
+/**
+ * @brief Группа не задана, команда адресуется bitmap
+ */
+#define MESH_GROUP_NONE 0
+
+/**
+ * @brief Флаг групповой команды: устройства отвечают mesh_group_switch_ack
+ */
+#define MESH_GROUP_FLAG_ACK 0x01
+
+/**
+ * @brief Шаг задержки подтверждения в ms, устройство с id N отвечает через (N + 1) * шаг
+ * чтобы десятки подтверждений не приходили отправителю одновременно
+ */
+#define MESH_GROUP_ACK_SLOT 2
+
+/**
+ * @brief Действие групповой команды
+ */
+typedef enum
+{
+	mesh_group_power_off = 0,			///< выключить нагрузку (power_down)
+	mesh_group_power_on = 1,			///< включить нагрузку (power_up)
+	mesh_group_power_toggle = 2			///< переключить нагрузку
+} mesh_group_action;
+
+/**
+ * @brief Групповая команда, поле data сообщения mesh_group_switch
+ *
+ * Устройство выполняет команду если его группа совпадает с group,
+ * либо при group == MESH_GROUP_NONE если его id отмечен в ids.
+ * Команда может повторяться отправителем (широковещательный UDP теряется),
+ * повтор с тем же seq не выполняется повторно, но подтверждается.
+ * С полем at команда выполняется всеми устройствами одновременно по синхронизированным
+ * часам, устройство без синхронизации выполняет ее сразу.
+ */
+struct mesh_group_command
+{
+	uint32_t seq;								///< номер команды у отправителя
+	uint8_t group;								///< группа устройств, MESH_GROUP_NONE - адресация по ids
+	uint8_t action;								///< mesh_group_action
+	uint8_t flags;								///< MESH_GROUP_FLAG_*
+	uint8_t reserved;							///< выравнивание
+	uint8_t ids[MESH_GROUP_BITMAP_SIZE];		///< bitmap id устройств
+	uint64_t at;								///< момент выполнения по часам mesh (mesh_time.h) в us, 0 - сразу
+};
+
+/**
+ * @brief Подтверждение групповой команды, поле data сообщения mesh_group_switch_ack
+ */
+struct mesh_group_ack
+{
+	uint32_t seq;			///< номер подтверждаемой команды
+	uint8_t id;				///< id устройства
+	uint8_t state;			///< состояние нагрузки после выполнения, 1 - включена
+	uint8_t reserved[2];	///< выравнивание
+};
+
+/**
+ * @brief Функция добавления id устройства в bitmap команды
+ */
+void mesh_group_add_id(struct mesh_group_command* command, uint8_t id);
+
+/**
+ * @brief Функция проверки наличия id в bitmap
+ * @return 1 если id отмечен
+ */
+uint8_t mesh_group_has_id(const uint8_t* ids, uint8_t id);
+
+/**
+ * @brief Функция проверки адресована ли команда устройству
+ * @param[in] command Команда
+ * @param[in] id id устройства
+ * @param[in] group Группа устройства, MESH_GROUP_NONE если не задана
+ * @return 1 если устройство должно выполнить команду
+ */
+uint8_t mesh_group_match(const struct mesh_group_command* command, uint8_t id, uint8_t group);
+
+/**
+ * @brief Функция подсчета отмеченных id
+ */
+uint32_t mesh_group_count(const uint8_t* ids);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
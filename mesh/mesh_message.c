@@ -1,5 +1,6 @@
 #include "mesh_message.h"
 #include "mesh.h"
+#include "mesh_wire.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,7 +13,7 @@ struct mesh_message* new_message(mesh_message_command command, void* data, uint8
 	struct mesh_message* msg = (struct mesh_message*) malloc(sizeof(struct mesh_message));
 	memset(msg, 0, sizeof(struct mesh_message));
 
-	msg->magic = 0x00110110;
+	msg->magic = MESH_WIRE_MAGIC;
 	msg->command = command;
 	if(data != NULL)
 	{
@@ -20,6 +21,8 @@ struct mesh_message* new_message(mesh_message_command command, void* data, uint8
 		msg->data_size = size;
 	}
 
+	// сообщение создается только для отправки, сразу в формате сети
+	mesh_wire_encode(msg);
 	return msg;
 }
 
@@ -36,7 +39,7 @@ void mesh_send_keep_alive(struct mesh_ctx* mesh, struct mesh_device_info* info)
 	ssize_t msg_size = sizeof(struct mesh_message);
 
 	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, BROADCAST_ADDR);
-	if(sended_data < 0)
+	if(sended_data == 0)
 	{
 		LOG("failed send data\n");
 	}
@@ -55,7 +58,26 @@ void mesh_send_request_devices_info(struct mesh_ctx* mesh)
 	ssize_t msg_size = sizeof(struct mesh_message);
 
 	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, BROADCAST_ADDR);
-	if(sended_data < 0)
+	if(sended_data == 0)
+	{
+		LOG("failed send data\n");
+	}
+	else if(msg_size != sended_data)
+	{
+		LOG("sending less data msg_size: %u, sended: %u\n", msg_size, sended_data);
+	}
+	free_message(msg);
+}
+
+void mesh_send_request_device_info(struct mesh_ctx* mesh, uint32_t dst)
+{
+	LOG("send_request_device_info\n");
+
+	struct mesh_message* msg = new_message(mesh_devices_info_request , NULL, 0);
+	ssize_t msg_size = sizeof(struct mesh_message);
+
+	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, dst);
+	if(sended_data == 0)
 	{
 		LOG("failed send data\n");
 	}
@@ -74,7 +96,7 @@ void mesh_send_device_info(struct mesh_ctx* mesh, struct mesh_device_info* info,
 	ssize_t msg_size = sizeof(struct mesh_message);
 
 	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, dst);
-	if(sended_data < 0)
+	if(sended_data == 0)
 	{
 		LOG("failed send data\n");
 	}
@@ -93,7 +115,64 @@ void mesh_send_request_device_info_confirm(struct mesh_ctx* mesh, uint32_t dst)
 	ssize_t msg_size = sizeof(struct mesh_message);
 
 	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, dst);
-	if(sended_data < 0)
+	if(sended_data == 0)
+	{
+		LOG("failed send data\n");
+	}
+	else if(msg_size != sended_data)
+	{
+		LOG("sending less data msg_size: %u, sended: %u\n", msg_size, sended_data);
+	}
+	free_message(msg);
+}
+
+void mesh_send_group_switch(struct mesh_ctx* mesh, struct mesh_group_command* command)
+{
+	LOG("send_group_switch\n");
+
+	struct mesh_message* msg = new_message(mesh_group_switch, command, sizeof(struct mesh_group_command));
+	ssize_t msg_size = sizeof(struct mesh_message);
+
+	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, BROADCAST_ADDR);
+	if(sended_data == 0)
+	{
+		LOG("failed send data\n");
+	}
+	else if(msg_size != sended_data)
+	{
+		LOG("sending less data msg_size: %u, sended: %u\n", msg_size, sended_data);
+	}
+	free_message(msg);
+}
+
+void mesh_send_group_switch_ack(struct mesh_ctx* mesh, struct mesh_group_ack* ack, uint32_t dst)
+{
+	LOG("send_group_switch_ack\n");
+
+	struct mesh_message* msg = new_message(mesh_group_switch_ack, ack, sizeof(struct mesh_group_ack));
+	ssize_t msg_size = sizeof(struct mesh_message);
+
+	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, dst);
+	if(sended_data == 0)
+	{
+		LOG("failed send data\n");
+	}
+	else if(msg_size != sended_data)
+	{
+		LOG("sending less data msg_size: %u, sended: %u\n", msg_size, sended_data);
+	}
+	free_message(msg);
+}
+
+void mesh_send_power_event(struct mesh_ctx* mesh, struct mesh_power_event* event)
+{
+	LOG("send_power_event\n");
+
+	struct mesh_message* msg = new_message(mesh_power_event, event, sizeof(struct mesh_power_event));
+	ssize_t msg_size = sizeof(struct mesh_message);
+
+	uint32_t sended_data = mesh_send_data(mesh, (void*) msg, msg_size, BROADCAST_ADDR);
+	if(sended_data == 0)
 	{
 		LOG("failed send data\n");
 	}
@@ -3,6 +3,10 @@
 
 #include "mesh_config.h"
 #include "mesh_device_info.h"
+#include "mesh_group.h"
+#include "mesh_power.h"
+#include "mesh_election.h"
+#include "mesh_time.h"
 #include "mesh_sender_info.h"
 
 
@@ -34,13 +38,20 @@ typedef enum
 	mesh_keep_alive = 0x0000001,						///< команда оповещения, что устройство в сети
 	mesh_devices_info_request = 0x0000002,				///< команда опроса устройств сети
 	mesh_device_info_response = 0x0000003,				///< команда ответа на опрос устройств сети
-	mesh_device_info_response_confirm = 0x0000004		///< команда подтверждения получения ответа на опрос устройств сети
+	mesh_device_info_response_confirm = 0x0000004,		///< команда подтверждения получения ответа на опрос устройств сети
+	mesh_group_switch = 0x0000005,						///< групповая команда управления нагрузкой (struct mesh_group_command)
+	mesh_group_switch_ack = 0x0000006,					///< подтверждение групповой команды (struct mesh_group_ack)
+	mesh_time_sync = 0x0000007,							///< маяк времени источника (struct mesh_time_beacon)
+	mesh_power_event = 0x0000008,						///< событие изменения состояния нагрузки (struct mesh_power_event)
+	mesh_election_announce = 0x0000009,					///< заявка кандидата либо анонс лидера сегмента (struct mesh_election_announce)
+	mesh_election_table = 0x000000A						///< часть таблицы устройств лидера (struct mesh_election_table)
 } mesh_message_command;
 
 /**
  * @brief Сообщения передаваемые по сети
- * @note Планируемая последовательность передачи magic,command, sender_id,data_size,data
- * Но по факту может быть не такой, не проверялось
+ * @note Раскладка в сети фиксирована и проверяется при компиляции (mesh_wire.h):
+ * magic, command (little-endian uint32), data_size, data, выравнивание до MESH_WIRE_MESSAGE_SIZE.
+ * new_message возвращает сообщение уже в формате сети, mesh_dispatch декодирует полученное на месте
  */
 struct mesh_message
 {
@@ -52,7 +63,7 @@ struct mesh_message
 };
 
 /**
- * @brief Функция для созания сообщения
+ * @brief Функция для созания сообщения в формате сети (mesh_wire_encode)
  * @param[in] command Команда сообщения
  * @param[in] data Передаваемые данные либо NULL
  * @param[in] size Размер передаваемых данных
@@ -88,6 +99,13 @@ void mesh_send_keep_alive(struct mesh_ctx* mesh, struct mesh_device_info* info);
  */
 void mesh_send_request_devices_info(struct mesh_ctx* mesh); //oneshoot
 
+/**
+ * @brief Функция для отправки запроса информации одному устройству
+ * @param[in] mesh Контекст запущенного mesh (в данную сеть будет отправленно сообщение)
+ * @param[in] dst Адресс устройства
+ */
+void mesh_send_request_device_info(struct mesh_ctx* mesh, uint32_t dst);
+
 /**
  * @brief Функция для отправки ответа на mesh_devices_info_request
  * @param[in] mesh Контекст запущенного mesh (в данную сеть будет отправленно сообщение)
@@ -103,6 +121,28 @@ void mesh_send_device_info(struct mesh_ctx* mesh, struct mesh_device_info* info,
  */
 void mesh_send_request_device_info_confirm(struct mesh_ctx* mesh, uint32_t dst); 
 
+/**
+ * @brief Функция для широковещательной отправки групповой команды
+ * @param[in] mesh Контекст запущенного mesh (в данную сеть будет отправленно сообщение)
+ * @param[in] command Групповая команда
+ */
+void mesh_send_group_switch(struct mesh_ctx* mesh, struct mesh_group_command* command);
+
+/**
+ * @brief Функция для отправки подтверждения групповой команды
+ * @param[in] mesh Контекст запущенного mesh (в данную сеть будет отправленно сообщение)
+ * @param[in] ack Подтверждение
+ * @param[in] dst Адресс отправителя команды
+ */
+void mesh_send_group_switch_ack(struct mesh_ctx* mesh, struct mesh_group_ack* ack, uint32_t dst);
+
+/**
+ * @brief Функция для широковещательной отправки события изменения состояния нагрузки
+ * @param[in] mesh Контекст запущенного mesh (в данную сеть будет отправленно сообщение)
+ * @param[in] event Событие
+ */
+void mesh_send_power_event(struct mesh_ctx* mesh, struct mesh_power_event* event);
+
 /**
  * @}
  */
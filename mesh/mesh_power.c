@@ -0,0 +1,48 @@
+#include "mesh_power.h"
+
+#include <stddef.h>
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+mesh_power_seq_status mesh_power_seq_check(uint32_t last_boot, uint32_t last, uint32_t boot, uint32_t seq, uint32_t* missed)
+{
+	uint32_t lost = 0;
+	mesh_power_seq_status status = mesh_power_seq_next;
+
+	if(last == 0)
+	{	// первое событие, о прошлых ничего не известно
+		status = mesh_power_seq_next;
+	}
+	else if(boot != last_boot)
+	{	// после загрузки seq снова идет с 1, события до загрузки получены либо потеряны
+		status = mesh_power_seq_restart;
+		lost = seq - 1;
+	}
+	else if(seq == last)
+	{
+		status = mesh_power_seq_duplicate;
+	}
+	else if(seq < last)
+	{	// UDP не сохраняет порядок, событие обогнали более новые
+		status = mesh_power_seq_stale;
+	}
+	else if(seq != last + 1)
+	{
+		status = mesh_power_seq_gap;
+		lost = seq - last - 1;
+	}
+
+	if(missed != NULL)
+	{
+		*missed = lost;
+	}
+	return status;
+}
+
+/**
+ * @}
+ */
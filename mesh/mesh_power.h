@@ -0,0 +1,72 @@
+#ifndef __MESH_POWER_H__
+#define __MESH_POWER_H__
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include "mesh_config.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh Mesh 
+ * @addtogroup mesh
+ * @{
+ */
+
+/**
+ * @brief Событие изменения состояния нагрузки, поле data сообщения mesh_power_event
+ *
+ * Устройство рассылает событие на каждое переключение нагрузки.
+ * seq растет на 1 с каждым событием начиная с 1 после загрузки,
+ * получатель по разрыву seq узнает о потерянных событиях (см. mesh_power_seq_check).
+ * boot выбирается случайно при загрузке: по нему перезагрузка отличается
+ * от опоздавшего события с меньшим seq.
+ */
+struct mesh_power_event
+{
+	uint32_t seq;				///< номер события
+	uint32_t boot;				///< идентификатор загрузки устройства
+	uint8_t id;					///< id устройства
+	uint8_t state;				///< состояние нагрузки, 1 - включена
+	uint8_t reserved[2];		///< выравнивание
+};
+
+/**
+ * @brief Результат проверки номера события
+ */
+typedef enum
+{
+	mesh_power_seq_next = 0,		///< следующее событие
+	mesh_power_seq_gap = 1,			///< пропущены события
+	mesh_power_seq_duplicate = 2,	///< повтор уже полученного события
+	mesh_power_seq_restart = 3,		///< устройство перезагружено, счет начат заново
+	mesh_power_seq_stale = 4		///< событие старше уже полученного, пришло с опозданием
+} mesh_power_seq_status;
+
+/**
+ * @brief Функция проверки номера события относительно последнего полученного
+ *
+ * Счет начинается заново только при смене boot. В пределах одной загрузки
+ * событие с меньшим seq устарело: состояние по нему применять нельзя.
+ *
+ * @param[in] last_boot boot последнего полученного события
+ * @param[in] last Номер последнего полученного события, 0 - событий не было
+ * @param[in] boot boot полученного события
+ * @param[in] seq Номер полученного события
+ * @param[out] missed Кол-во пропущенных событий, может быть NULL
+ * @return Результат проверки, duplicate и stale применять не нужно
+ */
+mesh_power_seq_status mesh_power_seq_check(uint32_t last_boot, uint32_t last, uint32_t boot, uint32_t seq, uint32_t* missed);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
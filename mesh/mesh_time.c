@@ -0,0 +1,187 @@
+#include "mesh_time.h"
+#include "mesh.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+/**
+ * @brief Минимальный интервал между опорными выборками для оценки ухода, us
+ */
+#define MESH_TIME_MIN_SPAN 1000000
+
+/**
+ * @brief Предел оценки ухода часов, ppb
+ * Кварцы узлов расходятся на десятки ppm, большая оценка - шум задержек доставки
+ */
+#define MESH_TIME_MAX_DRIFT 100000
+
+void mesh_time_init(struct mesh_time* time)
+{
+	if(time != NULL)
+	{
+		memset(time, 0, sizeof(struct mesh_time));
+	}
+}
+
+void mesh_time_send_beacon(struct mesh_ctx* ctx, uint32_t seq)
+{
+	struct mesh_time_beacon beacon;
+	memset(&beacon, 0, sizeof(struct mesh_time_beacon));
+	beacon.seq = seq;
+	// new_message сразу кодирует данные в формат сети, поэтому время ставится до него,
+	// подготовка сообщения попадает в погрешность маяка
+	beacon.time = mesh_clock(ctx);
+
+	struct mesh_message* msg = new_message(mesh_time_sync, &beacon, sizeof(struct mesh_time_beacon));
+	if(msg == NULL)
+	{
+		LOG("mesh[mesh_time_send_beacon]: failed create message\n");
+		return;
+	}
+
+	uint32_t msg_size = sizeof(struct mesh_message);
+	uint32_t sended_data = mesh_send_data(ctx, (void*) msg, msg_size, BROADCAST_ADDR);
+	if(msg_size != sended_data)
+	{
+		LOG("mesh[mesh_time_send_beacon]: sending less data msg_size: %u, sended: %u\n", msg_size, sended_data);
+	}
+	free_message(msg);
+}
+
+/**
+ * @brief Функция поиска выборки с максимальным смещением в диапазоне кольца [from, to)
+ */
+static const struct mesh_time_sample* mesh_time_max(const struct mesh_time* time, uint32_t from, uint32_t to)
+{
+	const struct mesh_time_sample* best = NULL;
+	for(uint32_t i = from; i < to; ++i)
+	{
+		const struct mesh_time_sample* sample = &time->samples[i & (MESH_TIME_SAMPLES - 1)];
+		if(best == NULL || sample->offset > best->offset)
+		{
+			best = sample;
+		}
+	}
+	return best;
+}
+
+static void mesh_time_estimate(struct mesh_time* time)
+{
+	uint32_t size = time->count < MESH_TIME_SAMPLES ? time->count : MESH_TIME_SAMPLES;
+	uint32_t first = time->count - size;
+	const struct mesh_time_sample* last = &time->samples[(time->count - 1) & (MESH_TIME_SAMPLES - 1)];
+
+	if(size >= MESH_TIME_MIN_SAMPLES)
+	{
+		const struct mesh_time_sample* older = mesh_time_max(time, first, first + size / 2);
+		const struct mesh_time_sample* newer = mesh_time_max(time, first + size / 2, time->count);
+		if(newer->local > older->local + MESH_TIME_MIN_SPAN)
+		{
+			int64_t drift = (newer->offset - older->offset) * 1000000000LL / (int64_t) (newer->local - older->local);
+			drift = drift > MESH_TIME_MAX_DRIFT ? MESH_TIME_MAX_DRIFT : drift < -MESH_TIME_MAX_DRIFT ? -MESH_TIME_MAX_DRIFT : drift;
+			// сглаживаем, выбор опорных выборок в половинах окна случаен
+			time->drift = time->synced ? (int32_t) ((3 * (int64_t) time->drift + drift) / 4) : (int32_t) drift;
+		}
+	}
+
+	// смещение: максимум окна, приведенный к последней выборке
+	time->base_local = last->local;
+	time->base_offset = last->offset;
+	for(uint32_t i = first; i < time->count; ++i)
+	{
+		const struct mesh_time_sample* sample = &time->samples[i & (MESH_TIME_SAMPLES - 1)];
+		int64_t offset = sample->offset + (int64_t) (last->local - sample->local) * time->drift / 1000000000LL;
+		if(offset > time->base_offset)
+		{
+			time->base_offset = offset;
+		}
+	}
+	time->synced = 1;
+}
+
+void mesh_time_on_beacon(struct mesh_time* time, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	uint64_t local = mesh_clock(ctx);
+
+	if(time == NULL || sender == NULL || msg == NULL || msg->data_size != sizeof(struct mesh_time_beacon))
+	{
+		LOG("mesh[mesh_time_on_beacon]: invalid beacon\n");
+		return;
+	}
+
+	struct mesh_time_beacon beacon;
+	memcpy(&beacon, msg->data, sizeof(struct mesh_time_beacon));
+
+	if(time->master != sender->ip)
+	{
+		if(time->master != 0 && mesh_time_synced(time, ctx))
+		{	// держимся текущего источника пока он жив
+			return;
+		}
+		mesh_time_init(time);
+		time->master = sender->ip;
+	}
+
+	struct mesh_time_sample* sample = &time->samples[time->count & (MESH_TIME_SAMPLES - 1)];
+	sample->local = local;
+	sample->offset = (int64_t) (beacon.time - local);
+	time->seq = beacon.seq;
+	++time->count;
+
+	mesh_time_estimate(time);
+}
+
+uint8_t mesh_time_synced(struct mesh_time* time, struct mesh_ctx* ctx)
+{
+	return time != NULL && time->synced && mesh_clock(ctx) - time->base_local < MESH_TIME_TIMEOUT;
+}
+
+uint64_t mesh_time_from_local(struct mesh_time* time, uint64_t local)
+{
+	if(time == NULL || !time->synced)
+	{
+		return local;
+	}
+	int64_t elapsed = (int64_t) (local - time->base_local);
+	return local + time->base_offset + elapsed * time->drift / 1000000000LL;
+}
+
+uint64_t mesh_time_to_local(struct mesh_time* time, uint64_t mesh)
+{
+	if(time == NULL || !time->synced)
+	{
+		return mesh;
+	}
+	// mesh = local + offset + (local - base) * drift, решаем относительно local
+	int64_t elapsed = (int64_t) (mesh - time->base_offset - time->base_local);
+	elapsed = elapsed * 1000000000LL / (1000000000LL + time->drift);
+	return time->base_local + elapsed;
+}
+
+uint64_t mesh_time_now(struct mesh_time* time, struct mesh_ctx* ctx)
+{
+	return mesh_time_from_local(time, mesh_clock(ctx));
+}
+
+struct mesh_timer* mesh_time_at(struct mesh_time* time, struct mesh_ctx* ctx, uint64_t at, void (* callback)(struct mesh_ctx* ctx, void* arg), void* arg)
+{
+	uint64_t local = mesh_time_to_local(time, at);
+	uint64_t now = mesh_clock(ctx);
+
+	uint32_t ms = 0;
+	if(local > now)
+	{	// округляем до ближайшей ms, таймеры транспорта точнее не умеют
+		ms = (uint32_t) ((local - now + 500) / 1000);
+	}
+	return mesh_timer_start(ctx, ms, 0, callback, arg);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,162 @@
+#ifndef __MESH_TIME_H__
+#define __MESH_TIME_H__
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include "mesh_config.h"
+#include "mesh_sender_info.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh Mesh 
+ * @addtogroup mesh
+ * @{
+ */
+
+/**
+ * @see mesh.h
+ */
+struct mesh_ctx;
+
+/**
+ * @see mesh.h
+ */
+struct mesh_timer;
+
+/**
+ * @see mesh_message.h
+ */
+struct mesh_message;
+
+/**
+ * @brief Период маяков времени в ms
+ */
+#define MESH_TIME_BEACON_INTERVAL 2000
+
+/**
+ * @brief Размер окна выборок (степень 2)
+ */
+#define MESH_TIME_SAMPLES 16
+
+/**
+ * @brief Минимальное кол-во выборок для оценки ухода часов
+ */
+#define MESH_TIME_MIN_SAMPLES 4
+
+/**
+ * @brief Время без маяков в us после которого часы считаются несинхронизированными
+ * и принимаются маяки другого источника
+ */
+#define MESH_TIME_TIMEOUT 30000000ULL
+
+/**
+ * @brief Маяк времени, поле data сообщения mesh_time_sync
+ */
+struct mesh_time_beacon
+{
+	uint32_t seq;			///< номер маяка
+	uint32_t reserved;		///< выравнивание
+	uint64_t time;			///< часы источника в момент отправки, us
+};
+
+/**
+ * @brief Выборка: локальное время приема маяка и смещение часов источника относительно локальных
+ */
+struct mesh_time_sample
+{
+	uint64_t local;			///< локальные часы при приеме, us
+	int64_t offset;			///< time маяка - local, us
+};
+
+/**
+ * @brief Оценка часов источника маяков (шлюза) на узле
+ *
+ * Маяки односторонние, задержка доставки d >= 0 только уменьшает выборку
+ * offset = master - local - d, поэтому лучшая оценка смещения - максимум
+ * выборок окна (выборка с минимальной задержкой, задержки power-save wifi отсекаются).
+ * Уход часов оценивается по максимумам старой и новой половин окна,
+ * смещение - по максимуму всех выборок окна, приведенных к последней с учетом ухода.
+ * Минимальная задержка сети входит в смещение, но одинакова для всех узлов
+ * и на взаимную синхронизацию не влияет.
+ */
+struct mesh_time
+{
+	uint32_t master;									///< адрес источника маяков, 0 - нет
+	uint32_t seq;										///< номер последнего маяка
+	struct mesh_time_sample samples[MESH_TIME_SAMPLES];	///< кольцо выборок
+	uint32_t count;										///< кол-во выборок всего
+
+	uint64_t base_local;								///< опорная точка оценки, локальное время
+	int64_t base_offset;								///< смещение в опорной точке, us
+	int32_t drift;										///< уход часов источника относительно локальных, ppb
+	uint8_t synced;										///< оценка готова
+};
+
+/**
+ * @brief Функция инициализации состояния
+ */
+void mesh_time_init(struct mesh_time* time);
+
+/**
+ * @brief Функция широковещательной отправки маяка с текущими часами узла (на источнике)
+ * @param[in] ctx Контекст mesh
+ * @param[in] seq Номер маяка
+ */
+void mesh_time_send_beacon(struct mesh_ctx* ctx, uint32_t seq);
+
+/**
+ * @brief Функция обработки маяка, вызывается из обработчика mesh_time_sync как можно раньше
+ * @param[in] time Состояние
+ * @param[in] ctx Контекст mesh
+ * @param[in] sender Отправитель
+ * @param[in] msg Сообщение
+ */
+void mesh_time_on_beacon(struct mesh_time* time, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg);
+
+/**
+ * @brief Функция проверки синхронизации
+ * @return 1 если оценка готова и маяки приходили не позднее MESH_TIME_TIMEOUT
+ */
+uint8_t mesh_time_synced(struct mesh_time* time, struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция перевода локальных часов в часы mesh (источника маяков)
+ */
+uint64_t mesh_time_from_local(struct mesh_time* time, uint64_t local);
+
+/**
+ * @brief Функция перевода часов mesh в локальные
+ */
+uint64_t mesh_time_to_local(struct mesh_time* time, uint64_t mesh);
+
+/**
+ * @brief Функция получения текущего времени mesh в us
+ * @note Без синхронизации возвращает локальные часы
+ */
+uint64_t mesh_time_now(struct mesh_time* time, struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция запуска однократного таймера на момент at по часам mesh
+ * Момент в прошлом срабатывает сразу. Точность ограничена таймерами транспорта (1 ms).
+ * @param[in] time Состояние
+ * @param[in] ctx Контекст mesh
+ * @param[in] at Время mesh в us
+ * @param[in] callback Функция вызываемая при срабатывании
+ * @param[in] arg Аргумент для callback
+ * @return Таймер либо NULL
+ */
+struct mesh_timer* mesh_time_at(struct mesh_time* time, struct mesh_ctx* ctx, uint64_t at, void (* callback)(struct mesh_ctx* ctx, void* arg), void* arg);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+#include "mesh_wire.h"
+#include "mesh.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+#if defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	#define MESH_WIRE_BIG_ENDIAN 1
+#else
+	#define MESH_WIRE_BIG_ENDIAN 0
+#endif
+
+/**
+ * @brief Поля структур в сети: структура, поле, смещение, размер значения, порядок байт
+ * Из одного списка строятся проверки раскладки при компиляции (на каждой платформе)
+ * и таблицы для кодирования, смещения в сети не зависят от компилятора
+ */
+#define MESH_WIRE_DEVICE_INFO(FIELD, T, M, B) \
+	FIELD(T, M type, B + 0, 1, mesh_wire_raw) \
+	FIELD(T, M id, B + 1, 1, mesh_wire_raw) \
+	FIELD(T, M reserved, B + 2, 1, mesh_wire_zero) \
+	FIELD(T, M ip, B + 4, 1, mesh_wire_raw) \
+	FIELD(T, M name, B + 8, 1, mesh_wire_raw)
+
+#define MESH_WIRE_GROUP_COMMAND(FIELD, T) \
+	FIELD(T, seq, 0, 4, mesh_wire_le) \
+	FIELD(T, group, 4, 1, mesh_wire_raw) \
+	FIELD(T, action, 5, 1, mesh_wire_raw) \
+	FIELD(T, flags, 6, 1, mesh_wire_raw) \
+	FIELD(T, reserved, 7, 1, mesh_wire_zero) \
+	FIELD(T, ids, 8, 1, mesh_wire_raw) \
+	FIELD(T, at, 8 + MESH_GROUP_BITMAP_SIZE, 8, mesh_wire_le)
+
+#define MESH_WIRE_GROUP_ACK(FIELD, T) \
+	FIELD(T, seq, 0, 4, mesh_wire_le) \
+	FIELD(T, id, 4, 1, mesh_wire_raw) \
+	FIELD(T, state, 5, 1, mesh_wire_raw) \
+	FIELD(T, reserved, 6, 1, mesh_wire_zero)
+
+#define MESH_WIRE_TIME_BEACON(FIELD, T) \
+	FIELD(T, seq, 0, 4, mesh_wire_le) \
+	FIELD(T, reserved, 4, 4, mesh_wire_zero) \
+	FIELD(T, time, 8, 8, mesh_wire_le)
+
+#define MESH_WIRE_POWER_EVENT(FIELD, T) \
+	FIELD(T, seq, 0, 4, mesh_wire_le) \
+	FIELD(T, boot, 4, 4, mesh_wire_le) \
+	FIELD(T, id, 8, 1, mesh_wire_raw) \
+	FIELD(T, state, 9, 1, mesh_wire_raw) \
+	FIELD(T, reserved, 10, 1, mesh_wire_zero)
+
+#define MESH_WIRE_ELECTION_ANNOUNCE(FIELD, T) \
+	FIELD(T, node, 0, 4, mesh_wire_le) \
+	FIELD(T, priority, 4, 4, mesh_wire_le) \
+	FIELD(T, role, 8, 1, mesh_wire_raw) \
+	FIELD(T, count, 9, 1, mesh_wire_raw) \
+	FIELD(T, reserved, 10, 1, mesh_wire_zero)
+
+#define MESH_WIRE_ELECTION_ENTRY(FIELD, T) \
+	FIELD(T, ip, 0, 4, mesh_wire_be) \
+	MESH_WIRE_DEVICE_INFO(FIELD, T, info., 4)
+
+#define MESH_WIRE_ELECTION_TABLE(FIELD, T) \
+	FIELD(T, count, 0, 1, mesh_wire_raw) \
+	FIELD(T, reserved, 1, 1, mesh_wire_zero)
+
+#define MESH_WIRE_CHECK(T, M, OFFSET, WIDTH, ORDER) \
+	_Static_assert(offsetof(T, M) == (OFFSET) && sizeof(((T*) 0)->M) % (WIDTH) == 0, #T "::" #M " wire layout");
+
+#define MESH_WIRE_FIELD(T, M, OFFSET, WIDTH, ORDER) \
+	{ (OFFSET), (WIDTH), sizeof(((T*) 0)->M) / (WIDTH), (ORDER) },
+
+#define MESH_WIRE_COUNT(fields) ((uint8_t) (sizeof(fields) / sizeof(struct mesh_wire_field)))
+
+_Static_assert(sizeof(mesh_message_command) == 4, "mesh_message_command wire size");
+_Static_assert(offsetof(struct mesh_message, magic) == 0, "mesh_message::magic wire layout");
+_Static_assert(offsetof(struct mesh_message, command) == 4, "mesh_message::command wire layout");
+_Static_assert(offsetof(struct mesh_message, data_size) == 8, "mesh_message::data_size wire layout");
+_Static_assert(offsetof(struct mesh_message, data) == MESH_WIRE_HEADER_SIZE, "mesh_message::data wire layout");
+_Static_assert(sizeof(struct mesh_message) == MESH_WIRE_MESSAGE_SIZE, "mesh_message wire size");
+
+MESH_WIRE_DEVICE_INFO(MESH_WIRE_CHECK, struct mesh_device_info, , 0)
+MESH_WIRE_GROUP_COMMAND(MESH_WIRE_CHECK, struct mesh_group_command)
+MESH_WIRE_GROUP_ACK(MESH_WIRE_CHECK, struct mesh_group_ack)
+MESH_WIRE_TIME_BEACON(MESH_WIRE_CHECK, struct mesh_time_beacon)
+MESH_WIRE_POWER_EVENT(MESH_WIRE_CHECK, struct mesh_power_event)
+MESH_WIRE_ELECTION_ANNOUNCE(MESH_WIRE_CHECK, struct mesh_election_announce)
+MESH_WIRE_ELECTION_ENTRY(MESH_WIRE_CHECK, struct mesh_election_entry)
+MESH_WIRE_ELECTION_TABLE(MESH_WIRE_CHECK, struct mesh_election_table)
+
+_Static_assert(sizeof(struct mesh_device_info) == 8 + MESH_DEVICE_NAME_SIZE, "mesh_device_info wire size");
+_Static_assert(sizeof(struct mesh_group_command) == 16 + MESH_GROUP_BITMAP_SIZE, "mesh_group_command wire size");
+_Static_assert(sizeof(struct mesh_group_ack) == 8, "mesh_group_ack wire size");
+_Static_assert(sizeof(struct mesh_time_beacon) == 16, "mesh_time_beacon wire size");
+_Static_assert(sizeof(struct mesh_power_event) == 12, "mesh_power_event wire size");
+_Static_assert(sizeof(struct mesh_election_announce) == 12, "mesh_election_announce wire size");
+_Static_assert(sizeof(struct mesh_election_entry) == 4 + sizeof(struct mesh_device_info), "mesh_election_entry wire size");
+_Static_assert(offsetof(struct mesh_election_table, entries) == 4, "mesh_election_table::entries wire layout");
+_Static_assert(sizeof(struct mesh_election_table) == 4 + MESH_ELECTION_TABLE_SIZE * sizeof(struct mesh_election_entry), "mesh_election_table wire size");
+_Static_assert(sizeof(struct mesh_election_table) <= UINT8_MAX, "mesh_election_table exceeds data_size");
+
+static const struct mesh_wire_field mesh_wire_device_info_fields[] = { MESH_WIRE_DEVICE_INFO(MESH_WIRE_FIELD, struct mesh_device_info, , 0) };
+static const struct mesh_wire_field mesh_wire_group_command_fields[] = { MESH_WIRE_GROUP_COMMAND(MESH_WIRE_FIELD, struct mesh_group_command) };
+static const struct mesh_wire_field mesh_wire_group_ack_fields[] = { MESH_WIRE_GROUP_ACK(MESH_WIRE_FIELD, struct mesh_group_ack) };
+static const struct mesh_wire_field mesh_wire_time_beacon_fields[] = { MESH_WIRE_TIME_BEACON(MESH_WIRE_FIELD, struct mesh_time_beacon) };
+static const struct mesh_wire_field mesh_wire_power_event_fields[] = { MESH_WIRE_POWER_EVENT(MESH_WIRE_FIELD, struct mesh_power_event) };
+static const struct mesh_wire_field mesh_wire_election_announce_fields[] = { MESH_WIRE_ELECTION_ANNOUNCE(MESH_WIRE_FIELD, struct mesh_election_announce) };
+static const struct mesh_wire_field mesh_wire_election_entry_fields[] = { MESH_WIRE_ELECTION_ENTRY(MESH_WIRE_FIELD, struct mesh_election_entry) };
+static const struct mesh_wire_field mesh_wire_election_table_fields[] = { MESH_WIRE_ELECTION_TABLE(MESH_WIRE_FIELD, struct mesh_election_table) };
+
+/**
+ * @brief Описания данных команд, индекс - mesh_message_command
+ */
+static const struct mesh_wire_schema mesh_wire_schemas[] =
+{
+	{ NULL, 0, 0, NULL, 0, 0, 0, 0 },
+	// mesh_keep_alive
+	{ mesh_wire_device_info_fields, MESH_WIRE_COUNT(mesh_wire_device_info_fields), sizeof(struct mesh_device_info), NULL, 0, 0, 0, 0 },
+	// mesh_devices_info_request
+	{ NULL, 0, 0, NULL, 0, 0, 0, 0 },
+	// mesh_device_info_response
+	{ mesh_wire_device_info_fields, MESH_WIRE_COUNT(mesh_wire_device_info_fields), sizeof(struct mesh_device_info), NULL, 0, 0, 0, 0 },
+	// mesh_device_info_response_confirm
+	{ NULL, 0, 0, NULL, 0, 0, 0, 0 },
+	// mesh_group_switch
+	{ mesh_wire_group_command_fields, MESH_WIRE_COUNT(mesh_wire_group_command_fields), sizeof(struct mesh_group_command), NULL, 0, 0, 0, 0 },
+	// mesh_group_switch_ack
+	{ mesh_wire_group_ack_fields, MESH_WIRE_COUNT(mesh_wire_group_ack_fields), sizeof(struct mesh_group_ack), NULL, 0, 0, 0, 0 },
+	// mesh_time_sync
+	{ mesh_wire_time_beacon_fields, MESH_WIRE_COUNT(mesh_wire_time_beacon_fields), sizeof(struct mesh_time_beacon), NULL, 0, 0, 0, 0 },
+	// mesh_power_event
+	{ mesh_wire_power_event_fields, MESH_WIRE_COUNT(mesh_wire_power_event_fields), sizeof(struct mesh_power_event), NULL, 0, 0, 0, 0 },
+	// mesh_election_announce
+	{ mesh_wire_election_announce_fields, MESH_WIRE_COUNT(mesh_wire_election_announce_fields), sizeof(struct mesh_election_announce), NULL, 0, 0, 0, 0 },
+	// mesh_election_table, заголовок и MESH_ELECTION_TABLE_SIZE записей
+	{ mesh_wire_election_table_fields, MESH_WIRE_COUNT(mesh_wire_election_table_fields), sizeof(struct mesh_election_table),
+			mesh_wire_election_entry_fields, MESH_WIRE_COUNT(mesh_wire_election_entry_fields),
+			MESH_ELECTION_TABLE_SIZE, sizeof(struct mesh_election_entry), offsetof(struct mesh_election_table, entries) },
+};
+
+_Static_assert(sizeof(mesh_wire_schemas) / sizeof(struct mesh_wire_schema) == mesh_election_table + 1, "mesh_wire_schemas must cover every command");
+
+static uint32_t mesh_wire_get_u32(const uint8_t* data)
+{
+	return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static void mesh_wire_put_u32(uint8_t* data, uint32_t value)
+{
+	data[0] = (uint8_t) value;
+	data[1] = (uint8_t) (value >> 8);
+	data[2] = (uint8_t) (value >> 16);
+	data[3] = (uint8_t) (value >> 24);
+}
+
+static void mesh_wire_reverse(uint8_t* data, uint8_t width)
+{
+	for(uint8_t i = 0; i < width / 2; ++i)
+	{
+		uint8_t byte = data[i];
+		data[i] = data[width - 1 - i];
+		data[width - 1 - i] = byte;
+	}
+}
+
+/**
+ * @brief Функция перестановки байт полей на месте
+ * Перестановка симметрична, одна функция и кодирует и декодирует
+ * @param[in] encode При кодировании резерв заполняется нулями
+ */
+static void mesh_wire_convert(const struct mesh_wire_field* fields, uint8_t count, uint8_t* data, uint8_t encode)
+{
+	for(uint8_t i = 0; i < count; ++i)
+	{
+		const struct mesh_wire_field* field = &fields[i];
+		uint8_t* value = data + field->offset;
+
+		if(field->order == mesh_wire_zero)
+		{
+			if(encode)
+			{
+				memset(value, 0, field->width * field->count);
+			}
+		}
+		else if(field->width > 1 && (field->order == mesh_wire_le) == MESH_WIRE_BIG_ENDIAN)
+		{	// порядок сети не совпадает с порядком платформы
+			for(uint8_t j = 0; j < field->count; ++j)
+			{
+				mesh_wire_reverse(value + j * field->width, field->width);
+			}
+		}
+	}
+}
+
+static void mesh_wire_convert_data(const struct mesh_wire_schema* schema, uint8_t* data, uint8_t encode)
+{
+	mesh_wire_convert(schema->fields, schema->count, data, encode);
+	for(uint8_t i = 0; i < schema->repeat; ++i)
+	{
+		mesh_wire_convert(schema->items, schema->items_count, data + schema->base + i * schema->stride, encode);
+	}
+}
+
+const struct mesh_wire_schema* mesh_wire_schema_get(uint32_t command)
+{
+	if(command == 0 || command >= sizeof(mesh_wire_schemas) / sizeof(struct mesh_wire_schema))
+	{
+		return NULL;
+	}
+	return &mesh_wire_schemas[command];
+}
+
+void mesh_wire_encode(struct mesh_message* msg)
+{
+	if(msg == NULL)
+	{
+		return;
+	}
+
+	const struct mesh_wire_schema* schema = mesh_wire_schema_get(msg->command);
+	if(schema != NULL && schema->size != 0 && msg->data_size == schema->size)
+	{
+		mesh_wire_convert_data(schema, msg->data, 1);
+	}
+
+	uint32_t magic = msg->magic;
+	uint32_t command = msg->command;
+	mesh_wire_put_u32((uint8_t*) &msg->magic, magic);
+	mesh_wire_put_u32((uint8_t*) &msg->command, command);
+}
+
+uint8_t mesh_wire_decode(struct mesh_message* msg)
+{
+	if(msg == NULL)
+	{
+		return 0;
+	}
+
+	uint32_t magic = mesh_wire_get_u32((const uint8_t*) &msg->magic);
+	uint32_t command = mesh_wire_get_u32((const uint8_t*) &msg->command);
+	if(magic != MESH_WIRE_MAGIC)
+	{
+		LOG("mesh[mesh_wire_decode]: wrong magic: %u\n", magic);
+		return 0;
+	}
+
+	const struct mesh_wire_schema* schema = mesh_wire_schema_get(command);
+	if(schema == NULL || msg->data_size != schema->size)
+	{
+		LOG("mesh[mesh_wire_decode]: invalid message command: %u, data_size: %u\n", command, msg->data_size);
+		return 0;
+	}
+
+	msg->magic = magic;
+	msg->command = (mesh_message_command) command;
+	if(schema->size != 0)
+	{
+		mesh_wire_convert_data(schema, msg->data, 0);
+	}
+	return 1;
+}
+
+/**
+ * @}
+ */
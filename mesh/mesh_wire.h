@@ -0,0 +1,110 @@
+#ifndef __MESH_WIRE_H__
+#define __MESH_WIRE_H__
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include "mesh_config.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh Mesh
+ * @addtogroup mesh
+ * @{
+ */
+
+/**
+ * @see mesh_message.h
+ */
+struct mesh_message;
+
+/**
+ * @brief Магическая последовательность начала сообщения, struct mesh_message::magic
+ */
+#define MESH_WIRE_MAGIC 0x00110110
+
+/**
+ * @brief Размер заголовка сообщения: magic (4), command (4), data_size (1)
+ */
+#define MESH_WIRE_HEADER_SIZE 9
+
+/**
+ * @brief Размер сообщения в сети, заголовок и data дополнены нулями до кратного 4
+ */
+#define MESH_WIRE_MESSAGE_SIZE ((MESH_WIRE_HEADER_SIZE + MESH_MESSAGE_DATA_SIZE + 3) & ~3)
+
+/**
+ * @brief Порядок байт поля в сети
+ */
+typedef enum
+{
+	mesh_wire_raw = 0,			///< байты как есть (uint8_t, строки, адрес ip_addr lwIP)
+	mesh_wire_le = 1,			///< little-endian
+	mesh_wire_be = 2,			///< big-endian (сетевой порядок адресов отправителя)
+	mesh_wire_zero = 3			///< резерв, при кодировании заполняется нулями
+} mesh_wire_order;
+
+/**
+ * @brief Поле структуры в сети
+ */
+struct mesh_wire_field
+{
+	uint16_t offset;		///< смещение от начала структуры
+	uint8_t width;			///< размер одного значения, байт
+	uint8_t count;			///< кол-во значений (массив)
+	uint8_t order;			///< mesh_wire_order
+};
+
+/**
+ * @brief Описание структуры передаваемой в mesh_message::data
+ */
+struct mesh_wire_schema
+{
+	const struct mesh_wire_field* fields;	///< поля по возрастанию смещения
+	uint8_t count;							///< кол-во полей
+	uint8_t size;							///< размер структуры в сети
+	const struct mesh_wire_field* items;	///< поля записи таблицы либо NULL
+	uint8_t items_count;					///< кол-во полей записи
+	uint8_t repeat;							///< кол-во записей таблицы
+	uint8_t stride;							///< размер записи
+	uint8_t base;							///< смещение первой записи
+};
+
+/**
+ * @brief Функция получения описания данных команды
+ * @param[in] command Команда (mesh_message_command)
+ * @return Описание либо NULL если команда неизвестна, schema->size == 0 - команда без данных
+ */
+const struct mesh_wire_schema* mesh_wire_schema_get(uint32_t command);
+
+/**
+ * @brief Функция приведения сообщения к формату сети перед отправкой
+ *
+ * Сообщение кодируется на месте без копирования: многобайтные поля заголовка
+ * и данных приводятся к little-endian (на little-endian платформе ничего не меняется),
+ * адреса отправителя - к сетевому порядку, резерв заполняется нулями.
+ * После кодирования поля сообщения читать нельзя.
+ * @param[in,out] msg Сообщение
+ */
+void mesh_wire_encode(struct mesh_message* msg);
+
+/**
+ * @brief Функция приведения полученного сообщения к формату платформы
+ * Проверяет magic, известность команды и data_size, затем декодирует данные на месте
+ * @param[in,out] msg Сообщение размера MESH_WIRE_MESSAGE_SIZE
+ * @return 0 если сообщение не соответствует формату и должно быть отброшено
+ */
+uint8_t mesh_wire_decode(struct mesh_message* msg);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef __MESH_SHM_H__
+#define __MESH_SHM_H__
+
+#include <stdint.h>
+
+/**
+ * @defgroup mesh_shm Mesh shared memory
+ * @brief Таблица устройств mesh_stub в POSIX shared memory
+ *
+ * Сегмент состоит из заголовка и массива записей фиксированного размера.
+ * Запись с номером slot принадлежит одному устройству на все время работы stub.
+ * Запись идет под seqlock (mesh_shm_header::seq): нечетное значение - идет запись,
+ * читатель копирует данные и повторяет чтение если seq изменился.
+ *
+ * @addtogroup mesh_shm
+ * @{
+ */
+
+/**
+ * @brief Имя сегмента по умолчанию
+ */
+#define MESH_SHM_DEFAULT_NAME "/esp_mesh_devices"
+
+/**
+ * @brief Метка инициализированного сегмента ("MESH")
+ */
+#define MESH_SHM_MAGIC 0x4853454D
+
+/**
+ * @brief Версия формата сегмента
+ */
+#define MESH_SHM_VERSION 1
+
+/**
+ * @brief Максимальное кол-во устройств
+ */
+#define MESH_SHM_CAPACITY 4096
+
+/**
+ * @brief Размер имени устройства, совпадает с MESH_DEVICE_NAME_SIZE
+ */
+#define MESH_SHM_NAME_SIZE 64
+
+/**
+ * @brief Запись об устройстве
+ */
+struct mesh_shm_record
+{
+	uint32_t ip;							///< адрес устройства (host order)
+	uint8_t id;								///< id устройства
+	uint8_t type;							///< тип устройства
+	uint16_t flags;							///< MESH_SHM_FLAG_*
+	uint64_t first_seen;					///< первое сообщение, ms CLOCK_MONOTONIC
+	uint64_t last_seen;						///< последнее сообщение, ms CLOCK_MONOTONIC
+	char name[MESH_SHM_NAME_SIZE];			///< имя устройства
+};
+
+/**
+ * @brief Устройство подтверждено живым трафиком, иначе загружено из кэша stub и еще не отвечало
+ */
+#define MESH_SHM_FLAG_VERIFIED 0x0001
+
+/**
+ * @brief Заголовок сегмента, занимает одну cache line
+ */
+struct mesh_shm_header
+{
+	uint32_t magic;							///< MESH_SHM_MAGIC, пишется последним при создании
+	uint32_t version;						///< MESH_SHM_VERSION
+	uint32_t capacity;						///< кол-во записей в сегменте
+	uint32_t record_size;					///< sizeof(struct mesh_shm_record)
+	uint32_t seq;							///< seqlock
+	uint32_t count;							///< кол-во занятых записей
+	uint64_t updated;						///< последнее изменение, ms CLOCK_MONOTONIC
+	uint32_t pid;							///< pid mesh_stub
+	uint32_t closed;						///< 1 - stub завершился, сегмент больше не обновляется
+	uint8_t reserved[24];					///< до 64 байт
+};
+
+/**
+ * @brief Записи сегмента
+ */
+#define MESH_SHM_RECORDS(header) ((struct mesh_shm_record*) ((uint8_t*) (header) + sizeof(struct mesh_shm_header)))
+
+/**
+ * @brief Размер сегмента
+ */
+#define MESH_SHM_SIZE (sizeof(struct mesh_shm_header) + MESH_SHM_CAPACITY * sizeof(struct mesh_shm_record))
+
+/**
+ * @}
+ */
+
+#endif
@@ -0,0 +1,156 @@
+#include "mesh_shm_client.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @defgroup mesh_shm Mesh shared memory
+ * @addtogroup mesh_shm
+ * @{
+ */
+
+/**
+ * @brief Сколько неудачных попыток чтения делать до уступки процессора
+ */
+#define MESH_SHM_SPIN 64
+
+/**
+ * @brief Через сколько неудачных попыток проверять что stub жив (мог упасть во время записи)
+ */
+#define MESH_SHM_ALIVE_CHECK (MESH_SHM_SPIN * 1024)
+
+/**
+ * @brief Клиент
+ */
+struct mesh_shm_client
+{
+	const struct mesh_shm_header* header;		///< отображенный сегмент
+	struct mesh_shm_record* buffer;				///< снимок для mesh_shm_client_foreach
+};
+
+struct mesh_shm_client* mesh_shm_client_open(const char* name)
+{
+	int fd = shm_open(name != NULL ? name : MESH_SHM_DEFAULT_NAME, O_RDONLY, 0);
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t) st.st_size < MESH_SHM_SIZE)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	void* ptr = mmap(NULL, MESH_SHM_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(ptr == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	const struct mesh_shm_header* header = (const struct mesh_shm_header*) ptr;
+	if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != MESH_SHM_MAGIC || header->version != MESH_SHM_VERSION
+			|| header->record_size != sizeof(struct mesh_shm_record) || header->capacity != MESH_SHM_CAPACITY)
+	{
+		munmap(ptr, MESH_SHM_SIZE);
+		return NULL;
+	}
+
+	struct mesh_shm_client* client = (struct mesh_shm_client*) malloc(sizeof(struct mesh_shm_client));
+	client->header = header;
+	client->buffer = NULL;
+	return client;
+}
+
+void mesh_shm_client_close(struct mesh_shm_client* client)
+{
+	if(client != NULL)
+	{
+		munmap((void*) client->header, MESH_SHM_SIZE);
+		free(client->buffer);
+		free(client);
+	}
+}
+
+int mesh_shm_client_snapshot(struct mesh_shm_client* client, struct mesh_shm_record* records, uint32_t capacity, uint64_t* updated)
+{
+	const struct mesh_shm_header* header = client->header;
+	const struct mesh_shm_record* source = MESH_SHM_RECORDS(header);
+
+	uint32_t attempt = 0;
+	for(;;)
+	{
+		uint32_t begin = __atomic_load_n(&header->seq, __ATOMIC_ACQUIRE);
+		if(!(begin & 1))
+		{
+			uint32_t count = header->count;
+			if(count > capacity)
+			{
+				count = capacity;
+			}
+			memcpy(records, source, count * sizeof(struct mesh_shm_record));
+			uint64_t changed = header->updated;
+			uint32_t closed = header->closed;
+
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if(__atomic_load_n(&header->seq, __ATOMIC_RELAXED) == begin)
+			{
+				if(updated != NULL)
+				{
+					*updated = changed;
+				}
+				return closed ? -1 : (int) count;
+			}
+		}
+
+		// писатель держит seqlock на время записи одной записи
+		if(++attempt % MESH_SHM_SPIN == 0)
+		{
+			sched_yield();
+		}
+		if(attempt % MESH_SHM_ALIVE_CHECK == 0 && kill(header->pid, 0) != 0 && errno == ESRCH)
+		{
+			return -1;
+		}
+	}
+}
+
+int mesh_shm_client_foreach(struct mesh_shm_client* client, mesh_shm_callback callback, void* arg)
+{
+	if(client->buffer == NULL)
+	{
+		client->buffer = (struct mesh_shm_record*) malloc(MESH_SHM_CAPACITY * sizeof(struct mesh_shm_record));
+	}
+
+	int count = mesh_shm_client_snapshot(client, client->buffer, MESH_SHM_CAPACITY, NULL);
+	for(int i = 0; i < count; ++i)
+	{
+		if(callback(&client->buffer[i], arg) != 0)
+		{
+			break;
+		}
+	}
+	return count;
+}
+
+uint64_t mesh_shm_now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @}
+ */
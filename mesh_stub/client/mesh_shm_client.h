@@ -0,0 +1,67 @@
+#ifndef __MESH_SHM_CLIENT_H__
+#define __MESH_SHM_CLIENT_H__
+
+#include "mesh_shm.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh_shm Mesh shared memory
+ * @addtogroup mesh_shm
+ * @{
+ */
+
+/**
+ * @brief Клиент таблицы устройств, только чтение, без системных вызовов на чтение
+ */
+struct mesh_shm_client;
+
+/**
+ * @brief Обработчик записи при обходе
+ * @return 0 - продолжить обход, иначе остановить
+ */
+typedef int (*mesh_shm_callback)(const struct mesh_shm_record* record, void* arg);
+
+/**
+ * @brief Функция подключения к сегменту
+ * @param[in] name Имя сегмента, NULL - MESH_SHM_DEFAULT_NAME
+ * @return Клиент либо NULL (нет сегмента, другая версия формата)
+ */
+struct mesh_shm_client* mesh_shm_client_open(const char* name);
+
+/**
+ * @brief Функция отключения от сегмента
+ */
+void mesh_shm_client_close(struct mesh_shm_client* client);
+
+/**
+ * @brief Функция получения согласованного снимка таблицы
+ * @param[out] records Буфер записей
+ * @param[in] capacity Размер буфера
+ * @param[out] updated Время последнего изменения таблицы, может быть NULL
+ * @return Кол-во записей, -1 если stub завершился (нужно переподключиться)
+ */
+int mesh_shm_client_snapshot(struct mesh_shm_client* client, struct mesh_shm_record* records, uint32_t capacity, uint64_t* updated);
+
+/**
+ * @brief Функция обхода снимка таблицы
+ * @return Кол-во записей в снимке, -1 если stub завершился
+ */
+int mesh_shm_client_foreach(struct mesh_shm_client* client, mesh_shm_callback callback, void* arg);
+
+/**
+ * @brief Функция получения текущего времени в формате записей (ms CLOCK_MONOTONIC)
+ */
+uint64_t mesh_shm_now();
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif
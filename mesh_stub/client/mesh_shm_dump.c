@@ -0,0 +1,92 @@
+#include "mesh_shm_client.h"
+
+#include <arpa/inet.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int print_record(const struct mesh_shm_record* record, void* arg)
+{
+	uint64_t now = *(const uint64_t*) arg;
+
+	struct in_addr addr;
+	addr.s_addr = htonl(record->ip);
+	if(record->flags & MESH_SHM_FLAG_VERIFIED)
+	{
+		printf("%-15s id: %3u type: %3u seen: %6llu ms ago  %s\n", inet_ntoa(addr), record->id, record->type,
+				(unsigned long long) (now - record->last_seen), record->name);
+	}
+	else
+	{
+		printf("%-15s id: %3u type: %3u cached, not seen yet  %s\n", inet_ntoa(addr), record->id, record->type, record->name);
+	}
+	return 0;
+}
+
+int main(int argc, const char** argv)
+{
+	const char* name = MESH_SHM_DEFAULT_NAME;
+	unsigned long bench = 0;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strncmp(argv[i], "--name=", 7) == 0)
+		{
+			name = argv[i] + 7;
+		}
+		else if(strncmp(argv[i], "--bench=", 8) == 0)
+		{
+			bench = strtoul(argv[i] + 8, NULL, 10);
+		}
+		else
+		{
+			printf("usage: %s [--name=SEGMENT] [--bench=SNAPSHOTS]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	struct mesh_shm_client* client = mesh_shm_client_open(name);
+	if(client == NULL)
+	{
+		printf("failed open %s, is esp_mesh running?\n", name);
+		return 1;
+	}
+
+	int result = 0;
+	if(bench != 0)
+	{
+		static struct mesh_shm_record records[MESH_SHM_CAPACITY];
+
+		struct timespec begin, end;
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+
+		int count = 0;
+		for(unsigned long i = 0; i < bench && count >= 0; ++i)
+		{
+			count = mesh_shm_client_snapshot(client, records, MESH_SHM_CAPACITY, NULL);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+		printf("%lu snapshots of %d devices in %.3f s: %.0f snapshots/s\n", bench, count, seconds, bench / seconds);
+	}
+	else
+	{
+		uint64_t now = mesh_shm_now();
+		int count = mesh_shm_client_foreach(client, print_record, &now);
+		if(count < 0)
+		{
+			printf("esp_mesh stopped\n");
+			result = 1;
+		}
+		else
+		{
+			printf("%d devices\n", count);
+		}
+	}
+
+	mesh_shm_client_close(client);
+	return result;
+}
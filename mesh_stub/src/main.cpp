@@ -1,115 +1,713 @@
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "mesh_platform.h"
+#include "mesh_uring.h"
+#include "mesh_coro.h"
+#include "mesh_registry.h"
+#include "mesh_schema.h"
+#include "mesh_cache.h"
+#include "mesh_query.h"
+#include "mesh_shm_publisher.h"
+#include "mesh_shm.h"
+
 #include <arpa/inet.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Маршрутизатор ответов для корутин контроллера, nullptr если контроллер не запущен
+ */
+static struct mesh_coro_router* router = nullptr;
+
+/**
+ * @brief Таблица известных устройств
+ */
+static struct mesh_registry* registry = nullptr;
+
+/**
+ * @brief Состояние виртуальной нагрузки заглушки для групповых команд
+ */
+static uint8_t stub_power = 0;
+
+/**
+ * @brief Последняя выполненная групповая команда, повтор не выполняется
+ */
+static uint32_t stub_group_seq = 0;
+static uint32_t stub_group_sender = 0;
+
+/**
+ * @brief Номер последнего события нагрузки заглушки
+ */
+static uint32_t stub_power_seq = 0;
+
+/**
+ * @brief Идентификатор запуска заглушки для событий нагрузки
+ */
+static uint32_t stub_power_boot = 0;
+
+static void fill_stub_info(struct mesh_device_info* info)
+{
+	memset(info, 0, sizeof(struct mesh_device_info));
+	info->type = 3;
+	info->id = 0;
+	snprintf(info->name, MESH_DEVICE_NAME_SIZE, "PC-stub");
+	info->ip = inet_addr("192.168.0.110");
+}
+
+/**
+ * @brief Ответ на запрос устройств с ожиданием подтверждения
+ */
+static mesh_task<> answer_devices_info(struct mesh_ctx* ctx, uint32_t ip)
+{
+	mesh_device_info info;
+	fill_stub_info(&info);
+
+	std::cout << "mesh[answer_devices_info]: send_device_info called" << std::endl;
+	mesh_send_device_info(ctx, &info, ip);
+
+	if(!co_await mesh_co_wait_ack(router, ip, 1000))
+	{
+		std::cout << "mesh[answer_devices_info]: confirm not received" << std::endl;
+	}
+}
+
+static void collect_cached(void* arg, const struct mesh_registry_device* device)
+{
+	if(!device->verified)
+	{
+		mesh_device_reply reply;
+		reply.ip = device->ip;
+		reply.info = device->info;
+		reinterpret_cast<std::vector<mesh_device_reply>*>(arg)->push_back(reply);
+	}
+}
 
-void mesh_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+/**
+ * @brief Контроллер: discovery, затем уточнение информации у каждого устройства
+ * Если таблица загружена из кэша, первый проход опрашивает известные устройства
+ * напрямую вместо широковищательного запроса всей сети
+ */
+static mesh_task<> controller(struct mesh_coro_router* router)
 {
-	if(msg != nullptr)
+	std::vector<mesh_device_reply> devices;
+	mesh_registry_foreach(registry, collect_cached, &devices);
+	if(!devices.empty())
 	{
-		if(msg->data_size == sizeof(struct mesh_device_info))
+		std::cout << "mesh[controller]: validate " << devices.size() << " cached devices" << std::endl;
+	}
+
+	while(!mesh_coro_router_closed(router))
+	{
+		if(devices.empty())
 		{
-			struct mesh_device_info* info = (struct mesh_device_info*) msg->data;
+			uint32_t found = co_await mesh_co_discover(router, 2000, &devices);
+			std::cout << "mesh[controller]: discovered " << found << " devices" << std::endl;
+		}
 
+		for(auto& device : devices)
+		{
 			in_addr addr;
-			addr.s_addr = info->ip;
-			printf("mesh[mesh_keep_alive_handler]: received info device_id: %d, device_type: %d, device_ip: %s, device_name: %s\n", 
-					info->id, info->type, inet_ntoa(addr), info->name);
+			addr.s_addr = htonl(device.ip);
+
+			mesh_device_info info;
+			if(co_await mesh_co_request_info(router, device.ip, 1000, &info))
+			{
+				printf("mesh[controller]: device %s id: %d, type: %d, name: %s\n", inet_ntoa(addr), info.id, info.type, info.name);
+			}
+			else
+			{
+				printf("mesh[controller]: device %s not responding\n", inet_ntoa(addr));
+			}
 		}
-		else
+		devices.clear();
+		co_await mesh_co_sleep(router, 10000);
+	}
+}
+
+/**
+ * @brief Групповая команда с повторами: каждая попытка отправляет тот же seq,
+ * устройства выполняют команду один раз и подтверждают каждую попытку
+ * @param[in] lead Задержка выполнения команды (mesh_group_command::at) в ms,
+ * подтверждения приходят после выполнения, поэтому первая попытка ждет дольше
+ */
+static mesh_task<> switch_devices(struct mesh_coro_router* router, struct mesh_group_command command, uint32_t lead)
+{
+	struct mesh_group_result acks;
+	memset(&acks, 0, sizeof(struct mesh_group_result));
+
+	struct mesh_group_command target = command;
+	uint32_t expected = command.group == MESH_GROUP_NONE ? mesh_group_count(command.ids) : 0;
+	for(uint32_t attempt = 0; attempt < 3 && !mesh_coro_router_closed(router); ++attempt)
+	{
+		uint32_t received = co_await mesh_co_group_switch(router, &command, attempt == 0 ? 300 + lead : 300, &acks);
+		printf("mesh[switch_devices]: seq: %u, attempt: %u, acks: %u, total: %u\n", command.seq, attempt + 1, received, acks.count);
+		if(expected != 0 && acks.count >= expected)
 		{
-			std::cout << "invalid message data size" << std::endl;
+			break;
+		}
+
+		// повтор адресуется только неподтвердившим устройствам
+		for(uint32_t i = 0; command.group == MESH_GROUP_NONE && i < MESH_GROUP_BITMAP_SIZE; ++i)
+		{
+			command.ids[i] &= ~acks.acked[i];
 		}
 	}
-	else
+
+	for(uint32_t id = 0; id < MESH_GROUP_BITMAP_SIZE * 8; ++id)
 	{
-		std::cout << "message is nullptr" << std::endl;
+		if(mesh_group_has_id(acks.acked, id))
+		{
+			printf("mesh[switch_devices]: device %u is %s\n", id, mesh_group_has_id(acks.on, id) ? "on" : "off");
+		}
+		else if(target.group == MESH_GROUP_NONE && mesh_group_has_id(target.ids, id))
+		{
+			printf("mesh[switch_devices]: device %u not responding\n", id);
+		}
 	}
 }
 
-void mesh_devices_info_request_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+/**
+ * @brief Функция разбора --switch=ACTION:TARGET, TARGET - список id через запятую либо group=N
+ */
+static bool parse_switch(const char* value, struct mesh_group_command* command)
 {
-	if(msg != nullptr)
+	memset(command, 0, sizeof(struct mesh_group_command));
+
+	const char* target = strchr(value, ':');
+	if(target == nullptr)
 	{
-		if(msg->data_size == sizeof(struct mesh_device_info))
-		{
-			mesh_device_info info;
-			info.type = 3;
-			info.id = 0;
-			snprintf(info.name, MESH_DEVICE_NAME_SIZE, "PC-stub");
-			info.ip = 0xC0A800; //192.168.0.110
+		return false;
+	}
 
-			std::cout << "mesh[mesh_devices_info_request_handler]: send_device_info called" << std::endl;
-			mesh_send_device_info(ctx, &info, sender->ip);
+	std::string action(value, target - value);
+	if(action == "on")
+	{
+		command->action = mesh_group_power_on;
+	}
+	else if(action == "off")
+	{
+		command->action = mesh_group_power_off;
+	}
+	else if(action == "toggle")
+	{
+		command->action = mesh_group_power_toggle;
+	}
+	else
+	{
+		return false;
+	}
+
+	++target;
+	char* end = nullptr;
+	if(strncmp(target, "group=", 6) == 0)
+	{
+		unsigned long group = strtoul(target + 6, &end, 10);
+		if(end == target + 6 || *end != 0 || group == MESH_GROUP_NONE || group > 0xFF)
+		{
+			return false;
 		}
-		else
+		command->group = group;
+		return true;
+	}
+
+	while(*target != 0)
+	{
+		unsigned long id = strtoul(target, &end, 10);
+		if(end == target || id > 0xFF || (*end != ',' && *end != 0))
 		{
-			std::cout << "invalid message data size" << std::endl;
+			return false;
 		}
+		mesh_group_add_id(command, id);
+		target = *end == ',' ? end + 1 : end;
+	}
+	return mesh_group_count(command->ids) != 0;
+}
+
+void mesh_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<mesh_keep_alive> info)
+{
+	mesh_registry_update(registry, sender->ip, info.get(), mesh_now(ctx));
+
+	in_addr addr;
+	addr.s_addr = info->ip;
+	printf("mesh[mesh_keep_alive_handler]: received info device_id: %d, device_type: %d, device_ip: %s, device_name: %s\n", 
+			info->id, info->type, inet_ntoa(addr), info->name);
+}
+
+void mesh_devices_info_request_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<mesh_devices_info_request>)
+{
+	if(router != nullptr)
+	{
+		mesh_coro_spawn(answer_devices_info(ctx, sender->ip));
 	}
 	else
 	{
-		std::cout << "message is nullptr" << std::endl;
+		mesh_device_info info;
+		fill_stub_info(&info);
+
+		std::cout << "mesh[mesh_devices_info_request_handler]: send_device_info called" << std::endl;
+		mesh_send_device_info(ctx, &info, sender->ip);
 	}
 }
 
-void mesh_device_info_response_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+void mesh_device_info_response_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<mesh_device_info_response> info)
 {
-	if(msg != nullptr)
+	mesh_registry_update(registry, sender->ip, info.get(), mesh_now(ctx));
+
+	if(!mesh_coro_route(router, sender, info.msg))
+	{	// ответ не ожидала корутина контроллера
+		in_addr addr;
+		addr.s_addr = info->ip;
+
+		in_addr sender_addr;
+		sender_addr.s_addr = sender->ip;
+		printf("mesh[mesh_device_info_response_handler]: received info device_id: %d, device_type: %d, device_ip: %s, device_name: %s, sender: %s\n", 
+				info->id, info->type, inet_ntoa(addr), info->name, inet_ntoa(sender_addr));
+	}
+	mesh_send_request_device_info_confirm(ctx, sender->ip);
+}
+
+void mesh_device_info_response_confirm_handler(struct mesh_ctx*, struct mesh_sender_info* sender, mesh_view<mesh_device_info_response_confirm> confirm)
+{
+	if(!mesh_coro_route(router, sender, confirm.msg))
 	{
-		if(msg->data_size == sizeof(struct mesh_device_info))
-		{
-			struct mesh_device_info* info = (struct mesh_device_info*) msg->data;
+		std::cout << "received device_info_response_confirm" << std::endl;
+	}
+}
 
-			in_addr addr;
-			addr.s_addr = info->ip;
+/**
+ * @brief Оценка часов источника маяков, контроллер принимает и свои маяки
+ */
+static struct mesh_time stub_time;
 
-			in_addr sender_addr;
-			sender_addr.s_addr = sender->ip;
-			printf("mesh[mesh_device_info_response_handler]: received info device_id: %d, device_type: %d, device_ip: %s, device_name: %s, sender: %s\n", 
-					info->id, info->type, inet_ntoa(addr), info->name, inet_ntoa(sender_addr));
+void mesh_time_sync_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<mesh_time_sync> beacon)
+{
+	mesh_time_on_beacon(&stub_time, ctx, sender, beacon.msg);
+}
 
-			mesh_send_request_device_info_confirm(ctx, sender->ip);
-		}
-		else
+/**
+ * @brief Групповая команда отложенная до момента mesh_group_command::at
+ */
+static struct mesh_group_command stub_group_pending;
+static uint32_t stub_group_pending_sender = 0;
+static struct mesh_timer* stub_group_timer = nullptr;
+
+static void send_group_ack(struct mesh_ctx* ctx, const struct mesh_group_command* command, uint32_t sender)
+{
+	if(command->flags & MESH_GROUP_FLAG_ACK)
+	{
+		mesh_device_info info;
+		fill_stub_info(&info);
+
+		struct mesh_group_ack ack;
+		memset(&ack, 0, sizeof(struct mesh_group_ack));
+		ack.seq = command->seq;
+		ack.id = info.id;
+		ack.state = stub_power;
+		mesh_send_group_switch_ack(ctx, &ack, sender);
+	}
+}
+
+static void set_stub_power(struct mesh_ctx* ctx, uint8_t state)
+{
+	if(state == stub_power)
+	{
+		return;
+	}
+	stub_power = state;
+
+	mesh_device_info info;
+	fill_stub_info(&info);
+
+	struct mesh_power_event event;
+	memset(&event, 0, sizeof(struct mesh_power_event));
+	event.seq = ++stub_power_seq;
+	event.boot = stub_power_boot;
+	event.id = info.id;
+	event.state = state;
+	mesh_send_power_event(ctx, &event);
+}
+
+static void apply_group_command(struct mesh_ctx* ctx, const struct mesh_group_command* command, uint32_t sender)
+{
+	set_stub_power(ctx, command->action == mesh_group_power_toggle ? stub_power ^ 1 : command->action == mesh_group_power_on);
+	printf("mesh[mesh_group_switch_handler]: seq: %u, power: %s, mesh time: %llu\n", command->seq, stub_power ? "on" : "off",
+		static_cast<unsigned long long>(mesh_time_now(&stub_time, ctx)));
+	send_group_ack(ctx, command, sender);
+}
+
+static void group_timer_handler(struct mesh_ctx* ctx, void*)
+{
+	// однократный таймер удален транспортом
+	stub_group_timer = nullptr;
+	apply_group_command(ctx, &stub_group_pending, stub_group_pending_sender);
+}
+
+void mesh_group_switch_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<mesh_group_switch> view)
+{
+	mesh_device_info info;
+	fill_stub_info(&info);
+
+	struct mesh_group_command* command = view.get();
+	if(!mesh_group_match(command, info.id, MESH_GROUP_NONE))
+	{
+		return;
+	}
+
+	bool repeat = command->seq == stub_group_seq && sender->ip == stub_group_sender;
+	stub_group_seq = command->seq;
+	stub_group_sender = sender->ip;
+
+	if(repeat && stub_group_timer != nullptr)
+	{	// действие еще ждет своего момента, подтверждение уйдет после выполнения
+		stub_group_pending.flags |= command->flags & MESH_GROUP_FLAG_ACK;
+		return;
+	}
+
+	if(repeat)
+	{	// повтор только подтверждается
+		send_group_ack(ctx, command, sender->ip);
+		return;
+	}
+
+	if(stub_group_timer != nullptr)
+	{
+		mesh_timer_stop(ctx, stub_group_timer);
+		stub_group_timer = nullptr;
+	}
+
+	if(command->at != 0 && mesh_time_synced(&stub_time, ctx))
+	{
+		stub_group_pending = *command;
+		stub_group_pending_sender = sender->ip;
+		stub_group_timer = mesh_time_at(&stub_time, ctx, command->at, group_timer_handler, nullptr);
+		if(stub_group_timer != nullptr)
 		{
-			std::cout << "invalid message data size" << std::endl;
+			return;
 		}
 	}
-	else
+	apply_group_command(ctx, command, sender->ip);
+}
+
+void mesh_group_switch_ack_handler(struct mesh_ctx*, struct mesh_sender_info* sender, mesh_view<mesh_group_switch_ack> ack)
+{
+	if(!mesh_coro_route(router, sender, ack.msg))
 	{
-		std::cout << "message is nullptr" << std::endl;
+		printf("mesh[mesh_group_switch_ack_handler]: unexpected ack seq: %u, id: %u\n", ack->seq, ack->id);
 	}
 }
 
-void mesh_device_info_response_confirm_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+void mesh_power_event_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<mesh_power_event> event)
 {
-	if(msg != nullptr)
+	in_addr addr;
+	addr.s_addr = htonl(sender->ip);
+
+	uint32_t missed = 0;
+	mesh_power_seq_status status = mesh_power_seq_next;
+	if(!mesh_registry_power(registry, sender->ip, event.get(), mesh_now(ctx), &status, &missed))
+	{	// состояние появится со следующим событием после keep_alive
+		printf("mesh[mesh_power_event_handler]: event from unknown device %s\n", inet_ntoa(addr));
+		return;
+	}
+
+	switch(status)
 	{
-		std::cout << "received device_info_response_confirm" << std::endl;
+		case mesh_power_seq_gap:
+			printf("mesh[mesh_power_event_handler]: device %s missed %u events before seq %u\n", inet_ntoa(addr), missed, event->seq);
+			break;
+
+		case mesh_power_seq_restart:
+			printf("mesh[mesh_power_event_handler]: device %s restarted, seq %u\n", inet_ntoa(addr), event->seq);
+			break;
+
+		case mesh_power_seq_stale:
+			printf("mesh[mesh_power_event_handler]: device %s stale event seq %u ignored\n", inet_ntoa(addr), event->seq);
+			return;
+
+		case mesh_power_seq_duplicate:
+			return;
+
+		default:
+			break;
+	}
+	printf("mesh[mesh_power_event_handler]: device %s id: %u, seq: %u, power: %s\n", inet_ntoa(addr), event->id, event->seq, event->state ? "on" : "off");
+}
+
+void mesh_election_table_handler(struct mesh_ctx* ctx, struct mesh_sender_info*, mesh_view<mesh_election_table> table)
+{
+	// лидер сегмента отвечает на опрос за устройства, которые сами молчат
+	for(uint32_t i = 0; i < table->count && i < MESH_ELECTION_TABLE_SIZE; ++i)
+	{
+		struct mesh_election_entry* entry = &table->entries[i];
+		mesh_registry_update(registry, entry->ip, &entry->info, mesh_now(ctx));
+
+		in_addr addr;
+		addr.s_addr = htonl(entry->ip);
+		printf("mesh[mesh_election_table_handler]: device %s id: %d, type: %d, name: %s\n", inet_ntoa(addr), entry->info.id, entry->info.type, entry->info.name);
+	}
+}
+
+/**
+ * @brief Обработчики mesh, команда и размер данных проверяются по типу mesh_view обработчика
+ */
+using stub_schema = mesh_schema<
+	mesh_keep_alive_handler,
+	mesh_devices_info_request_handler,
+	mesh_device_info_response_handler,
+	mesh_device_info_response_confirm_handler,
+	mesh_group_switch_handler,
+	mesh_group_switch_ack_handler,
+	mesh_time_sync_handler,
+	mesh_power_event_handler,
+	mesh_election_table_handler>;
+
+
+static bool keep_alive = true;
+
+static void emit_stub_message(struct mesh_ctx* ctx, void*)
+{
+	if(keep_alive)
+	{
+		mesh_device_info info;
+		fill_stub_info(&info);
+
+		LOG("keep_alive message send\n");
+		mesh_send_keep_alive(ctx, &info);
 	}
 	else
 	{
-		std::cout << "message is nullptr" << std::endl;
+		LOG("request_devices message send\n");
+		mesh_send_request_devices_info(ctx);
 	}
+	keep_alive = !keep_alive;
+}
+
+static uint32_t time_beacon_seq = 0;
+
+static void emit_time_beacon(struct mesh_ctx* ctx, void*)
+{
+	mesh_time_send_beacon(ctx, ++time_beacon_seq);
 }
 
-static struct mesh_message_handlers mesh_handlers[] = 
-{	
-	{ mesh_keep_alive, mesh_keep_alive_handler },
-	{ mesh_devices_info_request, mesh_devices_info_request_handler },
-	{ mesh_device_info_response, mesh_device_info_response_handler },
-	{ mesh_device_info_response_confirm, mesh_device_info_response_confirm_handler },
-	{ mesh_keep_alive, NULL },
-};
+/**
+ * @brief Выход из цикла по сигналу, чтобы закрыть сегмент shared memory
+ */
+static volatile sig_atomic_t stop_requested = 0;
 
+static void on_stop_signal(int)
+{
+	stop_requested = 1;
+}
+
+/**
+ * @brief Период обслуживания event_loop сервера запросов при работе через io_uring, ms
+ */
+#define QUERY_POLL_INTERVAL 20
+
+static void run_query_loop(struct mesh_ctx*, void* arg)
+{
+	// libev не отдает epoll дескриптор наружу, поэтому loop опрашивается без ожидания
+	ev_run(reinterpret_cast<struct ev_loop*>(arg), EVRUN_NOWAIT);
+}
+
+static void check_stop(struct mesh_ctx* ctx, void* arg)
+{
+	if(stop_requested)
+	{
+		if(*reinterpret_cast<bool*>(arg))
+		{
+			mesh_uring_break(ctx);
+		}
+		else
+		{
+			mesh_udp_break(ctx);
+		}
+	}
+}
 
 int main(int argc, const char** argv)
 {   
-	mesh_ctx* ctx = mesh_start(mesh_handlers, INADDR_ANY, 6636);
+	stub_power_boot = std::random_device()();
+
+	bool uring = false;
+	bool coro = false;
+	uint32_t workers = 0;
+	const char* shm_name = MESH_SHM_DEFAULT_NAME;
+	const char* cache_path = MESH_CACHE_DEFAULT_PATH;
+	const char* query_path = MESH_QUERY_DEFAULT_PATH;
+	bool group_switch = false;
+	uint32_t group_lead = 0;
+	struct mesh_group_command command;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--backend=uring") == 0)
+		{
+			uring = true;
+		}
+		else if(strcmp(argv[i], "--backend=ev") == 0)
+		{
+			uring = false;
+		}
+		else if(strcmp(argv[i], "--controller") == 0)
+		{
+			coro = true;
+		}
+		else if(strncmp(argv[i], "--workers=", 10) == 0)
+		{
+			workers = strtoul(argv[i] + 10, nullptr, 10);
+		}
+		else if(strncmp(argv[i], "--shm=", 6) == 0)
+		{
+			shm_name = argv[i] + 6;
+		}
+		else if(strcmp(argv[i], "--no-shm") == 0)
+		{
+			shm_name = nullptr;
+		}
+		else if(strncmp(argv[i], "--cache=", 8) == 0)
+		{
+			cache_path = argv[i] + 8;
+		}
+		else if(strcmp(argv[i], "--no-cache") == 0)
+		{
+			cache_path = nullptr;
+		}
+		else if(strncmp(argv[i], "--query=", 8) == 0)
+		{
+			query_path = argv[i] + 8;
+		}
+		else if(strcmp(argv[i], "--no-query") == 0)
+		{
+			query_path = nullptr;
+		}
+		else if(strncmp(argv[i], "--switch=", 9) == 0)
+		{
+			if(!parse_switch(argv[i] + 9, &command))
+			{
+				std::cout << "invalid --switch, expected on|off|toggle:ID[,ID...] or on|off|toggle:group=N" << std::endl;
+				return 1;
+			}
+			group_switch = true;
+		}
+		else if(strncmp(argv[i], "--at=", 5) == 0)
+		{
+			group_lead = strtoul(argv[i] + 5, nullptr, 10);
+		}
+		else
+		{
+			std::cout << "usage: " << argv[0] << " [--backend=ev|uring] [--workers=N] [--controller] [--shm=NAME|--no-shm] [--cache=PATH|--no-cache] [--query=PATH|--no-query] [--switch=ACTION:TARGET [--at=MS]]" << std::endl;
+			return 1;
+		}
+	}
+
+	if(group_switch && !coro)
+	{	// подтверждения собирает корутина
+		std::cout << "--switch requires --controller" << std::endl;
+		return 1;
+	}
+
+	if(coro && workers != 0)
+	{	// корутины возобновляются в потоке event loop
+		std::cout << "--controller can not be used with --workers" << std::endl;
+		return 1;
+	}
+
+	if(uring && !mesh_uring_supported())
+	{
+		std::cout << "io_uring not supported, fallback to libev" << std::endl;
+		uring = false;
+	}
+
+	mesh_ctx* ctx = uring ? mesh_uring_start(stub_schema::handlers, INADDR_ANY, 6636) : mesh_udp_start(stub_schema::handlers, INADDR_ANY, 6636);
 	if(ctx != nullptr)
 	{
+		std::cout << "mesh transport: " << ctx->transport->name << std::endl;
+
+		registry = mesh_registry_new();
+		// кэш загружается до публикации, клиенты сразу видят известные устройства
+		struct mesh_cache* cache = cache_path != nullptr ? mesh_cache_open(cache_path, registry) : nullptr;
+		struct mesh_shm_publisher* publisher = shm_name != nullptr ? mesh_shm_publisher_new(shm_name, registry) : nullptr;
+
+		signal(SIGINT, on_stop_signal);
+		signal(SIGTERM, on_stop_signal);
+		mesh_timer_start(ctx, 200, true, check_stop, &uring);
+
+		// обработчики печатают в консоль, выносим их из потока приема
+		struct mesh_dispatcher* dispatcher = workers != 0 ? mesh_dispatcher_new(workers) : nullptr;
+		// групповая команда и маяки запускают таймеры и меняют состояние stub, они остаются в потоке loop
+		mesh_dispatcher_keep_in_loop(dispatcher, mesh_group_switch);
+		mesh_dispatcher_keep_in_loop(dispatcher, mesh_time_sync);
+		if(uring)
+		{
+			mesh_uring_set_dispatcher(ctx, dispatcher);
+		}
+		else
+		{
+			mesh_udp_set_dispatcher(ctx, dispatcher);
+		}
+
+		// сервер запросов работает на libev, с io_uring его loop обслуживается таймером транспорта
+		struct ev_loop* query_loop = nullptr;
+		if(query_path != nullptr)
+		{
+			if(!uring)
+			{
+				query_loop = reinterpret_cast<struct mesh_udp_ctx*>(ctx)->loop;
+			}
+			else
+			{
+				query_loop = ev_loop_new(EVBACKEND_EPOLL);
+			}
+		}
+		struct mesh_query* query = query_loop != nullptr ? mesh_query_new(query_path, query_loop, ctx, registry) : nullptr;
+		if(uring && query_loop != nullptr)
+		{
+			mesh_timer_start(ctx, QUERY_POLL_INTERVAL, true, run_query_loop, query_loop);
+		}
+
+		if(coro)
+		{
+			router = mesh_coro_router_new(ctx);
+			// контроллер - источник часов mesh
+			emit_time_beacon(ctx, nullptr);
+			mesh_timer_start(ctx, MESH_TIME_BEACON_INTERVAL, true, emit_time_beacon, nullptr);
+			if(group_switch)
+			{	// seq от времени запуска, чтобы устройства не приняли команду за повтор прошлой
+				command.seq = static_cast<uint32_t>(time(nullptr));
+				// часы контроллера и есть часы mesh, устройства без синхронизации выполнят сразу
+				command.at = group_lead != 0 ? mesh_clock(ctx) + static_cast<uint64_t>(group_lead) * 1000 : 0;
+				mesh_coro_spawn(switch_devices(router, command, group_lead));
+			}
+			mesh_coro_spawn(controller(router));
+		}
+		else
+		{
+			mesh_timer_start(ctx, 10000, true, emit_stub_message, nullptr);
+		}
+
+		if(uring)
+		{
+			mesh_uring_run(ctx);
+		}
+		else
+		{
+			mesh_udp_run(ctx);
+		}
+		mesh_dispatcher_free(dispatcher);
+		mesh_coro_router_free(router);
+		mesh_query_free(query);
+		if(uring && query_loop != nullptr)
+		{
+			ev_loop_destroy(query_loop);
+		}
+		mesh_shm_publisher_free(publisher);
 		mesh_stop(ctx);
+		mesh_cache_close(cache);
+		mesh_registry_free(registry);
 	}
 	else
 	{
@@ -118,4 +716,3 @@ int main(int argc, const char** argv)
 	
 	return 0;
 }
-
@@ -0,0 +1,513 @@
+#include "mesh_memory.h"
+#include "mesh_registry.h"
+#include "mesh_wire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <new>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Адрес первого узла in-memory сети
+ */
+#define BENCH_BASE_ADDR 0x0A000001
+
+/**
+ * @brief Счетчики выделений памяти
+ * malloc/calloc/realloc подменяются при линковке (-Wl,--wrap), operator new идет через malloc,
+ * поэтому учитываются выделения и кода mesh на C, и контейнеров stub
+ */
+static uint64_t bench_allocs = 0;
+static uint64_t bench_alloc_bytes = 0;
+
+extern "C"
+{
+	void* __real_malloc(size_t size);
+	void* __real_calloc(size_t count, size_t size);
+	void* __real_realloc(void* ptr, size_t size);
+
+	void* __wrap_malloc(size_t size)
+	{
+		++bench_allocs;
+		bench_alloc_bytes += size;
+		return __real_malloc(size);
+	}
+
+	void* __wrap_calloc(size_t count, size_t size)
+	{
+		++bench_allocs;
+		bench_alloc_bytes += count * size;
+		return __real_calloc(count, size);
+	}
+
+	void* __wrap_realloc(void* ptr, size_t size)
+	{
+		++bench_allocs;
+		bench_alloc_bytes += size;
+		return __real_realloc(ptr, size);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = malloc(size != 0 ? size : 1);
+	if(ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+/**
+ * @brief Параметры замеров
+ */
+struct bench_config
+{
+	uint64_t iterations;		///< кол-во операций замера
+	uint32_t devices;			///< кол-во устройств в таблице (registry)
+};
+
+/**
+ * @brief Замер
+ */
+struct bench_case
+{
+	const char* name;											///< имя замера
+	uint64_t (*run)(const bench_config* config);				///< прогон, возвращает кол-во операций
+};
+
+/**
+ * @brief Защита от удаления замеряемого кода компилятором
+ */
+static volatile uint64_t bench_sink = 0;
+
+static uint64_t bench_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static void bench_fill_info(struct mesh_device_info* info, uint32_t i)
+{
+	memset(info, 0, sizeof(struct mesh_device_info));
+	info->type = 1;
+	info->id = static_cast<uint8_t>(i);
+	info->ip = BENCH_BASE_ADDR + i;
+	snprintf(info->name, MESH_DEVICE_NAME_SIZE, "bench %u", i);
+}
+
+static void bench_handler(struct mesh_ctx*, struct mesh_sender_info*, struct mesh_message* msg)
+{
+	bench_sink = bench_sink + msg->data_size;
+}
+
+/**
+ * @brief Таблица с обработчиком в конце, худший случай линейного поиска call_handler
+ */
+static struct mesh_message_handlers bench_handlers[] =
+{
+	{ mesh_devices_info_request, bench_handler },
+	{ mesh_device_info_response, bench_handler },
+	{ mesh_device_info_response_confirm, bench_handler },
+	{ mesh_group_switch, bench_handler },
+	{ mesh_group_switch_ack, bench_handler },
+	{ mesh_time_sync, bench_handler },
+	{ mesh_power_event, bench_handler },
+	{ mesh_election_announce, bench_handler },
+	{ mesh_election_table, bench_handler },
+	{ mesh_keep_alive, bench_handler },
+	{ mesh_keep_alive, NULL },
+};
+
+/**
+ * @brief Кодирование и декодирование сообщения на месте
+ */
+static uint64_t bench_wire(const bench_config* config)
+{
+	struct mesh_device_info info;
+	bench_fill_info(&info, 1);
+
+	struct mesh_message msg;
+	memset(&msg, 0, sizeof(struct mesh_message));
+	msg.data_size = sizeof(struct mesh_device_info);
+
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		msg.magic = MESH_WIRE_MAGIC;
+		msg.command = mesh_keep_alive;
+		memcpy(msg.data, &info, sizeof(struct mesh_device_info));
+		mesh_wire_encode(&msg);
+		bench_sink = bench_sink + mesh_wire_decode(&msg);
+	}
+	return config->iterations;
+}
+
+/**
+ * @brief Создание сообщения для отправки (выделение, копирование, кодирование)
+ */
+static uint64_t bench_new_message(const bench_config* config)
+{
+	struct mesh_device_info info;
+	bench_fill_info(&info, 1);
+
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		struct mesh_message* msg = new_message(mesh_keep_alive, &info, sizeof(struct mesh_device_info));
+		bench_sink = bench_sink + msg->data_size;
+		free_message(msg);
+	}
+	return config->iterations;
+}
+
+/**
+ * @brief Поиск обработчика и вызов (call_handler)
+ */
+static uint64_t bench_call_handler(const bench_config* config)
+{
+	struct mesh_message msg;
+	memset(&msg, 0, sizeof(struct mesh_message));
+	msg.magic = MESH_WIRE_MAGIC;
+	msg.command = mesh_keep_alive;
+	msg.data_size = sizeof(struct mesh_device_info);
+
+	struct mesh_sender_info sender;
+	sender.ip = BENCH_BASE_ADDR;
+	sender.port = 0;
+
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		call_handler(bench_handlers, nullptr, &sender, &msg);
+	}
+	return config->iterations;
+}
+
+/**
+ * @brief Прием сообщения: декодирование и вызов обработчика (mesh_dispatch)
+ */
+static uint64_t bench_dispatch(const bench_config* config)
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* ctx = mesh_memory_start(network, bench_handlers, BENCH_BASE_ADDR);
+
+	struct mesh_device_info info;
+	bench_fill_info(&info, 1);
+
+	struct mesh_message* encoded = new_message(mesh_keep_alive, &info, sizeof(struct mesh_device_info));
+	struct mesh_message msg;
+
+	struct mesh_sender_info sender;
+	sender.ip = BENCH_BASE_ADDR + 1;
+	sender.port = 0;
+
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{	// транспорт отдает каждое сообщение в своем буфере
+		memcpy(&msg, encoded, sizeof(struct mesh_message));
+		mesh_dispatch(ctx, &sender, &msg);
+	}
+
+	free_message(encoded);
+	mesh_stop(ctx);
+	mesh_memory_network_free(network);
+	return config->iterations;
+}
+
+/**
+ * @brief Обновление таблицы устройств по keep_alive
+ */
+static uint64_t bench_registry_update(const bench_config* config)
+{
+	struct mesh_registry* registry = mesh_registry_new();
+
+	struct mesh_device_info info;
+	bench_fill_info(&info, 1);
+
+	for(uint32_t i = 0; i < config->devices; ++i)
+	{	// прогрев, замеряется обновление известных устройств
+		mesh_registry_update(registry, BENCH_BASE_ADDR + i, &info, 0);
+	}
+
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		mesh_registry_update(registry, BENCH_BASE_ADDR + i % config->devices, &info, static_cast<uint32_t>(i));
+	}
+
+	mesh_registry_free(registry);
+	return config->iterations;
+}
+
+/**
+ * @brief Поиск устройства в таблице
+ */
+static uint64_t bench_registry_find(const bench_config* config)
+{
+	struct mesh_registry* registry = mesh_registry_new();
+
+	struct mesh_device_info info;
+	bench_fill_info(&info, 1);
+	for(uint32_t i = 0; i < config->devices; ++i)
+	{
+		mesh_registry_update(registry, BENCH_BASE_ADDR + i, &info, 0);
+	}
+
+	struct mesh_registry_device device;
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		bench_sink = bench_sink + mesh_registry_find(registry, BENCH_BASE_ADDR + i % config->devices, &device);
+	}
+
+	mesh_registry_free(registry);
+	return config->iterations;
+}
+
+static void bench_timer_callback(struct mesh_ctx*, void* arg)
+{
+	++*reinterpret_cast<uint64_t*>(arg);
+}
+
+/**
+ * @brief Запуск и остановка таймера
+ */
+static uint64_t bench_timer_start(const bench_config* config)
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* ctx = mesh_memory_start(network, bench_handlers, BENCH_BASE_ADDR);
+
+	uint64_t fired = 0;
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		struct mesh_timer* timer = mesh_timer_start(ctx, 1000, 0, bench_timer_callback, &fired);
+		mesh_timer_stop(ctx, timer);
+	}
+	// остановленные таймеры удаляются из очереди при обработке
+	mesh_memory_network_run(network, 1000);
+
+	mesh_stop(ctx);
+	mesh_memory_network_free(network);
+	return config->iterations;
+}
+
+/**
+ * @brief Срабатывание периодического таймера
+ */
+static uint64_t bench_timer_fire(const bench_config* config)
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* ctx = mesh_memory_start(network, bench_handlers, BENCH_BASE_ADDR);
+
+	uint64_t fired = 0;
+	struct mesh_timer* timer = mesh_timer_start(ctx, 1, 1, bench_timer_callback, &fired);
+
+	uint32_t until = config->iterations < UINT32_MAX ? static_cast<uint32_t>(config->iterations) : UINT32_MAX;
+	mesh_memory_network_run(network, until);
+
+	mesh_timer_stop(ctx, timer);
+	mesh_stop(ctx);
+	mesh_memory_network_free(network);
+	return fired;
+}
+
+/**
+ * @brief keep_alive от отправки до обработчика получателя через in-memory транспорт
+ */
+static uint64_t bench_keep_alive(const bench_config* config)
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* sender = mesh_memory_start(network, bench_handlers, BENCH_BASE_ADDR);
+	struct mesh_ctx* receiver = mesh_memory_start(network, bench_handlers, BENCH_BASE_ADDR + 1);
+
+	struct mesh_device_info info;
+	bench_fill_info(&info, 1);
+
+	uint64_t delivered = mesh_memory_network_stats(network).delivered;
+	for(uint64_t i = 0; i < config->iterations; ++i)
+	{
+		mesh_send_keep_alive(sender, &info);
+		mesh_memory_network_run(network, mesh_memory_network_now(network));
+	}
+	delivered = mesh_memory_network_stats(network).delivered - delivered;
+
+	mesh_stop(receiver);
+	mesh_stop(sender);
+	mesh_memory_network_free(network);
+	return delivered;
+}
+
+static const bench_case bench_cases[] =
+{
+	{ "wire", bench_wire },
+	{ "new_message", bench_new_message },
+	{ "call_handler", bench_call_handler },
+	{ "dispatch", bench_dispatch },
+	{ "registry_update", bench_registry_update },
+	{ "registry_find", bench_registry_find },
+	{ "timer_start", bench_timer_start },
+	{ "timer_fire", bench_timer_fire },
+	{ "keep_alive", bench_keep_alive },
+};
+
+static void bench_run(const bench_case* test, const bench_config* config, bool csv)
+{
+	uint64_t allocs = bench_allocs;
+	uint64_t bytes = bench_alloc_bytes;
+	uint64_t start = bench_clock();
+
+	uint64_t ops = test->run(config);
+
+	uint64_t elapsed = bench_clock() - start;
+	allocs = bench_allocs - allocs;
+	bytes = bench_alloc_bytes - bytes;
+
+	double seconds = elapsed / 1e9;
+	double rate = seconds > 0 ? ops / seconds : 0.;
+	double ns_per_op = ops != 0 ? static_cast<double>(elapsed) / ops : 0.;
+	double allocs_per_op = ops != 0 ? static_cast<double>(allocs) / ops : 0.;
+	double bytes_per_op = ops != 0 ? static_cast<double>(bytes) / ops : 0.;
+
+	if(csv)
+	{
+		printf("%s,%llu,%.6f,%.0f,%.1f,%.3f,%.1f\n", test->name, (unsigned long long) ops,
+				seconds, rate, ns_per_op, allocs_per_op, bytes_per_op);
+	}
+	else
+	{
+		printf("%-16s %10llu ops in %.3f s: %12.0f ops/s, %8.1f ns/op, %6.3f allocs/op, %8.1f bytes/op\n",
+				test->name, (unsigned long long) ops, seconds, rate, ns_per_op, allocs_per_op, bytes_per_op);
+	}
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --case=NAME              run only this case (repeatable), default all\n"
+			"  --iterations=N           operations per case\n"
+			"  --devices=N              devices in registry cases\n"
+			"  --csv                    machine readable output\n"
+			"cases:", name);
+	for(const bench_case& test : bench_cases)
+	{
+		printf(" %s", test.name);
+	}
+	printf("\n");
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	bench_config config;
+	config.iterations = 1000000;
+	config.devices = 256;
+
+	bool csv = false;
+	bool selected[sizeof(bench_cases) / sizeof(bench_case)] = { false };
+	bool any = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--case")) != nullptr)
+		{
+			bool found = false;
+			for(size_t j = 0; j < sizeof(bench_cases) / sizeof(bench_case); ++j)
+			{
+				if(strcmp(bench_cases[j].name, value) == 0)
+				{
+					selected[j] = true;
+					found = true;
+				}
+			}
+			if(!found)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+			any = true;
+		}
+		else if((value = option_value(argv[i], "--iterations")) != nullptr)
+		{
+			config.iterations = strtoull(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--devices")) != nullptr)
+		{
+			config.devices = strtoul(value, nullptr, 10);
+		}
+		else if(strcmp(argv[i], "--csv") == 0)
+		{
+			csv = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if(config.iterations == 0 || config.devices == 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	// логи mesh исказят замер
+	mesh_stub_log_enable(0);
+
+	if(csv)
+	{
+		printf("case,ops,seconds,ops_per_second,ns_per_op,allocs_per_op,bytes_per_op\n");
+	}
+
+	for(size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_case); ++i)
+	{
+		if(!any || selected[i])
+		{
+			bench_run(&bench_cases[i], &config, csv);
+		}
+	}
+	return 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,310 @@
+#include "mesh_cache.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Метка файла кэша ("MSHC")
+ */
+#define MESH_CACHE_MAGIC 0x4348534D
+
+/**
+ * @brief Версия формата
+ */
+#define MESH_CACHE_VERSION 1
+
+/**
+ * @brief Начальная емкость файла, записей
+ */
+#define MESH_CACHE_INITIAL_CAPACITY 256
+
+/**
+ * @brief Заголовок файла
+ */
+struct mesh_cache_header
+{
+	uint32_t magic;							///< MESH_CACHE_MAGIC
+	uint32_t version;						///< MESH_CACHE_VERSION
+	uint32_t record_size;					///< sizeof(struct mesh_cache_record)
+	uint32_t count;							///< кол-во записей
+	uint8_t reserved[16];					///< до 32 байт
+};
+
+/**
+ * @brief Запись об устройстве
+ */
+struct mesh_cache_record
+{
+	uint32_t checksum;						///< FNV-1a остальной части записи, 0 - запись пустая
+	uint32_t ip;							///< адрес устройства (host order)
+	uint8_t type;							///< тип устройства
+	uint8_t id;								///< id устройства
+	uint16_t reserved;						///< выравнивание
+	uint32_t device_ip;						///< mesh_device_info::ip
+	uint64_t last_seen;						///< последнее подтверждение, s CLOCK_REALTIME
+	char name[MESH_DEVICE_NAME_SIZE];		///< имя устройства
+};
+
+/**
+ * @brief Кэш
+ */
+struct mesh_cache
+{
+	int fd;									///< файл
+	struct mesh_registry* registry;			///< таблица устройств
+	struct mesh_cache_header* header;		///< отображение файла
+	uint32_t capacity;						///< емкость отображения, записей
+	uint32_t loaded;						///< загружено при открытии
+};
+
+static size_t mesh_cache_size(uint32_t capacity)
+{
+	return sizeof(struct mesh_cache_header) + static_cast<size_t>(capacity) * sizeof(struct mesh_cache_record);
+}
+
+static struct mesh_cache_record* mesh_cache_records(struct mesh_cache_header* header)
+{
+	return reinterpret_cast<struct mesh_cache_record*>(reinterpret_cast<uint8_t*>(header) + sizeof(struct mesh_cache_header));
+}
+
+static uint32_t mesh_cache_checksum(const struct mesh_cache_record* record)
+{
+	const uint8_t* data = reinterpret_cast<const uint8_t*>(record) + sizeof(record->checksum);
+	size_t size = sizeof(struct mesh_cache_record) - sizeof(record->checksum);
+
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	// 0 зарезервирован для пустой записи
+	return hash != 0 ? hash : 1;
+}
+
+/**
+ * @brief Функция изменения размера файла и отображения
+ */
+static bool mesh_cache_resize(struct mesh_cache* cache, uint32_t capacity)
+{
+	if(ftruncate(cache->fd, mesh_cache_size(capacity)) != 0)
+	{
+		LOG("mesh[cache]: failed resize file, err: %s\n", strerror(errno));
+		return false;
+	}
+
+	void* ptr = nullptr;
+	if(cache->header == nullptr)
+	{
+		ptr = mmap(nullptr, mesh_cache_size(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd, 0);
+	}
+	else
+	{
+		ptr = mremap(cache->header, mesh_cache_size(cache->capacity), mesh_cache_size(capacity), MREMAP_MAYMOVE);
+	}
+
+	if(ptr == MAP_FAILED)
+	{
+		LOG("mesh[cache]: failed map file, err: %s\n", strerror(errno));
+		return false;
+	}
+
+	cache->header = reinterpret_cast<struct mesh_cache_header*>(ptr);
+	cache->capacity = capacity;
+	return true;
+}
+
+static void mesh_cache_write(void* arg, const struct mesh_registry_device* device)
+{
+	mesh_cache* cache = reinterpret_cast<mesh_cache*>(arg);
+
+	if(device->slot >= cache->capacity)
+	{
+		uint32_t capacity = cache->capacity;
+		while(capacity <= device->slot)
+		{
+			capacity *= 2;
+		}
+		if(!mesh_cache_resize(cache, capacity))
+		{
+			return;
+		}
+	}
+
+	struct mesh_cache_record* record = &mesh_cache_records(cache->header)[device->slot];
+	if(device->verified)
+	{
+		record->last_seen = time(nullptr);
+	}
+	else if(record->checksum == 0)
+	{	// неподтвержденное устройство появляется только при загрузке кэша
+		record->last_seen = 0;
+	}
+
+	record->ip = device->ip;
+	record->type = device->info.type;
+	record->id = device->info.id;
+	record->reserved = 0;
+	record->device_ip = device->info.ip;
+	memcpy(record->name, device->info.name, MESH_DEVICE_NAME_SIZE);
+	record->checksum = mesh_cache_checksum(record);
+
+	if(device->slot >= cache->header->count)
+	{
+		cache->header->count = device->slot + 1;
+	}
+}
+
+/**
+ * @brief Функция проверки заголовка существующего файла
+ */
+static bool mesh_cache_valid(struct mesh_cache* cache, size_t size)
+{
+	struct mesh_cache_header* header = cache->header;
+	return header->magic == MESH_CACHE_MAGIC && header->version == MESH_CACHE_VERSION
+			&& header->record_size == sizeof(struct mesh_cache_record)
+			&& mesh_cache_size(header->count) <= size;
+}
+
+struct mesh_cache* mesh_cache_open(const char* path, struct mesh_registry* registry)
+{
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if(fd < 0)
+	{
+		LOG("mesh[cache]: failed open %s, err: %s\n", path, strerror(errno));
+		return nullptr;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0)
+	{
+		LOG("mesh[cache]: failed stat %s, err: %s\n", path, strerror(errno));
+		close(fd);
+		return nullptr;
+	}
+
+	mesh_cache* cache = new mesh_cache;
+	cache->fd = fd;
+	cache->registry = registry;
+	cache->header = nullptr;
+	cache->capacity = 0;
+	cache->loaded = 0;
+
+	// читаем старые записи целиком, файл затем переписывается компактно в порядке slot
+	std::vector<mesh_cache_record> records;
+	if(static_cast<size_t>(st.st_size) >= sizeof(struct mesh_cache_header))
+	{
+		uint32_t capacity = (st.st_size - sizeof(struct mesh_cache_header)) / sizeof(struct mesh_cache_record);
+		if(mesh_cache_resize(cache, capacity) && mesh_cache_valid(cache, st.st_size))
+		{
+			struct mesh_cache_record* stored = mesh_cache_records(cache->header);
+			records.assign(stored, stored + cache->header->count);
+		}
+		else if(cache->header != nullptr)
+		{
+			LOG("mesh[cache]: %s has unknown format, cache is reset\n", path);
+		}
+	}
+
+	uint32_t capacity = MESH_CACHE_INITIAL_CAPACITY;
+	while(capacity < records.size())
+	{
+		capacity *= 2;
+	}
+
+	if(cache->header != nullptr)
+	{
+		memset(cache->header, 0, mesh_cache_size(cache->capacity));
+	}
+	if(!mesh_cache_resize(cache, capacity))
+	{
+		if(cache->header != nullptr)
+		{
+			munmap(cache->header, mesh_cache_size(cache->capacity));
+		}
+		close(fd);
+		delete cache;
+		return nullptr;
+	}
+
+	cache->header->magic = MESH_CACHE_MAGIC;
+	cache->header->version = MESH_CACHE_VERSION;
+	cache->header->record_size = sizeof(struct mesh_cache_record);
+	cache->header->count = 0;
+
+	// записи пишутся подписчиком в порядке slot таблицы
+	mesh_registry_subscribe(registry, mesh_cache_write, cache);
+
+	uint64_t now = time(nullptr);
+	for(auto& record : records)
+	{
+		// запись оборванная при сбое питания либо давно не подтвержденная пропускается
+		if(record.checksum == 0 || record.checksum != mesh_cache_checksum(&record)
+				|| (record.last_seen != 0 && now > record.last_seen + MESH_CACHE_MAX_AGE))
+		{
+			continue;
+		}
+
+		struct mesh_device_info info;
+		memset(&info, 0, sizeof(struct mesh_device_info));
+		info.type = record.type;
+		info.id = record.id;
+		info.ip = record.device_ip;
+		memcpy(info.name, record.name, MESH_DEVICE_NAME_SIZE);
+
+		uint32_t before = mesh_registry_size(registry);
+		mesh_registry_restore(registry, record.ip, &info);
+		if(mesh_registry_size(registry) != before)
+		{
+			// сохраняем время последнего подтверждения, mesh_cache_write его не знает
+			struct mesh_registry_device device;
+			if(mesh_registry_find(registry, record.ip, &device) && device.slot < cache->capacity)
+			{
+				struct mesh_cache_record* stored = &mesh_cache_records(cache->header)[device.slot];
+				stored->last_seen = record.last_seen;
+				stored->checksum = mesh_cache_checksum(stored);
+			}
+			++cache->loaded;
+		}
+	}
+
+	LOG("mesh[cache]: loaded %u devices from %s\n", cache->loaded, path);
+	return cache;
+}
+
+void mesh_cache_close(struct mesh_cache* cache)
+{
+	if(cache == nullptr)
+	{
+		return;
+	}
+
+	mesh_registry_unsubscribe(cache->registry, mesh_cache_write, cache);
+
+	msync(cache->header, mesh_cache_size(cache->capacity), MS_SYNC);
+	munmap(cache->header, mesh_cache_size(cache->capacity));
+	close(cache->fd);
+	delete cache;
+}
+
+uint32_t mesh_cache_loaded(struct mesh_cache* cache)
+{
+	return cache != nullptr ? cache->loaded : 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "mesh_registry.h"
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Путь к файлу кэша по умолчанию
+ */
+#define MESH_CACHE_DEFAULT_PATH "esp_mesh.cache"
+
+/**
+ * @brief Устройства не подтвержденные дольше этого времени не загружаются, s
+ */
+#define MESH_CACHE_MAX_AGE (7 * 24 * 3600)
+
+/**
+ * @brief Постоянный кэш таблицы устройств
+ *
+ * Файл отображается в память (mmap) и состоит из заголовка и записей
+ * фиксированного размера, номер записи совпадает с mesh_registry_device::slot.
+ * Изменение устройства переписывает его запись на месте, новое устройство
+ * дописывается в конец, поэтому запись в кэш - это запись в память без
+ * системных вызовов (кроме редкого увеличения файла).
+ *
+ * При старте записи загружаются в таблицу как неподтвержденные
+ * (mesh_registry_restore) и сразу доступны, подтверждение происходит
+ * первым живым сообщением от устройства.
+ */
+struct mesh_cache;
+
+/**
+ * @brief Функция открытия кэша, загрузки устройств в таблицу и подписки на ее изменения
+ * @param[in] path Путь к файлу
+ * @param[in] registry Таблица устройств
+ * @return Кэш либо nullptr (таблица остается пустой)
+ */
+struct mesh_cache* mesh_cache_open(const char* path, struct mesh_registry* registry);
+
+/**
+ * @brief Функция закрытия кэша, данные сбрасываются на диск
+ */
+void mesh_cache_close(struct mesh_cache* cache);
+
+/**
+ * @brief Функция получения кол-ва загруженных при открытии устройств
+ */
+uint32_t mesh_cache_loaded(struct mesh_cache* cache);
+
+/**
+ * @}
+ */
@@ -0,0 +1,420 @@
+#include "mesh_coro.h"
+
+#include <string.h>
+
+#include <new>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Шаг классов размеров пула кадров
+ */
+#define MESH_CORO_FRAME_STEP 64
+
+/**
+ * @brief Кол-во классов размеров, кадры больше MESH_CORO_FRAME_STEP * MESH_CORO_FRAME_CLASSES идут мимо пула
+ */
+#define MESH_CORO_FRAME_CLASSES 64
+
+/**
+ * @brief Кол-во корзин ожиданий маршрутизатора (степень 2)
+ */
+#define MESH_CORO_BUCKETS 1024
+
+/**
+ * @brief Что отправить перед ожиданием
+ */
+enum mesh_coro_action
+{
+	mesh_coro_none = 0,				///< только ожидание
+	mesh_coro_discover,				///< широковищательный запрос устройств
+	mesh_coro_request_info,			///< запрос информации у устройства
+	mesh_coro_group_switch			///< групповая команда
+};
+
+/**
+ * @brief Свободный кадр в пуле
+ */
+struct mesh_coro_free_frame
+{
+	struct mesh_coro_free_frame* next;	///< следующий свободный кадр
+};
+
+static thread_local mesh_coro_free_frame* mesh_coro_free_frames[MESH_CORO_FRAME_CLASSES];
+static thread_local mesh_coro_frame_stats mesh_coro_stats;
+
+/**
+ * @brief Корзина ожиданий
+ */
+struct mesh_coro_bucket
+{
+	struct mesh_coro_waiter* head;		///< самое раннее ожидание
+	struct mesh_coro_waiter* tail;		///< самое позднее ожидание
+};
+
+/**
+ * @brief Маршрутизатор
+ */
+struct mesh_coro_router
+{
+	struct mesh_ctx* ctx;							///< контекст mesh
+	bool closed;									///< маршрутизатор удаляется
+	mesh_coro_bucket buckets[MESH_CORO_BUCKETS];	///< ожидания по (команда, адрес)
+};
+
+void* mesh_coro_frame_alloc(size_t size)
+{
+	size_t index = (size + MESH_CORO_FRAME_STEP - 1) / MESH_CORO_FRAME_STEP - 1;
+	if(index >= MESH_CORO_FRAME_CLASSES)
+	{
+		++mesh_coro_stats.oversized;
+		return ::operator new(size);
+	}
+
+	mesh_coro_free_frame* frame = mesh_coro_free_frames[index];
+	if(frame != nullptr)
+	{
+		mesh_coro_free_frames[index] = frame->next;
+		++mesh_coro_stats.reused;
+		return frame;
+	}
+
+	++mesh_coro_stats.allocated;
+	return ::operator new((index + 1) * MESH_CORO_FRAME_STEP);
+}
+
+void mesh_coro_frame_free(void* ptr, size_t size)
+{
+	size_t index = (size + MESH_CORO_FRAME_STEP - 1) / MESH_CORO_FRAME_STEP - 1;
+	if(index >= MESH_CORO_FRAME_CLASSES)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	mesh_coro_free_frame* frame = reinterpret_cast<mesh_coro_free_frame*>(ptr);
+	frame->next = mesh_coro_free_frames[index];
+	mesh_coro_free_frames[index] = frame;
+}
+
+struct mesh_coro_frame_stats mesh_coro_frame_get_stats()
+{
+	return mesh_coro_stats;
+}
+
+static mesh_coro_bucket* mesh_coro_bucket_get(struct mesh_coro_router* router, uint8_t command, uint32_t ip)
+{
+	uint32_t hash = (ip * 2654435761u) ^ command;
+	return &router->buckets[hash & (MESH_CORO_BUCKETS - 1)];
+}
+
+static void mesh_coro_link(struct mesh_coro_router* router, struct mesh_coro_waiter* waiter)
+{
+	mesh_coro_bucket* bucket = mesh_coro_bucket_get(router, waiter->command, waiter->ip);
+	waiter->next = nullptr;
+	waiter->prev = bucket->tail;
+	if(bucket->tail != nullptr)
+	{
+		bucket->tail->next = waiter;
+	}
+	else
+	{
+		bucket->head = waiter;
+	}
+	bucket->tail = waiter;
+}
+
+static void mesh_coro_unlink(struct mesh_coro_router* router, struct mesh_coro_waiter* waiter)
+{
+	mesh_coro_bucket* bucket = mesh_coro_bucket_get(router, waiter->command, waiter->ip);
+	if(waiter->prev != nullptr)
+	{
+		waiter->prev->next = waiter->next;
+	}
+	else
+	{
+		bucket->head = waiter->next;
+	}
+	if(waiter->next != nullptr)
+	{
+		waiter->next->prev = waiter->prev;
+	}
+	else
+	{
+		bucket->tail = waiter->prev;
+	}
+	waiter->prev = nullptr;
+	waiter->next = nullptr;
+}
+
+static void mesh_coro_timeout(struct mesh_ctx*, void* arg)
+{
+	mesh_coro_waiter* waiter = reinterpret_cast<mesh_coro_waiter*>(arg);
+
+	// однократный таймер удаляется транспортом после вызова
+	waiter->timer = nullptr;
+	if(waiter->command != 0)
+	{
+		mesh_coro_unlink(waiter->router, waiter);
+	}
+	waiter->handle.resume();
+}
+
+bool mesh_coro_suspend(struct mesh_coro_waiter* waiter, std::coroutine_handle<> handle)
+{
+	struct mesh_coro_router* router = waiter->router;
+	if(router == nullptr || router->closed)
+	{
+		return false;
+	}
+
+	waiter->handle = handle;
+	waiter->prev = nullptr;
+	waiter->next = nullptr;
+	if(waiter->command != 0)
+	{
+		mesh_coro_link(router, waiter);
+	}
+	waiter->timer = mesh_timer_start(router->ctx, waiter->timeout, false, mesh_coro_timeout, waiter);
+
+	// запрос отправляется после регистрации, чтобы не пропустить быстрый ответ
+	switch(waiter->action)
+	{
+		case mesh_coro_discover:
+			mesh_send_request_devices_info(router->ctx);
+			break;
+
+		case mesh_coro_request_info:
+			mesh_send_request_device_info(router->ctx, waiter->ip);
+			break;
+
+		case mesh_coro_group_switch:
+			mesh_send_group_switch(router->ctx, waiter->group);
+			break;
+	}
+	return true;
+}
+
+static void mesh_coro_complete(struct mesh_coro_router* router, struct mesh_coro_waiter* waiter)
+{
+	mesh_coro_unlink(router, waiter);
+	if(waiter->timer != nullptr)
+	{
+		mesh_timer_stop(router->ctx, waiter->timer);
+		waiter->timer = nullptr;
+	}
+	waiter->handle.resume();
+}
+
+struct mesh_coro_router* mesh_coro_router_new(struct mesh_ctx* ctx)
+{
+	mesh_coro_router* router = new mesh_coro_router;
+	router->ctx = ctx;
+	router->closed = false;
+	memset(router->buckets, 0, sizeof(router->buckets));
+	return router;
+}
+
+void mesh_coro_router_free(struct mesh_coro_router* router)
+{
+	if(router == nullptr)
+	{
+		return;
+	}
+
+	router->closed = true;
+	for(uint32_t i = 0; i < MESH_CORO_BUCKETS; ++i)
+	{
+		// возобновленная корутина может завершиться и удалить ожидание, берем всегда голову
+		while(router->buckets[i].head != nullptr)
+		{
+			mesh_coro_complete(router, router->buckets[i].head);
+		}
+	}
+	// паузы (mesh_co_sleep) не лежат в корзинах и завершаются своими таймерами,
+	// поэтому маршрутизатор удаляется после остановки event loop
+	delete router;
+}
+
+bool mesh_coro_router_closed(struct mesh_coro_router* router)
+{
+	return router == nullptr || router->closed;
+}
+
+static bool mesh_coro_group_done(struct mesh_coro_waiter* waiter)
+{
+	// при адресации группой состав заранее неизвестен
+	if(waiter->group->group != MESH_GROUP_NONE)
+	{
+		return false;
+	}
+
+	for(uint32_t i = 0; i < MESH_GROUP_BITMAP_SIZE; ++i)
+	{
+		if((waiter->group->ids[i] & ~waiter->acks->acked[i]) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool mesh_coro_route_group_ack(struct mesh_coro_router* router, struct mesh_message* msg)
+{
+	if(msg->data_size != sizeof(struct mesh_group_ack))
+	{
+		return false;
+	}
+	struct mesh_group_ack* ack = reinterpret_cast<struct mesh_group_ack*>(msg->data);
+
+	for(mesh_coro_waiter* waiter = mesh_coro_bucket_get(router, msg->command, 0)->head; waiter != nullptr; waiter = waiter->next)
+	{
+		if(waiter->command != msg->command || waiter->group == nullptr || waiter->group->seq != ack->seq)
+		{
+			continue;
+		}
+
+		uint8_t bit = 1 << (ack->id & 7);
+		if(!(waiter->acks->acked[ack->id >> 3] & bit))
+		{
+			waiter->acks->acked[ack->id >> 3] |= bit;
+			++waiter->acks->count;
+			++waiter->count;
+		}
+		if(ack->state)
+		{
+			waiter->acks->on[ack->id >> 3] |= bit;
+		}
+		else
+		{
+			waiter->acks->on[ack->id >> 3] &= ~bit;
+		}
+
+		if(mesh_coro_group_done(waiter))
+		{
+			mesh_coro_complete(router, waiter);
+		}
+		return true;
+	}
+	return false;
+}
+
+bool mesh_coro_route(struct mesh_coro_router* router, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	if(router == nullptr || sender == nullptr || msg == nullptr)
+	{
+		return false;
+	}
+
+	if(msg->command == mesh_group_switch_ack)
+	{
+		return mesh_coro_route_group_ack(router, msg);
+	}
+
+	struct mesh_device_info* info = nullptr;
+	if(msg->command == mesh_device_info_response)
+	{
+		if(msg->data_size != sizeof(struct mesh_device_info))
+		{
+			return false;
+		}
+		info = reinterpret_cast<struct mesh_device_info*>(msg->data);
+	}
+
+	bool consumed = false;
+
+	// сбор ответов от любых адресов (discovery)
+	for(mesh_coro_waiter* waiter = mesh_coro_bucket_get(router, msg->command, 0)->head; waiter != nullptr; waiter = waiter->next)
+	{
+		if(waiter->command == msg->command && waiter->ip == 0 && waiter->replies != nullptr && info != nullptr)
+		{
+			mesh_device_reply reply;
+			reply.ip = sender->ip;
+			reply.info = *info;
+			waiter->replies->push_back(reply);
+			++waiter->count;
+			consumed = true;
+		}
+	}
+
+	// самое раннее ожидание ответа от этого адреса
+	for(mesh_coro_waiter* waiter = mesh_coro_bucket_get(router, msg->command, sender->ip)->head; waiter != nullptr; waiter = waiter->next)
+	{
+		if(waiter->command == msg->command && waiter->ip == sender->ip)
+		{
+			waiter->matched = true;
+			if(waiter->info != nullptr && info != nullptr)
+			{
+				*waiter->info = *info;
+			}
+			mesh_coro_complete(router, waiter);
+			return true;
+		}
+	}
+	return consumed;
+}
+
+static void mesh_coro_waiter_init(struct mesh_coro_waiter* waiter, struct mesh_coro_router* router, uint32_t ms)
+{
+	*waiter = mesh_coro_waiter();
+	waiter->router = router;
+	waiter->timeout = ms;
+}
+
+mesh_co_collect mesh_co_discover(struct mesh_coro_router* router, uint32_t ms, std::vector<mesh_device_reply>* replies)
+{
+	mesh_co_collect awaiter;
+	mesh_coro_waiter_init(&awaiter, router, ms);
+	awaiter.action = mesh_coro_discover;
+	awaiter.command = mesh_device_info_response;
+	awaiter.replies = replies;
+	return awaiter;
+}
+
+mesh_co_reply mesh_co_request_info(struct mesh_coro_router* router, uint32_t ip, uint32_t ms, struct mesh_device_info* info)
+{
+	mesh_co_reply awaiter;
+	mesh_coro_waiter_init(&awaiter, router, ms);
+	awaiter.action = mesh_coro_request_info;
+	awaiter.command = mesh_device_info_response;
+	awaiter.ip = ip;
+	awaiter.info = info;
+	return awaiter;
+}
+
+mesh_co_reply mesh_co_wait_ack(struct mesh_coro_router* router, uint32_t ip, uint32_t ms)
+{
+	mesh_co_reply awaiter;
+	mesh_coro_waiter_init(&awaiter, router, ms);
+	awaiter.command = mesh_device_info_response_confirm;
+	awaiter.ip = ip;
+	return awaiter;
+}
+
+mesh_co_collect mesh_co_group_switch(struct mesh_coro_router* router, struct mesh_group_command* command, uint32_t ms, struct mesh_group_result* acks)
+{
+	command->flags |= MESH_GROUP_FLAG_ACK;
+
+	mesh_co_collect awaiter;
+	mesh_coro_waiter_init(&awaiter, router, ms);
+	awaiter.action = mesh_coro_group_switch;
+	awaiter.command = mesh_group_switch_ack;
+	awaiter.group = command;
+	awaiter.acks = acks;
+	return awaiter;
+}
+
+mesh_co_timer mesh_co_sleep(struct mesh_coro_router* router, uint32_t ms)
+{
+	mesh_co_timer awaiter;
+	mesh_coro_waiter_init(&awaiter, router, ms);
+	return awaiter;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <mesh.h>
+
+#include <stddef.h>
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Статистика пула кадров корутин
+ */
+struct mesh_coro_frame_stats
+{
+	uint64_t allocated;		///< кадров выделено у системы
+	uint64_t reused;		///< кадров взято из пула
+	uint64_t oversized;		///< кадров больше максимального класса (без пула)
+};
+
+/**
+ * @brief Функция выделения кадра корутины из пула текущего потока
+ */
+void* mesh_coro_frame_alloc(size_t size);
+
+/**
+ * @brief Функция возврата кадра корутины в пул текущего потока
+ */
+void mesh_coro_frame_free(void* ptr, size_t size);
+
+/**
+ * @brief Функция получения статистики пула текущего потока
+ */
+struct mesh_coro_frame_stats mesh_coro_frame_get_stats();
+
+/**
+ * @brief Общая часть promise для mesh_task
+ */
+struct mesh_task_promise_base
+{
+	std::coroutine_handle<> continuation;	///< ожидающая корутина
+	bool detached = false;					///< корутина запущена mesh_coro_spawn
+
+	static void* operator new(size_t size)
+	{
+		return mesh_coro_frame_alloc(size);
+	}
+
+	static void operator delete(void* ptr, size_t size)
+	{
+		mesh_coro_frame_free(ptr, size);
+	}
+
+	/**
+	 * @brief По завершении передаем управление ожидающей корутине,
+	 * отсоединенная корутина удаляет свой кадр сама
+	 */
+	struct final_awaiter
+	{
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		template<typename P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+		{
+			mesh_task_promise_base& promise = handle.promise();
+			std::coroutine_handle<> next = promise.continuation;
+			if(promise.detached)
+			{
+				handle.destroy();
+			}
+			return next ? next : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept
+		{
+		}
+	};
+
+	std::suspend_always initial_suspend() const noexcept
+	{
+		return {};
+	}
+
+	final_awaiter final_suspend() const noexcept
+	{
+		return {};
+	}
+
+	void unhandled_exception()
+	{
+		std::terminate();
+	}
+};
+
+template<typename T>
+struct mesh_task_promise : mesh_task_promise_base
+{
+	T value;
+
+	void return_value(T result)
+	{
+		value = std::move(result);
+	}
+
+	T result()
+	{
+		return std::move(value);
+	}
+};
+
+template<>
+struct mesh_task_promise<void> : mesh_task_promise_base
+{
+	void return_void()
+	{
+	}
+
+	void result()
+	{
+	}
+};
+
+/**
+ * @brief Ленивая корутина, запускается при co_await либо mesh_coro_spawn
+ * @tparam T Тип результата
+ */
+template<typename T = void>
+class mesh_task
+{
+public:
+	struct promise_type : mesh_task_promise<T>
+	{
+		mesh_task get_return_object()
+		{
+			return mesh_task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+	};
+
+	explicit mesh_task(std::coroutine_handle<promise_type> handle)
+		: handle(handle)
+	{
+	}
+
+	mesh_task(mesh_task&& other) noexcept
+		: handle(std::exchange(other.handle, nullptr))
+	{
+	}
+
+	mesh_task(const mesh_task&) = delete;
+	mesh_task& operator=(const mesh_task&) = delete;
+
+	~mesh_task()
+	{
+		if(handle)
+		{
+			handle.destroy();
+		}
+	}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		handle.promise().continuation = awaiting;
+		return handle;
+	}
+
+	T await_resume()
+	{
+		return handle.promise().result();
+	}
+
+	/**
+	 * @brief Передача владения кадром
+	 */
+	std::coroutine_handle<promise_type> release()
+	{
+		return std::exchange(handle, nullptr);
+	}
+
+private:
+	std::coroutine_handle<promise_type> handle;		///< кадр корутины
+};
+
+/**
+ * @brief Функция запуска корутины без ожидания результата, кадр удаляется по завершении
+ */
+template<typename T>
+void mesh_coro_spawn(mesh_task<T>&& task)
+{
+	auto handle = task.release();
+	handle.promise().detached = true;
+	handle.resume();
+}
+
+/**
+ * @brief Маршрутизатор ответов mesh в ожидающие корутины
+ *
+ * Ответ сопоставляется ожиданию по паре (команда, адрес отправителя),
+ * при нескольких ожиданиях одного ответа срабатывает самое раннее.
+ * Работает в потоке event loop (без mesh_dispatcher).
+ */
+struct mesh_coro_router;
+
+/**
+ * @brief Ответ устройства при discovery
+ */
+struct mesh_device_reply
+{
+	uint32_t ip;						///< адрес отправителя
+	struct mesh_device_info info;		///< информация об устройстве
+};
+
+/**
+ * @brief Сводное подтверждение групповой команды
+ */
+struct mesh_group_result
+{
+	uint8_t acked[MESH_GROUP_BITMAP_SIZE];		///< bitmap id подтвердивших устройств
+	uint8_t on[MESH_GROUP_BITMAP_SIZE];			///< bitmap id устройств с включенной нагрузкой
+	uint32_t count;								///< кол-во подтверждений
+};
+
+/**
+ * @brief Ожидание ответа, живет в кадре корутины
+ */
+struct mesh_coro_waiter
+{
+	struct mesh_coro_router* router;				///< маршрутизатор
+	uint32_t timeout;								///< таймаут в ms
+	uint8_t action;									///< что отправить перед ожиданием
+	uint8_t command;								///< ожидаемая команда
+	uint32_t ip;									///< ожидаемый отправитель, 0 - любой
+	bool matched;									///< ответ получен
+	uint32_t count;									///< кол-во собранных ответов
+
+	struct mesh_device_info* info;					///< куда сохранить ответ, может быть nullptr
+	std::vector<mesh_device_reply>* replies;		///< куда собирать ответы discovery
+	struct mesh_group_command* group;				///< отправляемая групповая команда
+	struct mesh_group_result* acks;					///< куда собирать подтверждения групповой команды
+
+	struct mesh_timer* timer;						///< таймер таймаута
+	std::coroutine_handle<> handle;					///< ожидающая корутина
+	struct mesh_coro_waiter* prev;					///< соседи в корзине маршрутизатора
+	struct mesh_coro_waiter* next;					///< соседи в корзине маршрутизатора
+};
+
+/**
+ * @brief Функция регистрации ожидания
+ * @return false если ожидание невозможно (маршрутизатор закрыт), корутина не засыпает
+ */
+bool mesh_coro_suspend(struct mesh_coro_waiter* waiter, std::coroutine_handle<> handle);
+
+/**
+ * @brief Базовый awaiter, регистрирует ожидание при засыпании
+ */
+struct mesh_coro_awaiter : mesh_coro_waiter
+{
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	bool await_suspend(std::coroutine_handle<> handle)
+	{
+		return mesh_coro_suspend(this, handle);
+	}
+};
+
+/**
+ * @brief Ожидание одного ответа, результат - получен ли ответ до таймаута
+ */
+struct mesh_co_reply : mesh_coro_awaiter
+{
+	bool await_resume() const noexcept
+	{
+		return matched;
+	}
+};
+
+/**
+ * @brief Сбор ответов до таймаута, результат - кол-во ответов
+ */
+struct mesh_co_collect : mesh_coro_awaiter
+{
+	uint32_t await_resume() const noexcept
+	{
+		return count;
+	}
+};
+
+/**
+ * @brief Пауза
+ */
+struct mesh_co_timer : mesh_coro_awaiter
+{
+	void await_resume() const noexcept
+	{
+	}
+};
+
+/**
+ * @brief Функция создания маршрутизатора для контекста
+ */
+struct mesh_coro_router* mesh_coro_router_new(struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция удаления маршрутизатора
+ * Все ожидающие корутины возобновляются с неудачным результатом,
+ * новые ожидания завершаются сразу, см. mesh_coro_router_closed
+ */
+void mesh_coro_router_free(struct mesh_coro_router* router);
+
+/**
+ * @brief Функция проверки закрытия маршрутизатора, для выхода из циклов корутин
+ */
+bool mesh_coro_router_closed(struct mesh_coro_router* router);
+
+/**
+ * @brief Функция передачи полученного сообщения ожидающим корутинам
+ * @return true если сообщение кто-то ожидал
+ */
+bool mesh_coro_route(struct mesh_coro_router* router, struct mesh_sender_info* sender, struct mesh_message* msg);
+
+/**
+ * @brief Широковищательный запрос устройств и сбор ответов в течении ms
+ * @param[out] replies Ответы устройств
+ */
+mesh_co_collect mesh_co_discover(struct mesh_coro_router* router, uint32_t ms, std::vector<mesh_device_reply>* replies);
+
+/**
+ * @brief Запрос информации у одного устройства
+ * @param[out] info Информация об устройстве, может быть nullptr
+ */
+mesh_co_reply mesh_co_request_info(struct mesh_coro_router* router, uint32_t ip, uint32_t ms, struct mesh_device_info* info);
+
+/**
+ * @brief Ожидание подтверждения (mesh_device_info_response_confirm) от устройства
+ */
+mesh_co_reply mesh_co_wait_ack(struct mesh_coro_router* router, uint32_t ip, uint32_t ms);
+
+/**
+ * @brief Широковищательная групповая команда и сбор подтверждений
+ * Ожидание завершается по таймауту либо раньше, когда подтвердили все устройства
+ * из bitmap (при адресации группой - только по таймауту).
+ * Подтверждения накапливаются в acks, поэтому повтор команды с тем же seq
+ * дособирает недостающие.
+ * @param[in] command Команда, флаг MESH_GROUP_FLAG_ACK выставляется
+ * @param[in,out] acks Сводное подтверждение
+ */
+mesh_co_collect mesh_co_group_switch(struct mesh_coro_router* router, struct mesh_group_command* command, uint32_t ms, struct mesh_group_result* acks);
+
+/**
+ * @brief Пауза на ms
+ */
+mesh_co_timer mesh_co_sleep(struct mesh_coro_router* router, uint32_t ms);
+
+/**
+ * @}
+ */
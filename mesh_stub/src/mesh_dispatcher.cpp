@@ -0,0 +1,213 @@
+#include "mesh_dispatcher.h"
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Сколько раз поток проверяет очередь перед засыпанием
+ */
+#define MESH_DISPATCHER_SPIN 256
+
+/**
+ * @brief Сообщение в очереди
+ */
+struct mesh_dispatcher_item
+{
+	struct mesh_ctx* ctx;					///< контекст принявший сообщение
+	struct mesh_sender_info sender;			///< отправитель
+	struct mesh_message msg;				///< копия сообщения
+};
+
+/**
+ * @brief Поток обработчика
+ */
+struct mesh_dispatcher_worker
+{
+	spsc_ring<mesh_dispatcher_item, MESH_DISPATCHER_QUEUE_SIZE> queue;	///< очередь сообщений
+
+	std::atomic<bool> waiting;				///< поток спит (или собирается) на cv
+	std::mutex mutex;						///< защищает засыпание
+	std::condition_variable cv;				///< пробуждение потока
+
+	uint64_t queued;						///< пишет только поток приема
+	uint64_t dropped;						///< пишет только поток приема
+	std::atomic<uint64_t> handled;			///< пишет только поток обработчика
+
+	std::thread thread;						///< поток
+};
+
+/**
+ * @brief Диспетчер
+ */
+struct mesh_dispatcher
+{
+	std::vector<std::unique_ptr<mesh_dispatcher_worker>> workers;	///< потоки
+	std::atomic<bool> stop;											///< флаг остановки
+	uint32_t loop_commands;											///< битовая маска команд, обрабатываемых в потоке приема
+};
+
+static void mesh_dispatcher_loop(struct mesh_dispatcher* dispatcher, mesh_dispatcher_worker* worker)
+{
+	uint32_t spin = 0;
+	for(;;)
+	{
+		mesh_dispatcher_item* item = worker->queue.front();
+		if(item != nullptr)
+		{
+			mesh_dispatch(item->ctx, &item->sender, &item->msg);
+			worker->queue.release();
+			worker->handled.fetch_add(1, std::memory_order_relaxed);
+			spin = 0;
+			continue;
+		}
+
+		if(dispatcher->stop.load(std::memory_order_acquire))
+		{
+			break;
+		}
+
+		if(++spin < MESH_DISPATCHER_SPIN)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// eventcount: объявляем что засыпаем и перепроверяем очередь,
+		// поток приема после публикации смотрит на waiting и будит под mutex
+		std::unique_lock<std::mutex> lock(worker->mutex);
+		worker->waiting.store(true, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		worker->cv.wait(lock, [&]()
+		{
+			return !worker->queue.empty() || dispatcher->stop.load(std::memory_order_acquire);
+		});
+		worker->waiting.store(false, std::memory_order_relaxed);
+		spin = 0;
+	}
+}
+
+static void mesh_dispatcher_wake(mesh_dispatcher_worker* worker)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(worker->waiting.load(std::memory_order_seq_cst))
+	{
+		std::lock_guard<std::mutex> lock(worker->mutex);
+		worker->cv.notify_one();
+	}
+}
+
+struct mesh_dispatcher* mesh_dispatcher_new(uint32_t workers)
+{
+	if(workers == 0)
+	{
+		LOG("mesh[mesh_dispatcher_new]: workers count is 0\n");
+		return nullptr;
+	}
+
+	mesh_dispatcher* dispatcher = new mesh_dispatcher;
+	dispatcher->stop = false;
+	dispatcher->loop_commands = 0;
+
+	for(uint32_t i = 0; i < workers; ++i)
+	{
+		mesh_dispatcher_worker* worker = new mesh_dispatcher_worker;
+		worker->waiting = false;
+		worker->queued = 0;
+		worker->dropped = 0;
+		worker->handled = 0;
+		dispatcher->workers.emplace_back(worker);
+	}
+
+	// потоки стартуют после заполнения workers, вектор больше не меняется
+	for(auto& worker : dispatcher->workers)
+	{
+		worker->thread = std::thread(mesh_dispatcher_loop, dispatcher, worker.get());
+	}
+	return dispatcher;
+}
+
+void mesh_dispatcher_free(struct mesh_dispatcher* dispatcher)
+{
+	if(dispatcher == nullptr)
+	{
+		return;
+	}
+
+	dispatcher->stop.store(true, std::memory_order_release);
+	for(auto& worker : dispatcher->workers)
+	{
+		{
+			std::lock_guard<std::mutex> lock(worker->mutex);
+			worker->cv.notify_one();
+		}
+		worker->thread.join();
+	}
+	delete dispatcher;
+}
+
+void mesh_dispatcher_keep_in_loop(struct mesh_dispatcher* dispatcher, mesh_message_command command)
+{
+	if(dispatcher != nullptr && command < 32)
+	{
+		dispatcher->loop_commands |= 1u << command;
+	}
+}
+
+bool mesh_dispatcher_push(struct mesh_dispatcher* dispatcher, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	// сообщение еще в формате сети, команда - little-endian uint32
+	const uint8_t* command = reinterpret_cast<const uint8_t*>(&msg->command);
+	uint32_t value = command[0] | (command[1] << 8) | (command[2] << 16) | (static_cast<uint32_t>(command[3]) << 24);
+	if(value < 32 && (dispatcher->loop_commands & (1u << value)))
+	{
+		mesh_dispatch(ctx, sender, msg);
+		return true;
+	}
+
+	// мультипликативный хэш, чтобы соседние адреса расходились по потокам
+	uint32_t hash = sender->ip * 2654435761u;
+	mesh_dispatcher_worker* worker = dispatcher->workers[hash % dispatcher->workers.size()].get();
+
+	mesh_dispatcher_item* item = worker->queue.acquire();
+	if(item == nullptr)
+	{
+		++worker->dropped;
+		return false;
+	}
+
+	item->ctx = ctx;
+	item->sender = *sender;
+	item->msg = *msg;
+	worker->queue.publish();
+	++worker->queued;
+
+	mesh_dispatcher_wake(worker);
+	return true;
+}
+
+struct mesh_dispatcher_stats mesh_dispatcher_get_stats(struct mesh_dispatcher* dispatcher)
+{
+	struct mesh_dispatcher_stats stats = { 0, 0, 0 };
+	for(auto& worker : dispatcher->workers)
+	{
+		stats.queued += worker->queued;
+		stats.dropped += worker->dropped;
+		stats.handled += worker->handled.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+/**
+ * @}
+ */
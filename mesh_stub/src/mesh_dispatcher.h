@@ -0,0 +1,73 @@
+#pragma once
+
+#include <mesh.h>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Размер очереди одного обработчика (кол-во сообщений)
+ */
+#define MESH_DISPATCHER_QUEUE_SIZE 1024
+
+/**
+ * @brief Диспетчер сообщений по потокам обработчиков
+ *
+ * Поток приема только копирует сообщение в SPSC очередь потока обработчика
+ * и сразу возвращается к сокету. Сообщения одного отправителя всегда попадают
+ * в один поток, поэтому их порядок сохраняется. Если очередь переполнена,
+ * сообщение отбрасывается (как при переполнении буфера сокета) и учитывается
+ * в статистике.
+ *
+ * @note Обработчики вызываются не в потоке event loop: им можно отправлять
+ * сообщения, но нельзя запускать/останавливать таймеры. Команды, обработчикам
+ * которых нужны таймеры, оставляются в потоке приема (mesh_dispatcher_keep_in_loop).
+ */
+struct mesh_dispatcher;
+
+/**
+ * @brief Статистика диспетчера
+ */
+struct mesh_dispatcher_stats
+{
+	uint64_t queued;		///< поставлено в очереди
+	uint64_t dropped;		///< отброшено из-за переполнения
+	uint64_t handled;		///< обработано
+};
+
+/**
+ * @brief Функция создания диспетчера и запуска потоков обработчиков
+ * @param[in] workers Кол-во потоков
+ * @return Диспетчер либо nullptr
+ */
+struct mesh_dispatcher* mesh_dispatcher_new(uint32_t workers);
+
+/**
+ * @brief Функция остановки потоков (после обработки очередей) и удаления диспетчера
+ * @note Вызывается до mesh_stop контекстов, чьи сообщения были в очередях
+ */
+void mesh_dispatcher_free(struct mesh_dispatcher* dispatcher);
+
+/**
+ * @brief Функция отметки команды, обрабатываемой сразу в потоке приема (потоке event loop)
+ * @note Вызывается до запуска цикла транспорта
+ */
+void mesh_dispatcher_keep_in_loop(struct mesh_dispatcher* dispatcher, mesh_message_command command);
+
+/**
+ * @brief Функция постановки сообщения в очередь, вызывается только из потока приема
+ * @return false если сообщение отброшено
+ */
+bool mesh_dispatcher_push(struct mesh_dispatcher* dispatcher, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg);
+
+/**
+ * @brief Функция получения статистики
+ */
+struct mesh_dispatcher_stats mesh_dispatcher_get_stats(struct mesh_dispatcher* dispatcher);
+
+/**
+ * @}
+ */
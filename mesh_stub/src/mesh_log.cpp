@@ -0,0 +1,34 @@
+#include "user_mesh_config.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+static int log_enabled = 1;
+
+int mesh_stub_log(const char* format, ...)
+{
+	int result = 0;
+	if(log_enabled)
+	{
+		va_list args;
+		va_start(args, format);
+		result = vprintf(format, args);
+		va_end(args);
+	}
+	return result;
+}
+
+void mesh_stub_log_enable(int enable)
+{
+	log_enabled = enable;
+}
+
+/**
+ * @}
+ */
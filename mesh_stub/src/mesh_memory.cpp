@@ -0,0 +1,426 @@
+#include "mesh_memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Порт от имени которого отправляются пакеты in-memory сети
+ */
+#define MESH_MEMORY_PORT 6636
+
+/**
+ * @brief Таймер in-memory транспорта
+ */
+struct mesh_timer
+{
+	uint32_t node;						///< номер узла запустившего таймер
+	uint64_t period;					///< период в us, 0 для однократного
+	bool active;						///< false если таймер остановлен
+	mesh_timer_callback callback;		///< пользовательский callback
+	void* arg;							///< аргумент callback
+};
+
+/**
+ * @brief Событие сети
+ */
+struct mesh_memory_event
+{
+	uint64_t time;										///< время события в us
+	uint64_t seq;										///< порядковый номер, сохраняет порядок событий с одинаковым временем
+
+	uint32_t src;										///< адрес отправителя пакета
+	uint32_t dst;										///< номер узла получателя
+	std::shared_ptr<std::vector<uint8_t>> data;			///< данные пакета, общие для всех получателей broadcast
+
+	struct mesh_timer* timer;							///< таймер, если событие таймера
+
+	bool operator>(const mesh_memory_event& other) const
+	{
+		return time != other.time ? time > other.time : seq > other.seq;
+	}
+};
+
+struct mesh_memory_network
+{
+	uint64_t now;																///< текущее время в us
+	uint64_t seq;																///< счетчик событий
+	uint32_t next_id;															///< номер для следующего узла
+
+	std::map<uint32_t, mesh_memory_ctx*> nodes;									///< узлы по номеру
+	std::map<uint32_t, uint32_t> addresses;										///< номер узла по адресу
+	std::priority_queue<mesh_memory_event, std::vector<mesh_memory_event>,
+		std::greater<mesh_memory_event>> events;								///< очередь событий
+
+	struct mesh_link_model link;												///< модель канала по умолчанию
+	std::map<std::pair<uint32_t, uint32_t>, mesh_link_model> links;				///< модели каналов по паре (src, dst)
+	struct mesh_medium_model medium;											///< модель среды передачи
+	uint64_t medium_free;														///< время освобождения среды в us
+
+	std::mt19937_64 random;														///< генератор для потерь и jitter
+	struct mesh_memory_stats stats;												///< статистика
+};
+
+/**
+ * @brief Функция занимает среду передачи на время отправки пакета
+ * @return Время окончания передачи в us
+ */
+static uint64_t mesh_memory_airtime(struct mesh_memory_network* network, uint32_t size, uint32_t recipients)
+{
+	uint64_t start = network->medium_free > network->now ? network->medium_free : network->now;
+	uint64_t duration = 0;
+	if(network->medium.bandwidth != 0)
+	{
+		duration += static_cast<uint64_t>(size) * 8 * 1000000 / network->medium.bandwidth;
+	}
+	if(recipients > 1)
+	{
+		duration += static_cast<uint64_t>(network->medium.fanout_cost) * recipients;
+	}
+
+	if(duration != 0)
+	{
+		network->medium_free = start + duration;
+	}
+	return start + duration;
+}
+
+/**
+ * @brief Функция применяет модель канала к пакету
+ * @return false если пакет потерян
+ */
+static bool mesh_memory_link(struct mesh_memory_network* network, uint32_t src, uint32_t dst, uint64_t* time)
+{
+	const mesh_link_model* link = &network->link;
+
+	auto iter = network->links.find(std::make_pair(src, dst));
+	if(iter != network->links.end())
+	{
+		link = &iter->second;
+	}
+
+	if(link->loss > 0. && std::uniform_real_distribution<double>(0., 1.)(network->random) < link->loss)
+	{
+		++network->stats.dropped;
+		return false;
+	}
+
+	*time += link->delay;
+	if(link->jitter != 0)
+	{
+		*time += std::uniform_int_distribution<uint32_t>(0, link->jitter)(network->random);
+	}
+	return true;
+}
+
+static void mesh_memory_push(struct mesh_memory_network* network, mesh_memory_event& event)
+{
+	event.seq = network->seq++;
+	network->events.push(event);
+}
+
+static uint32_t mesh_memory_send(struct mesh_ctx* base, void* data, uint32_t size, uint32_t ip)
+{
+	mesh_memory_ctx* ctx = reinterpret_cast<mesh_memory_ctx*>(base);
+	mesh_memory_network* network = ctx->network;
+
+	mesh_memory_event event;
+	event.src = ctx->ip;
+	event.timer = nullptr;
+	event.data = std::make_shared<std::vector<uint8_t>>(reinterpret_cast<uint8_t*>(data), reinterpret_cast<uint8_t*>(data) + size);
+
+	++network->stats.sent;
+	network->stats.bytes += size;
+
+	if(ip == BROADCAST_ADDR)
+	{
+		++network->stats.broadcasts;
+		uint64_t sended = mesh_memory_airtime(network, size, network->nodes.size() - 1);
+		for(auto& node : network->nodes)
+		{
+			event.time = sended;
+			if(node.first != ctx->id && mesh_memory_link(network, ctx->ip, node.second->ip, &event.time))
+			{
+				event.dst = node.first;
+				mesh_memory_push(network, event);
+			}
+		}
+	}
+	else
+	{
+		auto iter = network->addresses.find(ip);
+		if(iter != network->addresses.end())
+		{
+			event.time = mesh_memory_airtime(network, size, 1);
+			if(mesh_memory_link(network, ctx->ip, ip, &event.time))
+			{
+				event.dst = iter->second;
+				mesh_memory_push(network, event);
+			}
+		}
+	}
+	// как и UDP, отправка успешна даже если получателя нет
+	return size;
+}
+
+static uint64_t mesh_memory_clock(struct mesh_ctx* base)
+{
+	mesh_memory_ctx* ctx = reinterpret_cast<mesh_memory_ctx*>(base);
+	uint64_t now = ctx->network->now;
+	return now + static_cast<int64_t>(now) * ctx->clock_drift / 1000000 + ctx->clock_offset;
+}
+
+static uint32_t mesh_memory_now(struct mesh_ctx* base)
+{
+	return static_cast<uint32_t>(mesh_memory_clock(base) / 1000);
+}
+
+/**
+ * @brief Функция перевода интервала часов узла во время сети
+ */
+static uint64_t mesh_memory_local_to_network(mesh_memory_ctx* ctx, uint64_t us)
+{
+	return us * 1000000 / (1000000 + ctx->clock_drift);
+}
+
+static struct mesh_timer* mesh_memory_timer_start(struct mesh_ctx* base, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg)
+{
+	mesh_memory_ctx* ctx = reinterpret_cast<mesh_memory_ctx*>(base);
+
+	struct mesh_timer* timer = new mesh_timer;
+	timer->node = ctx->id;
+	timer->period = repeat ? mesh_memory_local_to_network(ctx, static_cast<uint64_t>(ms) * 1000) : 0;
+	timer->active = true;
+	timer->callback = callback;
+	timer->arg = arg;
+
+	mesh_memory_event event;
+	event.time = ctx->network->now + mesh_memory_local_to_network(ctx, static_cast<uint64_t>(ms) * 1000);
+	event.src = ctx->ip;
+	event.dst = ctx->id;
+	event.timer = timer;
+	mesh_memory_push(ctx->network, event);
+
+	return timer;
+}
+
+static void mesh_memory_timer_stop(struct mesh_ctx*, struct mesh_timer* timer)
+{
+	// таймер удаляется при извлечении из очереди
+	timer->active = false;
+}
+
+static void mesh_memory_stop(struct mesh_ctx* base)
+{
+	mesh_memory_ctx* ctx = reinterpret_cast<mesh_memory_ctx*>(base);
+	if(ctx != nullptr)
+	{
+		ctx->network->nodes.erase(ctx->id);
+		ctx->network->addresses.erase(ctx->ip);
+		delete ctx;
+	}
+}
+
+const struct mesh_transport mesh_memory_transport =
+{
+	"memory",
+	mesh_memory_send,
+	nullptr,
+	nullptr,
+	mesh_memory_now,
+	mesh_memory_clock,
+	mesh_memory_timer_start,
+	mesh_memory_timer_stop,
+	mesh_memory_stop,
+};
+
+struct mesh_memory_network* mesh_memory_network_new()
+{
+	mesh_memory_network* network = new mesh_memory_network;
+	network->now = 0;
+	network->seq = 0;
+	network->next_id = 0;
+	network->medium_free = 0;
+	memset(&network->link, 0, sizeof(struct mesh_link_model));
+	memset(&network->medium, 0, sizeof(struct mesh_medium_model));
+	memset(&network->stats, 0, sizeof(struct mesh_memory_stats));
+	return network;
+}
+
+void mesh_memory_network_set_seed(struct mesh_memory_network* network, uint64_t seed)
+{
+	network->random.seed(seed);
+}
+
+void mesh_memory_network_set_link(struct mesh_memory_network* network, const struct mesh_link_model* model)
+{
+	network->link = *model;
+}
+
+void mesh_memory_network_set_link_between(struct mesh_memory_network* network, uint32_t src, uint32_t dst, const struct mesh_link_model* model)
+{
+	network->links[std::make_pair(src, dst)] = *model;
+}
+
+void mesh_memory_network_set_medium(struct mesh_memory_network* network, const struct mesh_medium_model* model)
+{
+	network->medium = *model;
+}
+
+uint32_t mesh_memory_network_next(struct mesh_memory_network* network)
+{
+	if(network->events.empty())
+	{
+		return UINT32_MAX;
+	}
+	// округление вверх, чтобы mesh_memory_network_run(next) обработал событие
+	return static_cast<uint32_t>((network->events.top().time + 999) / 1000);
+}
+
+void mesh_memory_network_free(struct mesh_memory_network* network)
+{
+	if(network != nullptr)
+	{
+		while(!network->events.empty())
+		{
+			delete network->events.top().timer;
+			network->events.pop();
+		}
+		delete network;
+	}
+}
+
+static void mesh_memory_process(struct mesh_memory_network* network, const mesh_memory_event& event)
+{
+	auto iter = network->nodes.find(event.dst);
+	if(event.timer != nullptr)
+	{
+		struct mesh_timer* timer = event.timer;
+		if(!timer->active || iter == network->nodes.end())
+		{	// остановлен либо узел удален
+			delete timer;
+			return;
+		}
+
+		++network->stats.timers;
+		if(timer->period != 0)
+		{
+			mesh_memory_event next = event;
+			next.time = event.time + timer->period;
+			mesh_memory_push(network, next);
+
+			timer->callback(&iter->second->base, timer->arg);
+		}
+		else
+		{
+			struct mesh_timer fired = *timer;
+			delete timer;
+			fired.callback(&iter->second->base, fired.arg);
+		}
+	}
+	else if(iter != network->nodes.end())
+	{
+		if(event.data->size() == sizeof(struct mesh_message))
+		{
+			// копия, обработчик вправе модифицировать сообщение
+			struct mesh_message msg;
+			memcpy(&msg, event.data->data(), sizeof(struct mesh_message));
+
+			struct mesh_sender_info sender;
+			sender.ip = event.src;
+			sender.port = MESH_MEMORY_PORT;
+
+			++network->stats.delivered;
+			mesh_dispatch(&iter->second->base, &sender, &msg);
+		}
+		else
+		{
+			LOG("mesh[memory]: failed read message, wrong size\n");
+		}
+	}
+}
+
+uint64_t mesh_memory_network_run(struct mesh_memory_network* network, uint32_t until)
+{
+	uint64_t processed = 0;
+	uint64_t until_us = static_cast<uint64_t>(until) * 1000;
+
+	while(!network->events.empty() && network->events.top().time <= until_us)
+	{
+		mesh_memory_event event = network->events.top();
+		network->events.pop();
+
+		network->now = event.time;
+		mesh_memory_process(network, event);
+		++processed;
+	}
+
+	if(network->now < until_us)
+	{
+		network->now = until_us;
+	}
+	return processed;
+}
+
+uint32_t mesh_memory_network_now(struct mesh_memory_network* network)
+{
+	return static_cast<uint32_t>(network->now / 1000);
+}
+
+uint64_t mesh_memory_network_clock(struct mesh_memory_network* network)
+{
+	return network->now;
+}
+
+struct mesh_memory_stats mesh_memory_network_stats(struct mesh_memory_network* network)
+{
+	return network->stats;
+}
+
+struct mesh_ctx* mesh_memory_start(struct mesh_memory_network* network, struct mesh_message_handlers* handlers, uint32_t ip)
+{
+	if(network->addresses.find(ip) != network->addresses.end())
+	{
+		LOG("mesh[memory]: address already used\n");
+		return nullptr;
+	}
+
+	mesh_memory_ctx* ctx = new mesh_memory_ctx;
+	mesh_init(&ctx->base, &mesh_memory_transport, handlers);
+
+	ctx->network = network;
+	ctx->id = network->next_id++;
+	ctx->ip = ip;
+	ctx->clock_offset = 0;
+	ctx->clock_drift = 0;
+
+	network->nodes[ctx->id] = ctx;
+	network->addresses[ip] = ctx->id;
+
+	return &ctx->base;
+}
+
+void mesh_memory_set_clock(struct mesh_ctx* base, uint64_t offset, int32_t drift)
+{
+	mesh_memory_ctx* ctx = reinterpret_cast<mesh_memory_ctx*>(base);
+	if(ctx != nullptr)
+	{
+		ctx->clock_offset = offset;
+		ctx->clock_drift = drift;
+	}
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <mesh.h>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Сеть для in-memory транспорта
+ *
+ * Все узлы сети живут в одном процессе, пакеты и таймеры обрабатываются
+ * в виртуальном времени в порядке очереди событий, без сокетов и потоков.
+ * Что делает прогон детерминированным и позволяет поднять в одном процессе
+ * произвольное кол-во узлов.
+ */
+struct mesh_memory_network;
+
+/**
+ * @brief Контекст узла in-memory сети
+ */
+struct mesh_memory_ctx
+{
+	struct mesh_ctx base;						///< общая часть контекста
+
+	struct mesh_memory_network* network;		///< сеть к которой подключен узел
+	uint32_t id;								///< уникальный номер узла в сети
+	uint32_t ip;								///< адрес узла
+
+	uint64_t clock_offset;						///< смещение часов узла в us
+	int32_t clock_drift;						///< уход часов узла в ppm (частота кварца)
+};
+
+/**
+ * @brief Модель канала между двумя узлами
+ */
+struct mesh_link_model
+{
+	double loss;				///< вероятность потери пакета [0, 1]
+	uint32_t delay;				///< задержка доставки в us
+	uint32_t jitter;			///< максимальный случайный разброс задержки в us
+};
+
+/**
+ * @brief Модель общей среды передачи (эфир wifi)
+ *
+ * Все передачи сериализуются в среде: пакет занимает эфир на время
+ * size * 8 / bandwidth, broadcast дополнительно на fanout_cost за каждого получателя
+ * (повторная передача точкой доступа, буферизация для спящих клиентов).
+ */
+struct mesh_medium_model
+{
+	uint32_t bandwidth;			///< пропускная способность в бит/с, 0 - без ограничения
+	uint32_t fanout_cost;		///< стоимость broadcast в us на каждого получателя
+};
+
+/**
+ * @brief Статистика in-memory сети
+ */
+struct mesh_memory_stats
+{
+	uint64_t sent;				///< кол-во отправленных пакетов (broadcast считается за 1)
+	uint64_t broadcasts;		///< кол-во отправленных broadcast пакетов
+	uint64_t delivered;			///< кол-во доставленных пакетов
+	uint64_t dropped;			///< кол-во потерянных пакетов (модель канала)
+	uint64_t bytes;				///< кол-во отправленных байт
+	uint64_t timers;			///< кол-во сработавших таймеров
+};
+
+/**
+ * @brief Транспорт in-memory
+ */
+extern const struct mesh_transport mesh_memory_transport;
+
+/**
+ * @brief Функция создания пустой сети
+ */
+struct mesh_memory_network* mesh_memory_network_new();
+
+/**
+ * @brief Функция удаления сети
+ * @note Все узлы должны быть остановлены (mesh_stop) до вызова
+ */
+void mesh_memory_network_free(struct mesh_memory_network* network);
+
+/**
+ * @brief Функция задает зерно генератора случайных чисел (потери, jitter)
+ * При одинаковом зерне и сценарии прогон полностью повторяем
+ */
+void mesh_memory_network_set_seed(struct mesh_memory_network* network, uint64_t seed);
+
+/**
+ * @brief Функция задает модель канала по умолчанию для всех пар узлов
+ */
+void mesh_memory_network_set_link(struct mesh_memory_network* network, const struct mesh_link_model* model);
+
+/**
+ * @brief Функция задает модель канала для направления src -> dst
+ * @note Имеет приоритет над моделью по умолчанию
+ */
+void mesh_memory_network_set_link_between(struct mesh_memory_network* network, uint32_t src, uint32_t dst, const struct mesh_link_model* model);
+
+/**
+ * @brief Функция задает модель общей среды передачи
+ */
+void mesh_memory_network_set_medium(struct mesh_memory_network* network, const struct mesh_medium_model* model);
+
+/**
+ * @brief Функция получения времени ближайшего события в ms (с округлением вверх)
+ * @return Время события либо UINT32_MAX если очередь пуста
+ */
+uint32_t mesh_memory_network_next(struct mesh_memory_network* network);
+
+/**
+ * @brief Функция обработки событий сети
+ * Обрабатывает все события (доставка пакетов, таймеры) с временем <= until
+ * и переводит виртуальное время в until
+ * @param[in] network Сеть
+ * @param[in] until Время в ms до которого обрабатываются события
+ * @return Кол-во обработанных событий
+ */
+uint64_t mesh_memory_network_run(struct mesh_memory_network* network, uint32_t until);
+
+/**
+ * @brief Функция получения текущего виртуального времени сети в ms
+ */
+uint32_t mesh_memory_network_now(struct mesh_memory_network* network);
+
+/**
+ * @brief Функция получения текущего виртуального времени сети в us
+ * Эталонное время, часы узлов (mesh_clock) могут от него отличаться
+ */
+uint64_t mesh_memory_network_clock(struct mesh_memory_network* network);
+
+/**
+ * @brief Функция получения статистики сети
+ */
+struct mesh_memory_stats mesh_memory_network_stats(struct mesh_memory_network* network);
+
+/**
+ * @brief Функция подключения нового узла к сети
+ * @param[in] network Сеть
+ * @param[in] handlers Список обработчиков сообщений
+ * @param[in] ip Адрес узла (уникальный в пределах сети)
+ * @return Контекст mesh либо nullptr если адрес занят
+ */
+struct mesh_ctx* mesh_memory_start(struct mesh_memory_network* network, struct mesh_message_handlers* handlers, uint32_t ip);
+
+/**
+ * @brief Функция задает расхождение часов узла с временем сети
+ * Часы узла: clock = network * (1 + drift / 10^6) + offset,
+ * mesh_now и mesh_clock узла идут по ним, таймеры узла отмеряют время по ним же
+ * @param[in] ctx Контекст узла
+ * @param[in] offset Смещение в us
+ * @param[in] drift Уход в ppm
+ */
+void mesh_memory_set_clock(struct mesh_ctx* ctx, uint64_t offset, int32_t drift);
+
+/**
+ * @}
+ */
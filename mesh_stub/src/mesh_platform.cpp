@@ -6,6 +6,7 @@
 #include <error.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 
 #include <unistd.h>
 #include <resolv.h>
@@ -17,56 +18,25 @@
  * @{
  */
 
-static bool keep_alive = true;
-
-static void emit_stub_message(struct ev_loop *loop, ev_periodic *w, int revents)
+/**
+ * @brief Таймер транспорта поверх ev_timer
+ */
+struct mesh_timer
 {
-	if(!(EV_ERROR & revents))
-	{
-
-		void* ptr = ev_userdata(loop);
-		if(ptr != 0)
-		{
-			mesh_ctx* ctx = reinterpret_cast<mesh_ctx*>(ptr);
-
-			if(keep_alive)
-			{
-				mesh_device_info info;
-				info.type = 3;
-				info.id = 0;
-				snprintf(info.name, MESH_DEVICE_NAME_SIZE, "PC-stub");
-				info.ip = 0xC0A800; //192.168.0.110
-
-				LOG("keep_alive message send\n");
-				mesh_send_keep_alive(ctx, &info);
-			}
-			else
-			{
-				LOG("request_devices message send\n");
-				mesh_send_request_devices_info(ctx);
-			}
-			keep_alive = !keep_alive;
-		}
-		else
-		{
-			LOG("mesh_ctx not setted\n");
-		}
-	}
-	else
-	{
-		LOG("got invalid event: %i\n", revents);
-	}
-}
-
+	ev_timer watcher;					///< handle на таймер libev
+	struct mesh_ctx* ctx;				///< контекст запустивший таймер
+	mesh_timer_callback callback;		///< пользовательский callback
+	void* arg;							///< аргумент callback
+};
 
-static void mesh_recv_cb(struct ev_loop *loop, ev_io *w, int revents)
+static void mesh_recv_cb(struct ev_loop *loop, ev_io *, int revents)
 {
 	if(!(EV_ERROR & revents))
 	{
 		void* ptr = ev_userdata(loop);
 		if(ptr != 0)
 		{
-			mesh_ctx* ctx = reinterpret_cast<mesh_ctx*>(ptr);
+			mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(ptr);
 
 			uint8_t buffer[sizeof(mesh_message)] = { 0 };
 
@@ -85,7 +55,14 @@ static void mesh_recv_cb(struct ev_loop *loop, ev_io *w, int revents)
 				if(sender.ip != inet_addr("192.168.0.100"))
 				{
 					LOG("received command: %d\n", msg->command);
-					call_handler(ctx->handlers, ctx, &sender, msg);
+					if(ctx->dispatcher != nullptr)
+					{
+						mesh_dispatcher_push(ctx->dispatcher, &ctx->base, &sender, msg);
+					}
+					else
+					{
+						mesh_dispatch(&ctx->base, &sender, msg);
+					}
 				}
 			}
 			else
@@ -104,95 +81,252 @@ static void mesh_recv_cb(struct ev_loop *loop, ev_io *w, int revents)
 	}
 }
 
-struct mesh_ctx* mesh_start(struct mesh_message_handlers* handlers, uint32_t ip, uint32_t port)
+static void mesh_timer_cb(struct ev_loop *, ev_timer *w, int revents)
 {
-	mesh_ctx* ctx = new mesh_ctx;
+	if(!(EV_ERROR & revents))
+	{
+		struct mesh_timer* timer = reinterpret_cast<struct mesh_timer*>(w->data);
 
-	ctx->port = port;
-	ctx->socket = socket(PF_INET, SOCK_DGRAM, 0);
-	ctx->handlers = handlers;
-	if(ctx->socket <= 0)
+		// однократный таймер больше не активен, удаляем до вызова,
+		// периодический может быть остановлен внутри callback
+		if(!ev_is_active(&timer->watcher))
+		{
+			struct mesh_timer fired = *timer;
+			delete timer;
+			fired.callback(fired.ctx, fired.arg);
+		}
+		else
+		{
+			timer->callback(timer->ctx, timer->arg);
+		}
+	}
+	else
+	{
+		LOG("got invalid event: %i\n", revents);
+	}
+}
+
+static uint32_t mesh_udp_send(struct mesh_ctx* base, void* data, uint32_t size, uint32_t ip)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+
+	struct sockaddr_in s;
+	s.sin_family = AF_INET;
+	s.sin_port = htons(ctx->port);
+	s.sin_addr.s_addr = htonl(ip);
+
+	ssize_t sended_data = sendto(ctx->socket, data, size, 0, (struct sockaddr*) &s, sizeof(struct sockaddr_in));
+	if(sended_data < 0)
+	{
+		LOG("failed send data, err: %s\n", strerror(errno));
+	}
+	return sended_data;
+}
+
+static uint32_t mesh_udp_send_batch(struct mesh_ctx* base, struct mesh_packet* packets, uint32_t count)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+
+	const uint32_t batch_size = 64;
+	struct mmsghdr headers[batch_size];
+	struct iovec vectors[batch_size];
+	struct sockaddr_in addresses[batch_size];
+
+	uint32_t sended = 0;
+	while(sended < count)
+	{
+		uint32_t current = count - sended < batch_size ? count - sended : batch_size;
+		memset(headers, 0, sizeof(struct mmsghdr) * current);
+
+		for(uint32_t i = 0; i < current; ++i)
+		{
+			struct mesh_packet* packet = &packets[sended + i];
+
+			addresses[i].sin_family = AF_INET;
+			addresses[i].sin_port = htons(ctx->port);
+			addresses[i].sin_addr.s_addr = htonl(packet->ip);
+
+			vectors[i].iov_base = packet->data;
+			vectors[i].iov_len = packet->size;
+
+			headers[i].msg_hdr.msg_name = &addresses[i];
+			headers[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+			headers[i].msg_hdr.msg_iov = &vectors[i];
+			headers[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int result = sendmmsg(ctx->socket, headers, current, 0);
+		if(result <= 0)
+		{
+			LOG("failed send batch, err: %s\n", strerror(errno));
+			break;
+		}
+		sended += result;
+	}
+	return sended;
+}
+
+static uint32_t mesh_udp_receive(struct mesh_ctx* base, void* data, uint32_t size)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+
+	struct sockaddr_in srcaddr;
+	socklen_t struct_size = sizeof(struct sockaddr_in);
+
+	ssize_t readed_size = recvfrom(ctx->socket, data, size, 0, reinterpret_cast<struct sockaddr*>(&srcaddr), &struct_size);
+	if(readed_size < 0)
+	{
+		LOG("failed read socket, err: %s\n", strerror(errno));
+	}
+	return readed_size;
+}
+
+static uint32_t mesh_udp_now(struct mesh_ctx* base)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+	return static_cast<uint32_t>(ev_now(ctx->loop) * 1000.);
+}
+
+static struct mesh_timer* mesh_udp_timer_start(struct mesh_ctx* base, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+
+	struct mesh_timer* timer = new mesh_timer;
+	timer->ctx = base;
+	timer->callback = callback;
+	timer->arg = arg;
+
+	ev_timer_init(&timer->watcher, mesh_timer_cb, ms / 1000., repeat ? ms / 1000. : 0.);
+	timer->watcher.data = timer;
+	ev_timer_start(ctx->loop, &timer->watcher);
+
+	return timer;
+}
+
+static void mesh_udp_timer_stop(struct mesh_ctx* base, struct mesh_timer* timer)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+
+	ev_timer_stop(ctx->loop, &timer->watcher);
+	delete timer;
+}
+
+static void mesh_udp_stop(struct mesh_ctx* base)
+{
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+	if(ctx != nullptr)
+	{
+		ev_io_stop(ctx->loop, &ctx->socket_watcher);
+
+		close(ctx->socket);
+		ev_loop_destroy(ctx->loop);
+		delete ctx;
+	}
+}
+static uint64_t mesh_udp_clock(struct mesh_ctx*)
+{
+	// ev_now кэшируется на итерацию loop, для часов берем системное время
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+const struct mesh_transport mesh_udp_transport =
+{
+	"udp/libev",
+	mesh_udp_send,
+	mesh_udp_send_batch,
+	mesh_udp_receive,
+	mesh_udp_now,
+	mesh_udp_clock,
+	mesh_udp_timer_start,
+	mesh_udp_timer_stop,
+	mesh_udp_stop,
+};
+
+int mesh_udp_socket(uint32_t ip, uint32_t port)
+{
+	int fd = socket(PF_INET, SOCK_DGRAM, 0);
+	if(fd <= 0)
 	{
 		LOG("failed create socket, err: %s\n", strerror(errno));
-		return nullptr;
+		return -1;
 	}
 
 	struct sockaddr_in addr;
 	memset(&addr, 0, sizeof(struct sockaddr_in));
 
 	addr.sin_family = AF_INET;
-	addr.sin_port = htons(ctx->port);
+	addr.sin_port = htons(port);
 	addr.sin_addr.s_addr = htonl(ip);
 
-	if(bind(ctx->socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+	if(bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
 	{
 		LOG("failed bind socket, err: %s\n", strerror(errno));
-		return nullptr;
+		close(fd);
+		return -1;
 	}
 
 	int option_value = 1;
-	if (setsockopt(ctx->socket, SOL_SOCKET, SO_BROADCAST, &option_value, sizeof(option_value)) == -1) 
+	if (setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &option_value, sizeof(option_value)) == -1) 
 	{
 		LOG("failed  setsockopt (SO_BROADCAST), err: %s\n", strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+struct mesh_ctx* mesh_udp_start(struct mesh_message_handlers* handlers, uint32_t ip, uint32_t port)
+{
+	mesh_udp_ctx* ctx = new mesh_udp_ctx;
+	mesh_init(&ctx->base, &mesh_udp_transport, handlers);
+
+	ctx->port = port;
+	ctx->dispatcher = nullptr;
+	ctx->socket = mesh_udp_socket(ip, port);
+	if(ctx->socket < 0)
+	{
+		delete ctx;
 		return nullptr;
 	}
 
 	ctx->loop = ev_loop_new(0);
 	ev_set_userdata(ctx->loop, reinterpret_cast<void*>(ctx));
 
-	ev_periodic_init(&ctx->keep_alive_watcher, emit_stub_message, 0., 10., 0);
-	ev_periodic_start(ctx->loop, &ctx->keep_alive_watcher);
-
 	ev_io_init(&ctx->socket_watcher, mesh_recv_cb, ctx->socket, EV_READ);
 	ev_io_start(ctx->loop, &ctx->socket_watcher);
 
-	ev_loop(ctx->loop, 0);
-
-	return ctx;
+	return &ctx->base;
 }
 
-void mesh_stop(struct mesh_ctx* ctx)
+void mesh_udp_set_dispatcher(struct mesh_ctx* base, struct mesh_dispatcher* dispatcher)
 {
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
 	if(ctx != nullptr)
 	{
-		ev_io_stop(ctx->loop, &ctx->socket_watcher);
-		//ev_periodic_stop(ctx->loop, &ctx->keep_alive_watcher);
-
-		close(ctx->socket);
-		ev_loop_destroy(ctx->loop);
-		delete ctx;
+		ctx->dispatcher = dispatcher;
 	}
 }
 
-uint32_t mesh_send_data(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_t ip)
+void mesh_udp_run(struct mesh_ctx* base)
 {
-	struct sockaddr_in s;
-	s.sin_family = AF_INET;
-	s.sin_port = htons(ctx->port);
-	s.sin_addr.s_addr = htonl(ip);
-
-	ssize_t sended_data = sendto(ctx->socket, data, size, 0, (struct sockaddr*) &s, sizeof(struct sockaddr_in));
-	if(sended_data < 0)
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+	if(ctx != nullptr)
 	{
-		LOG("failed send data, err: %s\n", strerror(errno));
+		ev_run(ctx->loop, 0);
 	}
-	return sended_data;
 }
 
-uint32_t mesh_receive_data(struct mesh_ctx* ctx, void* data, uint32_t size)
+void mesh_udp_break(struct mesh_ctx* base)
 {
-	struct sockaddr_in srcaddr;
-	socklen_t struct_size = sizeof(struct sockaddr_in);
-
-	ssize_t readed_size = recvfrom(ctx->socket, data, size, 0, reinterpret_cast<struct sockaddr*>(&srcaddr), &struct_size);
-	if(readed_size < 0)
+	mesh_udp_ctx* ctx = reinterpret_cast<mesh_udp_ctx*>(base);
+	if(ctx != nullptr)
 	{
-		LOG("failed create socket, err: %s\n", strerror(errno));
+		ev_break(ctx->loop, EVBREAK_ALL);
 	}
-	return readed_size;
 }
 
 /**
  * @}
  */
-
@@ -9,6 +9,8 @@
 
 #include <ev.h>
 
+#include "mesh_dispatcher.h"
+
 /**
  * @defgroup mesh_stub Mesh stub
  * @brief Реализация mesh для PC
@@ -18,21 +20,60 @@
  */
 
 /**
- * @brief Контект mesh для PC
+ * @brief Контект UDP транспорта (libev) для PC
  */
-struct mesh_ctx 
+struct mesh_udp_ctx
 {
+	struct mesh_ctx base;						///< общая часть контекста
+
 	int port;									///< прорт для mesh
 	int socket;									///< открытый сокет
 
-	ev_periodic keep_alive_watcher;				///< handle на таймер libev
 	ev_io socket_watcher;						///< handle наблюдателя за сокетом
 	struct ev_loop* loop;						///< event_loop для работы libev
 
-	struct mesh_message_handlers* handlers;		///< обработчики mesh сообщений
+	struct mesh_dispatcher* dispatcher;			///< потоки обработчиков, nullptr - обработка в event_loop
 };
 
 /**
- * @}
+ * @brief Транспорт UDP поверх libev
+ */
+extern const struct mesh_transport mesh_udp_transport;
+
+/**
+ * @brief Функция создания UDP сокета для mesh (bind + SO_BROADCAST)
+ * @param[in] ip Адрес для bind
+ * @param[in] port Порт mesh
+ * @return Дескриптор сокета либо -1
  */
+int mesh_udp_socket(uint32_t ip, uint32_t port);
 
+/**
+ * @brief Функция создания mesh поверх UDP сокета
+ * @param[in] handlers Список обработчиков сообщений
+ * @param[in] ip Адрес для bind
+ * @param[in] port Порт mesh
+ * @return Контекст mesh либо nullptr
+ */
+struct mesh_ctx* mesh_udp_start(struct mesh_message_handlers* handlers, uint32_t ip, uint32_t port);
+
+/**
+ * @brief Функция передачи обработки сообщений в потоки диспетчера
+ * @param[in] ctx Контекст
+ * @param[in] dispatcher Диспетчер, nullptr - обработка в event_loop
+ */
+void mesh_udp_set_dispatcher(struct mesh_ctx* ctx, struct mesh_dispatcher* dispatcher);
+
+/**
+ * @brief Функция запуска event_loop, возвращает управление после mesh_udp_break
+ */
+void mesh_udp_run(struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция прерывания event_loop
+ */
+void mesh_udp_break(struct mesh_ctx* ctx);
+
+/**
+ * @}
+ */
@@ -0,0 +1,464 @@
+#include "mesh_query.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Максимальная длина строки запроса
+ */
+#define MESH_QUERY_MAX_LINE 256
+
+/**
+ * @brief Максимальный объем неотправленных ответов клиенту, медленный клиент отключается
+ */
+#define MESH_QUERY_MAX_PENDING (1024 * 1024)
+
+struct mesh_query;
+
+/**
+ * @brief Подключенный клиент
+ */
+struct mesh_query_client
+{
+	struct mesh_query* query;			///< сервер
+	int fd;								///< сокет клиента
+	ev_io read_watcher;					///< готовность к чтению
+	ev_io write_watcher;				///< готовность к записи, активен пока есть неотправленные данные
+	std::string in;						///< принятая неполная строка
+	std::string out;					///< неотправленные ответы
+	size_t out_offset;					///< отправлено из out
+	bool subscribed;					///< клиент получает изменения таблицы
+	bool closed;						///< клиент отключается
+};
+
+/**
+ * @brief Сервер
+ */
+struct mesh_query
+{
+	struct ev_loop* loop;								///< event_loop
+	struct mesh_ctx* ctx;								///< контекст mesh
+	struct mesh_registry* registry;						///< таблица устройств
+	std::string path;									///< путь сокета
+	int fd;												///< слушающий сокет
+	ev_io accept_watcher;								///< новые подключения
+	ev_async changes_watcher;							///< пробуждение loop при изменениях таблицы
+	std::vector<mesh_query_client*> clients;			///< клиенты
+
+	std::mutex mutex;									///< защищает changes
+	std::vector<mesh_registry_device> changes;			///< изменения ожидающие рассылки
+};
+
+/**
+ * @brief Аргумент обхода таблицы при ответе на запрос
+ */
+struct mesh_query_select
+{
+	struct mesh_query* query;			///< сервер
+	std::string* out;					///< куда писать ответ
+	uint32_t now;						///< текущее время, ms
+	bool by_id;							///< фильтр по id
+	uint8_t id;							///< искомый id
+	uint32_t count;						///< кол-во найденных устройств
+};
+
+static void mesh_query_append_device(std::string* out, const struct mesh_registry_device* device, uint32_t now)
+{
+	char ip[INET_ADDRSTRLEN];
+	struct in_addr addr;
+	addr.s_addr = htonl(device->ip);
+	inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+
+	uint32_t age = now - device->last_seen;
+	bool online = device->verified && age < MESH_QUERY_OFFLINE_TIMEOUT;
+
+	char buffer[128];
+	snprintf(buffer, sizeof(buffer), "{\"ip\":\"%s\",\"id\":%u,\"type\":%u,\"name\":\"", ip, device->info.id, device->info.type);
+	out->append(buffer);
+
+	for(size_t i = 0; i < MESH_DEVICE_NAME_SIZE && device->info.name[i] != 0; ++i)
+	{
+		unsigned char c = device->info.name[i];
+		if(c == '"' || c == '\\')
+		{
+			out->push_back('\\');
+			out->push_back(c);
+		}
+		else if(c < 0x20)
+		{
+			snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+			out->append(buffer);
+		}
+		else
+		{
+			out->push_back(c);
+		}
+	}
+
+	snprintf(buffer, sizeof(buffer), "\",\"online\":%s,\"verified\":%s,\"age\":%ld,\"power\":%s,\"missed\":%u}\n",
+			online ? "true" : "false", device->verified ? "true" : "false", device->verified ? static_cast<long>(age) : -1L,
+			device->power_known ? (device->power ? "true" : "false") : "null", device->power_missed);
+	out->append(buffer);
+}
+
+static void mesh_query_select_device(void* arg, const struct mesh_registry_device* device)
+{
+	mesh_query_select* select = reinterpret_cast<mesh_query_select*>(arg);
+	if(!select->by_id || device->info.id == select->id)
+	{
+		mesh_query_append_device(select->out, device, select->now);
+		++select->count;
+	}
+}
+
+static void mesh_query_client_close(mesh_query_client* client)
+{
+	struct mesh_query* query = client->query;
+
+	ev_io_stop(query->loop, &client->read_watcher);
+	ev_io_stop(query->loop, &client->write_watcher);
+	close(client->fd);
+
+	for(auto it = query->clients.begin(); it != query->clients.end(); ++it)
+	{
+		if(*it == client)
+		{
+			query->clients.erase(it);
+			break;
+		}
+	}
+	delete client;
+}
+
+/**
+ * @brief Функция отправки накопленных ответов
+ * @return false если клиент должен быть отключен
+ */
+static bool mesh_query_client_flush(mesh_query_client* client)
+{
+	while(client->out_offset < client->out.size())
+	{
+		ssize_t sent = send(client->fd, client->out.data() + client->out_offset, client->out.size() - client->out_offset, MSG_NOSIGNAL);
+		if(sent < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				break;
+			}
+			return false;
+		}
+		client->out_offset += sent;
+	}
+
+	if(client->out_offset == client->out.size())
+	{
+		client->out.clear();
+		client->out_offset = 0;
+		ev_io_stop(client->query->loop, &client->write_watcher);
+		return true;
+	}
+
+	if(client->out.size() - client->out_offset > MESH_QUERY_MAX_PENDING)
+	{
+		LOG("mesh[query]: client is too slow, disconnect\n");
+		return false;
+	}
+	ev_io_start(client->query->loop, &client->write_watcher);
+	return true;
+}
+
+static void mesh_query_execute(mesh_query_client* client, const char* line)
+{
+	struct mesh_query* query = client->query;
+
+	mesh_query_select select;
+	select.query = query;
+	select.out = &client->out;
+	select.now = mesh_now(query->ctx);
+	select.by_id = false;
+	select.id = 0;
+	select.count = 0;
+
+	char buffer[64];
+	if(strcmp(line, "list") == 0)
+	{
+		mesh_registry_foreach(query->registry, mesh_query_select_device, &select);
+	}
+	else if(strncmp(line, "id ", 3) == 0)
+	{
+		char* end = nullptr;
+		unsigned long id = strtoul(line + 3, &end, 10);
+		if(end == line + 3 || *end != 0 || id > 0xFF)
+		{
+			client->out.append("{\"error\":\"invalid id\"}\n");
+			return;
+		}
+		select.by_id = true;
+		select.id = id;
+		mesh_registry_foreach(query->registry, mesh_query_select_device, &select);
+	}
+	else if(strncmp(line, "ip ", 3) == 0)
+	{
+		struct in_addr addr;
+		if(inet_pton(AF_INET, line + 3, &addr) != 1)
+		{
+			client->out.append("{\"error\":\"invalid ip\"}\n");
+			return;
+		}
+
+		struct mesh_registry_device device;
+		if(mesh_registry_find(query->registry, ntohl(addr.s_addr), &device))
+		{
+			mesh_query_append_device(&client->out, &device, select.now);
+			++select.count;
+		}
+	}
+	else if(strcmp(line, "subscribe") == 0)
+	{
+		client->subscribed = true;
+		client->out.append("{\"subscribed\":true}\n");
+		return;
+	}
+	else if(strcmp(line, "unsubscribe") == 0)
+	{
+		client->subscribed = false;
+		client->out.append("{\"subscribed\":false}\n");
+		return;
+	}
+	else
+	{
+		client->out.append("{\"error\":\"unknown request\"}\n");
+		return;
+	}
+
+	snprintf(buffer, sizeof(buffer), "{\"count\":%u}\n", select.count);
+	client->out.append(buffer);
+}
+
+static void mesh_query_read_cb(struct ev_loop*, ev_io* w, int)
+{
+	mesh_query_client* client = reinterpret_cast<mesh_query_client*>(w->data);
+
+	char buffer[4096];
+	ssize_t size = recv(client->fd, buffer, sizeof(buffer), 0);
+	if(size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+	{
+		return;
+	}
+	if(size <= 0)
+	{
+		mesh_query_client_close(client);
+		return;
+	}
+
+	client->in.append(buffer, size);
+
+	size_t start = 0;
+	for(size_t end = client->in.find('\n'); end != std::string::npos; end = client->in.find('\n', start))
+	{
+		std::string line = client->in.substr(start, end - start);
+		if(!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		mesh_query_execute(client, line.c_str());
+		start = end + 1;
+	}
+	client->in.erase(0, start);
+
+	if(client->in.size() > MESH_QUERY_MAX_LINE)
+	{
+		client->out.append("{\"error\":\"request too long\"}\n");
+		client->closed = true;
+	}
+
+	if(!mesh_query_client_flush(client) || (client->closed && client->out.empty()))
+	{
+		mesh_query_client_close(client);
+	}
+}
+
+static void mesh_query_write_cb(struct ev_loop*, ev_io* w, int)
+{
+	mesh_query_client* client = reinterpret_cast<mesh_query_client*>(w->data);
+	if(!mesh_query_client_flush(client) || (client->closed && client->out.empty()))
+	{
+		mesh_query_client_close(client);
+	}
+}
+
+static void mesh_query_accept_cb(struct ev_loop* loop, ev_io* w, int)
+{
+	struct mesh_query* query = reinterpret_cast<struct mesh_query*>(w->data);
+
+	int fd = accept4(query->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if(fd < 0)
+	{
+		if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			LOG("mesh[query]: accept failed, err: %s\n", strerror(errno));
+		}
+		return;
+	}
+
+	mesh_query_client* client = new mesh_query_client;
+	client->query = query;
+	client->fd = fd;
+	client->out_offset = 0;
+	client->subscribed = false;
+	client->closed = false;
+
+	ev_io_init(&client->read_watcher, mesh_query_read_cb, fd, EV_READ);
+	client->read_watcher.data = client;
+	ev_io_init(&client->write_watcher, mesh_query_write_cb, fd, EV_WRITE);
+	client->write_watcher.data = client;
+
+	query->clients.push_back(client);
+	ev_io_start(loop, &client->read_watcher);
+}
+
+/**
+ * @brief Подписчик таблицы, может вызываться из потоков обработчиков
+ */
+static void mesh_query_on_change(void* arg, const struct mesh_registry_device* device)
+{
+	struct mesh_query* query = reinterpret_cast<struct mesh_query*>(arg);
+	{
+		std::lock_guard<std::mutex> lock(query->mutex);
+		query->changes.push_back(*device);
+	}
+	ev_async_send(query->loop, &query->changes_watcher);
+}
+
+static void mesh_query_changes_cb(struct ev_loop*, ev_async* w, int)
+{
+	struct mesh_query* query = reinterpret_cast<struct mesh_query*>(w->data);
+
+	std::vector<mesh_registry_device> changes;
+	{
+		std::lock_guard<std::mutex> lock(query->mutex);
+		changes.swap(query->changes);
+	}
+
+	// строка формируется один раз для всех подписчиков
+	std::string lines;
+	uint32_t now = mesh_now(query->ctx);
+	for(auto& device : changes)
+	{
+		mesh_query_append_device(&lines, &device, now);
+	}
+
+	std::vector<mesh_query_client*> failed;
+	for(auto client : query->clients)
+	{
+		if(client->subscribed && !client->closed)
+		{
+			client->out.append(lines);
+			if(!mesh_query_client_flush(client))
+			{
+				failed.push_back(client);
+			}
+		}
+	}
+
+	for(auto client : failed)
+	{
+		mesh_query_client_close(client);
+	}
+}
+
+struct mesh_query* mesh_query_new(const char* path, struct ev_loop* loop, struct mesh_ctx* ctx, struct mesh_registry* registry)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(struct sockaddr_un));
+	addr.sun_family = AF_UNIX;
+	if(strlen(path) >= sizeof(addr.sun_path))
+	{
+		LOG("mesh[query]: socket path is too long: %s\n", path);
+		return nullptr;
+	}
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(fd < 0)
+	{
+		LOG("mesh[query]: failed create socket, err: %s\n", strerror(errno));
+		return nullptr;
+	}
+
+	// сокет оставшийся от предыдущего запуска
+	unlink(path);
+	if(bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(struct sockaddr_un)) != 0 || listen(fd, 16) != 0)
+	{
+		LOG("mesh[query]: failed listen %s, err: %s\n", path, strerror(errno));
+		close(fd);
+		return nullptr;
+	}
+
+	struct mesh_query* query = new mesh_query;
+	query->loop = loop;
+	query->ctx = ctx;
+	query->registry = registry;
+	query->path = path;
+	query->fd = fd;
+
+	ev_io_init(&query->accept_watcher, mesh_query_accept_cb, fd, EV_READ);
+	query->accept_watcher.data = query;
+	ev_io_start(loop, &query->accept_watcher);
+
+	ev_async_init(&query->changes_watcher, mesh_query_changes_cb);
+	query->changes_watcher.data = query;
+	ev_async_start(loop, &query->changes_watcher);
+
+	mesh_registry_subscribe(registry, mesh_query_on_change, query);
+
+	LOG("mesh[query]: listen %s\n", path);
+	return query;
+}
+
+void mesh_query_free(struct mesh_query* query)
+{
+	if(query == nullptr)
+	{
+		return;
+	}
+
+	mesh_registry_unsubscribe(query->registry, mesh_query_on_change, query);
+
+	while(!query->clients.empty())
+	{
+		mesh_query_client_close(query->clients.back());
+	}
+
+	ev_async_stop(query->loop, &query->changes_watcher);
+	ev_io_stop(query->loop, &query->accept_watcher);
+	close(query->fd);
+	unlink(query->path.c_str());
+	delete query;
+}
+
+/**
+ * @}
+ */
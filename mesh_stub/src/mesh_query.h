@@ -0,0 +1,69 @@
+#pragma once
+
+#include <mesh.h>
+#include <ev.h>
+
+#include "mesh_registry.h"
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Путь UNIX сокета по умолчанию
+ */
+#define MESH_QUERY_DEFAULT_PATH "esp_mesh.sock"
+
+/**
+ * @brief Устройство без сообщений дольше этого времени считается offline, ms
+ * (keep_alive отправляется раз в 4 секунды)
+ */
+#define MESH_QUERY_OFFLINE_TIMEOUT 15000
+
+/**
+ * @brief Сервер запросов к таблице устройств
+ *
+ * Принимает подключения на локальном UNIX сокете (SOCK_STREAM),
+ * запросы и ответы - строки, завершенные '\n'. Ответы в JSON, одна строка - один объект.
+ *
+ * Запросы:
+ *	- list - все устройства, затем {"count":N}
+ *	- id N - устройства с mesh_device_info::id == N, затем {"count":N}
+ *	- ip A.B.C.D - устройство с адресом отправителя, затем {"count":0|1}
+ *	- subscribe - {"subscribed":true}, затем каждое изменение таблицы в формате list
+ *	- unsubscribe - {"subscribed":false}
+ *
+ * Устройство:
+ * @code{json}
+ *	{"ip":"192.168.0.5","id":5,"type":1,"name":"plug","online":true,"verified":true,"age":1200,"power":true,"missed":0}
+ * @endcode
+ * age - время с последнего сообщения в ms, -1 если устройство еще не подтверждено (из кэша).
+ * power - состояние нагрузки по mesh_power_event, null если событий не было,
+ * missed - кол-во потерянных событий нагрузки.
+ * На неизвестный запрос отвечается {"error":"..."}.
+ *
+ * Работает в потоке event loop, изменения таблицы из потоков обработчиков
+ * передаются в loop через ev_async.
+ */
+struct mesh_query;
+
+/**
+ * @brief Функция запуска сервера
+ * @param[in] path Путь UNIX сокета, существующий файл удаляется
+ * @param[in] loop event_loop в котором обслуживаются клиенты
+ * @param[in] ctx Контекст mesh, источник текущего времени (mesh_now)
+ * @param[in] registry Таблица устройств
+ * @return Сервер либо nullptr
+ */
+struct mesh_query* mesh_query_new(const char* path, struct ev_loop* loop, struct mesh_ctx* ctx, struct mesh_registry* registry);
+
+/**
+ * @brief Функция остановки сервера, клиенты отключаются, сокет удаляется
+ */
+void mesh_query_free(struct mesh_query* query);
+
+/**
+ * @}
+ */
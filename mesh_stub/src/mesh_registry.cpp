@@ -0,0 +1,210 @@
+#include "mesh_registry.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Подписка
+ */
+struct mesh_registry_subscription
+{
+	mesh_registry_listener listener;	///< подписчик
+	void* arg;							///< аргумент подписчика
+};
+
+/**
+ * @brief Таблица устройств
+ */
+struct mesh_registry
+{
+	std::mutex mutex;										///< блокировка таблицы
+	std::vector<mesh_registry_device> devices;				///< устройства по slot
+	std::unordered_map<uint32_t, uint32_t> index;			///< адрес -> slot
+	std::vector<mesh_registry_subscription> listeners;		///< подписчики
+};
+
+struct mesh_registry* mesh_registry_new()
+{
+	return new mesh_registry;
+}
+
+void mesh_registry_free(struct mesh_registry* registry)
+{
+	delete registry;
+}
+
+void mesh_registry_subscribe(struct mesh_registry* registry, mesh_registry_listener listener, void* arg)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	mesh_registry_subscription subscription;
+	subscription.listener = listener;
+	subscription.arg = arg;
+	registry->listeners.push_back(subscription);
+}
+
+void mesh_registry_unsubscribe(struct mesh_registry* registry, mesh_registry_listener listener, void* arg)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	for(auto it = registry->listeners.begin(); it != registry->listeners.end(); ++it)
+	{
+		if(it->listener == listener && it->arg == arg)
+		{
+			registry->listeners.erase(it);
+			break;
+		}
+	}
+}
+
+static mesh_registry_device* mesh_registry_insert(struct mesh_registry* registry, uint32_t ip, uint32_t now)
+{
+	uint32_t slot = registry->devices.size();
+	registry->index.emplace(ip, slot);
+	registry->devices.emplace_back();
+
+	mesh_registry_device* device = &registry->devices.back();
+	device->ip = ip;
+	device->slot = slot;
+	device->first_seen = now;
+	device->last_seen = now;
+	device->verified = 0;
+	device->power_known = 0;
+	device->power = 0;
+	device->power_seq = 0;
+	device->power_boot = 0;
+	device->power_missed = 0;
+	return device;
+}
+
+static void mesh_registry_notify(struct mesh_registry* registry, const mesh_registry_device* device)
+{
+	for(auto& subscription : registry->listeners)
+	{
+		subscription.listener(subscription.arg, device);
+	}
+}
+
+void mesh_registry_update(struct mesh_registry* registry, uint32_t ip, const struct mesh_device_info* info, uint32_t now)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	mesh_registry_device* device = nullptr;
+
+	auto it = registry->index.find(ip);
+	if(it == registry->index.end())
+	{
+		device = mesh_registry_insert(registry, ip, now);
+	}
+	else
+	{
+		device = &registry->devices[it->second];
+		if(!device->verified)
+		{	// устройство из кэша, время считаем с первого живого сообщения
+			device->first_seen = now;
+		}
+	}
+
+	device->info = *info;
+	// имя может прийти без завершающего нуля
+	device->info.name[MESH_DEVICE_NAME_SIZE - 1] = 0;
+	device->last_seen = now;
+	device->verified = 1;
+
+	mesh_registry_notify(registry, device);
+}
+
+void mesh_registry_restore(struct mesh_registry* registry, uint32_t ip, const struct mesh_device_info* info)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	if(registry->index.find(ip) != registry->index.end())
+	{
+		return;
+	}
+
+	mesh_registry_device* device = mesh_registry_insert(registry, ip, 0);
+	device->info = *info;
+	device->info.name[MESH_DEVICE_NAME_SIZE - 1] = 0;
+
+	mesh_registry_notify(registry, device);
+}
+
+bool mesh_registry_power(struct mesh_registry* registry, uint32_t ip, const struct mesh_power_event* event, uint32_t now, mesh_power_seq_status* status, uint32_t* missed)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	auto it = registry->index.find(ip);
+	if(it == registry->index.end())
+	{
+		return false;
+	}
+
+	mesh_registry_device* device = &registry->devices[it->second];
+
+	uint32_t lost = 0;
+	mesh_power_seq_status result = mesh_power_seq_check(device->power_boot, device->power_seq, event->boot, event->seq, &lost);
+	if(status != nullptr)
+	{
+		*status = result;
+	}
+	if(missed != nullptr)
+	{
+		*missed = lost;
+	}
+
+	device->last_seen = now;
+	if(result == mesh_power_seq_duplicate || result == mesh_power_seq_stale)
+	{	// состояние и seq не откатываются к старому событию
+		return true;
+	}
+
+	device->power_known = 1;
+	device->power = event->state;
+	device->power_seq = event->seq;
+	device->power_boot = event->boot;
+	device->power_missed += lost;
+
+	mesh_registry_notify(registry, device);
+	return true;
+}
+
+bool mesh_registry_find(struct mesh_registry* registry, uint32_t ip, struct mesh_registry_device* device)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	auto it = registry->index.find(ip);
+	if(it == registry->index.end())
+	{
+		return false;
+	}
+	*device = registry->devices[it->second];
+	return true;
+}
+
+uint32_t mesh_registry_size(struct mesh_registry* registry)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+	return registry->devices.size();
+}
+
+void mesh_registry_foreach(struct mesh_registry* registry, mesh_registry_listener callback, void* arg)
+{
+	std::lock_guard<std::mutex> lock(registry->mutex);
+
+	for(auto& device : registry->devices)
+	{
+		callback(arg, &device);
+	}
+}
+
+/**
+ * @}
+ */
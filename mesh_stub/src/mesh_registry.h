@@ -0,0 +1,111 @@
+#pragma once
+
+#include <mesh.h>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Устройство в таблице
+ */
+struct mesh_registry_device
+{
+	uint32_t ip;						///< адрес отправителя (host order), ключ таблицы
+	uint32_t slot;						///< постоянный номер записи, в порядке появления устройств
+	struct mesh_device_info info;		///< последняя полученная информация
+	uint32_t first_seen;				///< время первого сообщения, ms (mesh_now)
+	uint32_t last_seen;					///< время последнего сообщения, ms (mesh_now)
+	uint8_t verified;					///< 1 - устройство подтверждено живым трафиком, 0 - загружено из кэша
+
+	uint8_t power_known;				///< 1 - состояние нагрузки известно по mesh_power_event
+	uint8_t power;						///< последнее состояние нагрузки
+	uint32_t power_seq;					///< номер последнего события нагрузки, 0 - событий не было
+	uint32_t power_boot;				///< boot последнего события нагрузки
+	uint32_t power_missed;				///< всего потеряно событий нагрузки (разрывы seq)
+};
+
+/**
+ * @brief Таблица устройств mesh, собирается из keep_alive и device_info_response
+ * @note Потокобезопасна, подписчики вызываются под блокировкой таблицы
+ */
+struct mesh_registry;
+
+/**
+ * @brief Подписчик на изменения таблицы
+ * @param[in] arg Аргумент подписки
+ * @param[in] device Новое либо обновленное устройство
+ */
+typedef void (*mesh_registry_listener)(void* arg, const struct mesh_registry_device* device);
+
+/**
+ * @brief Функция создания таблицы
+ */
+struct mesh_registry* mesh_registry_new();
+
+/**
+ * @brief Функция удаления таблицы
+ */
+void mesh_registry_free(struct mesh_registry* registry);
+
+/**
+ * @brief Функция подписки на изменения
+ */
+void mesh_registry_subscribe(struct mesh_registry* registry, mesh_registry_listener listener, void* arg);
+
+/**
+ * @brief Функция отписки
+ */
+void mesh_registry_unsubscribe(struct mesh_registry* registry, mesh_registry_listener listener, void* arg);
+
+/**
+ * @brief Функция обновления устройства
+ * @param[in] ip Адрес отправителя
+ * @param[in] info Информация об устройстве
+ * @param[in] now Текущее время, ms
+ */
+void mesh_registry_update(struct mesh_registry* registry, uint32_t ip, const struct mesh_device_info* info, uint32_t now);
+
+/**
+ * @brief Функция добавления устройства из кэша, без подтверждения трафиком
+ * Существующее устройство не изменяется. Подтверждение - первый mesh_registry_update.
+ * @param[in] ip Адрес отправителя
+ * @param[in] info Сохраненная информация об устройстве
+ */
+void mesh_registry_restore(struct mesh_registry* registry, uint32_t ip, const struct mesh_device_info* info);
+
+/**
+ * @brief Функция применения события нагрузки к устройству
+ * Повтор и опоздавшее событие той же загрузки игнорируются, разрыв seq учитывается в power_missed.
+ * @param[in] ip Адрес отправителя
+ * @param[in] event Событие
+ * @param[in] now Текущее время, ms
+ * @param[out] status Результат проверки seq, может быть nullptr
+ * @param[out] missed Кол-во потерянных перед этим событием событий, может быть nullptr
+ * @return false если устройство не найдено
+ */
+bool mesh_registry_power(struct mesh_registry* registry, uint32_t ip, const struct mesh_power_event* event, uint32_t now, mesh_power_seq_status* status, uint32_t* missed);
+
+/**
+ * @brief Функция поиска устройства по адресу
+ * @param[out] device Копия записи
+ * @return false если устройство не найдено
+ */
+bool mesh_registry_find(struct mesh_registry* registry, uint32_t ip, struct mesh_registry_device* device);
+
+/**
+ * @brief Функция получения кол-ва устройств
+ */
+uint32_t mesh_registry_size(struct mesh_registry* registry);
+
+/**
+ * @brief Функция обхода всех устройств в порядке slot
+ * @note callback вызывается под блокировкой таблицы
+ */
+void mesh_registry_foreach(struct mesh_registry* registry, mesh_registry_listener callback, void* arg);
+
+/**
+ * @}
+ */
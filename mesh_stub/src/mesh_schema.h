@@ -0,0 +1,207 @@
+#pragma once
+
+#include <mesh.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Тип данных сообщения команды, void - команда без данных
+ * @tparam Command Команда mesh
+ */
+template<mesh_message_command Command>
+struct mesh_payload;
+
+#define MESH_PAYLOAD(command, payload) \
+	template<> \
+	struct mesh_payload<command> \
+	{ \
+		using type = payload; \
+	}
+
+MESH_PAYLOAD(mesh_keep_alive, struct mesh_device_info);
+MESH_PAYLOAD(mesh_devices_info_request, void);
+MESH_PAYLOAD(mesh_device_info_response, struct mesh_device_info);
+MESH_PAYLOAD(mesh_device_info_response_confirm, void);
+MESH_PAYLOAD(mesh_group_switch, struct mesh_group_command);
+MESH_PAYLOAD(mesh_group_switch_ack, struct mesh_group_ack);
+MESH_PAYLOAD(mesh_time_sync, struct mesh_time_beacon);
+MESH_PAYLOAD(mesh_power_event, struct mesh_power_event);
+MESH_PAYLOAD(mesh_election_announce, struct mesh_election_announce);
+MESH_PAYLOAD(mesh_election_table, struct mesh_election_table);
+
+#undef MESH_PAYLOAD
+
+template<mesh_message_command Command>
+using mesh_payload_t = typename mesh_payload<Command>::type;
+
+/**
+ * @brief Проверка типа данных: помещается в mesh_message::data и в uint8_t data_size,
+ * передается по сети побайтно
+ */
+template<typename T>
+constexpr bool mesh_payload_valid()
+{
+	if constexpr(std::is_void_v<T>)
+	{
+		return true;
+	}
+	else
+	{
+		return sizeof(T) <= MESH_MESSAGE_DATA_SIZE && sizeof(T) <= UINT8_MAX
+			&& std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>;
+	}
+}
+
+/**
+ * @brief Проверка схемы всех команд, новая команда без mesh_payload не скомпилируется
+ */
+template<mesh_message_command... Commands>
+constexpr bool mesh_schema_valid()
+{
+	return (mesh_payload_valid<mesh_payload_t<Commands>>() && ...);
+}
+
+static_assert(mesh_schema_valid<mesh_keep_alive, mesh_devices_info_request, mesh_device_info_response,
+		mesh_device_info_response_confirm, mesh_group_switch, mesh_group_switch_ack, mesh_time_sync,
+		mesh_power_event, mesh_election_announce, mesh_election_table>(),
+		"mesh payload does not fit mesh_message::data");
+
+/**
+ * @brief Типизированное представление сообщения без копирования данных
+ *
+ * Создается диспетчером только для сообщения нужной команды и размера,
+ * обработчику остается работать с полями. Исходное сообщение доступно через msg
+ * (например для mesh_coro_route).
+ * @note mesh_message::data не выровнено (смещение 9), как и весь stub полагаемся
+ * на невыровненный доступ x86/arm64
+ * @tparam Command Команда mesh
+ */
+template<mesh_message_command Command>
+struct mesh_view
+{
+	using payload = mesh_payload_t<Command>;
+
+	struct mesh_message* msg;		///< исходное сообщение
+
+	/**
+	 * @brief Проверка сообщения перед созданием представления
+	 */
+	static bool accepts(const struct mesh_message* msg)
+	{
+		if constexpr(std::is_void_v<payload>)
+		{	// данные команды без данных не читаются
+			return msg->command == Command;
+		}
+		else
+		{
+			return msg->command == Command && msg->data_size == sizeof(payload);
+		}
+	}
+
+	template<typename T = payload, typename = std::enable_if_t<!std::is_void_v<T>>>
+	T* get() const
+	{
+		return reinterpret_cast<T*>(msg->data);
+	}
+
+	template<typename T = payload, typename = std::enable_if_t<!std::is_void_v<T>>>
+	T* operator->() const
+	{
+		return get();
+	}
+
+	template<typename T = payload, typename = std::enable_if_t<!std::is_void_v<T>>>
+	T& operator*() const
+	{
+		return *get();
+	}
+};
+
+/**
+ * @brief Сигнатура типизированного обработчика
+ */
+template<mesh_message_command Command>
+using mesh_typed_handler = void (*)(struct mesh_ctx* ctx, struct mesh_sender_info* sender, mesh_view<Command> view);
+
+/**
+ * @brief Вывод команды из сигнатуры обработчика
+ */
+template<typename Handler>
+struct mesh_handler_traits;
+
+template<mesh_message_command Command>
+struct mesh_handler_traits<void (*)(struct mesh_ctx*, struct mesh_sender_info*, mesh_view<Command>)>
+{
+	static constexpr mesh_message_command command = Command;
+};
+
+/**
+ * @brief Обработчик с сигнатурой mesh_message_handler для таблицы mesh,
+ * отбрасывает сообщение неверного размера до вызова типизированного обработчика
+ */
+template<auto Handler>
+void mesh_schema_thunk(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	constexpr mesh_message_command command = mesh_handler_traits<decltype(Handler)>::command;
+	if(msg == nullptr || !mesh_view<command>::accepts(msg))
+	{
+		LOG("mesh[mesh_schema_thunk]: invalid message for command: %d, data_size: %d\n", command, msg != nullptr ? msg->data_size : -1);
+		return;
+	}
+	Handler(ctx, sender, mesh_view<command>{msg});
+}
+
+/**
+ * @brief Таблица обработчиков mesh из списка типизированных обработчиков
+ *
+ * Команда каждого обработчика выводится из типа его mesh_view,
+ * повтор команды в списке - ошибка компиляции.
+ * @code
+ *	mesh_udp_start(mesh_schema<keep_alive_handler, group_switch_handler>::handlers, ...);
+ * @endcode
+ * @tparam Handlers Обработчики (mesh_typed_handler)
+ */
+template<auto... Handlers>
+struct mesh_schema
+{
+	static constexpr bool unique()
+	{
+		constexpr mesh_message_command commands[] = { mesh_handler_traits<decltype(Handlers)>::command... };
+		for(size_t i = 0; i < sizeof...(Handlers); ++i)
+		{
+			for(size_t j = i + 1; j < sizeof...(Handlers); ++j)
+			{
+				if(commands[i] == commands[j])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	static_assert(sizeof...(Handlers) != 0, "mesh_schema requires handlers");
+	static_assert(unique(), "mesh_schema command handled twice");
+
+	/**
+	 * @brief Таблица для mesh_*_start, завершается обработчиком NULL
+	 */
+	static inline struct mesh_message_handlers handlers[] =
+	{
+		{ mesh_handler_traits<decltype(Handlers)>::command, mesh_schema_thunk<Handlers> }...,
+		{ mesh_keep_alive, nullptr },
+	};
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,150 @@
+#include "mesh_shm_publisher.h"
+#include "mesh_shm.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+static_assert(MESH_SHM_NAME_SIZE == MESH_DEVICE_NAME_SIZE, "mesh_shm_record name size mismatch");
+static_assert(sizeof(struct mesh_shm_header) == 64, "mesh_shm_header must take one cache line");
+
+/**
+ * @brief Публикатор
+ */
+struct mesh_shm_publisher
+{
+	std::string name;					///< имя сегмента
+	struct mesh_registry* registry;		///< таблица устройств
+	struct mesh_shm_header* header;		///< отображенный сегмент
+};
+
+static uint64_t mesh_shm_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void mesh_shm_publish(void* arg, const struct mesh_registry_device* device)
+{
+	mesh_shm_publisher* publisher = reinterpret_cast<mesh_shm_publisher*>(arg);
+	struct mesh_shm_header* header = publisher->header;
+
+	if(device->slot >= header->capacity)
+	{
+		LOG("mesh[shm]: device table is full, skip device slot: %u\n", device->slot);
+		return;
+	}
+
+	// время mesh_now у транспортов разное, в сегмент пишем CLOCK_MONOTONIC,
+	// сравнимый с часами читателей
+	uint64_t now = mesh_shm_clock();
+
+	// вызывается под блокировкой таблицы, писатель всегда один
+	uint32_t seq = header->seq;
+	__atomic_store_n(&header->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	struct mesh_shm_record* record = &MESH_SHM_RECORDS(header)[device->slot];
+	if(device->slot >= header->count)
+	{	// slot выдаются подряд, новое устройство всегда в конце
+		record->first_seen = now;
+	}
+	record->ip = device->ip;
+	record->id = device->info.id;
+	record->type = device->info.type;
+	record->flags = device->verified ? MESH_SHM_FLAG_VERIFIED : 0;
+	record->last_seen = now;
+	memcpy(record->name, device->info.name, MESH_SHM_NAME_SIZE);
+
+	if(device->slot >= header->count)
+	{
+		header->count = device->slot + 1;
+	}
+	header->updated = now;
+
+	__atomic_store_n(&header->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+struct mesh_shm_publisher* mesh_shm_publisher_new(const char* name, struct mesh_registry* registry)
+{
+	// сегмент прошлого запуска пересоздается, его читатели увидят closed
+	shm_unlink(name);
+
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if(fd < 0)
+	{
+		LOG("mesh[shm]: failed create segment %s, err: %s\n", name, strerror(errno));
+		return nullptr;
+	}
+
+	if(ftruncate(fd, MESH_SHM_SIZE) != 0)
+	{
+		LOG("mesh[shm]: failed resize segment, err: %s\n", strerror(errno));
+		close(fd);
+		shm_unlink(name);
+		return nullptr;
+	}
+
+	void* ptr = mmap(nullptr, MESH_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(ptr == MAP_FAILED)
+	{
+		LOG("mesh[shm]: failed map segment, err: %s\n", strerror(errno));
+		shm_unlink(name);
+		return nullptr;
+	}
+
+	mesh_shm_publisher* publisher = new mesh_shm_publisher;
+	publisher->name = name;
+	publisher->registry = registry;
+	publisher->header = reinterpret_cast<struct mesh_shm_header*>(ptr);
+
+	struct mesh_shm_header* header = publisher->header;
+	header->version = MESH_SHM_VERSION;
+	header->capacity = MESH_SHM_CAPACITY;
+	header->record_size = sizeof(struct mesh_shm_record);
+	header->seq = 0;
+	header->count = 0;
+	header->updated = mesh_shm_clock();
+	header->pid = getpid();
+	header->closed = 0;
+	__atomic_store_n(&header->magic, MESH_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	// устройства известные до запуска публикации
+	mesh_registry_foreach(registry, mesh_shm_publish, publisher);
+	mesh_registry_subscribe(registry, mesh_shm_publish, publisher);
+	return publisher;
+}
+
+void mesh_shm_publisher_free(struct mesh_shm_publisher* publisher)
+{
+	if(publisher == nullptr)
+	{
+		return;
+	}
+
+	mesh_registry_unsubscribe(publisher->registry, mesh_shm_publish, publisher);
+
+	__atomic_store_n(&publisher->header->closed, 1, __ATOMIC_RELEASE);
+	munmap(publisher->header, MESH_SHM_SIZE);
+	shm_unlink(publisher->name.c_str());
+	delete publisher;
+}
+
+/**
+ * @}
+ */
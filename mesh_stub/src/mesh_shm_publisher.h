@@ -0,0 +1,34 @@
+#pragma once
+
+#include "mesh_registry.h"
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Публикация таблицы устройств в POSIX shared memory (формат см. mesh_shm.h)
+ *
+ * Каждое изменение таблицы пишется в запись устройства под seqlock,
+ * чтение из других процессов не требует от stub ни вызовов, ни блокировок.
+ */
+struct mesh_shm_publisher;
+
+/**
+ * @brief Функция создания сегмента и подписки на изменения таблицы
+ * @param[in] name Имя сегмента (MESH_SHM_DEFAULT_NAME)
+ * @param[in] registry Таблица устройств
+ * @return Публикатор либо nullptr
+ */
+struct mesh_shm_publisher* mesh_shm_publisher_new(const char* name, struct mesh_registry* registry);
+
+/**
+ * @brief Функция отписки, пометки сегмента закрытым и удаления сегмента
+ */
+void mesh_shm_publisher_free(struct mesh_shm_publisher* publisher);
+
+/**
+ * @}
+ */
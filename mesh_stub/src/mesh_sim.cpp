@@ -0,0 +1,545 @@
+#include "mesh_sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Адрес первого узла симуляции (10.0.0.1), адреса узлов идут подряд
+ */
+#define MESH_SIM_BASE_ADDR 0x0A000001
+
+/**
+ * @brief Кол-во маяков до групповой команды в time_sync
+ */
+#define MESH_SIM_TIME_BEACONS 20
+
+/**
+ * @brief Задержка выполнения групповой команды в time_sync, ms
+ */
+#define MESH_SIM_TIME_LEAD 500
+
+/**
+ * @brief Кол-во повторов групповой команды в time_sync, повторы идут в пределах MESH_SIM_TIME_LEAD
+ */
+#define MESH_SIM_TIME_REPEATS 3
+
+/**
+ * @brief Кол-во периодов keep_alive для замера трафика после выборов
+ */
+#define MESH_SIM_ELECTION_PERIODS 10
+
+/**
+ * @brief Время ожидания ответов на опрос после выборов, ms
+ */
+#define MESH_SIM_ELECTION_DISCOVERY 300
+
+/**
+ * @brief Кол-во опросов после выборов, ответы теряются как и любые пакеты
+ */
+#define MESH_SIM_ELECTION_ATTEMPTS 3
+
+struct mesh_sim_state;
+
+/**
+ * @brief Узел симуляции
+ */
+struct mesh_sim_node
+{
+	struct mesh_sim_state* sim;				///< состояние прогона
+	struct mesh_ctx* ctx;					///< контекст узла
+	struct mesh_device_info info;			///< информация об узле
+
+	std::vector<bool> known;				///< известные узлы по индексу
+	uint32_t known_count;					///< кол-во известных узлов
+	bool tracked;							///< узел участвует в проверке схождения
+
+	struct mesh_time time;					///< оценка часов контроллера (time_sync)
+	uint64_t delivered;						///< время сети получения групповой команды, us, 0 - не получена
+	uint64_t executed;						///< время сети выполнения групповой команды, us, 0 - не выполнена
+
+	struct mesh_election election;			///< выборы лидера (election)
+};
+
+/**
+ * @brief Состояние прогона
+ */
+struct mesh_sim_state
+{
+	const struct mesh_sim_config* config;	///< параметры
+	struct mesh_memory_network* network;	///< сеть
+	std::vector<mesh_sim_node> nodes;		///< узлы, для discovery нулевой узел - контроллер
+
+	uint32_t expected;						///< сколько узлов должен узнать отслеживаемый узел
+	uint32_t required;						///< сколько узлов должно сойтись
+	uint32_t converged_nodes;				///< сколько узлов сошлось
+
+	struct mesh_group_command command;		///< групповая команда time_sync
+	uint32_t repeats;						///< кол-во отправок групповой команды
+
+	struct mesh_sim_result* result;			///< результат прогона
+};
+
+static bool mesh_sim_node_converged(struct mesh_sim_node* node)
+{
+	return node->known_count >= node->sim->expected;
+}
+
+static void mesh_sim_learn(struct mesh_sim_node* node, uint32_t ip)
+{
+	struct mesh_sim_state* sim = node->sim;
+
+	uint32_t index = ip - MESH_SIM_BASE_ADDR;
+	if(!node->tracked || index >= sim->nodes.size() || &sim->nodes[index] == node || node->known[index])
+	{
+		return;
+	}
+
+	node->known[index] = true;
+	++node->known_count;
+
+	if(node->known_count == sim->expected && ++sim->converged_nodes == sim->required)
+	{
+		sim->result->converged = true;
+		sim->result->convergence_time = mesh_now(node->ctx);
+		sim->result->stats = mesh_memory_network_stats(sim->network);
+	}
+}
+
+static void mesh_sim_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	if(node->sim->config->scenario == mesh_sim_election)
+	{
+		mesh_election_on_keep_alive(&node->election, ctx, sender, msg);
+		return;
+	}
+	mesh_sim_learn(node, sender->ip);
+}
+
+static void mesh_sim_devices_info_request_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message*)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	mesh_sim_scenario scenario = node->sim->config->scenario;
+	if((scenario == mesh_sim_discovery || scenario == mesh_sim_election) && node == &node->sim->nodes[0])
+	{	// контроллер не отвечает
+		return;
+	}
+
+	if(scenario != mesh_sim_election || !mesh_election_on_discovery(&node->election, ctx, sender))
+	{
+		mesh_send_device_info(ctx, &node->info, sender->ip);
+	}
+}
+
+static void mesh_sim_device_info_response_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	if(msg->data_size == sizeof(struct mesh_device_info))
+	{
+		mesh_sim_learn(reinterpret_cast<mesh_sim_node*>(ctx->user_data), sender->ip);
+		mesh_send_request_device_info_confirm(ctx, sender->ip);
+	}
+}
+
+static void mesh_sim_confirm_handler(struct mesh_ctx*, struct mesh_sender_info*, struct mesh_message*)
+{
+}
+
+static void mesh_sim_election_announce_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	if(node != &node->sim->nodes[0])
+	{
+		mesh_election_on_announce(&node->election, ctx, sender, msg);
+	}
+}
+
+static void mesh_sim_election_table_handler(struct mesh_ctx* ctx, struct mesh_sender_info*, struct mesh_message* msg)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	if(msg->data_size != sizeof(struct mesh_election_table))
+	{
+		return;
+	}
+
+	struct mesh_election_table* table = (struct mesh_election_table*) msg->data;
+	for(uint32_t i = 0; i < table->count && i < MESH_ELECTION_TABLE_SIZE; ++i)
+	{
+		mesh_sim_learn(node, table->entries[i].ip);
+	}
+}
+
+static uint8_t mesh_sim_election_info(void* arg, struct mesh_device_info* info)
+{
+	*info = reinterpret_cast<mesh_sim_node*>(arg)->info;
+	return 1;
+}
+
+static void mesh_sim_time_sync_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	mesh_time_on_beacon(&reinterpret_cast<mesh_sim_node*>(ctx->user_data)->time, ctx, sender, msg);
+}
+
+static void mesh_sim_group_execute(struct mesh_ctx* ctx, void*)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	mesh_sim_state* sim = node->sim;
+
+	node->executed = mesh_memory_network_clock(sim->network);
+
+	// момент выполнения по часам контроллера, его часы и есть часы mesh
+	uint64_t master = mesh_clock(sim->nodes[0].ctx);
+	uint64_t error = master > sim->command.at ? master - sim->command.at : sim->command.at - master;
+	sim->result->max_error = std::max(sim->result->max_error, error);
+
+	if(++sim->converged_nodes == sim->required)
+	{
+		sim->result->converged = true;
+		sim->result->convergence_time = mesh_memory_network_now(sim->network);
+		sim->result->stats = mesh_memory_network_stats(sim->network);
+	}
+}
+
+static void mesh_sim_group_switch_handler(struct mesh_ctx* ctx, struct mesh_sender_info*, struct mesh_message* msg)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	if(msg->data_size != sizeof(struct mesh_group_command) || node->delivered != 0)
+	{	// повтор команды
+		return;
+	}
+	node->delivered = mesh_memory_network_clock(node->sim->network);
+
+	struct mesh_group_command* command = (struct mesh_group_command*) msg->data;
+	if(command->at == 0 || !mesh_time_synced(&node->time, ctx) || mesh_time_at(&node->time, ctx, command->at, mesh_sim_group_execute, nullptr) == nullptr)
+	{
+		mesh_sim_group_execute(ctx, nullptr);
+	}
+}
+
+static struct mesh_message_handlers mesh_sim_handlers[] =
+{
+	{ mesh_keep_alive, mesh_sim_keep_alive_handler },
+	{ mesh_devices_info_request, mesh_sim_devices_info_request_handler },
+	{ mesh_device_info_response, mesh_sim_device_info_response_handler },
+	{ mesh_device_info_response_confirm, mesh_sim_confirm_handler },
+	{ mesh_time_sync, mesh_sim_time_sync_handler },
+	{ mesh_group_switch, mesh_sim_group_switch_handler },
+	{ mesh_election_announce, mesh_sim_election_announce_handler },
+	{ mesh_election_table, mesh_sim_election_table_handler },
+	{ mesh_keep_alive, NULL },
+};
+
+static void mesh_sim_request_timer(struct mesh_ctx* ctx, void*)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	if(!mesh_sim_node_converged(node))
+	{
+		mesh_send_request_devices_info(ctx);
+	}
+}
+
+static void mesh_sim_keep_alive_timer(struct mesh_ctx* ctx, void*)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	mesh_send_keep_alive(ctx, &node->info);
+}
+
+static void mesh_sim_keep_alive_start(struct mesh_ctx* ctx, void* arg)
+{
+	mesh_sim_keep_alive_timer(ctx, arg);
+	mesh_timer_start(ctx, reinterpret_cast<mesh_sim_node*>(ctx->user_data)->sim->config->interval, true, mesh_sim_keep_alive_timer, nullptr);
+}
+
+static void mesh_sim_beacon_timer(struct mesh_ctx* ctx, void*)
+{
+	mesh_sim_node* node = reinterpret_cast<mesh_sim_node*>(ctx->user_data);
+	mesh_time_send_beacon(ctx, ++node->time.seq);
+}
+
+static void mesh_sim_group_timer(struct mesh_ctx* ctx, void*)
+{
+	mesh_sim_state* sim = reinterpret_cast<mesh_sim_node*>(ctx->user_data)->sim;
+	if(sim->repeats == 0)
+	{
+		sim->command.at = mesh_clock(ctx) + MESH_SIM_TIME_LEAD * 1000;
+	}
+	mesh_send_group_switch(ctx, &sim->command);
+
+	if(++sim->repeats < MESH_SIM_TIME_REPEATS)
+	{
+		mesh_timer_start(ctx, MESH_SIM_TIME_LEAD / (MESH_SIM_TIME_REPEATS + 1), false, mesh_sim_group_timer, nullptr);
+	}
+}
+
+/**
+ * @brief Функция проверки окончания выборов
+ * @return Номер лидера, если лидер один, все устройства его слушают и он знает о всех, иначе 0
+ */
+static uint32_t mesh_sim_election_leader(mesh_sim_state* sim)
+{
+	uint32_t leader = 0;
+	for(uint32_t i = 1; i < sim->nodes.size(); ++i)
+	{
+		if(sim->nodes[i].election.role == mesh_election_leader)
+		{
+			if(leader != 0)
+			{
+				return 0;
+			}
+			leader = i;
+		}
+	}
+
+	uint32_t devices = std::min<uint32_t>(sim->nodes.size() - 2, MESH_ELECTION_MAX_DEVICES);
+	if(leader == 0 || sim->nodes[leader].election.count != devices)
+	{
+		return 0;
+	}
+
+	for(uint32_t i = 1; i < sim->nodes.size(); ++i)
+	{
+		if(i != leader && mesh_election_get_leader(&sim->nodes[i].election) != sim->nodes[leader].info.ip)
+		{
+			return 0;
+		}
+	}
+	return leader;
+}
+
+/**
+ * @brief Прогон выборов: ожидание лидера, замер широковещательного трафика, опрос сегмента контроллером
+ */
+static void mesh_sim_election_run(mesh_sim_state* sim)
+{
+	const struct mesh_sim_config* config = sim->config;
+	struct mesh_sim_result* result = sim->result;
+
+	while(result->leader == 0)
+	{
+		uint32_t next = mesh_memory_network_next(sim->network);
+		if(next > config->limit)
+		{
+			return;
+		}
+		result->events += mesh_memory_network_run(sim->network, next);
+		result->leader = mesh_sim_election_leader(sim);
+	}
+	result->convergence_time = mesh_memory_network_now(sim->network);
+
+	struct mesh_memory_stats before = mesh_memory_network_stats(sim->network);
+	uint32_t until = result->convergence_time + MESH_SIM_ELECTION_PERIODS * MESH_ELECTION_KEEP_ALIVE;
+	result->events += mesh_memory_network_run(sim->network, until);
+	struct mesh_memory_stats after = mesh_memory_network_stats(sim->network);
+	result->broadcasts_per_interval = static_cast<double>(after.broadcasts - before.broadcasts) / MESH_SIM_ELECTION_PERIODS;
+
+	// контроллер узнает сегмент опросом: отвечает только лидер, своей информацией и таблицей
+	for(uint32_t attempt = 0; attempt < MESH_SIM_ELECTION_ATTEMPTS && sim->nodes[0].known_count < sim->expected; ++attempt)
+	{
+		mesh_send_request_devices_info(sim->nodes[0].ctx);
+		until += MESH_SIM_ELECTION_DISCOVERY;
+		result->events += mesh_memory_network_run(sim->network, until);
+	}
+	result->discovered = sim->nodes[0].known_count;
+
+	result->converged = result->discovered == sim->expected;
+	result->stats = mesh_memory_network_stats(sim->network);
+}
+
+/**
+ * @brief Функция вычисления разброса (max - min) ненулевых времен узлов
+ */
+static uint64_t mesh_sim_spread(const mesh_sim_state* sim, uint64_t mesh_sim_node::* field)
+{
+	uint64_t min = UINT64_MAX;
+	uint64_t max = 0;
+	for(auto& node : sim->nodes)
+	{
+		if(node.*field != 0)
+		{
+			min = std::min(min, node.*field);
+			max = std::max(max, node.*field);
+		}
+	}
+	return max > min ? max - min : 0;
+}
+
+void mesh_sim_default_config(struct mesh_sim_config* config)
+{
+	memset(config, 0, sizeof(struct mesh_sim_config));
+	config->scenario = mesh_sim_discovery;
+	config->nodes = 100;
+	config->seed = 1;
+
+	config->link.loss = 0.01;
+	config->link.delay = 2000;
+	config->link.jitter = 3000;
+
+	config->medium.bandwidth = 11000000;
+	config->medium.fanout_cost = 0;
+
+	config->interval = 1000;
+	config->skew = 50;
+	config->limit = 120000;
+}
+
+const char* mesh_sim_scenario_name(mesh_sim_scenario scenario)
+{
+	switch(scenario)
+	{
+		case mesh_sim_discovery: return "discovery";
+		case mesh_sim_storm: return "storm";
+		case mesh_sim_keep_alive: return "keep_alive";
+		case mesh_sim_time_sync: return "time_sync";
+		case mesh_sim_election: return "election";
+	}
+	return "unknown";
+}
+
+bool mesh_sim_run(const struct mesh_sim_config* config, struct mesh_sim_result* result)
+{
+	if(config == nullptr || result == nullptr || config->nodes < 2 || config->interval == 0)
+	{
+		return false;
+	}
+	memset(result, 0, sizeof(struct mesh_sim_result));
+
+	auto started = std::chrono::steady_clock::now();
+
+	mesh_sim_state sim;
+	sim.config = config;
+	sim.result = result;
+	sim.converged_nodes = 0;
+	sim.network = mesh_memory_network_new();
+
+	mesh_memory_network_set_seed(sim.network, config->seed);
+	mesh_memory_network_set_link(sim.network, &config->link);
+	mesh_memory_network_set_medium(sim.network, &config->medium);
+
+	// в discovery и time_sync нулевой узел контроллер, остальные устройства
+	bool controller = config->scenario == mesh_sim_discovery || config->scenario == mesh_sim_time_sync || config->scenario == mesh_sim_election;
+	uint32_t total = controller ? config->nodes + 1 : config->nodes;
+	sim.expected = total - 1;
+	sim.required = config->scenario == mesh_sim_discovery ? 1 : config->scenario == mesh_sim_time_sync ? config->nodes : total;
+
+	memset(&sim.command, 0, sizeof(struct mesh_group_command));
+	sim.command.seq = 1;
+	sim.command.group = 1;
+	sim.command.action = mesh_group_power_toggle;
+	sim.repeats = 0;
+
+	// часы узлов: случайное смещение до 10 s и уход в пределах skew
+	std::mt19937_64 random(config->seed);
+	std::uniform_int_distribution<uint64_t> offset(0, 10000000);
+	std::uniform_int_distribution<int32_t> drift(-static_cast<int32_t>(config->skew), static_cast<int32_t>(config->skew));
+
+	sim.nodes.resize(total);
+	for(uint32_t i = 0; i < total; ++i)
+	{
+		mesh_sim_node* node = &sim.nodes[i];
+		node->sim = &sim;
+		node->known.assign(total, false);
+		node->known_count = 0;
+		node->tracked = (config->scenario != mesh_sim_discovery && config->scenario != mesh_sim_election) || i == 0;
+		mesh_time_init(&node->time);
+		node->delivered = 0;
+		node->executed = 0;
+
+		memset(&node->info, 0, sizeof(struct mesh_device_info));
+		node->info.type = 3;
+		node->info.id = i & 0xFF;
+		node->info.ip = MESH_SIM_BASE_ADDR + i;
+		snprintf(node->info.name, MESH_DEVICE_NAME_SIZE, "sim-%u", i);
+
+		node->ctx = mesh_memory_start(sim.network, mesh_sim_handlers, node->info.ip);
+		node->ctx->user_data = node;
+		if(config->scenario == mesh_sim_election && i != 0)
+		{	// все устройства с постоянным питанием, старшинство по номеру
+			mesh_election_init(&node->election, i, 0, 1, mesh_sim_election_info, node);
+		}
+		else if(config->scenario == mesh_sim_time_sync)
+		{
+			uint64_t node_offset = offset(random);
+			mesh_memory_set_clock(node->ctx, node_offset, drift(random));
+		}
+	}
+
+	switch(config->scenario)
+	{
+		case mesh_sim_discovery:
+			mesh_timer_start(sim.nodes[0].ctx, 0, false, mesh_sim_request_timer, nullptr);
+			mesh_timer_start(sim.nodes[0].ctx, config->interval, true, mesh_sim_request_timer, nullptr);
+			break;
+
+		case mesh_sim_storm:
+			for(auto& node : sim.nodes)
+			{
+				mesh_timer_start(node.ctx, 0, false, mesh_sim_request_timer, nullptr);
+				mesh_timer_start(node.ctx, config->interval, true, mesh_sim_request_timer, nullptr);
+			}
+			break;
+
+		case mesh_sim_keep_alive:
+			for(uint32_t i = 0; i < total; ++i)
+			{	// равномерно распределяем фазы keep_alive по периоду
+				mesh_timer_start(sim.nodes[i].ctx, config->interval * i / total, false, mesh_sim_keep_alive_start, nullptr);
+			}
+			break;
+
+		case mesh_sim_time_sync:
+			mesh_timer_start(sim.nodes[0].ctx, 0, false, mesh_sim_beacon_timer, nullptr);
+			mesh_timer_start(sim.nodes[0].ctx, config->interval, true, mesh_sim_beacon_timer, nullptr);
+			// команда посередине между маяками, чтобы не совпасть с ними по времени
+			mesh_timer_start(sim.nodes[0].ctx, config->interval * MESH_SIM_TIME_BEACONS + config->interval / 2, false, mesh_sim_group_timer, nullptr);
+			break;
+
+		case mesh_sim_election:
+			for(uint32_t i = 1; i < total; ++i)
+			{
+				mesh_election_start(&sim.nodes[i].election, sim.nodes[i].ctx);
+			}
+			mesh_sim_election_run(&sim);
+			break;
+	}
+
+	while(!result->converged && config->scenario != mesh_sim_election)
+	{
+		uint32_t next = mesh_memory_network_next(sim.network);
+		if(next > config->limit)
+		{
+			break;
+		}
+		result->events += mesh_memory_network_run(sim.network, next);
+	}
+
+	if(!result->converged && config->scenario != mesh_sim_election)
+	{
+		result->convergence_time = mesh_memory_network_now(sim.network);
+		result->stats = mesh_memory_network_stats(sim.network);
+	}
+	result->delivery_spread = mesh_sim_spread(&sim, &mesh_sim_node::delivered);
+	result->action_spread = mesh_sim_spread(&sim, &mesh_sim_node::executed);
+
+	for(auto& node : sim.nodes)
+	{
+		mesh_election_stop(&node.election, node.ctx);
+		mesh_stop(node.ctx);
+	}
+	mesh_memory_network_free(sim.network);
+
+	result->wall_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+	return true;
+}
+
+/**
+ * @}
+ */
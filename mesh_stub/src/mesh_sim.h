@@ -0,0 +1,80 @@
+#pragma once
+
+#include "mesh_memory.h"
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Сценарии симулятора
+ */
+typedef enum
+{
+	mesh_sim_discovery = 0,			///< контроллер опрашивает сеть (mesh_devices_info_request) до получения ответа от всех
+	mesh_sim_storm = 1,				///< все узлы одновременно опрашивают сеть (перезапуск сегмента)
+	mesh_sim_keep_alive = 2,		///< узлы рассылают keep_alive пока каждый не узнает о всех
+	mesh_sim_time_sync = 3,			///< контроллер рассылает маяки времени, затем групповую команду с моментом выполнения
+	mesh_sim_election = 4			///< устройства выбирают лидера, затем контроллер опрашивает сегмент через лидера
+} mesh_sim_scenario;
+
+/**
+ * @brief Параметры прогона
+ */
+struct mesh_sim_config
+{
+	mesh_sim_scenario scenario;				///< сценарий
+	uint32_t nodes;							///< кол-во устройств (без контроллера)
+	uint64_t seed;							///< зерно генератора
+
+	struct mesh_link_model link;			///< модель канала
+	struct mesh_medium_model medium;		///< модель среды
+
+	uint32_t interval;						///< период повтора опроса / keep_alive / маяков времени в ms
+	uint32_t skew;							///< максимальный уход часов узлов в ppm (time_sync)
+	uint32_t limit;							///< ограничение виртуального времени прогона в ms
+};
+
+/**
+ * @brief Результат прогона
+ */
+struct mesh_sim_result
+{
+	bool converged;							///< сеть сошлась до limit
+	uint32_t convergence_time;				///< виртуальное время схождения в ms
+	uint64_t events;						///< кол-во обработанных событий
+	uint64_t wall_time;						///< реальное время прогона в us
+	struct mesh_memory_stats stats;			///< статистика сети на момент схождения
+
+	uint64_t delivery_spread;				///< разброс доставки групповой команды в us (time_sync)
+	uint64_t action_spread;					///< разброс выполнения групповой команды в us (time_sync)
+	uint64_t max_error;						///< максимальное отклонение выполнения от заданного момента в us (time_sync)
+
+	uint32_t leader;						///< номер узла лидера (election)
+	double broadcasts_per_interval;			///< широковещательных сообщений за период keep_alive после выборов (election)
+	uint32_t discovered;					///< устройств узнал контроллер опросом после выборов (election)
+};
+
+/**
+ * @brief Функция заполняет параметры по умолчанию
+ */
+void mesh_sim_default_config(struct mesh_sim_config* config);
+
+/**
+ * @brief Функция получения имени сценария
+ */
+const char* mesh_sim_scenario_name(mesh_sim_scenario scenario);
+
+/**
+ * @brief Функция выполняет прогон сценария
+ * @param[in] config Параметры прогона
+ * @param[out] result Результат
+ * @return true если прогон выполнен
+ */
+bool mesh_sim_run(const struct mesh_sim_config* config, struct mesh_sim_result* result);
+
+/**
+ * @}
+ */
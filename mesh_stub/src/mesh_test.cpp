@@ -0,0 +1,778 @@
+#include "mesh_memory.h"
+#include "mesh_registry.h"
+#include "mesh_schema.h"
+#include "mesh_time.h"
+#include "mesh_wire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Адрес первого узла in-memory сети
+ */
+#define TEST_BASE_ADDR 0x0A000001
+
+/**
+ * @brief Проверка условия, при ошибке печатается место и прогон продолжается
+ */
+#define TEST_CHECK(expr) test_check((expr), #expr, __FILE__, __LINE__)
+
+/**
+ * @brief Кол-во проваленных проверок текущего прогона
+ */
+static uint32_t test_failures = 0;
+
+static bool test_check(bool ok, const char* expr, const char* file, int line)
+{
+	if(!ok)
+	{
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+		++test_failures;
+	}
+	return ok;
+}
+
+/**
+ * @brief Тест
+ */
+struct test_case
+{
+	const char* name;		///< имя теста
+	void (*run)();			///< прогон, ошибки считаются в test_failures
+};
+
+static void test_fill_info(struct mesh_device_info* info, uint32_t i)
+{
+	memset(info, 0, sizeof(struct mesh_device_info));
+	info->type = 1;
+	info->id = static_cast<uint8_t>(i);
+	info->ip = TEST_BASE_ADDR + i;
+	snprintf(info->name, MESH_DEVICE_NAME_SIZE, "test %u", i);
+}
+
+/**
+ * @brief Последний вызов обработчика
+ */
+struct test_call
+{
+	uint32_t count;						///< кол-во вызовов
+	mesh_message_command command;		///< команда сообщения
+	struct mesh_ctx* ctx;				///< контекст
+	uint32_t sender;					///< адрес отправителя
+	struct mesh_device_info info;		///< данные keep_alive
+};
+
+static test_call test_keep_alive_call;
+static test_call test_request_call;
+static test_call test_power_call;
+
+static void test_record(test_call* call, struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	++call->count;
+	call->command = msg->command;
+	call->ctx = ctx;
+	call->sender = sender != nullptr ? sender->ip : 0;
+	if(msg->data_size == sizeof(struct mesh_device_info))
+	{
+		memcpy(&call->info, msg->data, sizeof(struct mesh_device_info));
+	}
+}
+
+static void test_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	test_record(&test_keep_alive_call, ctx, sender, msg);
+}
+
+static void test_request_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	test_record(&test_request_call, ctx, sender, msg);
+}
+
+static void test_power_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	test_record(&test_power_call, ctx, sender, msg);
+}
+
+static void test_reset_calls()
+{
+	memset(&test_keep_alive_call, 0, sizeof(test_call));
+	memset(&test_request_call, 0, sizeof(test_call));
+	memset(&test_power_call, 0, sizeof(test_call));
+}
+
+/**
+ * @brief Таблица обработчиков: mesh_power_event стоит после завершающего элемента
+ * и не должен быть найден, команда завершающего элемента роли не играет
+ */
+static struct mesh_message_handlers test_handlers[] =
+{
+	{ mesh_devices_info_request, test_request_handler },
+	{ mesh_keep_alive, test_keep_alive_handler },
+	{ mesh_device_info_response, NULL },
+	{ mesh_power_event, test_power_handler },
+};
+
+/**
+ * @brief Таблица только из завершающего элемента с командой keep_alive
+ */
+static struct mesh_message_handlers test_empty_handlers[] =
+{
+	{ mesh_keep_alive, NULL },
+};
+
+/**
+ * @brief new_message отдает сообщение в формате сети, mesh_wire_decode возвращает его обратно
+ */
+static void test_wire()
+{
+	struct mesh_device_info info;
+	test_fill_info(&info, 7);
+
+	struct mesh_message* msg = new_message(mesh_keep_alive, &info, sizeof(struct mesh_device_info));
+	TEST_CHECK(msg != nullptr);
+	if(msg == nullptr)
+	{
+		return;
+	}
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(msg);
+	const uint8_t header[] = { 0x10, 0x01, 0x11, 0x00, 0x01, 0x00, 0x00, 0x00, sizeof(struct mesh_device_info) };
+	TEST_CHECK(memcmp(bytes, header, sizeof(header)) == 0);
+	TEST_CHECK(bytes[MESH_WIRE_HEADER_SIZE] == 1 && bytes[MESH_WIRE_HEADER_SIZE + 1] == 7);
+
+	struct mesh_message copy;
+	memcpy(&copy, msg, sizeof(struct mesh_message));
+	TEST_CHECK(mesh_wire_decode(&copy) == 1);
+	TEST_CHECK(copy.magic == MESH_WIRE_MAGIC);
+	TEST_CHECK(copy.command == mesh_keep_alive);
+	TEST_CHECK(copy.data_size == sizeof(struct mesh_device_info));
+	TEST_CHECK(memcmp(copy.data, &info, sizeof(struct mesh_device_info)) == 0);
+
+	// обратное кодирование дает те же байты
+	mesh_wire_encode(&copy);
+	TEST_CHECK(memcmp(&copy, msg, MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_device_info)) == 0);
+
+	memcpy(&copy, msg, sizeof(struct mesh_message));
+	reinterpret_cast<uint8_t*>(&copy)[0] ^= 0xFF;
+	TEST_CHECK(mesh_wire_decode(&copy) == 0);
+
+	memcpy(&copy, msg, sizeof(struct mesh_message));
+	copy.data_size = sizeof(struct mesh_device_info) - 1;
+	TEST_CHECK(mesh_wire_decode(&copy) == 0);
+
+	memcpy(&copy, msg, sizeof(struct mesh_message));
+	reinterpret_cast<uint8_t*>(&copy)[4] = 0x7F;
+	TEST_CHECK(mesh_wire_decode(&copy) == 0);
+
+	free_message(msg);
+
+	// команда без данных
+	msg = new_message(mesh_devices_info_request, NULL, 0);
+	TEST_CHECK(msg != nullptr && mesh_wire_decode(msg) == 1 && msg->command == mesh_devices_info_request);
+	free_message(msg);
+
+	// многобайтные поля данных
+	struct mesh_power_event event;
+	memset(&event, 0, sizeof(struct mesh_power_event));
+	event.seq = 0x01020304;
+	event.boot = 0xA1B2C3D4;
+	event.id = 3;
+	event.state = 1;
+	event.reserved[0] = 0xEE;
+
+	msg = new_message(mesh_power_event, &event, sizeof(struct mesh_power_event));
+	const uint8_t power[] = { 0x04, 0x03, 0x02, 0x01, 0xD4, 0xC3, 0xB2, 0xA1, 0x03, 0x01, 0x00, 0x00 };
+	TEST_CHECK(memcmp(msg->data, power, sizeof(power)) == 0);
+	TEST_CHECK(mesh_wire_decode(msg) == 1);
+
+	const struct mesh_power_event* decoded = reinterpret_cast<const struct mesh_power_event*>(msg->data);
+	TEST_CHECK(decoded->seq == 0x01020304 && decoded->boot == 0xA1B2C3D4);
+	TEST_CHECK(decoded->id == 3 && decoded->state == 1 && decoded->reserved[0] == 0);
+	free_message(msg);
+}
+
+/**
+ * @brief Поиск обработчика по команде и остановка на элементе с обработчиком NULL
+ */
+static void test_call_handler()
+{
+	struct mesh_message msg;
+	memset(&msg, 0, sizeof(struct mesh_message));
+	msg.magic = MESH_WIRE_MAGIC;
+
+	struct mesh_sender_info sender;
+	sender.ip = TEST_BASE_ADDR + 1;
+	sender.port = 0;
+
+	struct mesh_ctx* ctx = reinterpret_cast<struct mesh_ctx*>(&msg);
+
+	test_reset_calls();
+	msg.command = mesh_keep_alive;
+	call_handler(test_handlers, ctx, &sender, &msg);
+	TEST_CHECK(test_keep_alive_call.count == 1);
+	TEST_CHECK(test_keep_alive_call.ctx == ctx && test_keep_alive_call.sender == TEST_BASE_ADDR + 1);
+	TEST_CHECK(test_request_call.count == 0);
+
+	msg.command = mesh_devices_info_request;
+	call_handler(test_handlers, ctx, &sender, &msg);
+	TEST_CHECK(test_request_call.count == 1 && test_keep_alive_call.count == 1);
+
+	// совпадение команды с завершающим элементом не вызывает обработчик
+	msg.command = mesh_device_info_response;
+	call_handler(test_handlers, ctx, &sender, &msg);
+
+	// элемент после завершающего не просматривается
+	msg.command = mesh_power_event;
+	call_handler(test_handlers, ctx, &sender, &msg);
+	TEST_CHECK(test_power_call.count == 0);
+
+	msg.command = mesh_keep_alive;
+	call_handler(test_empty_handlers, ctx, &sender, &msg);
+	TEST_CHECK(test_keep_alive_call.count == 1 && test_request_call.count == 1);
+
+	call_handler(NULL, ctx, &sender, &msg);
+	call_handler(test_handlers, ctx, &sender, NULL);
+	TEST_CHECK(test_keep_alive_call.count == 1);
+}
+
+/**
+ * @brief keep_alive через in-memory транспорт: кодирование, доставка, декодирование, обработчик
+ */
+static void test_dispatch()
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* sender = mesh_memory_start(network, test_empty_handlers, TEST_BASE_ADDR);
+	struct mesh_ctx* receiver = mesh_memory_start(network, test_handlers, TEST_BASE_ADDR + 1);
+	TEST_CHECK(sender != nullptr && receiver != nullptr);
+	TEST_CHECK(mesh_memory_start(network, test_handlers, TEST_BASE_ADDR) == nullptr);
+
+	struct mesh_device_info info;
+	test_fill_info(&info, 5);
+
+	test_reset_calls();
+	mesh_send_keep_alive(sender, &info);
+	mesh_memory_network_run(network, mesh_memory_network_now(network) + 10);
+
+	TEST_CHECK(test_keep_alive_call.count == 1);
+	TEST_CHECK(test_keep_alive_call.ctx == receiver);
+	TEST_CHECK(test_keep_alive_call.sender == TEST_BASE_ADDR);
+	TEST_CHECK(memcmp(&test_keep_alive_call.info, &info, sizeof(struct mesh_device_info)) == 0);
+
+	// сообщение с неверным magic отбрасывается до обработчика
+	struct mesh_message* msg = new_message(mesh_keep_alive, &info, sizeof(struct mesh_device_info));
+	msg->magic = 0;
+	struct mesh_sender_info from;
+	from.ip = TEST_BASE_ADDR;
+	from.port = 0;
+	mesh_dispatch(receiver, &from, msg);
+	TEST_CHECK(test_keep_alive_call.count == 1);
+	free_message(msg);
+
+	mesh_stop(receiver);
+	mesh_stop(sender);
+	mesh_memory_network_free(network);
+}
+
+static void test_count_listener(void* arg, const struct mesh_registry_device*)
+{
+	++*reinterpret_cast<uint32_t*>(arg);
+}
+
+/**
+ * @brief Добавление и обновление устройств, события нагрузки
+ */
+static void test_registry()
+{
+	struct mesh_registry* registry = mesh_registry_new();
+
+	uint32_t notified = 0;
+	mesh_registry_subscribe(registry, test_count_listener, &notified);
+
+	struct mesh_device_info info;
+	test_fill_info(&info, 1);
+	mesh_registry_update(registry, TEST_BASE_ADDR, &info, 100);
+	test_fill_info(&info, 2);
+	mesh_registry_update(registry, TEST_BASE_ADDR + 1, &info, 150);
+	TEST_CHECK(mesh_registry_size(registry) == 2);
+	TEST_CHECK(notified == 2);
+
+	struct mesh_registry_device device;
+	TEST_CHECK(mesh_registry_find(registry, TEST_BASE_ADDR, &device));
+	TEST_CHECK(device.info.id == 1 && device.first_seen == 100 && device.last_seen == 100);
+	TEST_CHECK(device.verified == 1 && device.power_known == 0);
+	TEST_CHECK(!mesh_registry_find(registry, TEST_BASE_ADDR + 100, &device));
+
+	// повторный keep_alive обновляет запись, а не добавляет новую
+	test_fill_info(&info, 1);
+	snprintf(info.name, MESH_DEVICE_NAME_SIZE, "renamed");
+	mesh_registry_update(registry, TEST_BASE_ADDR, &info, 200);
+	TEST_CHECK(mesh_registry_size(registry) == 2);
+	TEST_CHECK(mesh_registry_find(registry, TEST_BASE_ADDR, &device));
+	TEST_CHECK(strcmp(device.info.name, "renamed") == 0);
+	TEST_CHECK(device.first_seen == 100 && device.last_seen == 200);
+
+	struct mesh_power_event event;
+	memset(&event, 0, sizeof(struct mesh_power_event));
+	event.boot = 10;
+	event.seq = 1;
+	event.state = 1;
+
+	mesh_power_seq_status status = mesh_power_seq_gap;
+	uint32_t missed = 0;
+	TEST_CHECK(!mesh_registry_power(registry, TEST_BASE_ADDR + 100, &event, 300, &status, &missed));
+
+	TEST_CHECK(mesh_registry_power(registry, TEST_BASE_ADDR, &event, 300, &status, &missed));
+	TEST_CHECK(status == mesh_power_seq_next && missed == 0);
+
+	event.seq = 4;
+	event.state = 0;
+	TEST_CHECK(mesh_registry_power(registry, TEST_BASE_ADDR, &event, 310, &status, &missed));
+	TEST_CHECK(status == mesh_power_seq_gap && missed == 2);
+
+	// опоздавшее событие той же загрузки не откатывает состояние
+	event.seq = 3;
+	event.state = 1;
+	uint32_t before = notified;
+	TEST_CHECK(mesh_registry_power(registry, TEST_BASE_ADDR, &event, 320, &status, &missed));
+	TEST_CHECK(status == mesh_power_seq_stale);
+	TEST_CHECK(mesh_registry_find(registry, TEST_BASE_ADDR, &device));
+	TEST_CHECK(device.power_known == 1 && device.power == 0 && device.power_seq == 4);
+	TEST_CHECK(device.power_missed == 2 && device.last_seen == 320);
+	TEST_CHECK(notified == before);
+
+	event.seq = 4;
+	TEST_CHECK(mesh_registry_power(registry, TEST_BASE_ADDR, &event, 330, &status, &missed));
+	TEST_CHECK(status == mesh_power_seq_duplicate);
+
+	// новая загрузка начинает счет заново
+	event.boot = 11;
+	event.seq = 2;
+	event.state = 1;
+	TEST_CHECK(mesh_registry_power(registry, TEST_BASE_ADDR, &event, 340, &status, &missed));
+	TEST_CHECK(status == mesh_power_seq_restart && missed == 1);
+	TEST_CHECK(mesh_registry_find(registry, TEST_BASE_ADDR, &device));
+	TEST_CHECK(device.power == 1 && device.power_seq == 2 && device.power_boot == 11 && device.power_missed == 3);
+
+	mesh_registry_unsubscribe(registry, test_count_listener, &notified);
+	before = notified;
+	mesh_registry_update(registry, TEST_BASE_ADDR + 2, &info, 400);
+	TEST_CHECK(notified == before && mesh_registry_size(registry) == 3);
+
+	mesh_registry_free(registry);
+}
+
+static void test_timer_callback(struct mesh_ctx*, void* arg)
+{
+	++*reinterpret_cast<uint32_t*>(arg);
+}
+
+/**
+ * @brief Оценка часов источника на приемнике
+ */
+static struct mesh_time test_time;
+
+static void test_time_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	mesh_time_on_beacon(&test_time, ctx, sender, msg);
+}
+
+static struct mesh_message_handlers test_time_handlers[] =
+{
+	{ mesh_time_sync, test_time_handler },
+	{ mesh_keep_alive, NULL },
+};
+
+/**
+ * @brief Маяк времени проходит кодирование сети, приемник видит часы источника
+ */
+static void test_time_beacon()
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* source = mesh_memory_start(network, test_empty_handlers, TEST_BASE_ADDR);
+	struct mesh_ctx* receiver = mesh_memory_start(network, test_time_handlers, TEST_BASE_ADDR + 1);
+
+	// часы источника впереди на 5 s
+	mesh_memory_set_clock(source, 5000000, 0);
+	mesh_time_init(&test_time);
+
+	mesh_time_send_beacon(source, 5);
+	mesh_memory_network_run(network, mesh_memory_network_now(network) + 10);
+
+	TEST_CHECK(test_time.master == TEST_BASE_ADDR && test_time.seq == 5 && test_time.count == 1);
+	int64_t offset = test_time.samples[0].offset;
+	TEST_CHECK(offset > 5000000 - 100000 && offset <= 5000000);
+
+	mesh_stop(receiver);
+	mesh_stop(source);
+	mesh_memory_network_free(network);
+}
+
+/**
+ * @brief Таймеры in-memory транспорта в виртуальном времени
+ */
+static void test_timers()
+{
+	struct mesh_memory_network* network = mesh_memory_network_new();
+	struct mesh_ctx* ctx = mesh_memory_start(network, test_empty_handlers, TEST_BASE_ADDR);
+
+	uint32_t once = 0;
+	uint32_t periodic = 0;
+	uint32_t stopped = 0;
+
+	uint32_t start = mesh_now(ctx);
+	mesh_timer_start(ctx, 50, 0, test_timer_callback, &once);
+	struct mesh_timer* timer = mesh_timer_start(ctx, 10, 1, test_timer_callback, &periodic);
+	struct mesh_timer* cancelled = mesh_timer_start(ctx, 20, 0, test_timer_callback, &stopped);
+	TEST_CHECK(timer != nullptr && cancelled != nullptr);
+	mesh_timer_stop(ctx, cancelled);
+
+	mesh_memory_network_run(network, start + 49);
+	TEST_CHECK(once == 0 && periodic == 4);
+
+	mesh_memory_network_run(network, start + 100);
+	TEST_CHECK(once == 1 && periodic == 10 && stopped == 0);
+	TEST_CHECK(mesh_now(ctx) == start + 100);
+
+	mesh_timer_stop(ctx, timer);
+	mesh_memory_network_run(network, start + 200);
+	TEST_CHECK(once == 1 && periodic == 10);
+
+	mesh_stop(ctx);
+	mesh_memory_network_free(network);
+}
+
+/**
+ * @brief Сообщения в формате сети: заголовок (magic, command little-endian, data_size) и данные,
+ * не перечисленные байты нули. Одни и те же байты должны получаться у прошивки (mesh_wire)
+ * и у stub (mesh_schema)
+ */
+static const uint8_t test_keep_alive_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_device_info)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x01, 0x00, 0x00, 0x00, 0x48,
+	0x01, 0x07, 0x00, 0x00,			// type, id, reserved
+	0xC0, 0xA8, 0x01, 0x07,			// ip 192.168.1.7 в сетевом порядке
+	'p', 'l', 'u', 'g',
+};
+
+static const uint8_t test_devices_info_request_wire[MESH_WIRE_HEADER_SIZE] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t test_device_info_response_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_device_info)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x03, 0x00, 0x00, 0x00, 0x48,
+	0x02, 0x09, 0x00, 0x00,
+	0xC0, 0xA8, 0x01, 0x09,
+	'l', 'a', 'm', 'p',
+};
+
+static const uint8_t test_device_info_response_confirm_wire[MESH_WIRE_HEADER_SIZE] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const uint8_t test_group_switch_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_group_command)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x05, 0x00, 0x00, 0x00, 0x30,
+	0x04, 0x03, 0x02, 0x01,			// seq
+	0x02, 0x01, 0x01, 0x00,			// group, action, flags, reserved
+	0x08, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,		// ids: 3 и 9
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x55, 0x44, 0x33, 0x22, 0x11, 0x00, 0x00, 0x00,		// at
+};
+
+static const uint8_t test_group_switch_ack_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_group_ack)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x06, 0x00, 0x00, 0x00, 0x08,
+	0x0D, 0x0C, 0x0B, 0x0A,			// seq
+	0x07, 0x01, 0x00, 0x00,			// id, state, reserved
+};
+
+static const uint8_t test_time_sync_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_time_beacon)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x07, 0x00, 0x00, 0x00, 0x10,
+	0x05, 0x00, 0x00, 0x00,			// seq
+	0x00, 0x00, 0x00, 0x00,			// reserved
+	0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,		// time
+};
+
+static const uint8_t test_power_event_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_power_event)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x08, 0x00, 0x00, 0x00, 0x0C,
+	0x04, 0x03, 0x02, 0x01,			// seq
+	0xD4, 0xC3, 0xB2, 0xA1,			// boot
+	0x03, 0x01, 0x00, 0x00,			// id, state, reserved
+};
+
+static const uint8_t test_election_announce_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_election_announce)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x09, 0x00, 0x00, 0x00, 0x0C,
+	0xEE, 0xFF, 0xC0, 0x00,			// node
+	0x02, 0x01, 0x00, 0x00,			// priority
+	0x01, 0x02, 0x00, 0x00,			// role, count, reserved
+};
+
+static const uint8_t test_election_table_wire[MESH_WIRE_HEADER_SIZE + sizeof(struct mesh_election_table)] =
+{
+	0x10, 0x01, 0x11, 0x00, 0x0A, 0x00, 0x00, 0x00, 0xE8,
+	0x01, 0x00, 0x00, 0x00,			// count, reserved
+	0x0A, 0x00, 0x00, 0x01,			// entries[0].ip big-endian
+	0x01, 0x05, 0x00, 0x00,			// entries[0].info
+	0xC0, 0xA8, 0x01, 0x05,
+	'a',
+};
+
+static void test_vector_ip(uint32_t* ip, uint8_t last)
+{
+	const uint8_t bytes[] = { 192, 168, 1, last };
+	memcpy(ip, bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Сообщение, полученное типизированным обработчиком mesh_schema
+ */
+static struct mesh_message* test_vector_msg = nullptr;
+
+template<mesh_message_command Command>
+static void test_vector_handler(struct mesh_ctx*, struct mesh_sender_info*, mesh_view<Command> view)
+{
+	test_vector_msg = view.msg;
+}
+
+/**
+ * @brief Проверка одной команды в обе стороны
+ *
+ * Данные stub (expected) кодируются прошивкой в wire. Байты wire декодируются прошивкой,
+ * проходят таблицу mesh_schema до mesh_view и совпадают с expected, обратное кодирование
+ * дает исходные байты.
+ */
+template<mesh_message_command Command>
+static void test_vector(const uint8_t* wire, uint32_t size, const mesh_payload_t<Command>* expected)
+{
+	using payload = mesh_payload_t<Command>;
+
+	uint32_t data_size = 0;
+	if constexpr(!std::is_void_v<payload>)
+	{
+		data_size = sizeof(payload);
+	}
+	TEST_CHECK(size == MESH_WIRE_HEADER_SIZE + data_size);
+
+	struct mesh_message* msg = new_message(Command, const_cast<payload*>(expected), data_size);
+	TEST_CHECK(msg != nullptr && memcmp(msg, wire, size) == 0);
+	free_message(msg);
+
+	struct mesh_message buffer;
+	memset(&buffer, 0, sizeof(struct mesh_message));
+	memcpy(&buffer, wire, size);
+	TEST_CHECK(mesh_wire_decode(&buffer) == 1);
+	TEST_CHECK(buffer.magic == MESH_WIRE_MAGIC && buffer.command == Command);
+
+	test_vector_msg = nullptr;
+	call_handler(mesh_schema<test_vector_handler<Command>>::handlers, nullptr, nullptr, &buffer);
+	TEST_CHECK(test_vector_msg == &buffer);
+
+	if constexpr(!std::is_void_v<payload>)
+	{
+		mesh_view<Command> view{ &buffer };
+		TEST_CHECK(mesh_view<Command>::accepts(&buffer) && memcmp(view.get(), expected, sizeof(payload)) == 0);
+	}
+
+	mesh_wire_encode(&buffer);
+	TEST_CHECK(memcmp(&buffer, wire, size) == 0);
+}
+
+/**
+ * @brief Совместимость формата сети прошивки и схемы stub на фиксированных байтах
+ */
+static void test_vectors()
+{
+	struct mesh_device_info plug;
+	memset(&plug, 0, sizeof(struct mesh_device_info));
+	plug.type = 1;
+	plug.id = 7;
+	test_vector_ip(&plug.ip, 7);
+	strcpy(plug.name, "plug");
+	test_vector<mesh_keep_alive>(test_keep_alive_wire, sizeof(test_keep_alive_wire), &plug);
+
+	test_vector<mesh_devices_info_request>(test_devices_info_request_wire, sizeof(test_devices_info_request_wire), nullptr);
+
+	struct mesh_device_info lamp;
+	memset(&lamp, 0, sizeof(struct mesh_device_info));
+	lamp.type = 2;
+	lamp.id = 9;
+	test_vector_ip(&lamp.ip, 9);
+	strcpy(lamp.name, "lamp");
+	test_vector<mesh_device_info_response>(test_device_info_response_wire, sizeof(test_device_info_response_wire), &lamp);
+
+	test_vector<mesh_device_info_response_confirm>(test_device_info_response_confirm_wire, sizeof(test_device_info_response_confirm_wire), nullptr);
+
+	struct mesh_group_command command;
+	memset(&command, 0, sizeof(struct mesh_group_command));
+	command.seq = 0x01020304;
+	command.group = 2;
+	command.action = 1;
+	command.flags = 1;
+	mesh_group_add_id(&command, 3);
+	mesh_group_add_id(&command, 9);
+	command.at = 0x1122334455ull;
+	test_vector<mesh_group_switch>(test_group_switch_wire, sizeof(test_group_switch_wire), &command);
+
+	struct mesh_group_ack ack;
+	memset(&ack, 0, sizeof(struct mesh_group_ack));
+	ack.seq = 0x0A0B0C0D;
+	ack.id = 7;
+	ack.state = 1;
+	test_vector<mesh_group_switch_ack>(test_group_switch_ack_wire, sizeof(test_group_switch_ack_wire), &ack);
+
+	struct mesh_time_beacon beacon;
+	memset(&beacon, 0, sizeof(struct mesh_time_beacon));
+	beacon.seq = 5;
+	beacon.time = 0x0102030405060708ull;
+	test_vector<mesh_time_sync>(test_time_sync_wire, sizeof(test_time_sync_wire), &beacon);
+
+	struct mesh_power_event event;
+	memset(&event, 0, sizeof(struct mesh_power_event));
+	event.seq = 0x01020304;
+	event.boot = 0xA1B2C3D4;
+	event.id = 3;
+	event.state = 1;
+	test_vector<mesh_power_event>(test_power_event_wire, sizeof(test_power_event_wire), &event);
+
+	struct mesh_election_announce announce;
+	memset(&announce, 0, sizeof(struct mesh_election_announce));
+	announce.node = 0x00C0FFEE;
+	announce.priority = 0x0102;
+	announce.role = 1;
+	announce.count = 2;
+	test_vector<mesh_election_announce>(test_election_announce_wire, sizeof(test_election_announce_wire), &announce);
+
+	struct mesh_election_table table;
+	memset(&table, 0, sizeof(struct mesh_election_table));
+	table.count = 1;
+	table.entries[0].ip = TEST_BASE_ADDR;
+	table.entries[0].info.type = 1;
+	table.entries[0].info.id = 5;
+	test_vector_ip(&table.entries[0].info.ip, 5);
+	strcpy(table.entries[0].info.name, "a");
+	test_vector<mesh_election_table>(test_election_table_wire, sizeof(test_election_table_wire), &table);
+
+	// reserved[2] принятого сообщения не проверяется, при кодировании обнуляется
+	struct mesh_message buffer;
+	memset(&buffer, 0, sizeof(struct mesh_message));
+	memcpy(&buffer, test_keep_alive_wire, sizeof(test_keep_alive_wire));
+	buffer.data[2] = 0xAA;
+	buffer.data[3] = 0x55;
+	TEST_CHECK(mesh_wire_decode(&buffer) == 1 && mesh_view<mesh_keep_alive>::accepts(&buffer));
+
+	mesh_view<mesh_keep_alive> view{ &buffer };
+	TEST_CHECK(view->reserved[0] == 0xAA && view->reserved[1] == 0x55);
+	TEST_CHECK(view->id == 7 && view->ip == plug.ip && strcmp(view->name, "plug") == 0);
+
+	mesh_wire_encode(&buffer);
+	TEST_CHECK(memcmp(&buffer, test_keep_alive_wire, sizeof(test_keep_alive_wire)) == 0);
+}
+
+static const test_case test_cases[] =
+{
+	{ "wire", test_wire },
+	{ "call_handler", test_call_handler },
+	{ "dispatch", test_dispatch },
+	{ "registry", test_registry },
+	{ "timers", test_timers },
+	{ "time", test_time_beacon },
+	{ "vectors", test_vectors },
+};
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --case=NAME              run only this case (repeatable), default all\n"
+			"  --verbose                print mesh log\n"
+			"cases:", name);
+	for(const test_case& test : test_cases)
+	{
+		printf(" %s", test.name);
+	}
+	printf("\n");
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	bool verbose = false;
+	bool selected[sizeof(test_cases) / sizeof(test_case)] = { false };
+	bool any = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--case")) != nullptr)
+		{
+			bool found = false;
+			for(size_t j = 0; j < sizeof(test_cases) / sizeof(test_case); ++j)
+			{
+				if(strcmp(test_cases[j].name, value) == 0)
+				{
+					selected[j] = true;
+					found = true;
+				}
+			}
+			if(!found)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+			any = true;
+		}
+		else if(strcmp(argv[i], "--verbose") == 0)
+		{
+			verbose = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	mesh_stub_log_enable(verbose ? 1 : 0);
+
+	uint32_t failed = 0;
+	for(size_t i = 0; i < sizeof(test_cases) / sizeof(test_case); ++i)
+	{
+		if(any && !selected[i])
+		{
+			continue;
+		}
+
+		test_failures = 0;
+		test_cases[i].run();
+		printf("%-16s %s\n", test_cases[i].name, test_failures == 0 ? "ok" : "FAILED");
+		failed += test_failures != 0 ? 1 : 0;
+	}
+	return failed == 0 ? 0 : 1;
+}
+
+/**
+ * @}
+ */
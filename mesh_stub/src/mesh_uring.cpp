@@ -0,0 +1,801 @@
+#include "mesh_uring.h"
+#include "mesh_platform.h"
+
+#include <linux/io_uring.h>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <functional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Размер submission queue
+ */
+#define MESH_URING_ENTRIES 256
+
+/**
+ * @brief Размер completion queue, с запасом под пачки multishot приема
+ */
+#define MESH_URING_CQ_ENTRIES 4096
+
+/**
+ * @brief Кол-во буферов приема в provided buffer ring (степень 2)
+ */
+#define MESH_URING_BUFFERS 256
+
+/**
+ * @brief Размер буфера приема: заголовок recvmsg + адрес + пакет
+ */
+#define MESH_URING_BUFFER_SIZE (sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) + MESH_RECV_BUF_SIZE)
+
+/**
+ * @brief Кол-во одновременно отправляемых пакетов
+ */
+#define MESH_URING_SEND_SLOTS 256
+
+/**
+ * @brief Группа provided buffer ring
+ */
+#define MESH_URING_BUFFER_GROUP 0
+
+/**
+ * @brief Тип операции в user_data
+ */
+enum
+{
+	MESH_URING_RECV = 1,		///< multishot прием
+	MESH_URING_SEND = 2			///< отправка, номер слота в старших битах
+};
+
+/**
+ * @brief Таймер транспорта
+ */
+struct mesh_timer
+{
+	uint64_t period;					///< период в us, 0 для однократного
+	bool active;						///< false если таймер остановлен
+	mesh_timer_callback callback;		///< пользовательский callback
+	void* arg;							///< аргумент callback
+};
+
+/**
+ * @brief Запись очереди таймеров
+ */
+struct mesh_uring_timer_event
+{
+	uint64_t deadline;					///< время срабатывания в us
+	uint64_t seq;						///< порядок таймеров с одинаковым временем
+	struct mesh_timer* timer;			///< таймер
+
+	bool operator>(const mesh_uring_timer_event& other) const
+	{
+		return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+	}
+};
+
+/**
+ * @brief Слот отправки, живет до получения completion
+ */
+struct mesh_uring_send_slot
+{
+	struct msghdr msg;					///< заголовок sendmsg
+	struct iovec vector;				///< данные пакета
+	struct sockaddr_in addr;			///< адрес назначения
+	int32_t next;						///< следующий свободный слот
+	uint8_t data[MESH_RECV_BUF_SIZE];	///< копия отправляемых данных
+};
+
+/**
+ * @brief Контекст io_uring транспорта
+ */
+struct mesh_uring_ctx
+{
+	struct mesh_ctx base;								///< общая часть контекста
+
+	int port;											///< прорт для mesh
+	int socket;											///< открытый сокет
+	int ring;											///< дескриптор io_uring
+	bool running;										///< флаг работы цикла
+	std::thread::id owner;								///< поток владеющий очередью io_uring
+	struct mesh_dispatcher* dispatcher;					///< потоки обработчиков, nullptr - обработка в цикле
+
+	uint8_t* sq_ring;									///< отображение submission queue
+	size_t sq_ring_size;								///< размер отображения
+	unsigned* sq_head;									///< голова очереди (пишет ядро)
+	unsigned* sq_tail;									///< хвост очереди (пишем мы)
+	unsigned* sq_array;									///< индексы sqe
+	unsigned sq_mask;									///< маска индекса
+	unsigned sq_entries;								///< размер очереди
+	unsigned sq_pending;								///< подготовлено, но не отправлено ядру
+	struct io_uring_sqe* sqes;							///< массив sqe
+	size_t sqes_size;									///< размер отображения sqe
+
+	uint8_t* cq_ring;									///< отображение completion queue
+	size_t cq_ring_size;								///< размер отображения (0 если общее с sq)
+	unsigned* cq_head;									///< голова очереди (пишем мы)
+	unsigned* cq_tail;									///< хвост очереди (пишет ядро)
+	unsigned cq_mask;									///< маска индекса
+	struct io_uring_cqe* cqes;							///< массив cqe
+
+	struct io_uring_buf_ring* buffer_ring;				///< provided buffer ring
+	size_t buffer_ring_size;							///< размер отображения
+	uint8_t* buffers;									///< буферы приема
+	struct msghdr recv_msg;								///< шаблон для multishot recvmsg
+	bool recv_armed;									///< multishot прием активен
+
+	std::vector<mesh_uring_send_slot> slots;			///< слоты отправки
+	int32_t free_slot;									///< первый свободный слот, -1 если нет
+
+	std::priority_queue<mesh_uring_timer_event, std::vector<mesh_uring_timer_event>,
+		std::greater<mesh_uring_timer_event>> timers;	///< очередь таймеров
+	uint64_t timer_seq;									///< счетчик таймеров
+};
+
+static int mesh_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int mesh_uring_enter(int ring, unsigned submit, unsigned wait, unsigned flags, void* arg, size_t size)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, ring, submit, wait, flags, arg, size));
+}
+
+static int mesh_uring_register(int ring, unsigned opcode, void* arg, unsigned count)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, ring, opcode, arg, count));
+}
+
+static uint64_t mesh_uring_clock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Функция отправки ядру подготовленных sqe и ожидания completion
+ * @param[in] ctx Контекст
+ * @param[in] wait Сколько completion ждать
+ * @param[in] timeout Максимальное время ожидания в us (при wait != 0)
+ */
+static void mesh_uring_submit(mesh_uring_ctx* ctx, unsigned wait, uint64_t timeout)
+{
+	int result = 0;
+	if(wait != 0)
+	{
+		struct __kernel_timespec ts;
+		ts.tv_sec = timeout / 1000000;
+		ts.tv_nsec = (timeout % 1000000) * 1000;
+
+		struct io_uring_getevents_arg arg;
+		memset(&arg, 0, sizeof(struct io_uring_getevents_arg));
+		arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+		result = mesh_uring_enter(ctx->ring, ctx->sq_pending, wait, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	}
+	else if(ctx->sq_pending != 0)
+	{
+		result = mesh_uring_enter(ctx->ring, ctx->sq_pending, 0, 0, nullptr, 0);
+	}
+
+	if(result >= 0)
+	{
+		ctx->sq_pending -= static_cast<unsigned>(result) < ctx->sq_pending ? result : ctx->sq_pending;
+	}
+	else if(errno != ETIME && errno != EINTR && errno != EBUSY)
+	{
+		LOG("mesh[uring]: io_uring_enter failed, err: %s\n", strerror(errno));
+	}
+}
+
+/**
+ * @brief Функция получения свободного sqe
+ * @note sqe становится видимым ядру после mesh_uring_commit
+ */
+static struct io_uring_sqe* mesh_uring_sqe(mesh_uring_ctx* ctx)
+{
+	unsigned tail = *ctx->sq_tail;
+	if(tail - __atomic_load_n(ctx->sq_head, __ATOMIC_ACQUIRE) >= ctx->sq_entries)
+	{	// очередь заполнена, отдаем ядру то что есть
+		mesh_uring_submit(ctx, 0, 0);
+		if(tail - __atomic_load_n(ctx->sq_head, __ATOMIC_ACQUIRE) >= ctx->sq_entries)
+		{
+			return nullptr;
+		}
+	}
+
+	unsigned index = tail & ctx->sq_mask;
+	struct io_uring_sqe* sqe = &ctx->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	ctx->sq_array[index] = index;
+	return sqe;
+}
+
+static void mesh_uring_commit(mesh_uring_ctx* ctx)
+{
+	__atomic_store_n(ctx->sq_tail, *ctx->sq_tail + 1, __ATOMIC_RELEASE);
+	++ctx->sq_pending;
+}
+
+/**
+ * @brief Функция возврата буфера приема в provided buffer ring
+ */
+static void mesh_uring_recycle(mesh_uring_ctx* ctx, uint16_t bid)
+{
+	// tail совмещен с полем resv нулевого буфера, поэтому пишем поля по отдельности.
+	// bufs не используется: в C++ __DECLARE_FLEX_ARRAY добавляет пустую структуру
+	// размером 1 байт и массив съезжает на 8 байт относительно ядра
+	uint16_t tail = ctx->buffer_ring->tail;
+	struct io_uring_buf* buf = reinterpret_cast<struct io_uring_buf*>(ctx->buffer_ring) + (tail & (MESH_URING_BUFFERS - 1));
+	buf->addr = reinterpret_cast<uint64_t>(ctx->buffers + bid * MESH_URING_BUFFER_SIZE);
+	buf->len = MESH_URING_BUFFER_SIZE;
+	buf->bid = bid;
+	__atomic_store_n(&ctx->buffer_ring->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+static void mesh_uring_arm_recv(mesh_uring_ctx* ctx)
+{
+	struct io_uring_sqe* sqe = mesh_uring_sqe(ctx);
+	if(sqe == nullptr)
+	{
+		LOG("mesh[uring]: submission queue is full\n");
+		return;
+	}
+
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = ctx->socket;
+	sqe->addr = reinterpret_cast<uint64_t>(&ctx->recv_msg);
+	sqe->len = 1;
+	sqe->msg_flags = MSG_TRUNC;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = MESH_URING_BUFFER_GROUP;
+	sqe->user_data = MESH_URING_RECV;
+	mesh_uring_commit(ctx);
+
+	ctx->recv_armed = true;
+}
+
+static void mesh_uring_on_recv(mesh_uring_ctx* ctx, int32_t res, uint32_t flags)
+{
+	if(!(flags & IORING_CQE_F_MORE))
+	{	// multishot завершен (нет буферов либо ошибка), перезапуск в цикле
+		ctx->recv_armed = false;
+	}
+
+	if(!(flags & IORING_CQE_F_BUFFER))
+	{
+		if(res < 0 && res != -ENOBUFS)
+		{
+			LOG("mesh[uring]: recvmsg failed, err: %s\n", strerror(-res));
+		}
+		return;
+	}
+
+	uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+	uint8_t* buffer = ctx->buffers + bid * MESH_URING_BUFFER_SIZE;
+
+	if(res > 0)
+	{
+		struct io_uring_recvmsg_out* out = reinterpret_cast<struct io_uring_recvmsg_out*>(buffer);
+		struct sockaddr_in* srcaddr = reinterpret_cast<struct sockaddr_in*>(buffer + sizeof(struct io_uring_recvmsg_out));
+		uint8_t* payload = buffer + sizeof(struct io_uring_recvmsg_out) + ctx->recv_msg.msg_namelen + ctx->recv_msg.msg_controllen;
+
+		if(!(out->flags & MSG_TRUNC) && out->payloadlen == sizeof(struct mesh_message))
+		{
+			struct mesh_message* msg = reinterpret_cast<struct mesh_message*>(payload);
+
+			struct mesh_sender_info sender;
+			sender.ip = ntohl(srcaddr->sin_addr.s_addr);
+			sender.port = ntohs(srcaddr->sin_port);
+
+			if(sender.ip != inet_addr("192.168.0.100"))
+			{
+				LOG("received command: %d\n", msg->command);
+				if(ctx->dispatcher != nullptr)
+				{
+					mesh_dispatcher_push(ctx->dispatcher, &ctx->base, &sender, msg);
+				}
+				else
+				{
+					mesh_dispatch(&ctx->base, &sender, msg);
+				}
+			}
+		}
+		else
+		{
+			LOG("failed read message, wrong size\n");
+		}
+	}
+	mesh_uring_recycle(ctx, bid);
+}
+
+static void mesh_uring_on_send(mesh_uring_ctx* ctx, int32_t slot, int32_t res)
+{
+	if(res < 0)
+	{
+		LOG("failed send data, err: %s\n", strerror(-res));
+	}
+	ctx->slots[slot].next = ctx->free_slot;
+	ctx->free_slot = slot;
+}
+
+/**
+ * @brief Функция обработки всех готовых completion
+ */
+static void mesh_uring_reap(mesh_uring_ctx* ctx)
+{
+	unsigned head = *ctx->cq_head;
+	while(head != __atomic_load_n(ctx->cq_tail, __ATOMIC_ACQUIRE))
+	{
+		struct io_uring_cqe cqe = ctx->cqes[head & ctx->cq_mask];
+		__atomic_store_n(ctx->cq_head, ++head, __ATOMIC_RELEASE);
+
+		if((cqe.user_data & 0xFF) == MESH_URING_RECV)
+		{
+			mesh_uring_on_recv(ctx, cqe.res, cqe.flags);
+		}
+		else if((cqe.user_data & 0xFF) == MESH_URING_SEND)
+		{
+			mesh_uring_on_send(ctx, static_cast<int32_t>(cqe.user_data >> 8), cqe.res);
+		}
+	}
+}
+
+/**
+ * @brief Функция вызова сработавших таймеров
+ * @return Время до следующего таймера в us
+ */
+static uint64_t mesh_uring_fire_timers(mesh_uring_ctx* ctx)
+{
+	uint64_t now = mesh_uring_clock();
+	while(!ctx->timers.empty() && ctx->timers.top().deadline <= now)
+	{
+		mesh_uring_timer_event event = ctx->timers.top();
+		ctx->timers.pop();
+
+		struct mesh_timer* timer = event.timer;
+		if(!timer->active)
+		{
+			delete timer;
+		}
+		else if(timer->period != 0)
+		{
+			event.deadline += timer->period;
+			event.seq = ctx->timer_seq++;
+			ctx->timers.push(event);
+			timer->callback(&ctx->base, timer->arg);
+		}
+		else
+		{
+			struct mesh_timer fired = *timer;
+			delete timer;
+			fired.callback(&ctx->base, fired.arg);
+		}
+	}
+
+	// ограничиваем ожидание, чтобы mesh_uring_break отрабатывал без событий
+	uint64_t wait = 1000000;
+	if(!ctx->timers.empty())
+	{
+		uint64_t deadline = ctx->timers.top().deadline;
+		now = mesh_uring_clock();
+		wait = deadline > now ? (deadline - now < wait ? deadline - now : wait) : 0;
+	}
+	return wait;
+}
+
+static uint32_t mesh_uring_send(struct mesh_ctx* base, void* data, uint32_t size, uint32_t ip)
+{
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+
+	if(size > MESH_RECV_BUF_SIZE)
+	{
+		LOG("mesh[uring]: packet too big, size: %u\n", size);
+		return 0;
+	}
+
+	// из чужого потока (обработчики диспетчера) очередь не трогаем
+	bool owner = std::this_thread::get_id() == ctx->owner;
+	struct io_uring_sqe* sqe = owner && ctx->free_slot >= 0 ? mesh_uring_sqe(ctx) : nullptr;
+	if(sqe == nullptr)
+	{	// все слоты заняты либо чужой поток, отправляем синхронно
+		struct sockaddr_in s;
+		s.sin_family = AF_INET;
+		s.sin_port = htons(ctx->port);
+		s.sin_addr.s_addr = htonl(ip);
+
+		ssize_t sended_data = sendto(ctx->socket, data, size, 0, (struct sockaddr*) &s, sizeof(struct sockaddr_in));
+		if(sended_data < 0)
+		{
+			LOG("failed send data, err: %s\n", strerror(errno));
+			return 0;
+		}
+		return sended_data;
+	}
+
+	int32_t index = ctx->free_slot;
+	mesh_uring_send_slot* slot = &ctx->slots[index];
+	ctx->free_slot = slot->next;
+
+	memcpy(slot->data, data, size);
+	slot->vector.iov_base = slot->data;
+	slot->vector.iov_len = size;
+
+	slot->addr.sin_family = AF_INET;
+	slot->addr.sin_port = htons(ctx->port);
+	slot->addr.sin_addr.s_addr = htonl(ip);
+
+	memset(&slot->msg, 0, sizeof(struct msghdr));
+	slot->msg.msg_name = &slot->addr;
+	slot->msg.msg_namelen = sizeof(struct sockaddr_in);
+	slot->msg.msg_iov = &slot->vector;
+	slot->msg.msg_iovlen = 1;
+
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = ctx->socket;
+	sqe->addr = reinterpret_cast<uint64_t>(&slot->msg);
+	sqe->len = 1;
+	sqe->user_data = MESH_URING_SEND | (static_cast<uint64_t>(index) << 8);
+	mesh_uring_commit(ctx);
+
+	// отправка уйдет ядру вместе с ожиданием в цикле, без отдельного syscall
+	return size;
+}
+
+static uint32_t mesh_uring_send_batch(struct mesh_ctx* base, struct mesh_packet* packets, uint32_t count)
+{
+	uint32_t sended = 0;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		if(mesh_uring_send(base, packets[i].data, packets[i].size, packets[i].ip) == packets[i].size)
+		{
+			++sended;
+		}
+	}
+	// пачка отдается ядру одним вызовом
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+	if(std::this_thread::get_id() == ctx->owner)
+	{
+		mesh_uring_submit(ctx, 0, 0);
+	}
+	return sended;
+}
+
+static uint32_t mesh_uring_now(struct mesh_ctx*)
+{
+	return static_cast<uint32_t>(mesh_uring_clock() / 1000);
+}
+
+static uint64_t mesh_uring_now_us(struct mesh_ctx*)
+{
+	return mesh_uring_clock();
+}
+
+static struct mesh_timer* mesh_uring_timer_start(struct mesh_ctx* base, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg)
+{
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+
+	struct mesh_timer* timer = new mesh_timer;
+	timer->period = repeat ? static_cast<uint64_t>(ms) * 1000 : 0;
+	timer->active = true;
+	timer->callback = callback;
+	timer->arg = arg;
+
+	mesh_uring_timer_event event;
+	event.deadline = mesh_uring_clock() + static_cast<uint64_t>(ms) * 1000;
+	event.seq = ctx->timer_seq++;
+	event.timer = timer;
+	ctx->timers.push(event);
+
+	return timer;
+}
+
+static void mesh_uring_timer_stop(struct mesh_ctx*, struct mesh_timer* timer)
+{
+	// таймер удаляется при извлечении из очереди
+	timer->active = false;
+}
+
+static void mesh_uring_free(mesh_uring_ctx* ctx)
+{
+	if(ctx->buffers != nullptr)
+	{
+		munmap(ctx->buffers, MESH_URING_BUFFERS * MESH_URING_BUFFER_SIZE);
+	}
+	if(ctx->buffer_ring != nullptr)
+	{
+		munmap(ctx->buffer_ring, ctx->buffer_ring_size);
+	}
+	if(ctx->sqes != nullptr)
+	{
+		munmap(ctx->sqes, ctx->sqes_size);
+	}
+	if(ctx->cq_ring != nullptr && ctx->cq_ring_size != 0)
+	{
+		munmap(ctx->cq_ring, ctx->cq_ring_size);
+	}
+	if(ctx->sq_ring != nullptr)
+	{
+		munmap(ctx->sq_ring, ctx->sq_ring_size);
+	}
+	if(ctx->ring >= 0)
+	{
+		close(ctx->ring);
+	}
+	if(ctx->socket >= 0)
+	{
+		close(ctx->socket);
+	}
+
+	while(!ctx->timers.empty())
+	{
+		delete ctx->timers.top().timer;
+		ctx->timers.pop();
+	}
+	delete ctx;
+}
+
+static void mesh_uring_stop(struct mesh_ctx* base)
+{
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+	if(ctx != nullptr)
+	{
+		mesh_uring_free(ctx);
+	}
+}
+
+const struct mesh_transport mesh_uring_transport =
+{
+	"udp/io_uring",
+	mesh_uring_send,
+	mesh_uring_send_batch,
+	nullptr,
+	mesh_uring_now,
+	mesh_uring_now_us,
+	mesh_uring_timer_start,
+	mesh_uring_timer_stop,
+	mesh_uring_stop,
+};
+
+static bool mesh_uring_init_ring(mesh_uring_ctx* ctx)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(struct io_uring_params));
+	params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+	params.cq_entries = MESH_URING_CQ_ENTRIES;
+
+	ctx->ring = mesh_uring_setup(MESH_URING_ENTRIES, &params);
+	if(ctx->ring < 0 && errno == EINVAL)
+	{	// старое ядро без DEFER_TASKRUN
+		memset(&params, 0, sizeof(struct io_uring_params));
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = MESH_URING_CQ_ENTRIES;
+		ctx->ring = mesh_uring_setup(MESH_URING_ENTRIES, &params);
+	}
+
+	if(ctx->ring < 0)
+	{
+		LOG("mesh[uring]: io_uring_setup failed, err: %s\n", strerror(errno));
+		return false;
+	}
+
+	if(!(params.features & IORING_FEAT_EXT_ARG))
+	{
+		LOG("mesh[uring]: kernel does not support IORING_FEAT_EXT_ARG\n");
+		return false;
+	}
+
+	ctx->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+	if(single && cq_size > ctx->sq_ring_size)
+	{
+		ctx->sq_ring_size = cq_size;
+	}
+
+	void* ptr = mmap(nullptr, ctx->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ctx->ring, IORING_OFF_SQ_RING);
+	if(ptr == MAP_FAILED)
+	{
+		LOG("mesh[uring]: failed map submission queue, err: %s\n", strerror(errno));
+		return false;
+	}
+	ctx->sq_ring = reinterpret_cast<uint8_t*>(ptr);
+
+	if(single)
+	{
+		ctx->cq_ring = ctx->sq_ring;
+		ctx->cq_ring_size = 0;
+	}
+	else
+	{
+		ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ctx->ring, IORING_OFF_CQ_RING);
+		if(ptr == MAP_FAILED)
+		{
+			LOG("mesh[uring]: failed map completion queue, err: %s\n", strerror(errno));
+			return false;
+		}
+		ctx->cq_ring = reinterpret_cast<uint8_t*>(ptr);
+		ctx->cq_ring_size = cq_size;
+	}
+
+	ctx->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(nullptr, ctx->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ctx->ring, IORING_OFF_SQES);
+	if(ptr == MAP_FAILED)
+	{
+		LOG("mesh[uring]: failed map sqes, err: %s\n", strerror(errno));
+		return false;
+	}
+	ctx->sqes = reinterpret_cast<struct io_uring_sqe*>(ptr);
+
+	ctx->sq_head = reinterpret_cast<unsigned*>(ctx->sq_ring + params.sq_off.head);
+	ctx->sq_tail = reinterpret_cast<unsigned*>(ctx->sq_ring + params.sq_off.tail);
+	ctx->sq_array = reinterpret_cast<unsigned*>(ctx->sq_ring + params.sq_off.array);
+	ctx->sq_mask = *reinterpret_cast<unsigned*>(ctx->sq_ring + params.sq_off.ring_mask);
+	ctx->sq_entries = params.sq_entries;
+
+	ctx->cq_head = reinterpret_cast<unsigned*>(ctx->cq_ring + params.cq_off.head);
+	ctx->cq_tail = reinterpret_cast<unsigned*>(ctx->cq_ring + params.cq_off.tail);
+	ctx->cq_mask = *reinterpret_cast<unsigned*>(ctx->cq_ring + params.cq_off.ring_mask);
+	ctx->cqes = reinterpret_cast<struct io_uring_cqe*>(ctx->cq_ring + params.cq_off.cqes);
+	return true;
+}
+
+static bool mesh_uring_init_buffers(mesh_uring_ctx* ctx)
+{
+	ctx->buffer_ring_size = MESH_URING_BUFFERS * sizeof(struct io_uring_buf);
+	void* ptr = mmap(nullptr, ctx->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ptr == MAP_FAILED)
+	{
+		LOG("mesh[uring]: failed allocate buffer ring, err: %s\n", strerror(errno));
+		return false;
+	}
+	ctx->buffer_ring = reinterpret_cast<struct io_uring_buf_ring*>(ptr);
+
+	ptr = mmap(nullptr, MESH_URING_BUFFERS * MESH_URING_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ptr == MAP_FAILED)
+	{
+		LOG("mesh[uring]: failed allocate buffers, err: %s\n", strerror(errno));
+		return false;
+	}
+	ctx->buffers = reinterpret_cast<uint8_t*>(ptr);
+
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(struct io_uring_buf_reg));
+	reg.ring_addr = reinterpret_cast<uint64_t>(ctx->buffer_ring);
+	reg.ring_entries = MESH_URING_BUFFERS;
+	reg.bgid = MESH_URING_BUFFER_GROUP;
+
+	if(mesh_uring_register(ctx->ring, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+	{
+		LOG("mesh[uring]: failed register buffer ring, err: %s\n", strerror(errno));
+		return false;
+	}
+
+	for(uint16_t i = 0; i < MESH_URING_BUFFERS; ++i)
+	{
+		mesh_uring_recycle(ctx, i);
+	}
+
+	memset(&ctx->recv_msg, 0, sizeof(struct msghdr));
+	ctx->recv_msg.msg_namelen = sizeof(struct sockaddr_in);
+	return true;
+}
+
+bool mesh_uring_supported()
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(struct io_uring_params));
+
+	int ring = mesh_uring_setup(1, &params);
+	if(ring < 0)
+	{
+		return false;
+	}
+	close(ring);
+	return (params.features & IORING_FEAT_EXT_ARG) != 0;
+}
+
+struct mesh_ctx* mesh_uring_start(struct mesh_message_handlers* handlers, uint32_t ip, uint32_t port)
+{
+	mesh_uring_ctx* ctx = new mesh_uring_ctx;
+	mesh_init(&ctx->base, &mesh_uring_transport, handlers);
+
+	ctx->port = port;
+	ctx->ring = -1;
+	ctx->running = false;
+	ctx->owner = std::this_thread::get_id();
+	ctx->dispatcher = nullptr;
+	ctx->sq_ring = nullptr;
+	ctx->cq_ring = nullptr;
+	ctx->sqes = nullptr;
+	ctx->sq_pending = 0;
+	ctx->buffer_ring = nullptr;
+	ctx->buffers = nullptr;
+	ctx->recv_armed = false;
+	ctx->timer_seq = 0;
+
+	ctx->slots.resize(MESH_URING_SEND_SLOTS);
+	for(int32_t i = 0; i < MESH_URING_SEND_SLOTS; ++i)
+	{
+		ctx->slots[i].next = i + 1 < MESH_URING_SEND_SLOTS ? i + 1 : -1;
+	}
+	ctx->free_slot = 0;
+
+	ctx->socket = mesh_udp_socket(ip, port);
+	if(ctx->socket < 0 || !mesh_uring_init_ring(ctx) || !mesh_uring_init_buffers(ctx))
+	{
+		mesh_uring_free(ctx);
+		return nullptr;
+	}
+	return &ctx->base;
+}
+
+void mesh_uring_set_dispatcher(struct mesh_ctx* base, struct mesh_dispatcher* dispatcher)
+{
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+	if(ctx != nullptr)
+	{
+		ctx->dispatcher = dispatcher;
+	}
+}
+
+void mesh_uring_run(struct mesh_ctx* base)
+{
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+	if(ctx == nullptr)
+	{
+		return;
+	}
+
+	ctx->running = true;
+	while(ctx->running)
+	{
+		if(!ctx->recv_armed)
+		{
+			mesh_uring_arm_recv(ctx);
+		}
+
+		uint64_t wait = mesh_uring_fire_timers(ctx);
+		if(!ctx->running)
+		{
+			break;
+		}
+
+		// один syscall: отдаем накопленные отправки и ждем новые completion
+		mesh_uring_submit(ctx, 1, wait);
+		mesh_uring_reap(ctx);
+	}
+	// отдаем ядру хвост отправок
+	mesh_uring_submit(ctx, 0, 0);
+}
+
+void mesh_uring_break(struct mesh_ctx* base)
+{
+	mesh_uring_ctx* ctx = reinterpret_cast<mesh_uring_ctx*>(base);
+	if(ctx != nullptr)
+	{
+		ctx->running = false;
+	}
+}
+
+/**
+ * @}
+ */
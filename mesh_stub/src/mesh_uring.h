@@ -0,0 +1,60 @@
+#pragma once
+
+#include <mesh.h>
+
+#include "mesh_dispatcher.h"
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Транспорт UDP поверх io_uring
+ *
+ * В отличии от libev (уведомление о готовности + recvfrom на каждый пакет)
+ * прием выполняется одним multishot recvmsg с буферами из provided buffer ring,
+ * отправка ставится в очередь submission и уходит пачкой, поэтому на пакет
+ * не тратится отдельный системный вызов.
+ *
+ * @note Требуется ядро >= 6.0 (multishot recvmsg, IORING_REGISTER_PBUF_RING)
+ */
+extern const struct mesh_transport mesh_uring_transport;
+
+/**
+ * @brief Функция проверки поддержки io_uring ядром
+ */
+bool mesh_uring_supported();
+
+/**
+ * @brief Функция создания mesh поверх io_uring
+ * @param[in] handlers Список обработчиков сообщений
+ * @param[in] ip Адрес для bind
+ * @param[in] port Порт mesh
+ * @return Контекст mesh либо nullptr
+ */
+struct mesh_ctx* mesh_uring_start(struct mesh_message_handlers* handlers, uint32_t ip, uint32_t port);
+
+/**
+ * @brief Функция передачи обработки сообщений в потоки диспетчера
+ * @param[in] ctx Контекст
+ * @param[in] dispatcher Диспетчер, nullptr - обработка в цикле
+ * @note Отправка из потоков обработчиков идет напрямую через sendto,
+ * очередь io_uring использует только поток создавший контекст
+ */
+void mesh_uring_set_dispatcher(struct mesh_ctx* ctx, struct mesh_dispatcher* dispatcher);
+
+/**
+ * @brief Функция запуска цикла обработки, возвращает управление после mesh_uring_break
+ */
+void mesh_uring_run(struct mesh_ctx* ctx);
+
+/**
+ * @brief Функция прерывания цикла обработки
+ */
+void mesh_uring_break(struct mesh_ctx* ctx);
+
+/**
+ * @}
+ */
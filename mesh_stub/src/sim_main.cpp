@@ -0,0 +1,175 @@
+#include <iostream>
+
+#include "mesh_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --scenario=discovery|storm|keep_alive|time_sync|election\n"
+			"  --nodes=N            devices count\n"
+			"  --seed=N             random seed\n"
+			"  --loss=P             packet loss probability [0, 1]\n"
+			"  --delay=US           link delay\n"
+			"  --jitter=US          link delay jitter\n"
+			"  --bandwidth=BPS      medium bandwidth, 0 - unlimited\n"
+			"  --fanout=US          broadcast cost per recipient\n"
+			"  --interval=MS        request retry / keep_alive / time beacon period\n"
+			"  --skew=PPM           max clock drift of devices (time_sync)\n"
+			"  --limit=MS           virtual time limit\n"
+			"  --csv                machine readable output\n", name);
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	mesh_sim_config config;
+	mesh_sim_default_config(&config);
+
+	bool csv = false;
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--scenario")) != nullptr)
+		{
+			if(strcmp(value, "discovery") == 0)
+			{
+				config.scenario = mesh_sim_discovery;
+			}
+			else if(strcmp(value, "storm") == 0)
+			{
+				config.scenario = mesh_sim_storm;
+			}
+			else if(strcmp(value, "keep_alive") == 0)
+			{
+				config.scenario = mesh_sim_keep_alive;
+			}
+			else if(strcmp(value, "time_sync") == 0)
+			{
+				config.scenario = mesh_sim_time_sync;
+			}
+			else if(strcmp(value, "election") == 0)
+			{
+				config.scenario = mesh_sim_election;
+			}
+			else
+			{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+		else if((value = option_value(argv[i], "--nodes")) != nullptr)
+		{
+			config.nodes = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--seed")) != nullptr)
+		{
+			config.seed = strtoull(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--loss")) != nullptr)
+		{
+			config.link.loss = strtod(value, nullptr);
+		}
+		else if((value = option_value(argv[i], "--delay")) != nullptr)
+		{
+			config.link.delay = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--jitter")) != nullptr)
+		{
+			config.link.jitter = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--bandwidth")) != nullptr)
+		{
+			config.medium.bandwidth = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--fanout")) != nullptr)
+		{
+			config.medium.fanout_cost = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--interval")) != nullptr)
+		{
+			config.interval = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--skew")) != nullptr)
+		{
+			config.skew = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--limit")) != nullptr)
+		{
+			config.limit = strtoul(value, nullptr, 10);
+		}
+		else if(strcmp(argv[i], "--csv") == 0)
+		{
+			csv = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	// логи mesh на каждое сообщение сотен узлов бессмысленны
+	mesh_stub_log_enable(0);
+
+	mesh_sim_result result;
+	if(!mesh_sim_run(&config, &result))
+	{
+		std::cout << "invalid simulation config" << std::endl;
+		return 1;
+	}
+
+	double speedup = result.wall_time != 0 ? (result.convergence_time * 1000.) / result.wall_time : 0.;
+	if(csv)
+	{
+		printf("scenario,nodes,seed,loss,delay_us,jitter_us,bandwidth_bps,fanout_us,interval_ms,"
+				"converged,convergence_ms,sent,broadcasts,delivered,dropped,bytes,events,wall_us,speedup,"
+				"skew_ppm,delivery_spread_us,action_spread_us,max_error_us,leader,broadcasts_per_interval,discovered\n");
+		printf("%s,%u,%llu,%g,%u,%u,%u,%u,%u,%d,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.1f,%u,%llu,%llu,%llu,%u,%.1f,%u\n",
+				mesh_sim_scenario_name(config.scenario), config.nodes, (unsigned long long) config.seed,
+				config.link.loss, config.link.delay, config.link.jitter, config.medium.bandwidth, config.medium.fanout_cost, config.interval,
+				result.converged ? 1 : 0, result.convergence_time,
+				(unsigned long long) result.stats.sent, (unsigned long long) result.stats.broadcasts,
+				(unsigned long long) result.stats.delivered, (unsigned long long) result.stats.dropped,
+				(unsigned long long) result.stats.bytes, (unsigned long long) result.events,
+				(unsigned long long) result.wall_time, speedup,
+				config.skew, (unsigned long long) result.delivery_spread,
+				(unsigned long long) result.action_spread, (unsigned long long) result.max_error,
+				result.leader, result.broadcasts_per_interval, result.discovered);
+	}
+	else
+	{
+		printf("scenario:     %s, nodes: %u, seed: %llu\n", mesh_sim_scenario_name(config.scenario), config.nodes, (unsigned long long) config.seed);
+		printf("converged:    %s at %u ms (virtual)\n", result.converged ? "yes" : "no", result.convergence_time);
+		printf("messages:     sent %llu (broadcast %llu), delivered %llu, dropped %llu, bytes %llu\n",
+				(unsigned long long) result.stats.sent, (unsigned long long) result.stats.broadcasts,
+				(unsigned long long) result.stats.delivered, (unsigned long long) result.stats.dropped,
+				(unsigned long long) result.stats.bytes);
+		if(config.scenario == mesh_sim_time_sync)
+		{
+			printf("time sync:    skew %u ppm, delivery spread %llu us, action spread %llu us, max error %llu us\n",
+					config.skew, (unsigned long long) result.delivery_spread,
+					(unsigned long long) result.action_spread, (unsigned long long) result.max_error);
+		}
+		if(config.scenario == mesh_sim_election)
+		{
+			printf("election:     leader %u, %.1f broadcasts per keep_alive period, controller discovered %u devices\n",
+					result.leader, result.broadcasts_per_interval, result.discovered);
+		}
+		printf("simulation:   %llu events in %llu us (x%.1f real time)\n",
+				(unsigned long long) result.events, (unsigned long long) result.wall_time, speedup);
+	}
+	return result.converged ? 0 : 2;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Lock-free кольцевой буфер для одного писателя и одного читателя
+ *
+ * Запись и чтение идут прямо в слоты буфера (acquire/publish, front/release),
+ * чтобы не копировать элемент дважды. Индексы писателя и читателя разнесены
+ * по разным cache line, каждая сторона кэширует чужой индекс и читает его
+ * атомарно только когда по кэшу буфер полон/пуст.
+ *
+ * @tparam T Тип элемента
+ * @tparam Size Размер буфера, степень 2
+ */
+template<typename T, uint32_t Size>
+class spsc_ring
+{
+	static_assert(Size != 0 && (Size & (Size - 1)) == 0, "spsc_ring size must be power of 2");
+
+public:
+	spsc_ring()
+		: tail(0)
+		, cached_head(0)
+		, head(0)
+		, cached_tail(0)
+	{
+	}
+
+	spsc_ring(const spsc_ring&) = delete;
+	spsc_ring& operator=(const spsc_ring&) = delete;
+
+	/**
+	 * @brief Получение свободного слота (писатель)
+	 * @return Слот для заполнения либо nullptr если буфер полон
+	 */
+	T* acquire()
+	{
+		uint32_t current = tail.load(std::memory_order_relaxed);
+		if(current - cached_head == Size)
+		{
+			cached_head = head.load(std::memory_order_acquire);
+			if(current - cached_head == Size)
+			{
+				return nullptr;
+			}
+		}
+		return &items[current & (Size - 1)];
+	}
+
+	/**
+	 * @brief Публикация заполненного слота (писатель)
+	 */
+	void publish()
+	{
+		tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Получение первого элемента (читатель)
+	 * @return Элемент либо nullptr если буфер пуст
+	 */
+	T* front()
+	{
+		uint32_t current = head.load(std::memory_order_relaxed);
+		if(current == cached_tail)
+		{
+			cached_tail = tail.load(std::memory_order_acquire);
+			if(current == cached_tail)
+			{
+				return nullptr;
+			}
+		}
+		return &items[current & (Size - 1)];
+	}
+
+	/**
+	 * @brief Освобождение первого элемента (читатель)
+	 */
+	void release()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Проверка на пустоту, безопасна с любой стороны
+	 */
+	bool empty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	alignas(64) std::atomic<uint32_t> tail;		///< индекс записи, меняет писатель
+	uint32_t cached_head;						///< последний прочитанный писателем head
+
+	alignas(64) std::atomic<uint32_t> head;		///< индекс чтения, меняет читатель
+	uint32_t cached_tail;						///< последний прочитанный читателем tail
+
+	alignas(64) T items[Size];					///< элементы
+};
+
+/**
+ * @}
+ */
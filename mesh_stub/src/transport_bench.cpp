@@ -0,0 +1,339 @@
+#include <iostream>
+
+#include "mesh_platform.h"
+#include "mesh_uring.h"
+#include "mesh_wire.h"
+
+#include <arpa/inet.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief Адрес loopback для замера
+ */
+#define BENCH_ADDR 0x7F000001
+
+/**
+ * @brief Кол-во адресов отправителей (127.0.1.1 и далее)
+ */
+#define BENCH_SENDERS 8
+
+/**
+ * @brief Состояние одного замера
+ */
+struct bench_state
+{
+	struct mesh_ctx* ctx;				///< контекст приемника
+	bool uring;							///< используемый транспорт
+	uint64_t packets;					///< сколько пакетов отправить
+	uint64_t work;						///< имитация работы обработчика, ns
+	std::atomic<uint64_t> received;		///< сколько пакетов обработано
+	uint64_t last_received;				///< принято на прошлой проверке
+	std::atomic<bool> sender_done;		///< отправитель закончил
+};
+
+static uint64_t bench_clock(clockid_t id)
+{
+	struct timespec ts;
+	clock_gettime(id, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static void bench_handler(struct mesh_ctx* ctx, struct mesh_sender_info*, struct mesh_message*)
+{
+	bench_state* state = reinterpret_cast<bench_state*>(ctx->user_data);
+	if(state->work != 0)
+	{	// медленный обработчик: вывод, запись на диск и т.п.
+		uint64_t until = bench_clock(CLOCK_MONOTONIC) + state->work;
+		while(bench_clock(CLOCK_MONOTONIC) < until)
+		{
+		}
+	}
+	state->received.fetch_add(1, std::memory_order_relaxed);
+}
+
+static struct mesh_message_handlers bench_handlers[] =
+{
+	{ mesh_keep_alive, bench_handler },
+	{ mesh_keep_alive, NULL },
+};
+
+static void bench_check(struct mesh_ctx* ctx, void*)
+{
+	bench_state* state = reinterpret_cast<bench_state*>(ctx->user_data);
+
+	// все приняли, либо отправитель закончил и новых пакетов нет (остальное потеряно)
+	bool idle = state->sender_done && state->received == state->last_received;
+	if(state->received >= state->packets || idle)
+	{
+		if(state->uring)
+		{
+			mesh_uring_break(ctx);
+		}
+		else
+		{
+			mesh_udp_break(ctx);
+		}
+	}
+	state->last_received = state->received;
+}
+
+static void bench_sender(bench_state* state, uint32_t port)
+{
+	// несколько отправителей с разными адресами, чтобы диспетчер раскладывал их по потокам
+	int fds[BENCH_SENDERS];
+	for(uint32_t i = 0; i < BENCH_SENDERS; ++i)
+	{
+		struct sockaddr_in source;
+		memset(&source, 0, sizeof(struct sockaddr_in));
+		source.sin_family = AF_INET;
+		source.sin_addr.s_addr = htonl(BENCH_ADDR + 0x100 + i);
+
+		fds[i] = socket(PF_INET, SOCK_DGRAM, 0);
+		if(fds[i] < 0 || bind(fds[i], reinterpret_cast<struct sockaddr*>(&source), sizeof(source)) != 0)
+		{
+			std::cout << "failed create sender socket" << std::endl;
+			for(uint32_t j = 0; j <= i; ++j)
+			{
+				close(fds[j]);
+			}
+			state->sender_done = true;
+			return;
+		}
+	}
+
+	struct mesh_message msg;
+	memset(&msg, 0, sizeof(struct mesh_message));
+	msg.magic = MESH_WIRE_MAGIC;
+	msg.command = mesh_keep_alive;
+	msg.data_size = sizeof(struct mesh_device_info);
+	mesh_wire_encode(&msg);
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(struct sockaddr_in));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(BENCH_ADDR);
+
+	const uint32_t batch_size = 64;
+	struct mmsghdr headers[batch_size];
+	struct iovec vector;
+	vector.iov_base = &msg;
+	vector.iov_len = sizeof(struct mesh_message);
+
+	memset(headers, 0, sizeof(headers));
+	for(uint32_t i = 0; i < batch_size; ++i)
+	{
+		headers[i].msg_hdr.msg_name = &addr;
+		headers[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+		headers[i].msg_hdr.msg_iov = &vector;
+		headers[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	uint64_t sended = 0;
+	uint32_t batch = 0;
+	while(sended < state->packets)
+	{
+		uint32_t current = state->packets - sended < batch_size ? state->packets - sended : batch_size;
+		int result = sendmmsg(fds[batch++ % BENCH_SENDERS], headers, current, 0);
+		if(result <= 0)
+		{
+			break;
+		}
+		sended += result;
+
+		// даем приемнику разобрать очередь сокета, иначе замеряется только потеря пакетов
+		if(batch % 16 == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	for(uint32_t i = 0; i < BENCH_SENDERS; ++i)
+	{
+		close(fds[i]);
+	}
+	state->sender_done = true;
+}
+
+static bool bench_run(bool uring, uint64_t packets, uint32_t port, uint32_t workers, uint64_t work, bool csv)
+{
+	bench_state state;
+	state.uring = uring;
+	state.packets = packets;
+	state.work = work;
+	state.received = 0;
+	state.last_received = 0;
+	state.sender_done = false;
+
+	state.ctx = uring ? mesh_uring_start(bench_handlers, BENCH_ADDR, port) : mesh_udp_start(bench_handlers, BENCH_ADDR, port);
+	if(state.ctx == nullptr)
+	{
+		std::cout << "failed start mesh" << std::endl;
+		return false;
+	}
+	state.ctx->user_data = &state;
+
+	struct mesh_dispatcher* dispatcher = workers != 0 ? mesh_dispatcher_new(workers) : nullptr;
+	if(uring)
+	{
+		mesh_uring_set_dispatcher(state.ctx, dispatcher);
+	}
+	else
+	{
+		mesh_udp_set_dispatcher(state.ctx, dispatcher);
+	}
+
+	mesh_timer_start(state.ctx, 100, true, bench_check, nullptr);
+
+	uint64_t wall = bench_clock(CLOCK_MONOTONIC);
+	uint64_t cpu = bench_clock(CLOCK_THREAD_CPUTIME_ID);
+
+	std::thread sender(bench_sender, &state, port);
+	if(uring)
+	{
+		mesh_uring_run(state.ctx);
+	}
+	else
+	{
+		mesh_udp_run(state.ctx);
+	}
+
+	cpu = bench_clock(CLOCK_THREAD_CPUTIME_ID) - cpu;
+	wall = bench_clock(CLOCK_MONOTONIC) - wall;
+	sender.join();
+
+	uint64_t dropped = 0;
+	if(dispatcher != nullptr)
+	{
+		dropped = mesh_dispatcher_get_stats(dispatcher).dropped;
+		mesh_dispatcher_free(dispatcher);
+	}
+
+	const char* name = state.ctx->transport->name;
+	mesh_stop(state.ctx);
+
+	double seconds = wall / 1e9;
+	uint64_t received = state.received;
+	double rate = seconds > 0 ? received / seconds : 0.;
+	double cpu_per_packet = received != 0 ? static_cast<double>(cpu) / received : 0.;
+	double loss = packets != 0 ? 100. * (packets - received) / packets : 0.;
+
+	if(csv)
+	{
+		printf("%s,%u,%llu,%llu,%llu,%llu,%.3f,%.0f,%.1f,%.2f\n", name, workers, (unsigned long long) work,
+				(unsigned long long) packets, (unsigned long long) received, (unsigned long long) dropped,
+				seconds, rate, cpu_per_packet, loss);
+	}
+	else
+	{
+		printf("%-12s workers %u: handled %llu/%llu (queue drop %llu) in %.3f s: %.0f packets/s, %.1f ns cpu/packet, loss %.2f%%\n",
+				name, workers, (unsigned long long) received, (unsigned long long) packets, (unsigned long long) dropped,
+				seconds, rate, cpu_per_packet, loss);
+	}
+	return true;
+}
+
+static void usage(const char* name)
+{
+	printf("usage: %s [options]\n"
+			"  --backend=ev|uring|all   transport to measure\n"
+			"  --packets=N              packets per run\n"
+			"  --port=N                 loopback port\n"
+			"  --workers=N              handler threads, 0 - handle in receive loop\n"
+			"  --work=NS                busy time of every handler call\n"
+			"  --csv                    machine readable output\n", name);
+}
+
+static const char* option_value(const char* arg, const char* name)
+{
+	size_t length = strlen(name);
+	if(strncmp(arg, name, length) == 0 && arg[length] == '=')
+	{
+		return arg + length + 1;
+	}
+	return nullptr;
+}
+
+int main(int argc, const char** argv)
+{
+	bool ev = true;
+	bool uring = true;
+	uint64_t packets = 1000000;
+	uint32_t port = 16636;
+	uint32_t workers = 0;
+	uint64_t work = 0;
+	bool csv = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if((value = option_value(argv[i], "--backend")) != nullptr)
+		{
+			ev = strcmp(value, "ev") == 0 || strcmp(value, "all") == 0;
+			uring = strcmp(value, "uring") == 0 || strcmp(value, "all") == 0;
+			if(!ev && !uring)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+		else if((value = option_value(argv[i], "--packets")) != nullptr)
+		{
+			packets = strtoull(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--port")) != nullptr)
+		{
+			port = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--workers")) != nullptr)
+		{
+			workers = strtoul(value, nullptr, 10);
+		}
+		else if((value = option_value(argv[i], "--work")) != nullptr)
+		{
+			work = strtoull(value, nullptr, 10);
+		}
+		else if(strcmp(argv[i], "--csv") == 0)
+		{
+			csv = true;
+		}
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	mesh_stub_log_enable(0);
+
+	if(csv)
+	{
+		printf("backend,workers,work_ns,packets,handled,queue_dropped,seconds,packets_per_second,cpu_ns_per_packet,loss_percent\n");
+	}
+
+	if(ev && !bench_run(false, packets, port, workers, work, csv))
+	{
+		return 1;
+	}
+
+	if(uring)
+	{
+		if(!mesh_uring_supported())
+		{
+			std::cout << "io_uring not supported by kernel" << std::endl;
+			return 1;
+		}
+		if(!bench_run(true, packets, port, workers, work, csv))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -1 +1,37 @@
 #pragma once
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup mesh_stub Mesh stub
+ * @addtogroup mesh_stub
+ * @{
+ */
+
+/**
+ * @brief Функция вывода логов mesh для PC
+ * В отличии от printf может быть отключена, например в симуляторе
+ */
+int mesh_stub_log(const char* format, ...);
+
+/**
+ * @brief Функция включения/отключения логов
+ */
+void mesh_stub_log_enable(int enable);
+
+/**
+ * @}
+ */
+
+#if defined __cplusplus
+}
+#endif
+
+#define LOG mesh_stub_log
+
+/**
+ * @brief На PC лидер выборов (симулятор) держит таблицу сегмента любого размера
+ */
+#define MESH_ELECTION_MAX_DEVICES 256
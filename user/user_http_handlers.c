@@ -119,7 +119,7 @@ static void http_scan_callback(void *args, STATUS status)
 		query_response_body(data, strlen(data), query);
 
 		cJSON_Delete(json_root);
-		free(data);
+		light_http_free(data);
 
 		query_done(query);
 	}
@@ -149,7 +149,7 @@ int http_system_info_handler(struct query *query)
 	char* data = cJSON_Print(json_root);
 	query_response_body(data, strlen(data), query);
 
-	free(data);
+	light_http_free(data);
 	cJSON_Delete(json_root);
 
 	return 1;
@@ -201,7 +201,7 @@ int http_get_device_info_handler(struct query *query)
 	query_response_header("Content-Type", "application/json", query);
 	query_response_body(data, strlen(data), query);
 
-	free(data);
+	light_http_free(data);
 	cJSON_Delete(json_root);
 
 	return 1;
@@ -229,7 +229,7 @@ int http_scan_wifi_info_list_handler(struct query *query)
 		query_response_body(data, strlen(data), query);
 
 		cJSON_Delete(json_root);
-		free(data);
+		light_http_free(data);
 	}
 	else
 	{
@@ -282,7 +282,7 @@ int http_set_device_name_handler(struct query *query)
 	query_response_body(data, strlen(data), query);
 
 	cJSON_Delete(json_root);
-	free(data);
+	light_http_free(data);
 
 	return 1;
 }
@@ -399,7 +399,7 @@ int http_set_main_wifi_handler(struct query *query)
 	query_response_body(data, strlen(data), query);
 
 	cJSON_Delete(json_root);
-	free(data);
+	light_http_free(data);
 
 	if(result)
 	{
@@ -434,7 +434,7 @@ int http_get_wifi_error_handler(struct query *query)
 	query_response_body(data, strlen(data), query);
 
 	cJSON_Delete(json_root);
-	free(data);
+	light_http_free(data);
 
 	return 1;
 }
@@ -471,7 +471,7 @@ int http_on_handler(struct query *query)
 		query_response_body(data, strlen(data), query);
 
 		cJSON_Delete(json_root);
-		free(data);
+		light_http_free(data);
 	}
 	else
 	{
@@ -518,7 +518,7 @@ int http_off_handler(struct query *query)
 		query_response_body(data, strlen(data), query);
 
 		cJSON_Delete(json_root);
-		free(data);
+		light_http_free(data);
 	}
 	else
 	{
@@ -576,7 +576,7 @@ int http_status_handler(struct query *query)
 		query_response_body(data, strlen(data), query);
 
 		cJSON_Delete(json_root);
-		free(data);
+		light_http_free(data);
 	}
 	else
 	{
@@ -615,7 +615,7 @@ int http_start_test_mode(struct query *query)
 	query_response_body(data, strlen(data), query);
 
 	cJSON_Delete(json_root);
-	free(data);
+	light_http_free(data);
 
 	return 1;
 }
@@ -634,7 +634,7 @@ int http_stop_test_mode(struct query *query)
 	query_response_body(data, strlen(data), query);
 
 	cJSON_Delete(json_root);
-	free(data);
+	light_http_free(data);
 
 	return 1;
 }
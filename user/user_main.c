@@ -1,6 +1,7 @@
 #include "user_config.h"
 
 #include "esp_common.h"
+#include "cJSON.h"
 
 #ifdef NDEBUG
 #include "../esp-gdbstub/gdbstub.h"
@@ -11,7 +12,9 @@
 #include "user_wifi.h"
 #include "user_power.h"
 #include "user_http_handlers.h"
+#include "user_http_routes.h"
 #include "user_mesh_handlers.h"
+#include "user_mesh.h"
 
 #include "../mesh/mesh.h"
 #include "../data/data.h"
@@ -22,18 +25,18 @@ LOCAL os_timer_t info_timer;
 
 static struct http_handler_rule http_handlers[] = 
 {	
-	{ "/getSystemInfo", http_system_info_handler },
-	{ "/getDeviceInfo", http_get_device_info_handler },
-	{ "/getBroadcastNetworks", http_scan_wifi_info_list_handler },
-	{ "/setDeviceName", http_set_device_name_handler },
-	{ "/setWifi", http_set_main_wifi_handler },
-	{ "/getWifiError", http_get_wifi_error_handler },
-	{ "/on", http_on_handler },
-	{ "/off", http_off_handler },
-	{ "/status", http_status_handler },
-	{ "/testModeOn",  http_start_test_mode},
-	{ "/testModeOff",  http_stop_test_mode},
-	{ NULL, NULL },
+	{ "/getSystemInfo", http_system_info_handler, HTTP_METHOD_ANY },
+	{ "/getDeviceInfo", http_get_device_info_handler, HTTP_METHOD_ANY },
+	{ "/getBroadcastNetworks", http_scan_wifi_info_list_handler, HTTP_METHOD_ANY },
+	{ "/setDeviceName", http_set_device_name_handler, HTTP_METHOD_ANY },
+	{ "/setWifi", http_set_main_wifi_handler, HTTP_METHOD_ANY },
+	{ "/getWifiError", http_get_wifi_error_handler, HTTP_METHOD_ANY },
+	{ "/on", http_on_handler, HTTP_METHOD_ANY },
+	{ "/off", http_off_handler, HTTP_METHOD_ANY },
+	{ "/status", http_status_handler, HTTP_METHOD_ANY },
+	{ "/testModeOn", http_start_test_mode, HTTP_METHOD_ANY },
+	{ "/testModeOff", http_stop_test_mode, HTTP_METHOD_ANY },
+	{ NULL, NULL, HTTP_METHOD_ANY },
 };
 
 static struct mesh_message_handlers mesh_handlers[] = 
@@ -42,6 +45,9 @@ static struct mesh_message_handlers mesh_handlers[] =
 	{ mesh_devices_info_request, mesh_devices_info_request_handler },
 	{ mesh_device_info_response, mesh_device_info_response_handler },
 	{ mesh_device_info_response_confirm, mesh_device_info_response_confirm_handler },
+	{ mesh_group_switch, mesh_group_switch_handler },
+	{ mesh_time_sync, mesh_time_sync_handler },
+	{ mesh_election_announce, mesh_election_announce_handler },
 	{ mesh_keep_alive, NULL },
 };
 
@@ -96,8 +102,18 @@ void user_init(void)
 		}
 		wifi_start_ap(&info);
 	}
-	asio_webserver_start(http_handlers);
-	mesh_start(mesh_handlers, ANY_ADDR, 6636);
+	// узлы cJSON обработчиков выделяются из арены запроса
+	cJSON_Hooks json_hooks = { light_http_malloc, light_http_free };
+	cJSON_InitHooks(&json_hooks);
+	asio_webserver_start_table(http_handlers, &user_http_routes);
+	struct mesh_ctx* mesh = mesh_lwip_start(mesh_handlers, ANY_ADDR, 6636);
+	if(mesh != NULL)
+	{
+		mesh_election_setup(mesh);
+		power_set_listener(mesh_power_listener, mesh);
+		// начальное состояние после загрузки, событие с seq 1
+		mesh_power_listener(power_status() ? 1 : 0, mesh);
+	}
 
 	uint32_t end_time = system_get_time();
 	os_printf("time: system up by: %umks\n", (end_time - start_time));
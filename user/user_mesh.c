@@ -58,7 +58,7 @@ static void asio_mesh_recv_callback(void *arg, struct udp_pcb *pcb, struct pbuf
 {
 	if(arg != NULL)
 	{
-		struct mesh_ctx* ctx = (struct mesh_ctx*) arg;
+		struct mesh_lwip_ctx* ctx = (struct mesh_lwip_ctx*) arg;
 		os_printf("mesh[asio_mesh_recv_callback]: pcb: %p, pbuf: %p\n", pcb, p);
 
 		if(p != NULL)
@@ -90,7 +90,7 @@ static void asio_mesh_recv_callback(void *arg, struct udp_pcb *pcb, struct pbuf
 					sender.port = ntohs(port);
 
 
-					call_handler(ctx->handlers, ctx, &sender, msg);
+					mesh_dispatch(&ctx->base, &sender, msg);
 				}
 			}
 			pbuf_free(p);
@@ -105,7 +105,7 @@ static void asio_mesh_recv_callback(void *arg, struct udp_pcb *pcb, struct pbuf
 /**
  * @brief Инцилазация mesh
  */
-static void asio_init_mesh_ctx(struct mesh_ctx* ctx, uint32_t addr, uint32_t port)
+static void asio_init_mesh_ctx(struct mesh_lwip_ctx* ctx, uint32_t addr, uint32_t port)
 {
 	LWIP_ASSERT("mesh[asio_init_mesh_ctx]: udp_new failed", ctx != NULL);
 
@@ -122,44 +122,40 @@ static void asio_init_mesh_ctx(struct mesh_ctx* ctx, uint32_t addr, uint32_t por
 }
 
 
-struct mesh_ctx* mesh_start(struct mesh_message_handlers* handlers, uint32_t addr, uint32_t port)
+/**
+ * @brief Таймер транспорта поверх os_timer
+ */
+struct mesh_timer
 {
-	vPortEnterCritical();
-	struct mesh_ctx* ctx = (struct mesh_ctx*) zalloc(sizeof(struct mesh_ctx));
-	if(ctx != NULL)
-	{
-		ctx->handlers = handlers;
-		asio_init_mesh_ctx(ctx, addr, port);
-
-		/*os_timer_setfn(&mesh_keep_alive_timer, mesh_keep_alive_timer_handler, ctx);*/
-		/*os_timer_arm(&mesh_keep_alive_timer, 4000, true);*/
-	}
-	else
-	{
-		LOG("mesh[mesh_start]: failed create ctx\n");
-	}
-	vPortExitCritical();
-}
-
-void mesh_stop(struct mesh_ctx* ctx)
+	os_timer_t timer;					///< таймер sdk
+	uint8_t repeat;						///< периодический или нет
+	struct mesh_ctx* ctx;				///< контекст запустивший таймер
+	mesh_timer_callback callback;		///< пользовательский callback
+	void* arg;							///< аргумент callback
+};
+
+static void mesh_lwip_timer_handler(void *p_args)
 {
-	vPortEnterCritical();
-	os_timer_disarm(&mesh_keep_alive_timer);
-
-	if(ctx != NULL)
+	struct mesh_timer* timer = (struct mesh_timer*) p_args;
+	if(timer != NULL)
 	{
-
-		udp_disconnect(ctx->socket);
-		udp_remove(ctx->socket);
-
-		free(ctx);
-		ctx = NULL;
+		if(timer->repeat)
+		{
+			timer->callback(timer->ctx, timer->arg);
+		}
+		else
+		{	// однократный таймер удаляется до вызова callback
+			struct mesh_timer fired = *timer;
+			free(timer);
+			fired.callback(fired.ctx, fired.arg);
+		}
 	}
-	vPortExitCritical();
 }
 
-uint32_t mesh_send_data(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_t ip)
+static uint32_t mesh_lwip_send(struct mesh_ctx* base, void* data, uint32_t size, uint32_t ip)
 {
+	struct mesh_lwip_ctx* ctx = (struct mesh_lwip_ctx*) base;
+
 	uint32_t sended = 0;
 	struct pbuf* buffer = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM);
 	if(buffer != NULL)
@@ -172,7 +168,7 @@ uint32_t mesh_send_data(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_
 		err_t result = udp_sendto(ctx->socket, buffer, &dst_addr, ctx->port);
 		if(result != ERR_OK)
 		{
-			LOG("mesh[mesh_send_data]: failed send data, result: %d\n", result);
+			LOG("mesh[mesh_lwip_send]: failed send data, result: %d\n", result);
 		}
 		else
 		{
@@ -182,17 +178,106 @@ uint32_t mesh_send_data(struct mesh_ctx* ctx, void* data, uint32_t size, uint32_
 	}
 	else
 	{
-		LOG("mesh[mesh_send_data]: failed allocate response buffer\n");
+		LOG("mesh[mesh_lwip_send]: failed allocate response buffer\n");
 	}
 	return sended;
 }
 
-// для LwIP не нужно, по этому просто заглушк
-uint32_t mesh_receive_data(struct mesh_ctx* ctx, void* data, uint32_t size)
+static uint32_t mesh_lwip_now(struct mesh_ctx* base)
+{
+	return system_get_time() / 1000;
+}
+
+static uint64_t mesh_lwip_clock(struct mesh_ctx* base)
+{
+	// system_get_time переполняется раз в ~71 минуту, досчитываем старшую часть
+	static uint32_t last = 0;
+	static uint32_t high = 0;
+
+	uint32_t now = system_get_time();
+	if(now < last)
+	{
+		++high;
+	}
+	last = now;
+	return ((uint64_t) high << 32) | now;
+}
+
+static struct mesh_timer* mesh_lwip_timer_start(struct mesh_ctx* base, uint32_t ms, uint8_t repeat, mesh_timer_callback callback, void* arg)
 {
-	uint32_t received = 0;
-	LOG("mesh[mesh_receive_data]: not implemented\n");
-	return received;
+	struct mesh_timer* timer = (struct mesh_timer*) zalloc(sizeof(struct mesh_timer));
+	if(timer != NULL)
+	{
+		timer->repeat = repeat;
+		timer->ctx = base;
+		timer->callback = callback;
+		timer->arg = arg;
+
+		os_timer_setfn(&timer->timer, mesh_lwip_timer_handler, timer);
+		os_timer_arm(&timer->timer, ms, repeat);
+	}
+	else
+	{
+		LOG("mesh[mesh_lwip_timer_start]: failed allocate timer\n");
+	}
+	return timer;
+}
+
+static void mesh_lwip_timer_stop(struct mesh_ctx* base, struct mesh_timer* timer)
+{
+	os_timer_disarm(&timer->timer);
+	free(timer);
+}
+
+static void mesh_lwip_stop(struct mesh_ctx* base)
+{
+	vPortEnterCritical();
+	os_timer_disarm(&mesh_keep_alive_timer);
+
+	struct mesh_lwip_ctx* ctx = (struct mesh_lwip_ctx*) base;
+	if(ctx != NULL)
+	{
+		udp_disconnect(ctx->socket);
+		udp_remove(ctx->socket);
+
+		free(ctx);
+		ctx = NULL;
+	}
+	vPortExitCritical();
+}
+
+// для LwIP receive не нужен, данные приходят в asio_mesh_recv_callback
+const struct mesh_transport mesh_lwip_transport =
+{
+	"lwip",
+	mesh_lwip_send,
+	NULL,
+	NULL,
+	mesh_lwip_now,
+	mesh_lwip_clock,
+	mesh_lwip_timer_start,
+	mesh_lwip_timer_stop,
+	mesh_lwip_stop,
+};
+
+struct mesh_ctx* mesh_lwip_start(struct mesh_message_handlers* handlers, uint32_t addr, uint32_t port)
+{
+	vPortEnterCritical();
+	struct mesh_lwip_ctx* ctx = (struct mesh_lwip_ctx*) zalloc(sizeof(struct mesh_lwip_ctx));
+	if(ctx != NULL)
+	{
+		mesh_init(&ctx->base, &mesh_lwip_transport, handlers);
+		asio_init_mesh_ctx(ctx, addr, port);
+
+		/*os_timer_setfn(&mesh_keep_alive_timer, mesh_keep_alive_timer_handler, ctx);*/
+		/*os_timer_arm(&mesh_keep_alive_timer, 4000, true);*/
+	}
+	else
+	{
+		LOG("mesh[mesh_lwip_start]: failed create ctx\n");
+	}
+	vPortExitCritical();
+	return (ctx != NULL ? &ctx->base : NULL);
 }
 
 /**
@@ -23,15 +23,29 @@
  */
 
 /** 
- * @brief Стуктура описывающая контекст mesg для esp
+ * @brief Стуктура описывающая контекст mesh для esp (LwIP транспорт)
  */
-struct mesh_ctx
+struct mesh_lwip_ctx
 {
+	struct mesh_ctx base;							///< общая часть контекста
 	uint32_t port;									///< порт на котором слушаются пакеты
 	struct udp_pcb* socket;							///< открытый сокет (используется LwIP RAW API)
-	struct mesh_message_handlers* handlers;			///< список обработчиков команд
 };
 
+/**
+ * @brief Транспорт поверх LwIP RAW API
+ */
+extern const struct mesh_transport mesh_lwip_transport;
+
+/**
+ * @brief Функция для запуска mesh поверх LwIP
+ * @param[in] handlers Список обработчиков команд
+ * @param[in] addr Адрес для bind
+ * @param[in] port Порт mesh
+ * @return Контекст mesh либо NULL
+ */
+struct mesh_ctx* mesh_lwip_start(struct mesh_message_handlers* handlers, uint32_t addr, uint32_t port);
+
 /**
  * @}
  * @}
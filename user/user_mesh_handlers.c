@@ -4,6 +4,7 @@
 
 #include "../data/data.h"
 #include "user_wifi.h"
+#include "user_power.h"
 
 /**
  * @defgroup user User 
@@ -14,6 +15,35 @@
  * @{
  */
 
+/**
+ * @brief Выборы лидера сегмента
+ */
+static struct mesh_election mesh_election_state;
+
+static uint8_t mesh_fill_device_info(void* arg, struct mesh_device_info* info)
+{
+	struct data_custom_name device_name;
+	memset(&device_name, 0, sizeof(struct data_custom_name));
+
+	struct data_device_info device_info;
+	memset(&device_info, 0, sizeof(struct data_device_info));
+
+	struct ip_info device_ip;
+	memset(&device_ip, 0, sizeof(struct ip_info));
+
+	if(!data_read_custom_name(&device_name) || !data_read_current_device(&device_info) || !wifi_get_ip(&device_ip))
+	{
+		return 0;
+	}
+
+	memset(info, 0, sizeof(struct mesh_device_info));
+	info->id = device_info.device_id;
+	info->type = device_info.device_type;
+	info->ip = device_ip.ip.addr;
+	memcpy(info->name, device_name.data, MESH_DEVICE_NAME_SIZE);
+	return 1;
+}
+
 void mesh_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
 {
 	if(msg != NULL)
@@ -21,6 +51,7 @@ void mesh_keep_alive_handler(struct mesh_ctx* ctx, struct mesh_sender_info* send
 		if(msg->data_size == sizeof(struct mesh_device_info))
 		{
 			struct mesh_device_info* info = (struct mesh_device_info*) msg->data;
+			mesh_election_on_keep_alive(&mesh_election_state, ctx, sender, msg);
 			os_printf("mesh[mesh_keep_alive_handler]: received info \n");
 			/*os_printf("mesh[mesh_keep_alive_handler]: received info device_id: %d, device_type: %d, device_ip: %d, device_name: %s\n", */
 					/*info->id, info->type, info->ip, info->name);*/
@@ -40,25 +71,12 @@ void mesh_devices_info_request_handler(struct mesh_ctx* ctx, struct mesh_sender_
 {
 	if(msg != NULL)
 	{
-		struct data_custom_name device_name;
-		memset(&device_name, 0, sizeof(struct data_custom_name));
-
-		struct data_device_info device_info;
-		memset(&device_info, 0, sizeof(struct data_device_info));
-
-		struct ip_info device_ip;
-		memset(&device_ip, 0, sizeof(struct ip_info));
-
-		if(data_read_custom_name(&device_name) && data_read_current_device(&device_info) && wifi_get_ip(&device_ip))
+		struct mesh_device_info mesh_device_info;
+		if(mesh_election_on_discovery(&mesh_election_state, ctx, sender))
+		{	// за сегмент отвечает лидер
+		}
+		else if(mesh_fill_device_info(NULL, &mesh_device_info))
 		{
-			struct mesh_device_info mesh_device_info;
-			memset(&mesh_device_info, 0, sizeof(struct mesh_device_info));
-
-			mesh_device_info.id = device_info.device_id;
-			mesh_device_info.type = device_info.device_type;
-			mesh_device_info.ip = device_ip.ip.addr;
-			memcpy(mesh_device_info.name, device_name.data, MESH_DEVICE_NAME_SIZE);
-
 			mesh_send_device_info(ctx, &mesh_device_info, sender->ip);
 		}
 		else
@@ -107,6 +125,226 @@ void mesh_device_info_response_confirm_handler(struct mesh_ctx* ctx, struct mesh
 	}
 }
 
+/**
+ * @brief Оценка часов шлюза по маякам mesh_time_sync
+ */
+static struct mesh_time mesh_time_state;
+
+void mesh_time_sync_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	mesh_time_on_beacon(&mesh_time_state, ctx, sender, msg);
+}
+
+/**
+ * @brief Последняя принятая групповая команда, повтор не выполняется
+ */
+static uint32_t group_last_seq = 0;
+static uint32_t group_last_sender = 0;
+
+/**
+ * @brief Подтверждение ожидающее своего слота
+ */
+static struct mesh_group_ack group_ack;
+static uint32_t group_ack_dst = 0;
+static struct mesh_timer* group_ack_timer = NULL;
+
+/**
+ * @brief Действие отложенное до момента mesh_group_command::at
+ */
+static uint8_t group_pending_action = 0;
+static uint8_t group_pending_ack = 0;
+static struct mesh_timer* group_action_timer = NULL;
+
+static void mesh_group_apply(uint8_t action)
+{
+	switch(action)
+	{
+		case mesh_group_power_off:
+			power_down();
+			break;
+
+		case mesh_group_power_on:
+			power_up();
+			break;
+
+		case mesh_group_power_toggle:
+			power_status() ? power_down() : power_up();
+			break;
+	}
+}
+
+static void mesh_group_ack_timer_handler(struct mesh_ctx* ctx, void* arg)
+{
+	// однократный таймер удален транспортом
+	group_ack_timer = NULL;
+	group_ack.state = power_status() ? 1 : 0;
+	mesh_send_group_switch_ack(ctx, &group_ack, group_ack_dst);
+}
+
+static void mesh_group_schedule_ack(struct mesh_ctx* ctx)
+{
+	// новая команда заменяет неотправленное подтверждение
+	if(group_ack_timer != NULL)
+	{
+		mesh_timer_stop(ctx, group_ack_timer);
+	}
+	group_ack_timer = mesh_timer_start(ctx, MESH_GROUP_ACK_SLOT * (group_ack.id + 1), false, mesh_group_ack_timer_handler, NULL);
+	if(group_ack_timer == NULL)
+	{
+		mesh_group_ack_timer_handler(ctx, NULL);
+	}
+}
+
+static void mesh_group_action_timer_handler(struct mesh_ctx* ctx, void* arg)
+{
+	group_action_timer = NULL;
+	mesh_group_apply(group_pending_action);
+	if(group_pending_ack)
+	{
+		mesh_group_schedule_ack(ctx);
+	}
+}
+
+void mesh_group_switch_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	if(msg == NULL)
+	{
+		os_printf("mesh[mesh_group_switch_handler]: mesh_message is null\n");
+		return;
+	}
+
+	if(msg->data_size != sizeof(struct mesh_group_command))
+	{
+		os_printf("mesh[mesh_group_switch_handler]: invalid data size\n");
+		return;
+	}
+
+	struct data_device_info device_info;
+	memset(&device_info, 0, sizeof(struct data_device_info));
+	if(!data_read_current_device(&device_info))
+	{
+		os_printf("mesh[mesh_group_switch_handler]: failed read flash\n");
+		return;
+	}
+
+	struct mesh_group_command* command = (struct mesh_group_command*) msg->data;
+	uint8_t group = device_info.group != 0xFF ? device_info.group : MESH_GROUP_NONE;
+	if(!mesh_group_match(command, device_info.device_id, group))
+	{
+		return;
+	}
+
+	if(command->action > mesh_group_power_toggle)
+	{
+		os_printf("mesh[mesh_group_switch_handler]: unknown action: %d\n", command->action);
+		return;
+	}
+
+	uint8_t repeat = command->seq == group_last_seq && sender->ip == group_last_sender;
+	group_last_seq = command->seq;
+	group_last_sender = sender->ip;
+
+	memset(&group_ack, 0, sizeof(struct mesh_group_ack));
+	group_ack.seq = command->seq;
+	group_ack.id = device_info.device_id;
+	group_ack_dst = sender->ip;
+
+	if(repeat && group_action_timer != NULL)
+	{	// действие еще ждет своего момента, подтверждение уйдет после выполнения
+		group_pending_ack = (command->flags & MESH_GROUP_FLAG_ACK) != 0;
+		return;
+	}
+
+	if(!repeat)
+	{
+		if(group_action_timer != NULL)
+		{
+			mesh_timer_stop(ctx, group_action_timer);
+			group_action_timer = NULL;
+		}
+
+		if(command->at != 0 && mesh_time_synced(&mesh_time_state, ctx))
+		{
+			group_pending_action = command->action;
+			group_pending_ack = (command->flags & MESH_GROUP_FLAG_ACK) != 0;
+			group_action_timer = mesh_time_at(&mesh_time_state, ctx, command->at, mesh_group_action_timer_handler, NULL);
+			if(group_action_timer != NULL)
+			{
+				return;
+			}
+		}
+		mesh_group_apply(command->action);
+	}
+
+	if(command->flags & MESH_GROUP_FLAG_ACK)
+	{
+		mesh_group_schedule_ack(ctx);
+	}
+}
+
+/**
+ * @brief Номер последнего события нагрузки, идет с 1 после загрузки
+ */
+static uint32_t power_event_seq = 0;
+
+/**
+ * @brief Идентификатор загрузки для событий нагрузки, выбирается при первом событии
+ */
+static uint32_t power_event_boot = 0;
+
+void mesh_power_listener(uint8_t state, void* arg)
+{
+	struct mesh_ctx* ctx = (struct mesh_ctx*) arg;
+	if(ctx == NULL)
+	{
+		return;
+	}
+
+	struct data_device_info device_info;
+	memset(&device_info, 0, sizeof(struct data_device_info));
+	if(!data_read_current_device(&device_info))
+	{	// событие все равно уходит, иначе шлюз увидит разрыв seq
+		os_printf("mesh[mesh_power_listener]: failed read flash\n");
+	}
+
+	struct mesh_power_event event;
+	memset(&event, 0, sizeof(struct mesh_power_event));
+	if(power_event_seq == 0)
+	{	// счетчик загрузок во flash стоил бы записи на каждую загрузку
+		power_event_boot = os_random();
+	}
+
+	event.seq = ++power_event_seq;
+	event.boot = power_event_boot;
+	event.id = device_info.device_id;
+	event.state = state;
+	mesh_send_power_event(ctx, &event);
+}
+
+void mesh_election_announce_handler(struct mesh_ctx* ctx, struct mesh_sender_info* sender, struct mesh_message* msg)
+{
+	mesh_election_on_announce(&mesh_election_state, ctx, sender, msg);
+}
+
+void mesh_election_setup(struct mesh_ctx* ctx)
+{
+	struct data_device_info device_info;
+	memset(&device_info, 0, sizeof(struct data_device_info));
+	if(!data_read_current_device(&device_info))
+	{
+		os_printf("mesh[mesh_election_setup]: failed read flash\n");
+		return;
+	}
+
+	// лидером может быть только устройство с постоянным питанием, старшинство по device_id
+	mesh_election_init(&mesh_election_state, system_get_chip_id(), device_info.device_id, 
+			data_device_info_get_powered(&device_info), mesh_fill_device_info, NULL);
+	if(!mesh_election_start(&mesh_election_state, ctx))
+	{
+		os_printf("mesh[mesh_election_setup]: failed start election\n");
+	}
+}
+
 /**
  * @}
  * @}
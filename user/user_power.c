@@ -30,10 +30,25 @@
 static os_timer_t test_mode_timer;
 static uint8_t power_state = 0;
 
+static power_listener state_listener = NULL;
+static void* state_listener_arg = NULL;
+
+static void power_set(uint8_t state)
+{
+	GPIO_OUTPUT_SET(POWER_GPIO, state);
+	if(state != power_state)
+	{
+		power_state = state;
+		if(state_listener != NULL)
+		{
+			state_listener(state, state_listener_arg);
+		}
+	}
+}
+
 static void power_test_mode_callback(void *p_args)
 {
-	GPIO_OUTPUT_SET(POWER_GPIO, power_state);
-	power_state ^= 1;
+	power_set(power_state ^ 1);
 }
 
 void power_init()
@@ -41,14 +56,20 @@ void power_init()
 	PIN_FUNC_SELECT(POWER_GPIO_MUX, POWER_GPIO_FUNC);
 }
 
+void power_set_listener(power_listener listener, void* arg)
+{
+	state_listener = listener;
+	state_listener_arg = arg;
+}
+
 void power_down()
 {
-	GPIO_OUTPUT_SET(POWER_GPIO, 0);
+	power_set(0);
 }
 
 void power_up()
 {
-	GPIO_OUTPUT_SET(POWER_GPIO, 1);
+	power_set(1);
 }
 
 int8_t power_status()